@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Simulator {
+	struct BenchmarkOptions {
+		uint32_t max_threads_count = 8;
+		uint64_t messages_count = 200000;
+		uint64_t max_bodies_count = 10000000;
+	};
+}
@@ -0,0 +1,189 @@
+#include "broadphase_benchmark.h"
+#include "../broadphase.h"
+#include "../dynamic_aabb_tree.h"
+#include "../job_system.h"
+#include "../world.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace Simulator;
+
+static constexpr size_t MAX_BROADPHASE_BODIES_COUNT = 1000000;
+static constexpr size_t MAX_BRUTE_FORCE_BODIES_COUNT = 10000;
+static constexpr float BODY_RADIUS = 0.5f;
+static constexpr float BODIES_DENSITY = 0.5f;
+static constexpr float STEP_DT = 1.0f / 60.0f;
+static constexpr uint32_t REFIT_STEPS_COUNT = 10;
+
+static void populateWorld(World& world, size_t bodies_count)
+{
+	world.clear();
+	world.reserve(bodies_count);
+	world.setGravity(0.0f, 0.0f, 0.0f);
+
+	float extent = std::cbrt(static_cast<float>(bodies_count) / BODIES_DENSITY);
+	uint32_t seed = 0x2545F491u;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+	};
+
+	for (size_t i = 0; i < bodies_count; i++) {
+		float mass = ((i % 16) == 0) ? 0.0f : 1.0f;
+		world.addBody(random() * extent, random() * extent, random() * extent, random() * 2.0f - 1.0f, random() * 2.0f - 1.0f,
+			random() * 2.0f - 1.0f, mass, BODY_RADIUS * (0.5f + random() * 0.5f));
+	}
+}
+
+static void sortPairs(std::vector<BroadphasePair>& pairs)
+{
+	std::sort(pairs.begin(), pairs.end(), [](const BroadphasePair& a, const BroadphasePair& b)
+		{
+			return (a.first_body_idx != b.first_body_idx) ? (a.first_body_idx < b.first_body_idx) : (a.second_body_idx < b.second_body_idx);
+		});
+}
+
+static bool isSamePairs(const std::vector<BroadphasePair>& a, const std::vector<BroadphasePair>& b)
+{
+	return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const BroadphasePair& first, const BroadphasePair& second)
+		{
+			return (first.first_body_idx == second.first_body_idx) && (first.second_body_idx == second.second_body_idx);
+		});
+}
+
+static void findBruteForcePairs(const World& world, std::vector<BroadphasePair>& out_pairs)
+{
+	const float* inverse_mass = world.getInverseMasses();
+	uint32_t bodies_count = static_cast<uint32_t>(world.getBodiesCount());
+
+	out_pairs.clear();
+	for (uint32_t i = 0; i < bodies_count; i++) {
+		Aabb aabb = getBodyAabb(world.getPositionsX(), world.getPositionsY(), world.getPositionsZ(), world.getRadii(), i);
+
+		for (uint32_t j = i + 1; j < bodies_count; j++) {
+			if ((inverse_mass[i] == 0.0f) && (inverse_mass[j] == 0.0f)) {
+				continue;
+			}
+
+			if (isOverlapping(aabb, getBodyAabb(world.getPositionsX(), world.getPositionsY(), world.getPositionsZ(), world.getRadii(), j))) {
+				out_pairs.push_back({ i, j });
+			}
+		}
+	}
+}
+
+template<typename Function>
+static double measureMilliseconds(Function function)
+{
+	auto start_time = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+bool Simulator::runBroadphaseBenchmark(const BenchmarkOptions& options, JsonWriter& json)
+{
+	size_t max_bodies_count = std::min<size_t>(options.max_bodies_count, MAX_BROADPHASE_BODIES_COUNT);
+
+	std::vector<size_t> bodies_counts;
+	for (size_t bodies_count = 1000; bodies_count < max_bodies_count; bodies_count *= 10) {
+		bodies_counts.push_back(bodies_count);
+	}
+
+	bodies_counts.push_back(max_bodies_count);
+
+	JobSystemSettings job_system_settings;
+	job_system_settings.workers_count = options.max_threads_count - 1;
+
+	JobSystem job_system;
+	std::string out_error_message;
+	if (!job_system.start(job_system_settings, out_error_message)) {
+		fprintf(stderr, "%s\n", out_error_message.c_str());
+		return false;
+	}
+
+	bool success = true;
+	World world;
+	std::vector<BroadphasePair> pairs;
+	std::vector<BroadphasePair> reference_pairs;
+
+	json.beginArray("broadphase");
+
+	for (size_t bodies_count : bodies_counts) {
+		populateWorld(world, bodies_count);
+
+		bool has_reference_pairs = false;
+		if (bodies_count <= MAX_BRUTE_FORCE_BODIES_COUNT) {
+			findBruteForcePairs(world, reference_pairs);
+			sortPairs(reference_pairs);
+			has_reference_pairs = true;
+		}
+
+		for (BroadphaseMethod method : { BroadphaseMethod::UNIFORM_GRID, BroadphaseMethod::DYNAMIC_TREE }) {
+			populateWorld(world, bodies_count);
+
+			BroadphaseSettings settings;
+			settings.method = method;
+
+			Broadphase broadphase;
+			broadphase.init(settings);
+
+			double build_ms = measureMilliseconds([&]() { broadphase.update(world, &job_system); });
+			double serial_pairs_ms = measureMilliseconds([&]() { broadphase.findPairs(world, pairs); });
+			double parallel_pairs_ms = measureMilliseconds([&]() { broadphase.findPairs(world, pairs, &job_system); });
+			size_t pairs_count = pairs.size();
+
+			sortPairs(pairs);
+			if (!has_reference_pairs) {
+				reference_pairs = pairs;
+				has_reference_pairs = true;
+			}
+			else if (!isSamePairs(pairs, reference_pairs)) {
+				fprintf(stderr, "broadphase %s found %zu pairs for %zu bodies, expected %zu.\n", Broadphase::getMethodName(method), pairs_count,
+					bodies_count, reference_pairs.size());
+				success = false;
+			}
+
+			// Refit after small steps, the tree only reinserts the bodies that left their fat boxes.
+			double refit_ms = 0.0;
+			uint64_t reinserted_count = 0;
+			for (uint32_t step = 0; step < REFIT_STEPS_COUNT; step++) {
+				world.step(STEP_DT, IntegrationMethod::SEMI_IMPLICIT_EULER, job_system);
+				refit_ms += measureMilliseconds([&]() { broadphase.update(world, &job_system); });
+
+				if (method == BroadphaseMethod::DYNAMIC_TREE) {
+					reinserted_count += broadphase.getDynamicTree().getReinsertedCount();
+				}
+			}
+
+			refit_ms /= REFIT_STEPS_COUNT;
+
+			double pairs_per_second = static_cast<double>(pairs_count) * 1000.0 / std::max(parallel_pairs_ms, 1e-6);
+
+			printf("broadphase %s bodies:%zu pairs:%zu build %.3f ms refit %.3f ms (%llu reinserted) pairs %.3f ms serial %.3f ms parallel "
+				"%.2f M pairs/s\n", Broadphase::getMethodName(method), bodies_count, pairs_count, build_ms, refit_ms,
+				static_cast<unsigned long long>(reinserted_count / REFIT_STEPS_COUNT), serial_pairs_ms, parallel_pairs_ms,
+				pairs_per_second / 1e6);
+
+			json.beginObject();
+			json.write("method", Broadphase::getMethodName(method));
+			json.write("bodies", static_cast<uint64_t>(bodies_count));
+			json.write("threads", static_cast<uint64_t>(job_system.getThreadsCount()));
+			json.write("pairs", static_cast<uint64_t>(pairs_count));
+			json.write("build_ms", build_ms);
+			json.write("refit_ms", refit_ms);
+			json.write("reinserted_per_step", reinserted_count / REFIT_STEPS_COUNT);
+			json.write("serial_pairs_ms", serial_pairs_ms);
+			json.write("parallel_pairs_ms", parallel_pairs_ms);
+			json.write("pairs_per_second", pairs_per_second);
+			json.endObject();
+		}
+	}
+
+	json.endArray();
+
+	job_system.stop();
+	return success;
+}
@@ -0,0 +1,112 @@
+#include "instrumentation_benchmark.h"
+#include "../instrumentation.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace Simulator;
+
+static constexpr uint64_t ITERATIONS_PER_MESSAGE = 10;
+
+enum class InstrumentationBenchmarkKind {
+	BASELINE,
+	SCOPE,
+	COUNTER
+};
+
+static void runInstrumentedLoop(InstrumentationBenchmarkKind kind, uint64_t iterations_count, const std::atomic<bool>& start_flag,
+	uint64_t& out_elapsed_ns)
+{
+	while (!start_flag.load(std::memory_order_acquire)) {
+		std::this_thread::yield();
+	}
+
+	volatile uint64_t sink = 0;
+	auto start_time = std::chrono::steady_clock::now();
+
+	for (uint64_t i = 0; i < iterations_count; i++) {
+		if (kind == InstrumentationBenchmarkKind::SCOPE) {
+			SIMULATOR_SCOPE_TIMER("benchmark scope");
+			sink = sink + i;
+		}
+		else if (kind == InstrumentationBenchmarkKind::COUNTER) {
+			SIMULATOR_COUNTER_ADD("benchmark counter", 1);
+			sink = sink + i;
+		}
+		else {
+			sink = sink + i;
+		}
+	}
+
+	out_elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+static double runInstrumentationBenchmarkPass(InstrumentationBenchmarkKind kind, uint64_t iterations_count, uint32_t threads_count)
+{
+	std::atomic<bool> start_flag = false;
+	std::vector<uint64_t> elapsed_ns(threads_count, 0);
+	std::vector<std::thread> threads;
+
+	for (uint32_t i = 0; i < threads_count; i++) {
+		threads.emplace_back(runInstrumentedLoop, kind, iterations_count, std::cref(start_flag), std::ref(elapsed_ns[i]));
+	}
+
+	start_flag.store(true, std::memory_order_release);
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	uint64_t total_elapsed_ns = 0;
+	for (uint64_t thread_elapsed_ns : elapsed_ns) {
+		total_elapsed_ns += thread_elapsed_ns;
+	}
+
+	return static_cast<double>(total_elapsed_ns) / static_cast<double>(threads_count * iterations_count);
+}
+
+bool Simulator::runInstrumentationBenchmark(const BenchmarkOptions& options, JsonWriter& json)
+{
+	InstrumentationSettings settings;
+	settings.aggregation_interval = std::chrono::milliseconds(1);
+	Instrumentation::start(settings);
+
+	uint64_t iterations_count = options.messages_count * ITERATIONS_PER_MESSAGE;
+
+	std::vector<uint32_t> threads_counts;
+	for (uint32_t threads_count = 1; threads_count < options.max_threads_count; threads_count *= 2) {
+		threads_counts.push_back(threads_count);
+	}
+
+	threads_counts.push_back(options.max_threads_count);
+
+	json.beginArray("instrumentation");
+
+	for (uint32_t threads_count : threads_counts) {
+		uint64_t dropped_events_count = Instrumentation::getDroppedEventsCount();
+
+		double baseline_ns = runInstrumentationBenchmarkPass(InstrumentationBenchmarkKind::BASELINE, iterations_count, threads_count);
+		double scope_ns = runInstrumentationBenchmarkPass(InstrumentationBenchmarkKind::SCOPE, iterations_count, threads_count) - baseline_ns;
+		double counter_ns = runInstrumentationBenchmarkPass(InstrumentationBenchmarkKind::COUNTER, iterations_count, threads_count) - baseline_ns;
+
+		dropped_events_count = Instrumentation::getDroppedEventsCount() - dropped_events_count;
+
+		printf("instrumentation threads:%u iterations:%llu scope %.2f ns counter %.2f ns dropped:%llu\n", threads_count,
+			static_cast<unsigned long long>(iterations_count), scope_ns, counter_ns, static_cast<unsigned long long>(dropped_events_count));
+
+		json.beginObject();
+		json.write("threads", static_cast<uint64_t>(threads_count));
+		json.write("iterations", iterations_count);
+		json.write("scope_ns", scope_ns);
+		json.write("counter_ns", counter_ns);
+		json.write("dropped_events", dropped_events_count);
+		json.endObject();
+	}
+
+	json.endArray();
+
+	Instrumentation::stop();
+	return true;
+}
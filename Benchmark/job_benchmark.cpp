@@ -0,0 +1,149 @@
+#include "job_benchmark.h"
+#include "../job_system.h"
+#include "../world.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace Simulator;
+
+static constexpr size_t PARALLEL_FOR_ITEMS_COUNT = 1 << 22;
+static constexpr size_t PARALLEL_FOR_CHUNK_SIZE = 1024;
+static constexpr uint32_t PARALLEL_FOR_REPEATS_COUNT = 8;
+static constexpr size_t WORLD_BODIES_COUNT = 1000000;
+static constexpr uint32_t WORLD_STEPS_COUNT = 20;
+static constexpr float WORLD_STEP_DT = 1.0f / 60.0f;
+
+struct JobScalingResult {
+	uint32_t threads_count = 0;
+	double empty_job_ns = 0.0;
+	double parallel_for_ms = 0.0;
+	double world_step_ms = 0.0;
+	uint64_t stolen_jobs_count = 0;
+};
+
+template<typename Function>
+static double measureMilliseconds(Function function)
+{
+	auto start_time = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+static double runEmptyJobs(JobSystem& job_system, uint64_t jobs_count)
+{
+	std::atomic<uint64_t> executed_jobs_count = 0;
+	JobCounter counter;
+
+	double elapsed_ms = measureMilliseconds([&]()
+		{
+			for (uint64_t i = 0; i < jobs_count; i++) {
+				job_system.schedule([&executed_jobs_count]() { executed_jobs_count.fetch_add(1, std::memory_order_relaxed); }, &counter);
+			}
+
+			job_system.wait(counter);
+		});
+
+	return elapsed_ms * 1e6 / static_cast<double>(jobs_count);
+}
+
+static double runParallelFor(JobSystem& job_system, std::vector<float>& values)
+{
+	return measureMilliseconds([&]()
+		{
+			for (uint32_t repeat = 0; repeat < PARALLEL_FOR_REPEATS_COUNT; repeat++) {
+				job_system.parallelFor(values.size(), PARALLEL_FOR_CHUNK_SIZE, [&values](size_t begin, size_t end)
+					{
+						for (size_t i = begin; i < end; i++) {
+							values[i] = std::sqrt(values[i] * 0.5f + 1.0f);
+						}
+					});
+			}
+		}) / PARALLEL_FOR_REPEATS_COUNT;
+}
+
+static double runWorldSteps(JobSystem& job_system, World& world)
+{
+	return measureMilliseconds([&]()
+		{
+			for (uint32_t step = 0; step < WORLD_STEPS_COUNT; step++) {
+				world.step(WORLD_STEP_DT, IntegrationMethod::SEMI_IMPLICIT_EULER, job_system);
+			}
+		}) / WORLD_STEPS_COUNT;
+}
+
+bool Simulator::runJobBenchmark(const BenchmarkOptions& options, JsonWriter& json)
+{
+	std::vector<uint32_t> threads_counts;
+	for (uint32_t threads_count = 1; threads_count < options.max_threads_count; threads_count *= 2) {
+		threads_counts.push_back(threads_count);
+	}
+
+	threads_counts.push_back(options.max_threads_count);
+
+	std::vector<float> values(PARALLEL_FOR_ITEMS_COUNT, 1.0f);
+
+	World world;
+	world.reserve(WORLD_BODIES_COUNT);
+	for (size_t i = 0; i < WORLD_BODIES_COUNT; i++) {
+		float offset = static_cast<float>(i % 1000);
+		world.addBody(offset, offset * 0.5f, -offset, 1.0f, 2.0f, 3.0f, 1.0f, 0.5f);
+	}
+
+	std::vector<JobScalingResult> results;
+
+	for (uint32_t threads_count : threads_counts) {
+		// The benchmark thread helps in wait(), so it counts as one of the threads.
+		JobSystemSettings settings;
+		settings.workers_count = threads_count - 1;
+
+		JobSystem job_system;
+		std::string out_error_message;
+		if (!job_system.start(settings, out_error_message)) {
+			fprintf(stderr, "%s\n", out_error_message.c_str());
+			return false;
+		}
+
+		JobScalingResult result;
+		result.threads_count = threads_count;
+		result.empty_job_ns = runEmptyJobs(job_system, options.messages_count);
+		result.parallel_for_ms = runParallelFor(job_system, values);
+		result.world_step_ms = runWorldSteps(job_system, world);
+		result.stolen_jobs_count = job_system.getStats().stolen_jobs_count;
+		results.push_back(result);
+
+		job_system.stop();
+	}
+
+	json.beginArray("jobs");
+
+	for (const JobScalingResult& result : results) {
+		double parallel_for_speedup = results.front().parallel_for_ms / std::max(result.parallel_for_ms, 1e-6);
+		double world_speedup = results.front().world_step_ms / std::max(result.world_step_ms, 1e-6);
+		double world_bodies_per_second = static_cast<double>(WORLD_BODIES_COUNT) * 1000.0 / std::max(result.world_step_ms, 1e-6);
+
+		printf("jobs threads:%u empty job %.1f ns parallel for %.3f ms (x%.2f, %.0f%%) world step %.3f ms (x%.2f, %.2f M bodies/s) stolen:%llu\n",
+			result.threads_count, result.empty_job_ns, result.parallel_for_ms, parallel_for_speedup,
+			parallel_for_speedup * 100.0 / result.threads_count, result.world_step_ms, world_speedup, world_bodies_per_second / 1e6,
+			static_cast<unsigned long long>(result.stolen_jobs_count));
+
+		json.beginObject();
+		json.write("threads", static_cast<uint64_t>(result.threads_count));
+		json.write("empty_job_ns", result.empty_job_ns);
+		json.write("parallel_for_ms", result.parallel_for_ms);
+		json.write("parallel_for_speedup", parallel_for_speedup);
+		json.write("parallel_for_efficiency", parallel_for_speedup / result.threads_count);
+		json.write("world_step_ms", result.world_step_ms);
+		json.write("world_speedup", world_speedup);
+		json.write("world_bodies_per_second", world_bodies_per_second);
+		json.write("stolen_jobs", result.stolen_jobs_count);
+		json.endObject();
+	}
+
+	json.endArray();
+
+	return true;
+}
@@ -0,0 +1,98 @@
+#include "json_writer.h"
+#include <cstdio>
+
+using namespace Simulator;
+
+void JsonWriter::beginObject(std::string_view key)
+{
+	writeKey(key);
+	m_text += '{';
+	m_scope_has_items.push_back(false);
+}
+
+void JsonWriter::endObject()
+{
+	m_scope_has_items.pop_back();
+	m_text += '}';
+}
+
+void JsonWriter::beginArray(std::string_view key)
+{
+	writeKey(key);
+	m_text += '[';
+	m_scope_has_items.push_back(false);
+}
+
+void JsonWriter::endArray()
+{
+	m_scope_has_items.pop_back();
+	m_text += ']';
+}
+
+void JsonWriter::write(std::string_view key, std::string_view value)
+{
+	writeKey(key);
+	writeString(value);
+}
+
+void JsonWriter::write(std::string_view key, const char* value)
+{
+	write(key, std::string_view(value));
+}
+
+void JsonWriter::write(std::string_view key, uint64_t value)
+{
+	writeKey(key);
+	m_text += std::to_string(value);
+}
+
+void JsonWriter::write(std::string_view key, double value)
+{
+	char number[64];
+	snprintf(number, sizeof(number), "%.6g", value);
+	writeKey(key);
+	m_text += number;
+}
+
+const std::string& JsonWriter::getText() const
+{
+	return m_text;
+}
+
+void JsonWriter::writeKey(std::string_view key)
+{
+	if (!m_scope_has_items.empty()) {
+		if (m_scope_has_items.back()) {
+			m_text += ',';
+		}
+
+		m_scope_has_items.back() = true;
+	}
+
+	if (!key.empty()) {
+		writeString(key);
+		m_text += ':';
+	}
+}
+
+void JsonWriter::writeString(std::string_view value)
+{
+	m_text += '"';
+
+	for (char c : value) {
+		if ((c == '"') || (c == '\\')) {
+			m_text += '\\';
+			m_text += c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20) {
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+			m_text += escaped;
+		}
+		else {
+			m_text += c;
+		}
+	}
+
+	m_text += '"';
+}
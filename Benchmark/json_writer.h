@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace Simulator {
+	class JsonWriter {
+	public:
+		void beginObject(std::string_view key = {});
+		void endObject();
+		void beginArray(std::string_view key);
+		void endArray();
+		void write(std::string_view key, std::string_view value);
+		void write(std::string_view key, const char* value);
+		void write(std::string_view key, uint64_t value);
+		void write(std::string_view key, double value);
+		const std::string& getText() const;
+
+	private:
+		void writeKey(std::string_view key);
+		void writeString(std::string_view value);
+
+		std::string m_text;
+		std::vector<bool> m_scope_has_items;
+	};
+}
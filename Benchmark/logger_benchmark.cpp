@@ -0,0 +1,327 @@
+#include "logger_benchmark.h"
+#include "../log_record.h"
+#include "../logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Simulator;
+
+static constexpr size_t MESSAGES_VARIANTS_COUNT = 4096;
+static constexpr std::chrono::milliseconds DRAIN_TIMEOUT{ 60000 };
+
+static std::vector<std::string> createMessages(uint32_t seed)
+{
+	static constexpr char CHARACTERS[] = "abcdefghijklmnopqrstuvwxyz0123456789 ";
+
+	std::mt19937 generator(seed);
+	std::uniform_int_distribution<int> kind_distribution(0, 99);
+	std::uniform_int_distribution<size_t> short_size_distribution(32, 96);
+	std::uniform_int_distribution<size_t> medium_size_distribution(96, 320);
+	std::uniform_int_distribution<size_t> long_size_distribution(320, 1536);
+	std::uniform_int_distribution<size_t> character_distribution(0, sizeof(CHARACTERS) - 2);
+
+	std::vector<std::string> messages(MESSAGES_VARIANTS_COUNT);
+
+	for (std::string& message : messages) {
+		int kind = kind_distribution(generator);
+		size_t size = (kind < 70) ? short_size_distribution(generator) :
+			((kind < 95) ? medium_size_distribution(generator) : long_size_distribution(generator));
+
+		message.resize(size);
+		for (char& c : message) {
+			c = CHARACTERS[character_distribution(generator)];
+		}
+	}
+
+	return messages;
+}
+
+static uint64_t getPercentile(const std::vector<uint64_t>& sorted_values, double percentile)
+{
+	if (sorted_values.empty()) {
+		return 0;
+	}
+
+	size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sorted_values.size())));
+	rank = std::clamp<size_t>(rank, 1, sorted_values.size());
+	return sorted_values[rank - 1];
+}
+
+static void runProducer(Logger& logger, const std::vector<std::string>& messages, uint64_t messages_count, size_t first_message_idx,
+	const std::atomic<bool>& start_flag, std::vector<uint64_t>& out_latencies)
+{
+	out_latencies.resize(messages_count);
+
+	while (!start_flag.load(std::memory_order_acquire)) {
+		std::this_thread::yield();
+	}
+
+	for (uint64_t i = 0; i < messages_count; i++) {
+		const std::string& message = messages[(first_message_idx + i) % messages.size()];
+
+		auto start_time = std::chrono::steady_clock::now();
+		logger.logWrite(message);
+		auto end_time = std::chrono::steady_clock::now();
+
+		out_latencies[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+	}
+}
+
+struct RoundTripCase {
+	const char* expected_text;
+	char record[256];
+	size_t record_size;
+};
+
+// Records decoded by LogDecoder have to read exactly like the text the logger writes, so every argument type is checked.
+static bool verifyLogRecordRoundTrip(JsonWriter& json)
+{
+	RoundTripCase cases[] = {
+		{ "[ERROR] Unhandled exception 0xC0000005 at address 0x7FF612345678." },
+		{ "[LAYER] Message 0x00001A2B repeated 42 times." },
+		{ "[WARNING] Logger dropped 18446744073709551615 messages." },
+		{ "[INFO] Rendered 120 headless frames in 2.500000 s (48.000000 frames/s)." },
+		{ "[ERROR] Failed to register main window class. Windows error:-5" },
+		{ "[ERROR] Failed to create output directory. \"out {x}\" is not a directory." },
+		{ "" }
+	};
+
+	cases[0].record_size = encodeLogRecord(cases[0].record, sizeof(cases[0].record), LogFormat::UNHANDLED_EXCEPTION, LogLevel::ERR, 1,
+		0xC0000005ul, reinterpret_cast<const void*>(0x7FF612345678ull));
+	cases[1].record_size = encodeLogRecord(cases[1].record, sizeof(cases[1].record), LogFormat::VULKAN_LAYER_MESSAGE_REPEATED, LogLevel::VERBOSE, 2,
+		0x1A2Bu, 42u);
+	cases[2].record_size = encodeLogRecord(cases[2].record, sizeof(cases[2].record), LogFormat::LOGGER_DROPPED_MESSAGES, LogLevel::WARNING, 3,
+		UINT64_MAX);
+	cases[3].record_size = encodeLogRecord(cases[3].record, sizeof(cases[3].record), LogFormat::HEADLESS_FRAMES_RENDERED, LogLevel::INFO, 4,
+		120ull, 2.5, 48.0);
+	cases[4].record_size = encodeLogRecord(cases[4].record, sizeof(cases[4].record), LogFormat::MAIN_WINDOW_CLASS_REGISTRATION_FAILED,
+		LogLevel::ERR, 5, -5);
+	cases[5].record_size = encodeLogRecord(cases[5].record, sizeof(cases[5].record), LogFormat::OUTPUT_DIRECTORY_CREATION_FAILED, LogLevel::ERR,
+		6, "\"out {x}\" is not a directory.");
+	cases[6].record_size = encodeLogRecord(cases[6].record, sizeof(cases[6].record), LogFormat::RAW_TEXT, LogLevel::INFO, 7, "");
+
+	uint64_t checked_records_count = 0;
+	for (const RoundTripCase& round_trip_case : cases) {
+		char text[256];
+		size_t record_size = getLogRecordSize(round_trip_case.record, round_trip_case.record_size);
+		size_t text_size = formatLogRecord(round_trip_case.record, record_size, text, sizeof(text));
+
+		if ((record_size != round_trip_case.record_size) || (text_size != strlen(round_trip_case.expected_text)) ||
+			(memcmp(text, round_trip_case.expected_text, text_size) != 0)) {
+			fprintf(stderr, "Log record round trip mismatch: \"%.*s\", expected \"%s\".\n", static_cast<int>(text_size), text,
+				round_trip_case.expected_text);
+			return false;
+		}
+
+		checked_records_count++;
+	}
+
+	printf("logger round trip: %llu records decoded as written\n", static_cast<unsigned long long>(checked_records_count));
+	json.write("logger_round_trip_records", checked_records_count);
+	return true;
+}
+
+static void runStopProducer(Logger& logger, const std::vector<std::string>& messages, size_t first_message_idx,
+	const std::atomic<bool>& stop_flag)
+{
+	for (size_t i = first_message_idx; !stop_flag.load(std::memory_order_acquire); i++) {
+		logger.logWrite(messages[i % messages.size()]);
+	}
+}
+
+// Stopping while producers write must not lose a record silently, every accepted record is either written or counted as dropped.
+static bool verifyStopUnderLoad(const std::vector<std::string>& messages, JsonWriter& json)
+{
+	static constexpr uint32_t RUNS_COUNT = 300;
+	static constexpr uint32_t THREADS_COUNT = 3;
+
+	LoggerSettings settings;
+	settings.ring_capacity = 64;
+	settings.segment_size = 1024 * 1024;
+	settings.max_segments = 2;
+
+	uint64_t accepted_records_count = 0;
+	uint64_t dropped_messages_count = 0;
+
+	for (uint32_t run = 0; run < RUNS_COUNT; run++) {
+		Logger logger;
+		std::string out_error_message;
+		if (!logger.start("benchmark_log.txt", out_error_message, settings)) {
+			fprintf(stderr, "Failed to start logger. %s\n", out_error_message.c_str());
+			return false;
+		}
+
+		std::atomic<bool> stop_flag = false;
+		std::vector<std::thread> threads;
+
+		for (uint32_t i = 0; i < THREADS_COUNT; i++) {
+			threads.emplace_back(runStopProducer, std::ref(logger), std::cref(messages), (i * MESSAGES_VARIANTS_COUNT) / THREADS_COUNT,
+				std::cref(stop_flag));
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(200 + (run % 8) * 100));
+		logger.requestStop();
+		logger.waitForStop();
+
+		stop_flag.store(true, std::memory_order_release);
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		// The logger's own dropped messages record is written too, or counted as dropped when it does not fit.
+		LoggerStats stats = logger.getStats();
+		uint64_t written_records_count = stats.written_records_count - ((stats.dropped_messages_count > 0) ? 1 : 0);
+
+		if (written_records_count + stats.dropped_messages_count != stats.accepted_records_count) {
+			fprintf(stderr, "Logger stop lost records: %llu accepted, %llu written, %llu dropped.\n",
+				static_cast<unsigned long long>(stats.accepted_records_count), static_cast<unsigned long long>(written_records_count),
+				static_cast<unsigned long long>(stats.dropped_messages_count));
+			return false;
+		}
+
+		accepted_records_count += stats.accepted_records_count;
+		dropped_messages_count += stats.dropped_messages_count;
+	}
+
+	printf("logger stop under load: %u runs, %llu records accepted, %llu dropped, none lost\n", RUNS_COUNT,
+		static_cast<unsigned long long>(accepted_records_count), static_cast<unsigned long long>(dropped_messages_count));
+	json.beginObject("logger_stop_under_load");
+	json.write("runs", static_cast<uint64_t>(RUNS_COUNT));
+	json.write("accepted_records", accepted_records_count);
+	json.write("dropped_messages", dropped_messages_count);
+	json.endObject();
+	return true;
+}
+
+static bool runLoggerBenchmarkPass(const BenchmarkOptions& options, const std::vector<std::string>& messages, uint32_t threads_count,
+	JsonWriter& json)
+{
+	LoggerSettings settings;
+	settings.max_segments = 2;
+
+	Logger logger;
+	std::string out_error_message;
+	if (!logger.start("benchmark_log.txt", out_error_message, settings)) {
+		fprintf(stderr, "Failed to start logger. %s\n", out_error_message.c_str());
+		return false;
+	}
+
+	std::atomic<bool> start_flag = false;
+	std::vector<std::vector<uint64_t>> thread_latencies(threads_count);
+	std::vector<std::thread> threads;
+
+	for (uint32_t i = 0; i < threads_count; i++) {
+		threads.emplace_back(runProducer, std::ref(logger), std::cref(messages), options.messages_count,
+			(i * MESSAGES_VARIANTS_COUNT) / threads_count, std::cref(start_flag), std::ref(thread_latencies[i]));
+	}
+
+	auto start_time = std::chrono::steady_clock::now();
+	start_flag.store(true, std::memory_order_release);
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	auto produced_time = std::chrono::steady_clock::now();
+
+	if (!logger.flush(DRAIN_TIMEOUT)) {
+		fprintf(stderr, "Logger did not drain in time.\n");
+		return false;
+	}
+
+	auto drained_time = std::chrono::steady_clock::now();
+	LoggerStats stats = logger.getStats();
+	logger.requestStop();
+	logger.waitForStop();
+
+	std::vector<uint64_t> latencies;
+	latencies.reserve(threads_count * options.messages_count);
+	for (const std::vector<uint64_t>& values : thread_latencies) {
+		latencies.insert(latencies.end(), values.begin(), values.end());
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+
+	uint64_t messages_count = threads_count * options.messages_count;
+	double produce_seconds = std::chrono::duration<double>(produced_time - start_time).count();
+	double total_seconds = std::chrono::duration<double>(drained_time - start_time).count();
+	double messages_per_second = static_cast<double>(messages_count) / total_seconds;
+	double produce_messages_per_second = static_cast<double>(messages_count) / produce_seconds;
+	double drain_messages_per_second = (stats.drain_time_ns > 0) ?
+		(static_cast<double>(stats.written_records_count) * 1e9 / static_cast<double>(stats.drain_time_ns)) : 0.0;
+
+	printf("logger threads:%u messages:%llu %.0f msg/s (producers %.0f msg/s, drain %.0f msg/s) "
+		"producer p50/p99/p99.9:%llu/%llu/%llu ns enqueue-to-sink p50/p99/p99.9:%llu/%llu/%llu ns dropped:%llu\n",
+		threads_count, static_cast<unsigned long long>(messages_count), messages_per_second, produce_messages_per_second, drain_messages_per_second,
+		static_cast<unsigned long long>(getPercentile(latencies, 50.0)),
+		static_cast<unsigned long long>(getPercentile(latencies, 99.0)),
+		static_cast<unsigned long long>(getPercentile(latencies, 99.9)),
+		static_cast<unsigned long long>(stats.sink_latency_p50_ns),
+		static_cast<unsigned long long>(stats.sink_latency_p99_ns),
+		static_cast<unsigned long long>(stats.sink_latency_p999_ns),
+		static_cast<unsigned long long>(stats.dropped_messages_count));
+
+	json.beginObject();
+	json.write("threads", static_cast<uint64_t>(threads_count));
+	json.write("messages", messages_count);
+	json.write("messages_per_second", messages_per_second);
+	json.write("producer_messages_per_second", produce_messages_per_second);
+	json.write("drain_messages_per_second", drain_messages_per_second);
+	json.write("written_bytes", stats.written_bytes_count);
+	json.write("dropped_messages", stats.dropped_messages_count);
+	json.beginObject("producer_latency_ns");
+	json.write("p50", getPercentile(latencies, 50.0));
+	json.write("p99", getPercentile(latencies, 99.0));
+	json.write("p999", getPercentile(latencies, 99.9));
+	json.write("max", latencies.empty() ? 0 : latencies.back());
+	json.endObject();
+	json.beginObject("enqueue_to_sink_latency_ns");
+	json.write("p50", stats.sink_latency_p50_ns);
+	json.write("p99", stats.sink_latency_p99_ns);
+	json.write("p999", stats.sink_latency_p999_ns);
+	json.write("max", stats.sink_latency_max_ns);
+	json.endObject();
+	json.endObject();
+	return true;
+}
+
+bool Simulator::runLoggerBenchmark(const BenchmarkOptions& options, JsonWriter& json)
+{
+	if (!verifyLogRecordRoundTrip(json)) {
+		return false;
+	}
+
+	std::vector<std::string> messages = createMessages(1);
+	if (!verifyStopUnderLoad(messages, json)) {
+		return false;
+	}
+
+	bool success = true;
+
+	std::vector<uint32_t> threads_counts;
+	for (uint32_t threads_count = 1; threads_count < options.max_threads_count; threads_count *= 2) {
+		threads_counts.push_back(threads_count);
+	}
+
+	threads_counts.push_back(options.max_threads_count);
+
+	json.beginArray("logger");
+
+	for (uint32_t threads_count : threads_counts) {
+		if (!runLoggerBenchmarkPass(options, messages, threads_count, json)) {
+			success = false;
+			break;
+		}
+	}
+
+	json.endArray();
+	return success;
+}
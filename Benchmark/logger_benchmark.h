@@ -0,0 +1,8 @@
+#pragma once
+
+#include "benchmark_options.h"
+#include "json_writer.h"
+
+namespace Simulator {
+	bool runLoggerBenchmark(const BenchmarkOptions& options, JsonWriter& json);
+}
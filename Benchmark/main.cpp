@@ -0,0 +1,113 @@
+#include "benchmark_options.h"
+#include "broadphase_benchmark.h"
+#include "instrumentation_benchmark.h"
+#include "job_benchmark.h"
+#include "json_writer.h"
+#include "logger_benchmark.h"
+#include "memory_benchmark.h"
+#include "world_benchmark.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+
+static void printUsage()
+{
+	fprintf(stderr, "Usage: Benchmark [--suite all|logger|instrumentation|jobs|world|broadphase|memory] [--threads N] [--messages N] [--bodies N] [--output results.json]\n");
+}
+
+int main(int argc, char* argv[])
+{
+	Simulator::BenchmarkOptions options;
+	unsigned hardware_threads_count = std::thread::hardware_concurrency();
+	options.max_threads_count = ((hardware_threads_count > 0) && (hardware_threads_count < options.max_threads_count)) ?
+		hardware_threads_count : options.max_threads_count;
+
+	std::string suite = "all";
+	std::string output_file_name = "benchmark_results.json";
+
+	for (int i = 1; i < argc; i++) {
+		bool has_value = (i + 1) < argc;
+
+		if ((strcmp(argv[i], "--suite") == 0) && has_value) {
+			suite = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--threads") == 0) && has_value) {
+			options.max_threads_count = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if ((strcmp(argv[i], "--messages") == 0) && has_value) {
+			options.messages_count = strtoull(argv[++i], nullptr, 10);
+		}
+		else if ((strcmp(argv[i], "--bodies") == 0) && has_value) {
+			options.max_bodies_count = strtoull(argv[++i], nullptr, 10);
+		}
+		else if ((strcmp(argv[i], "--output") == 0) && has_value) {
+			output_file_name = argv[++i];
+		}
+		else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if ((options.max_threads_count == 0) || (options.messages_count == 0) || (options.max_bodies_count == 0)) {
+		printUsage();
+		return 1;
+	}
+
+	Simulator::JsonWriter json;
+	bool success = true;
+	bool suite_found = false;
+
+	json.beginObject();
+
+	if ((suite == "all") || (suite == "logger")) {
+		suite_found = true;
+		success = Simulator::runLoggerBenchmark(options, json) && success;
+	}
+
+	if ((suite == "all") || (suite == "instrumentation")) {
+		suite_found = true;
+		success = Simulator::runInstrumentationBenchmark(options, json) && success;
+	}
+
+	if ((suite == "all") || (suite == "jobs")) {
+		suite_found = true;
+		success = Simulator::runJobBenchmark(options, json) && success;
+	}
+
+	if ((suite == "all") || (suite == "world")) {
+		suite_found = true;
+		success = Simulator::runWorldBenchmark(options, json) && success;
+	}
+
+	if ((suite == "all") || (suite == "broadphase")) {
+		suite_found = true;
+		success = Simulator::runBroadphaseBenchmark(options, json) && success;
+	}
+
+	if ((suite == "all") || (suite == "memory")) {
+		suite_found = true;
+		success = Simulator::runMemoryBenchmark(options, json) && success;
+	}
+
+	json.endObject();
+
+	if (!suite_found) {
+		printUsage();
+		return 1;
+	}
+
+	std::ofstream output(output_file_name, std::ofstream::out | std::ofstream::trunc);
+	if (!output.is_open()) {
+		fprintf(stderr, "Failed to create results file \"%s\".\n", output_file_name.c_str());
+		return 1;
+	}
+
+	output << json.getText() << '\n';
+	output.close();
+
+	return (success && output.good()) ? 0 : 1;
+}
@@ -0,0 +1,299 @@
+#include "memory_benchmark.h"
+#include "../memory_allocator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace Simulator;
+
+static constexpr VkDeviceSize DEFRAGMENTATION_ALLOCATION_SIZE = 1024 * 1024;
+static constexpr uint32_t DEFRAGMENTATION_BLOCKS_COUNT = 3;
+// Every third allocation is kept, so the survivors of three full blocks fit in one.
+static constexpr uint32_t DEFRAGMENTATION_KEPT_INTERVAL = 3;
+
+struct VulkanDevice {
+	VkInstance instance = VK_NULL_HANDLE;
+	VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+	VkDevice logical_device = VK_NULL_HANDLE;
+
+	~VulkanDevice()
+	{
+		if (logical_device != VK_NULL_HANDLE) {
+			vkDestroyDevice(logical_device, nullptr);
+		}
+
+		if (instance != VK_NULL_HANDLE) {
+			vkDestroyInstance(instance, nullptr);
+		}
+	}
+};
+
+static bool createDevice(VulkanDevice& out_device, std::string& out_error_message)
+{
+	if (volkInitialize() != VK_SUCCESS) {
+		out_error_message = "Vulkan not found on this system.";
+		return false;
+	}
+
+	VkApplicationInfo app_info{};
+	app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	app_info.pNext = nullptr;
+	app_info.pApplicationName = nullptr;
+	app_info.applicationVersion = 0;
+	app_info.pEngineName = nullptr;
+	app_info.engineVersion = 0;
+	app_info.apiVersion = VK_MAKE_API_VERSION(0, 1, 3, 0);
+
+	VkInstanceCreateInfo inst_info{};
+	inst_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	inst_info.pNext = nullptr;
+	inst_info.flags = 0;
+	inst_info.pApplicationInfo = &app_info;
+	inst_info.enabledLayerCount = 0;
+	inst_info.ppEnabledLayerNames = nullptr;
+	inst_info.enabledExtensionCount = 0;
+	inst_info.ppEnabledExtensionNames = nullptr;
+
+	VkResult vk_error = vkCreateInstance(&inst_info, nullptr, &out_device.instance);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan instance. VK error:" + std::to_string(vk_error) + ".";
+		out_device.instance = VK_NULL_HANDLE;
+		return false;
+	}
+
+	volkLoadInstance(out_device.instance);
+
+	uint32_t physical_devices_count = 1;
+	vk_error = vkEnumeratePhysicalDevices(out_device.instance, &physical_devices_count, &out_device.physical_device);
+	if (((vk_error != VK_SUCCESS) && (vk_error != VK_INCOMPLETE)) || (physical_devices_count == 0)) {
+		out_error_message = "No Vulkan physical device found.";
+		return false;
+	}
+
+	float queue_priority = 1.0f;
+
+	VkDeviceQueueCreateInfo device_queue_create_info{};
+	device_queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	device_queue_create_info.pNext = nullptr;
+	device_queue_create_info.flags = 0;
+	device_queue_create_info.queueFamilyIndex = 0;
+	device_queue_create_info.queueCount = 1;
+	device_queue_create_info.pQueuePriorities = &queue_priority;
+
+	VkDeviceCreateInfo device_create_info{};
+	device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	device_create_info.pNext = nullptr;
+	device_create_info.flags = 0;
+	device_create_info.queueCreateInfoCount = 1;
+	device_create_info.pQueueCreateInfos = &device_queue_create_info;
+	device_create_info.enabledLayerCount = 0;
+	device_create_info.ppEnabledLayerNames = nullptr;
+	device_create_info.enabledExtensionCount = 0;
+	device_create_info.ppEnabledExtensionNames = nullptr;
+	device_create_info.pEnabledFeatures = nullptr;
+
+	vk_error = vkCreateDevice(out_device.physical_device, &device_create_info, nullptr, &out_device.logical_device);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan logical device. VK error:" + std::to_string(vk_error) + ".";
+		out_device.logical_device = VK_NULL_HANDLE;
+		return false;
+	}
+
+	volkLoadDevice(out_device.logical_device);
+	return true;
+}
+
+static uint32_t getPattern(size_t allocation_idx)
+{
+	return static_cast<uint32_t>(allocation_idx) * 0x9E3779B9u + 1;
+}
+
+static bool hasPattern(const MemoryAllocation& allocation, uint32_t pattern)
+{
+	const uint32_t* words = static_cast<const uint32_t*>(allocation.mapped_data);
+	return std::all_of(words, words + allocation.size / sizeof(uint32_t), [pattern](uint32_t word) { return word == pattern; });
+}
+
+static uint32_t getBlocksCount(const MemoryAllocatorStats& stats)
+{
+	uint32_t blocks_count = 0;
+	for (const MemoryHeapStats& heap_stats : stats.heaps) {
+		blocks_count += heap_stats.blocks_count;
+	}
+
+	return blocks_count;
+}
+
+static VkDeviceSize getUsedSize(const MemoryAllocatorStats& stats)
+{
+	VkDeviceSize used_size = 0;
+	for (const MemoryHeapStats& heap_stats : stats.heaps) {
+		used_size += heap_stats.used_size;
+	}
+
+	return used_size;
+}
+
+// Fills three blocks, frees two allocations out of three and defragments. The survivors must end up in fewer blocks with their
+// contents intact, every move must start from a live allocation and no two allocations may overlap.
+static bool runDefragmentationCheck(const VulkanDevice& device, JsonWriter& json)
+{
+	VkPhysicalDeviceMemoryProperties memory_properties;
+	vkGetPhysicalDeviceMemoryProperties(device.physical_device, &memory_properties);
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device.physical_device, &properties);
+
+	MemoryAllocator allocator;
+	std::string out_error_message;
+	if (!allocator.init(device.logical_device, memory_properties, properties.limits, nullptr, out_error_message)) {
+		fprintf(stderr, "%s\n", out_error_message.c_str());
+		return false;
+	}
+
+	VkMemoryRequirements memory_requirements{};
+	memory_requirements.size = DEFRAGMENTATION_ALLOCATION_SIZE;
+	memory_requirements.alignment = MemoryAllocator::MIN_ALLOCATION_SIZE;
+	memory_requirements.memoryTypeBits = (1u << memory_properties.memoryTypeCount) - 1;
+
+	size_t allocations_count = static_cast<size_t>(DEFRAGMENTATION_BLOCKS_COUNT * MemoryAllocator::DEFAULT_BLOCK_SIZE / DEFRAGMENTATION_ALLOCATION_SIZE);
+	std::vector<MemoryAllocation> allocations(allocations_count);
+	std::vector<uint32_t> patterns(allocations_count);
+
+	for (size_t i = 0; i < allocations_count; i++) {
+		// Upload memory is mapped, so the contents can be checked from the host after the moves.
+		if (!allocator.allocate(memory_requirements, MemoryUsage::UPLOAD, MemoryResourceType::BUFFER, true, allocations[i], out_error_message)) {
+			fprintf(stderr, "%s\n", out_error_message.c_str());
+			return false;
+		}
+
+		patterns[i] = getPattern(i);
+		std::fill_n(static_cast<uint32_t*>(allocations[i].mapped_data), allocations[i].size / sizeof(uint32_t), patterns[i]);
+	}
+
+	std::vector<MemoryAllocation> kept_allocations;
+	std::vector<uint32_t> kept_patterns;
+	for (size_t i = 0; i < allocations_count; i++) {
+		if ((i % DEFRAGMENTATION_KEPT_INTERVAL) == 0) {
+			kept_allocations.push_back(allocations[i]);
+			kept_patterns.push_back(patterns[i]);
+		}
+		else {
+			allocator.free(allocations[i]);
+		}
+	}
+
+	MemoryAllocatorStats stats_before = allocator.getStats();
+
+	/**************************************************************************************/
+
+	bool success = true;
+	std::vector<MemoryDefragmentationMove> moves;
+
+	auto start_time = std::chrono::steady_clock::now();
+	allocator.beginDefragmentation(UINT32_MAX, moves);
+
+	for (const MemoryDefragmentationMove& move : moves) {
+		auto allocation_it = std::find_if(kept_allocations.begin(), kept_allocations.end(), [&move](const MemoryAllocation& allocation)
+			{
+				return (allocation.memory == move.src.memory) && (allocation.offset == move.src.offset);
+			});
+
+		if (allocation_it == kept_allocations.end()) {
+			fprintf(stderr, "memory defragmentation moves an allocation that is not live.\n");
+			success = false;
+			continue;
+		}
+
+		memcpy(move.dst.mapped_data, move.src.mapped_data, static_cast<size_t>(move.src.size));
+		*allocation_it = move.dst;
+	}
+
+	allocator.endDefragmentation(moves);
+	double defragmentation_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+	MemoryAllocatorStats stats_after = allocator.getStats();
+
+	/**************************************************************************************/
+
+	for (size_t i = 0; i < kept_allocations.size(); i++) {
+		if (!hasPattern(kept_allocations[i], kept_patterns[i])) {
+			fprintf(stderr, "memory allocation %zu lost its contents after defragmentation.\n", i);
+			success = false;
+		}
+	}
+
+	std::vector<MemoryAllocation> sorted_allocations = kept_allocations;
+	std::sort(sorted_allocations.begin(), sorted_allocations.end(), [](const MemoryAllocation& a, const MemoryAllocation& b)
+		{
+			return (a.memory != b.memory) ? std::less<VkDeviceMemory>()(a.memory, b.memory) : (a.offset < b.offset);
+		});
+
+	for (size_t i = 1; i < sorted_allocations.size(); i++) {
+		const MemoryAllocation& previous = sorted_allocations[i - 1];
+		if ((previous.memory == sorted_allocations[i].memory) && (previous.offset + previous.size > sorted_allocations[i].offset)) {
+			fprintf(stderr, "memory allocations overlap after defragmentation.\n");
+			success = false;
+		}
+	}
+
+	uint32_t blocks_before = getBlocksCount(stats_before);
+	uint32_t blocks_after = getBlocksCount(stats_after);
+	if ((blocks_before > 1) && (blocks_after >= blocks_before)) {
+		fprintf(stderr, "memory defragmentation kept %u blocks, expected fewer.\n", blocks_after);
+		success = false;
+	}
+
+	if (getUsedSize(stats_after) != getUsedSize(stats_before)) {
+		fprintf(stderr, "memory defragmentation changed the used size.\n");
+		success = false;
+	}
+
+	// Every move allocates its destination once and frees its source once.
+	if (stats_after.allocations_total_count - stats_after.frees_total_count != kept_allocations.size()) {
+		fprintf(stderr, "memory allocator counts %llu live allocations, expected %zu.\n",
+			static_cast<unsigned long long>(stats_after.allocations_total_count - stats_after.frees_total_count), kept_allocations.size());
+		success = false;
+	}
+
+	printf("memory defragmentation allocations:%zu kept:%zu moves:%zu blocks %u -> %u in %.3f ms %s\n", allocations_count, kept_allocations.size(),
+		moves.size(), blocks_before, blocks_after, defragmentation_ms, success ? "ok" : "FAILED");
+
+	json.beginObject();
+	json.write("test", "defragmentation");
+	json.write("allocations", static_cast<uint64_t>(allocations_count));
+	json.write("kept_allocations", static_cast<uint64_t>(kept_allocations.size()));
+	json.write("moves", static_cast<uint64_t>(moves.size()));
+	json.write("blocks_before", static_cast<uint64_t>(blocks_before));
+	json.write("blocks_after", static_cast<uint64_t>(blocks_after));
+	json.write("defragmentation_ms", defragmentation_ms);
+	json.write("valid", success ? "true" : "false");
+	json.endObject();
+
+	for (MemoryAllocation& allocation : kept_allocations) {
+		allocator.free(allocation);
+	}
+
+	allocator.destroy();
+	return success;
+}
+
+bool Simulator::runMemoryBenchmark(const BenchmarkOptions& options, JsonWriter& json)
+{
+	VulkanDevice device;
+	std::string out_error_message;
+	if (!createDevice(device, out_error_message)) {
+		fprintf(stderr, "%s\n", out_error_message.c_str());
+		return false;
+	}
+
+	json.beginArray("memory");
+	bool success = runDefragmentationCheck(device, json);
+	json.endArray();
+
+	return success;
+}
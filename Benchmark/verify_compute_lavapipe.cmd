@@ -0,0 +1,36 @@
+@echo off
+rem Runs --verify-compute on lavapipe, so the compute shader and the CPU World kernel are checked against each other without a GPU.
+rem Usage: verify_compute_lavapipe.cmd [Simulator.exe] [lvp_icd.x86_64.json]
+rem Exits with the simulator's exit code: non-zero when a particle is outside the tolerance or when the run fails.
+setlocal
+
+set SIMULATOR=%~1
+if "%SIMULATOR%"=="" set SIMULATOR=%~dp0..\bin\x64\Release\Simulator.exe
+
+set LAVAPIPE_ICD=%~2
+if "%LAVAPIPE_ICD%"=="" set LAVAPIPE_ICD=C:\mesa\lvp_icd.x86_64.json
+
+if not exist "%SIMULATOR%" (
+	echo Simulator not found: "%SIMULATOR%".
+	exit /b 1
+)
+
+if not exist "%LAVAPIPE_ICD%" (
+	echo lavapipe ICD not found: "%LAVAPIPE_ICD%".
+	exit /b 1
+)
+
+rem Only the lavapipe driver is loaded, so it is the only device the simulator can pick.
+set VK_DRIVER_FILES=%LAVAPIPE_ICD%
+set VK_ICD_FILENAMES=%LAVAPIPE_ICD%
+
+"%SIMULATOR%" --verify-compute --sim-bodies 100000
+set EXIT_CODE=%ERRORLEVEL%
+
+if not "%EXIT_CODE%"=="0" (
+	echo Compute verification on lavapipe failed with exit code %EXIT_CODE%.
+	exit /b %EXIT_CODE%
+)
+
+echo Compute verification on lavapipe passed.
+exit /b 0
@@ -0,0 +1,148 @@
+#include "world_benchmark.h"
+#include "../world.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace Simulator;
+
+static constexpr float STEP_DT = 1.0f / 60.0f;
+static constexpr uint64_t TARGET_BODY_UPDATES = 50000000;
+static constexpr uint64_t MIN_STEPS_COUNT = 3;
+static constexpr uint64_t MAX_STEPS_COUNT = 10000;
+static constexpr size_t VERIFY_BODIES_COUNT = 4099;
+static constexpr uint32_t VERIFY_STEPS_COUNT = 200;
+static constexpr float VERIFY_TOLERANCE = 1e-4f;
+
+static void populateWorld(World& world, size_t bodies_count)
+{
+	world.clear();
+	world.reserve(bodies_count);
+	world.setDamping(0.05f);
+
+	uint32_t seed = 0x9E3779B9u;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+	};
+
+	for (size_t i = 0; i < bodies_count; i++) {
+		float mass = ((i % 64) == 0) ? 0.0f : (0.5f + random() * 4.0f);
+		world.addBody(random() * 1000.0f, random() * 1000.0f, random() * 1000.0f, random() * 10.0f - 5.0f, random() * 10.0f - 5.0f,
+			random() * 10.0f - 5.0f, mass, 0.5f);
+	}
+}
+
+static float getMaxRelativeError(const float* values, const float* reference_values, size_t count)
+{
+	float max_error = 0.0f;
+	float max_magnitude = 1.0f;
+	for (size_t i = 0; i < count; i++) {
+		max_error = std::max(max_error, std::fabs(values[i] - reference_values[i]));
+		max_magnitude = std::max(max_magnitude, std::fabs(reference_values[i]));
+	}
+
+	return max_error / max_magnitude;
+}
+
+// Positions only, relative to the world extent: Verlet derives velocity from a position difference divided by dt,
+// which amplifies the last-ulp differences FMA introduces well past any useful tolerance.
+static float verifySimdPath(SimdPath path, IntegrationMethod method)
+{
+	World reference_world;
+	World world;
+	reference_world.setSimdPath(SimdPath::SCALAR);
+	world.setSimdPath(path);
+	populateWorld(reference_world, VERIFY_BODIES_COUNT);
+	populateWorld(world, VERIFY_BODIES_COUNT);
+
+	for (uint32_t step = 0; step < VERIFY_STEPS_COUNT; step++) {
+		uint32_t body_idx = (step * 31) % VERIFY_BODIES_COUNT;
+		reference_world.applyForce(body_idx, 100.0f, 50.0f, -25.0f);
+		world.applyForce(body_idx, 100.0f, 50.0f, -25.0f);
+		reference_world.step(STEP_DT, method);
+		world.step(STEP_DT, method);
+	}
+
+	return std::max({ getMaxRelativeError(world.getPositionsX(), reference_world.getPositionsX(), VERIFY_BODIES_COUNT),
+		getMaxRelativeError(world.getPositionsY(), reference_world.getPositionsY(), VERIFY_BODIES_COUNT),
+		getMaxRelativeError(world.getPositionsZ(), reference_world.getPositionsZ(), VERIFY_BODIES_COUNT) });
+}
+
+static const char* getIntegrationMethodName(IntegrationMethod method)
+{
+	return (method == IntegrationMethod::VERLET) ? "verlet" : "euler";
+}
+
+bool Simulator::runWorldBenchmark(const BenchmarkOptions& options, JsonWriter& json)
+{
+	std::vector<SimdPath> simd_paths;
+	for (SimdPath path : { SimdPath::SCALAR, SimdPath::SSE, SimdPath::AVX2, SimdPath::NEON }) {
+		if (World::isSimdPathSupported(path)) {
+			simd_paths.push_back(path);
+		}
+	}
+
+	std::vector<size_t> bodies_counts;
+	for (size_t bodies_count = 1000; bodies_count < options.max_bodies_count; bodies_count *= 10) {
+		bodies_counts.push_back(bodies_count);
+	}
+
+	bodies_counts.push_back(options.max_bodies_count);
+
+	bool success = true;
+	World world;
+
+	json.beginArray("world");
+
+	for (IntegrationMethod method : { IntegrationMethod::SEMI_IMPLICIT_EULER, IntegrationMethod::VERLET }) {
+		for (SimdPath path : simd_paths) {
+			float max_error = (path == SimdPath::SCALAR) ? 0.0f : verifySimdPath(path, method);
+			bool verified = (max_error <= VERIFY_TOLERANCE);
+			success = success && verified;
+
+			if (!verified) {
+				fprintf(stderr, "world %s %s diverges from the scalar reference (max relative error %g).\n", getIntegrationMethodName(method),
+					World::getSimdPathName(path), max_error);
+			}
+
+			world.setSimdPath(path);
+
+			for (size_t bodies_count : bodies_counts) {
+				populateWorld(world, bodies_count);
+
+				uint64_t steps_count = std::clamp<uint64_t>(TARGET_BODY_UPDATES / bodies_count, MIN_STEPS_COUNT, MAX_STEPS_COUNT);
+
+				auto start_time = std::chrono::steady_clock::now();
+
+				for (uint64_t step = 0; step < steps_count; step++) {
+					world.step(STEP_DT, method);
+				}
+
+				double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+				double bodies_per_second = static_cast<double>(bodies_count * steps_count) / std::max(elapsed_s, 1e-9);
+				double step_ms = elapsed_s * 1000.0 / static_cast<double>(steps_count);
+
+				printf("world %s %s bodies:%zu steps:%llu %.3f ms/step %.2f M bodies/s error:%g\n", getIntegrationMethodName(method),
+					World::getSimdPathName(path), bodies_count, static_cast<unsigned long long>(steps_count), step_ms,
+					bodies_per_second / 1e6, max_error);
+
+				json.beginObject();
+				json.write("method", getIntegrationMethodName(method));
+				json.write("simd_path", World::getSimdPathName(path));
+				json.write("bodies", static_cast<uint64_t>(bodies_count));
+				json.write("steps", steps_count);
+				json.write("step_ms", step_ms);
+				json.write("bodies_per_second", bodies_per_second);
+				json.write("max_relative_error", static_cast<double>(max_error));
+				json.endObject();
+			}
+		}
+	}
+
+	json.endArray();
+
+	return success;
+}
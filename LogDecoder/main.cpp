@@ -0,0 +1,176 @@
+#include "../log_record.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static constexpr size_t READ_BUFFER_SIZE = 1 << 20;
+static constexpr size_t TEXT_BUFFER_SIZE = 1 << 16;
+static constexpr size_t SEGMENT_NUMBER_DIGITS = 6;
+
+// Segments are named <stem>.NNNNNN<extension> by the log sink, for example log.000003.bin for the log file log.bin.
+static bool parseSegmentPath(const std::filesystem::path& path, std::filesystem::path& out_log_path, uint64_t& out_segment_idx)
+{
+	std::string stem = path.stem().string();
+	if ((stem.size() <= SEGMENT_NUMBER_DIGITS + 1) || (stem[stem.size() - SEGMENT_NUMBER_DIGITS - 1] != '.')) {
+		return false;
+	}
+
+	uint64_t segment_idx = 0;
+	for (size_t i = stem.size() - SEGMENT_NUMBER_DIGITS; i < stem.size(); i++) {
+		if ((stem[i] < '0') || (stem[i] > '9')) {
+			return false;
+		}
+
+		segment_idx = segment_idx * 10 + static_cast<uint64_t>(stem[i] - '0');
+	}
+
+	out_log_path = path;
+	out_log_path.replace_filename(stem.substr(0, stem.size() - SEGMENT_NUMBER_DIGITS - 1) + path.extension().string());
+	out_segment_idx = segment_idx;
+	return true;
+}
+
+// Older segments are deleted as the log rolls over, so the remaining ones are found by listing the directory.
+static std::vector<std::filesystem::path> findSegments(const std::filesystem::path& log_path, uint64_t first_segment_idx)
+{
+	std::filesystem::path directory = log_path.parent_path();
+	if (directory.empty()) {
+		directory = ".";
+	}
+
+	std::vector<std::pair<uint64_t, std::filesystem::path>> segments;
+	std::error_code error;
+
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		std::filesystem::path segment_log_path;
+		uint64_t segment_idx;
+
+		if (parseSegmentPath(entry.path(), segment_log_path, segment_idx) && (segment_log_path.filename() == log_path.filename()) &&
+			(segment_idx >= first_segment_idx)) {
+			segments.emplace_back(segment_idx, entry.path());
+		}
+	}
+
+	std::sort(segments.begin(), segments.end());
+
+	std::vector<std::filesystem::path> segment_paths;
+	for (const auto& segment : segments) {
+		segment_paths.push_back(segment.second);
+	}
+
+	return segment_paths;
+}
+
+static bool decodeSegment(const std::filesystem::path& segment_path, std::ostream& output, std::vector<char>& buffer, std::vector<char>& text,
+	uint64_t& records_count)
+{
+	std::ifstream input(segment_path, std::ifstream::in | std::ifstream::binary);
+	if (!input.is_open()) {
+		fprintf(stderr, "Failed to open binary log file \"%s\".\n", segment_path.string().c_str());
+		return false;
+	}
+
+	char magic[sizeof(Simulator::LOG_FILE_MAGIC)];
+	input.read(magic, sizeof(magic));
+	if ((input.gcount() != sizeof(magic)) || (memcmp(magic, Simulator::LOG_FILE_MAGIC, sizeof(magic)) != 0)) {
+		fprintf(stderr, "File \"%s\" is not a binary log file.\n", segment_path.string().c_str());
+		return false;
+	}
+
+	size_t buffer_begin = 0;
+	size_t buffer_end = 0;
+
+	while (true) {
+		size_t record_size = Simulator::getLogRecordSize(buffer.data() + buffer_begin, buffer_end - buffer_begin);
+
+		if (record_size == 0) {
+			if (input.eof()) {
+				break;
+			}
+
+			memmove(buffer.data(), buffer.data() + buffer_begin, buffer_end - buffer_begin);
+			buffer_end -= buffer_begin;
+			buffer_begin = 0;
+
+			if (buffer_end == buffer.size()) {
+				fprintf(stderr, "Corrupted record in \"%s\" after %llu records.\n", segment_path.string().c_str(),
+					static_cast<unsigned long long>(records_count));
+				return false;
+			}
+
+			input.read(buffer.data() + buffer_end, buffer.size() - buffer_end);
+			buffer_end += static_cast<size_t>(input.gcount());
+			continue;
+		}
+
+		static constexpr char UNUSED_HEADER[Simulator::LOG_RECORD_HEADER_SIZE] = {};
+		if (memcmp(buffer.data() + buffer_begin, UNUSED_HEADER, sizeof(UNUSED_HEADER)) == 0) {
+			buffer_begin = buffer_end;
+			break;
+		}
+
+		size_t text_size = Simulator::formatLogRecord(buffer.data() + buffer_begin, record_size, text.data(), text.size());
+		output.write(text.data(), text_size);
+		output.put('\n');
+
+		buffer_begin += record_size;
+		records_count++;
+	}
+
+	if (buffer_end != buffer_begin) {
+		fprintf(stderr, "Truncated record at end of \"%s\" after %llu records.\n", segment_path.string().c_str(),
+			static_cast<unsigned long long>(records_count));
+	}
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	if ((argc < 2) || (argc > 3)) {
+		fprintf(stderr, "Usage: LogDecoder <binary log file or segment> [text log file]\n");
+		return 1;
+	}
+
+	// A segment path decodes that segment and the ones written after it, the log file path decodes every remaining segment.
+	std::filesystem::path input_path = argv[1];
+	std::filesystem::path log_path;
+	uint64_t first_segment_idx = 0;
+
+	if (!parseSegmentPath(input_path, log_path, first_segment_idx)) {
+		log_path = input_path;
+	}
+
+	std::vector<std::filesystem::path> segment_paths = findSegments(log_path, first_segment_idx);
+	if (segment_paths.empty()) {
+		segment_paths.push_back(input_path);
+	}
+
+	std::ofstream output_file;
+	if (argc == 3) {
+		output_file.open(argv[2], std::ofstream::out | std::ofstream::trunc);
+		if (!output_file.is_open()) {
+			fprintf(stderr, "Failed to create text log file \"%s\".\n", argv[2]);
+			return 1;
+		}
+	}
+
+	std::ostream& output = (argc == 3) ? output_file : std::cout;
+
+	std::vector<char> buffer(READ_BUFFER_SIZE);
+	std::vector<char> text(TEXT_BUFFER_SIZE);
+	uint64_t records_count = 0;
+
+	for (const std::filesystem::path& segment_path : segment_paths) {
+		if (!decodeSegment(segment_path, output, buffer, text, records_count)) {
+			return 1;
+		}
+	}
+
+	output.flush();
+	return output.good() ? 0 : 1;
+}
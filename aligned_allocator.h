@@ -0,0 +1,50 @@
+#pragma once
+
+#include <new>
+#include <vector>
+#include <cstddef>
+
+namespace Simulator {
+	template<typename T, size_t ALIGNMENT>
+	class AlignedAllocator {
+	public:
+		using value_type = T;
+
+		template<typename U>
+		struct rebind {
+			using other = AlignedAllocator<U, ALIGNMENT>;
+		};
+
+		AlignedAllocator() = default;
+
+		template<typename U>
+		AlignedAllocator(const AlignedAllocator<U, ALIGNMENT>&)
+		{
+		}
+
+		T* allocate(size_t count)
+		{
+			return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(ALIGNMENT)));
+		}
+
+		void deallocate(T* data, size_t count)
+		{
+			::operator delete(data, count * sizeof(T), std::align_val_t(ALIGNMENT));
+		}
+
+		template<typename U>
+		bool operator==(const AlignedAllocator<U, ALIGNMENT>&) const
+		{
+			return true;
+		}
+
+		template<typename U>
+		bool operator!=(const AlignedAllocator<U, ALIGNMENT>&) const
+		{
+			return false;
+		}
+	};
+
+	template<typename T, size_t ALIGNMENT = 64>
+	using AlignedVector = std::vector<T, AlignedAllocator<T, ALIGNMENT>>;
+}
@@ -0,0 +1,102 @@
+#include "broadphase.h"
+#include "dynamic_aabb_tree.h"
+#include "job_system.h"
+#include "uniform_grid.h"
+#include "world.h"
+
+using namespace Simulator;
+
+Broadphase::Broadphase()
+	: m_grid(std::make_unique<UniformGrid>()), m_tree(std::make_unique<DynamicAabbTree>())
+{
+}
+
+Broadphase::~Broadphase() = default;
+
+void Broadphase::init(const BroadphaseSettings& settings)
+{
+	m_settings = settings;
+	m_grid = std::make_unique<UniformGrid>();
+	m_tree = std::make_unique<DynamicAabbTree>();
+}
+
+void Broadphase::update(const World& world, JobSystem* job_system)
+{
+	switch (m_settings.method) {
+	case BroadphaseMethod::UNIFORM_GRID:
+		m_grid->build(world, m_settings.cell_size, m_settings.chunk_size, job_system);
+		break;
+	case BroadphaseMethod::DYNAMIC_TREE:
+		m_tree->update(world, m_settings.tree_margin, m_settings.chunk_size, job_system);
+		break;
+	}
+}
+
+void Broadphase::findPairs(const World& world, std::vector<BroadphasePair>& out_pairs, JobSystem* job_system)
+{
+	out_pairs.clear();
+
+	size_t bodies_count = world.getBodiesCount();
+	auto findRangePairs = [this, &world](size_t begin, size_t end, std::vector<BroadphasePair>& out_range_pairs)
+	{
+		if (m_settings.method == BroadphaseMethod::UNIFORM_GRID) {
+			m_grid->findPairs(begin, end, out_range_pairs);
+		}
+		else {
+			m_tree->findPairs(world, begin, end, out_range_pairs);
+		}
+	};
+
+	if (job_system == nullptr) {
+		findRangePairs(0, bodies_count, out_pairs);
+		return;
+	}
+
+	// One pair list per thread, merged once every range is done.
+	m_thread_pairs.resize(job_system->getThreadsCount());
+	for (std::vector<BroadphasePair>& thread_pairs : m_thread_pairs) {
+		thread_pairs.clear();
+	}
+
+	job_system->parallelFor(bodies_count, m_settings.chunk_size, [this, &findRangePairs](size_t begin, size_t end)
+		{
+			findRangePairs(begin, end, m_thread_pairs[JobSystem::getThreadIndex()]);
+		});
+
+	size_t pairs_count = 0;
+	for (const std::vector<BroadphasePair>& thread_pairs : m_thread_pairs) {
+		pairs_count += thread_pairs.size();
+	}
+
+	out_pairs.reserve(pairs_count);
+	for (const std::vector<BroadphasePair>& thread_pairs : m_thread_pairs) {
+		out_pairs.insert(out_pairs.end(), thread_pairs.begin(), thread_pairs.end());
+	}
+}
+
+BroadphaseMethod Broadphase::getMethod() const
+{
+	return m_settings.method;
+}
+
+const UniformGrid& Broadphase::getUniformGrid() const
+{
+	return *m_grid;
+}
+
+const DynamicAabbTree& Broadphase::getDynamicTree() const
+{
+	return *m_tree;
+}
+
+const char* Broadphase::getMethodName(BroadphaseMethod method)
+{
+	switch (method) {
+	case BroadphaseMethod::UNIFORM_GRID:
+		return "grid";
+	case BroadphaseMethod::DYNAMIC_TREE:
+		return "tree";
+	default:
+		return "unknown";
+	}
+}
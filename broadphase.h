@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Simulator {
+	class World;
+	class JobSystem;
+	class UniformGrid;
+	class DynamicAabbTree;
+
+	enum class BroadphaseMethod {
+		UNIFORM_GRID,
+		DYNAMIC_TREE
+	};
+
+	struct BroadphasePair {
+		uint32_t first_body_idx;
+		uint32_t second_body_idx;
+	};
+
+	struct Aabb {
+		float min[3];
+		float max[3];
+	};
+
+	struct BroadphaseSettings {
+		BroadphaseMethod method = BroadphaseMethod::UNIFORM_GRID;
+		// Raised to the largest body diameter when smaller, 0 uses that diameter.
+		float cell_size = 0.0f;
+		float tree_margin = 0.1f;
+		size_t chunk_size = 1024;
+	};
+
+	// Finds the pairs of bodies whose bounding boxes overlap. Pairs of two static bodies are skipped, each pair is reported
+	// once with first_body_idx < second_body_idx, in no particular order.
+	class Broadphase {
+	public:
+		Broadphase();
+		~Broadphase();
+		void init(const BroadphaseSettings& settings);
+		void update(const World& world, JobSystem* job_system = nullptr);
+		void findPairs(const World& world, std::vector<BroadphasePair>& out_pairs, JobSystem* job_system = nullptr);
+		BroadphaseMethod getMethod() const;
+		const UniformGrid& getUniformGrid() const;
+		const DynamicAabbTree& getDynamicTree() const;
+
+		static const char* getMethodName(BroadphaseMethod method);
+
+	private:
+		BroadphaseSettings m_settings;
+		std::unique_ptr<UniformGrid> m_grid;
+		std::unique_ptr<DynamicAabbTree> m_tree;
+		std::vector<std::vector<BroadphasePair>> m_thread_pairs;
+	};
+
+	inline Aabb getBodyAabb(const float* position_x, const float* position_y, const float* position_z, const float* radius, uint32_t body_idx)
+	{
+		float body_radius = radius[body_idx];
+		return { { position_x[body_idx] - body_radius, position_y[body_idx] - body_radius, position_z[body_idx] - body_radius },
+			{ position_x[body_idx] + body_radius, position_y[body_idx] + body_radius, position_z[body_idx] + body_radius } };
+	}
+
+	inline bool isOverlapping(const Aabb& a, const Aabb& b)
+	{
+		return (a.min[0] <= b.max[0]) && (b.min[0] <= a.max[0]) && (a.min[1] <= b.max[1]) && (b.min[1] <= a.max[1]) &&
+			(a.min[2] <= b.max[2]) && (b.min[2] <= a.max[2]);
+	}
+}
@@ -0,0 +1,225 @@
+#include "command_recorder.h"
+#include "job_system.h"
+#include <algorithm>
+
+using namespace Simulator;
+
+CommandRecorder::~CommandRecorder()
+{
+	destroy();
+}
+
+bool CommandRecorder::create(VkDevice logical_device, uint32_t queue_family_idx, uint32_t frames_count, uint32_t threads_count,
+	const VkAllocationCallbacks* allocation_callbacks, std::string& out_error_message)
+{
+	destroy();
+
+	if ((frames_count == 0) || (threads_count == 0)) {
+		out_error_message = "Invalid command recorder frames or threads count.";
+		return false;
+	}
+
+	m_vk_logical_device = logical_device;
+	m_allocation_callbacks = allocation_callbacks;
+	m_frames_count = frames_count;
+	m_threads_count = threads_count;
+	m_frame_idx = 0;
+
+	m_pools.resize(static_cast<size_t>(frames_count) * threads_count);
+	for (std::unique_ptr<ThreadPool>& pool : m_pools) {
+		pool = std::make_unique<ThreadPool>();
+
+		VkCommandPoolCreateInfo command_pool_create_info{};
+		command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		command_pool_create_info.pNext = nullptr;
+		command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		command_pool_create_info.queueFamilyIndex = queue_family_idx;
+
+		VkResult vk_error = vkCreateCommandPool(m_vk_logical_device, &command_pool_create_info, m_allocation_callbacks, &pool->command_pool);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to create Vulkan recorder command pool. VK error:" + std::to_string(vk_error) + ".";
+			pool->command_pool = VK_NULL_HANDLE;
+			destroy();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void CommandRecorder::destroy()
+{
+	for (std::unique_ptr<ThreadPool>& pool : m_pools) {
+		if (pool && (pool->command_pool != VK_NULL_HANDLE)) {
+			vkDestroyCommandPool(m_vk_logical_device, pool->command_pool, m_allocation_callbacks);
+		}
+	}
+
+	m_pools.clear();
+	m_vk_logical_device = VK_NULL_HANDLE;
+	m_allocation_callbacks = nullptr;
+	m_frames_count = 0;
+	m_threads_count = 0;
+	m_frame_idx = 0;
+}
+
+bool CommandRecorder::isCreated() const
+{
+	return !m_pools.empty();
+}
+
+bool CommandRecorder::beginFrame(uint32_t frame_idx, std::string& out_error_message)
+{
+	if (!isCreated()) {
+		out_error_message = "Command recorder not created.";
+		return false;
+	}
+
+	m_frame_idx = frame_idx % m_frames_count;
+
+	for (uint32_t i = 0; i < m_threads_count; i++) {
+		ThreadPool& pool = *m_pools[static_cast<size_t>(m_frame_idx) * m_threads_count + i];
+
+		// Resetting the pool returns the memory of every buffer at once instead of resetting them one by one.
+		VkResult vk_error = vkResetCommandPool(m_vk_logical_device, pool.command_pool, 0);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to reset Vulkan recorder command pool. VK error:" + std::to_string(vk_error) + ".";
+			return false;
+		}
+
+		pool.used_command_buffers_count = 0;
+		pool.recorded_ranges.clear();
+		m_stats.pool_resets_count++;
+	}
+
+	return true;
+}
+
+bool CommandRecorder::record(JobSystem* job_system, uint32_t items_count, uint32_t min_chunk_size, const VkCommandBufferInheritanceInfo& inheritance_info,
+	const CommandRecordFunction& function, std::vector<VkCommandBuffer>& out_command_buffers, std::string& out_error_message)
+{
+	out_command_buffers.clear();
+
+	if (!isCreated()) {
+		out_error_message = "Command recorder not created.";
+		return false;
+	}
+
+	if (items_count == 0) {
+		return true;
+	}
+
+	for (uint32_t i = 0; i < m_threads_count; i++) {
+		ThreadPool& pool = *m_pools[static_cast<size_t>(m_frame_idx) * m_threads_count + i];
+		pool.recorded_ranges.clear();
+		pool.vk_error = VK_SUCCESS;
+	}
+
+	if (job_system != nullptr) {
+		job_system->parallelFor(items_count, std::max(min_chunk_size, 1u), [&](size_t begin, size_t end)
+			{
+				ThreadPool& pool = getThreadPool(JobSystem::getThreadIndex());
+				std::lock_guard<std::mutex> lock(pool.mutex);
+				recordRange(pool, static_cast<uint32_t>(begin), static_cast<uint32_t>(end), inheritance_info, function);
+			});
+	}
+	else {
+		recordRange(getThreadPool(0), 0, items_count, inheritance_info, function);
+	}
+
+	/**************************************************************************************/
+
+	std::vector<RecordedRange> recorded_ranges;
+
+	for (uint32_t i = 0; i < m_threads_count; i++) {
+		ThreadPool& pool = *m_pools[static_cast<size_t>(m_frame_idx) * m_threads_count + i];
+		if (pool.vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to record Vulkan secondary command buffer. VK error:" + std::to_string(pool.vk_error) + ".";
+			return false;
+		}
+
+		recorded_ranges.insert(recorded_ranges.end(), pool.recorded_ranges.begin(), pool.recorded_ranges.end());
+	}
+
+	std::sort(recorded_ranges.begin(), recorded_ranges.end(), [](const RecordedRange& a, const RecordedRange& b)
+		{
+			return a.begin < b.begin;
+		});
+
+	out_command_buffers.reserve(recorded_ranges.size());
+	for (const RecordedRange& recorded_range : recorded_ranges) {
+		out_command_buffers.push_back(recorded_range.command_buffer);
+	}
+
+	m_stats.recorded_command_buffers_count += out_command_buffers.size();
+	return true;
+}
+
+uint32_t CommandRecorder::getThreadsCount() const
+{
+	return m_threads_count;
+}
+
+CommandRecorderStats CommandRecorder::getStats() const
+{
+	CommandRecorderStats stats = m_stats;
+	for (const std::unique_ptr<ThreadPool>& pool : m_pools) {
+		stats.allocated_command_buffers_count += pool->command_buffers.size();
+	}
+
+	return stats;
+}
+
+void CommandRecorder::recordRange(ThreadPool& pool, uint32_t begin, uint32_t end, const VkCommandBufferInheritanceInfo& inheritance_info,
+	const CommandRecordFunction& function)
+{
+	if (pool.vk_error != VK_SUCCESS) {
+		return;
+	}
+
+	if (pool.used_command_buffers_count == pool.command_buffers.size()) {
+		size_t allocated_count = pool.command_buffers.size();
+		pool.command_buffers.resize(allocated_count + COMMAND_BUFFERS_ALLOCATION_COUNT, VK_NULL_HANDLE);
+
+		VkCommandBufferAllocateInfo command_buffer_allocate_info{};
+		command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_allocate_info.pNext = nullptr;
+		command_buffer_allocate_info.commandPool = pool.command_pool;
+		command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		command_buffer_allocate_info.commandBufferCount = COMMAND_BUFFERS_ALLOCATION_COUNT;
+
+		pool.vk_error = vkAllocateCommandBuffers(m_vk_logical_device, &command_buffer_allocate_info, &pool.command_buffers[allocated_count]);
+		if (pool.vk_error != VK_SUCCESS) {
+			pool.command_buffers.resize(allocated_count);
+			return;
+		}
+	}
+
+	VkCommandBuffer command_buffer = pool.command_buffers[pool.used_command_buffers_count++];
+
+	// Secondary buffers continue the rendering begun in the primary buffer they are executed from.
+	VkCommandBufferBeginInfo command_buffer_begin_info{};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.pNext = nullptr;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	command_buffer_begin_info.pInheritanceInfo = &inheritance_info;
+
+	pool.vk_error = vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
+	if (pool.vk_error != VK_SUCCESS) {
+		return;
+	}
+
+	function(command_buffer, begin, end);
+
+	pool.vk_error = vkEndCommandBuffer(command_buffer);
+	if (pool.vk_error != VK_SUCCESS) {
+		return;
+	}
+
+	pool.recorded_ranges.push_back({ begin, command_buffer });
+}
+
+CommandRecorder::ThreadPool& CommandRecorder::getThreadPool(uint32_t thread_idx)
+{
+	return *m_pools[static_cast<size_t>(m_frame_idx) * m_threads_count + (thread_idx % m_threads_count)];
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Volk/volk.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Simulator {
+	class JobSystem;
+
+	using CommandRecordFunction = std::function<void(VkCommandBuffer command_buffer, uint32_t begin, uint32_t end)>;
+
+	struct CommandRecorderStats {
+		uint64_t recorded_command_buffers_count = 0;
+		uint64_t allocated_command_buffers_count = 0;
+		uint64_t pool_resets_count = 0;
+	};
+
+	// Records secondary command buffers over item ranges on the job system. Every frame slot has one command pool per
+	// thread, so threads never share a pool while recording and a frame's pools are reset as a whole once its fence signalled.
+	class CommandRecorder {
+	public:
+		~CommandRecorder();
+		bool create(VkDevice logical_device, uint32_t queue_family_idx, uint32_t frames_count, uint32_t threads_count,
+			const VkAllocationCallbacks* allocation_callbacks, std::string& out_error_message);
+		void destroy();
+		bool isCreated() const;
+		bool beginFrame(uint32_t frame_idx, std::string& out_error_message);
+		// Command buffers are returned in item order. Without a job system every range is recorded on the calling thread.
+		bool record(JobSystem* job_system, uint32_t items_count, uint32_t min_chunk_size, const VkCommandBufferInheritanceInfo& inheritance_info,
+			const CommandRecordFunction& function, std::vector<VkCommandBuffer>& out_command_buffers, std::string& out_error_message);
+		uint32_t getThreadsCount() const;
+		CommandRecorderStats getStats() const;
+
+	private:
+		struct RecordedRange {
+			uint32_t begin;
+			VkCommandBuffer command_buffer;
+		};
+
+		struct alignas(64) ThreadPool {
+			// Threads outside the job system all run with thread index 0, the lock keeps them from sharing the pool.
+			std::mutex mutex;
+			VkCommandPool command_pool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> command_buffers;
+			uint32_t used_command_buffers_count = 0;
+			std::vector<RecordedRange> recorded_ranges;
+			VkResult vk_error = VK_SUCCESS;
+		};
+
+		void recordRange(ThreadPool& pool, uint32_t begin, uint32_t end, const VkCommandBufferInheritanceInfo& inheritance_info,
+			const CommandRecordFunction& function);
+		ThreadPool& getThreadPool(uint32_t thread_idx);
+
+		static constexpr uint32_t COMMAND_BUFFERS_ALLOCATION_COUNT = 16;
+
+		VkDevice m_vk_logical_device = VK_NULL_HANDLE;
+		const VkAllocationCallbacks* m_allocation_callbacks = nullptr;
+		std::vector<std::unique_ptr<ThreadPool>> m_pools;
+		uint32_t m_frames_count = 0;
+		uint32_t m_threads_count = 0;
+		uint32_t m_frame_idx = 0;
+		CommandRecorderStats m_stats;
+	};
+}
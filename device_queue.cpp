@@ -0,0 +1,162 @@
+#include "device_queue.h"
+
+using namespace Simulator;
+
+void DeviceQueue::init(VkQueue vk_queue, uint32_t queue_family_idx, Type type)
+{
+	m_vk_queue = vk_queue;
+	m_queue_family_idx = queue_family_idx;
+	m_type = type;
+	m_shared = false;
+	m_state = std::make_shared<SharedState>();
+}
+
+void DeviceQueue::initShared(const DeviceQueue& queue, Type type)
+{
+	m_vk_queue = queue.m_vk_queue;
+	m_queue_family_idx = queue.m_queue_family_idx;
+	m_type = type;
+	m_shared = true;
+	m_state = queue.m_state;
+}
+
+void DeviceQueue::reset()
+{
+	m_vk_queue = VK_NULL_HANDLE;
+	m_queue_family_idx = VK_QUEUE_FAMILY_IGNORED;
+	m_shared = false;
+	m_state.reset();
+}
+
+VkQueue DeviceQueue::getHandle() const
+{
+	return m_vk_queue;
+}
+
+uint32_t DeviceQueue::getFamilyIndex() const
+{
+	return m_queue_family_idx;
+}
+
+DeviceQueue::Type DeviceQueue::getType() const
+{
+	return m_type;
+}
+
+bool DeviceQueue::isShared() const
+{
+	return m_shared;
+}
+
+VkResult DeviceQueue::submit(uint32_t submits_count, const VkSubmitInfo* submits, VkFence fence)
+{
+	std::lock_guard lock(m_state->submit_mutex);
+	return vkQueueSubmit(m_vk_queue, submits_count, submits, fence);
+}
+
+VkResult DeviceQueue::submit2(uint32_t submits_count, const VkSubmitInfo2* submits, VkFence fence)
+{
+	std::lock_guard lock(m_state->submit_mutex);
+	return vkQueueSubmit2(m_vk_queue, submits_count, submits, fence);
+}
+
+VkResult DeviceQueue::present(const VkPresentInfoKHR& present_info)
+{
+	std::lock_guard lock(m_state->submit_mutex);
+	return vkQueuePresentKHR(m_vk_queue, &present_info);
+}
+
+VkResult DeviceQueue::waitIdle()
+{
+	std::lock_guard lock(m_state->submit_mutex);
+	return vkQueueWaitIdle(m_vk_queue);
+}
+
+uint64_t DeviceQueue::getReleasedCount() const
+{
+	return m_state ? m_state->released_count.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t DeviceQueue::getAcquiredCount() const
+{
+	return m_state ? m_state->acquired_count.load(std::memory_order_relaxed) : 0;
+}
+
+bool DeviceQueue::transferBufferOwnership(QueueOwnership& ownership, DeviceQueue& src_queue, VkCommandBuffer src_command_buffer,
+	DeviceQueue& dst_queue, VkCommandBuffer dst_command_buffer, const BufferOwnershipTransfer& transfer)
+{
+	VkBufferMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.pNext = nullptr;
+	barrier.buffer = transfer.buffer;
+	barrier.offset = transfer.offset;
+	barrier.size = transfer.size;
+
+	if ((ownership.queue_family_idx == VK_QUEUE_FAMILY_IGNORED) || (ownership.queue_family_idx == dst_queue.m_queue_family_idx)) {
+		barrier.srcAccessMask = transfer.src_access_mask;
+		barrier.dstAccessMask = transfer.dst_access_mask;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+		vkCmdPipelineBarrier(dst_command_buffer, transfer.src_stage_mask, transfer.dst_stage_mask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		ownership.queue_family_idx = dst_queue.m_queue_family_idx;
+		return false;
+	}
+
+	barrier.srcQueueFamilyIndex = ownership.queue_family_idx;
+	barrier.dstQueueFamilyIndex = dst_queue.m_queue_family_idx;
+
+	barrier.srcAccessMask = transfer.src_access_mask;
+	barrier.dstAccessMask = 0;
+	vkCmdPipelineBarrier(src_command_buffer, transfer.src_stage_mask, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = transfer.dst_access_mask;
+	vkCmdPipelineBarrier(dst_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, transfer.dst_stage_mask, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	src_queue.m_state->released_count.fetch_add(1, std::memory_order_relaxed);
+	dst_queue.m_state->acquired_count.fetch_add(1, std::memory_order_relaxed);
+	ownership.queue_family_idx = dst_queue.m_queue_family_idx;
+	return true;
+}
+
+bool DeviceQueue::transferImageOwnership(QueueOwnership& ownership, DeviceQueue& src_queue, VkCommandBuffer src_command_buffer,
+	DeviceQueue& dst_queue, VkCommandBuffer dst_command_buffer, const ImageOwnershipTransfer& transfer)
+{
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.pNext = nullptr;
+	barrier.oldLayout = transfer.old_layout;
+	barrier.newLayout = transfer.new_layout;
+	barrier.image = transfer.image;
+	barrier.subresourceRange = transfer.subresource_range;
+
+	if ((ownership.queue_family_idx == VK_QUEUE_FAMILY_IGNORED) || (ownership.queue_family_idx == dst_queue.m_queue_family_idx)) {
+		barrier.srcAccessMask = transfer.src_access_mask;
+		barrier.dstAccessMask = transfer.dst_access_mask;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+		vkCmdPipelineBarrier(dst_command_buffer, transfer.src_stage_mask, transfer.dst_stage_mask, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		ownership.queue_family_idx = dst_queue.m_queue_family_idx;
+		return false;
+	}
+
+	barrier.srcQueueFamilyIndex = ownership.queue_family_idx;
+	barrier.dstQueueFamilyIndex = dst_queue.m_queue_family_idx;
+
+	barrier.srcAccessMask = transfer.src_access_mask;
+	barrier.dstAccessMask = 0;
+	vkCmdPipelineBarrier(src_command_buffer, transfer.src_stage_mask, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = transfer.dst_access_mask;
+	vkCmdPipelineBarrier(dst_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, transfer.dst_stage_mask, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	src_queue.m_state->released_count.fetch_add(1, std::memory_order_relaxed);
+	dst_queue.m_state->acquired_count.fetch_add(1, std::memory_order_relaxed);
+	ownership.queue_family_idx = dst_queue.m_queue_family_idx;
+	return true;
+}
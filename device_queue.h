@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Volk/volk.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace Simulator {
+	struct QueueOwnership {
+		uint32_t queue_family_idx = VK_QUEUE_FAMILY_IGNORED;
+	};
+
+	struct BufferOwnershipTransfer {
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = VK_WHOLE_SIZE;
+		VkPipelineStageFlags src_stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkAccessFlags src_access_mask = 0;
+		VkPipelineStageFlags dst_stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkAccessFlags dst_access_mask = 0;
+	};
+
+	struct ImageOwnershipTransfer {
+		VkImage image = VK_NULL_HANDLE;
+		VkImageSubresourceRange subresource_range{};
+		VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkImageLayout new_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags src_stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkAccessFlags src_access_mask = 0;
+		VkPipelineStageFlags dst_stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkAccessFlags dst_access_mask = 0;
+	};
+
+	class DeviceQueue {
+	public:
+		enum class Type {
+			GRAPHICS,
+			COMPUTE,
+			TRANSFER,
+			PRESENT
+		};
+
+		void init(VkQueue vk_queue, uint32_t queue_family_idx, Type type);
+		void initShared(const DeviceQueue& queue, Type type);
+		void reset();
+		VkQueue getHandle() const;
+		uint32_t getFamilyIndex() const;
+		Type getType() const;
+		bool isShared() const;
+		VkResult submit(uint32_t submits_count, const VkSubmitInfo* submits, VkFence fence);
+		VkResult submit2(uint32_t submits_count, const VkSubmitInfo2* submits, VkFence fence);
+		VkResult present(const VkPresentInfoKHR& present_info);
+		VkResult waitIdle();
+		uint64_t getReleasedCount() const;
+		uint64_t getAcquiredCount() const;
+
+		static bool transferBufferOwnership(QueueOwnership& ownership, DeviceQueue& src_queue, VkCommandBuffer src_command_buffer,
+			DeviceQueue& dst_queue, VkCommandBuffer dst_command_buffer, const BufferOwnershipTransfer& transfer);
+		static bool transferImageOwnership(QueueOwnership& ownership, DeviceQueue& src_queue, VkCommandBuffer src_command_buffer,
+			DeviceQueue& dst_queue, VkCommandBuffer dst_command_buffer, const ImageOwnershipTransfer& transfer);
+
+	private:
+		struct SharedState {
+			std::mutex submit_mutex;
+			std::atomic<uint64_t> released_count = 0;
+			std::atomic<uint64_t> acquired_count = 0;
+		};
+
+		VkQueue m_vk_queue = VK_NULL_HANDLE;
+		uint32_t m_queue_family_idx = VK_QUEUE_FAMILY_IGNORED;
+		Type m_type = Type::GRAPHICS;
+		bool m_shared = false;
+		std::shared_ptr<SharedState> m_state;
+	};
+}
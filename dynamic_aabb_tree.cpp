@@ -0,0 +1,477 @@
+#include "dynamic_aabb_tree.h"
+#include "job_system.h"
+#include "world.h"
+#include <algorithm>
+#include <cfloat>
+
+using namespace Simulator;
+
+static Aabb combineAabbs(const Aabb& a, const Aabb& b)
+{
+	return { { std::min(a.min[0], b.min[0]), std::min(a.min[1], b.min[1]), std::min(a.min[2], b.min[2]) },
+		{ std::max(a.max[0], b.max[0]), std::max(a.max[1], b.max[1]), std::max(a.max[2], b.max[2]) } };
+}
+
+static float getSurfaceArea(const Aabb& aabb)
+{
+	float size_x = aabb.max[0] - aabb.min[0];
+	float size_y = aabb.max[1] - aabb.min[1];
+	float size_z = aabb.max[2] - aabb.min[2];
+	return 2.0f * (size_x * size_y + size_y * size_z + size_z * size_x);
+}
+
+static bool isContaining(const Aabb& outer, const Aabb& inner)
+{
+	return (outer.min[0] <= inner.min[0]) && (outer.min[1] <= inner.min[1]) && (outer.min[2] <= inner.min[2]) &&
+		(inner.max[0] <= outer.max[0]) && (inner.max[1] <= outer.max[1]) && (inner.max[2] <= outer.max[2]);
+}
+
+void DynamicAabbTree::update(const World& world, float margin, size_t chunk_size, JobSystem* job_system)
+{
+	size_t bodies_count = world.getBodiesCount();
+	const float* position_x = world.getPositionsX();
+	const float* position_y = world.getPositionsY();
+	const float* position_z = world.getPositionsZ();
+	const float* radius = world.getRadii();
+
+	m_reinserted_count = 0;
+
+	if (bodies_count > m_body_leaves.size() * 2) {
+		rebuild(world, margin, job_system);
+		return;
+	}
+
+	if (m_body_leaves.size() > bodies_count) {
+		while (m_body_leaves.size() > bodies_count) {
+			removeLeaf(m_body_leaves.back());
+			freeNode(m_body_leaves.back());
+			m_body_leaves.pop_back();
+		}
+
+		m_leaf_order.erase(std::remove_if(m_leaf_order.begin(), m_leaf_order.end(), [bodies_count](uint32_t body_idx)
+			{
+				return body_idx >= bodies_count;
+			}), m_leaf_order.end());
+	}
+
+	// Finding the bodies that left their fat boxes is read only and runs in parallel, the reinserts don't.
+	size_t leaves_count = m_body_leaves.size();
+	m_moved_flags.resize(leaves_count);
+
+	auto findMovedBodies = [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++) {
+			Aabb aabb = getBodyAabb(position_x, position_y, position_z, radius, static_cast<uint32_t>(i));
+			m_moved_flags[i] = isContaining(m_nodes[m_body_leaves[i]].aabb, aabb) ? 0 : 1;
+		}
+	};
+
+	if (job_system != nullptr) {
+		job_system->parallelFor(leaves_count, chunk_size, findMovedBodies);
+	}
+	else {
+		findMovedBodies(0, leaves_count);
+	}
+
+	size_t moved_count = std::count(m_moved_flags.begin(), m_moved_flags.end(), static_cast<uint8_t>(1));
+	if (moved_count * 2 > leaves_count) {
+		rebuild(world, margin, job_system);
+		return;
+	}
+
+	for (size_t i = 0; i < leaves_count; i++) {
+		if (m_moved_flags[i] == 0) {
+			continue;
+		}
+
+		int32_t leaf_idx = m_body_leaves[i];
+		removeLeaf(leaf_idx);
+		setFatAabb(leaf_idx, getBodyAabb(position_x, position_y, position_z, radius, static_cast<uint32_t>(i)), margin);
+		insertLeaf(leaf_idx);
+		m_reinserted_count++;
+	}
+
+	for (size_t i = leaves_count; i < bodies_count; i++) {
+		int32_t leaf_idx = allocateNode();
+		m_nodes[leaf_idx].body_idx = static_cast<uint32_t>(i);
+		setFatAabb(leaf_idx, getBodyAabb(position_x, position_y, position_z, radius, static_cast<uint32_t>(i)), margin);
+		insertLeaf(leaf_idx);
+		m_body_leaves.push_back(leaf_idx);
+		m_leaf_order.push_back(static_cast<uint32_t>(i));
+	}
+}
+
+void DynamicAabbTree::findPairs(const World& world, size_t begin, size_t end, std::vector<BroadphasePair>& out_pairs) const
+{
+	const float* position_x = world.getPositionsX();
+	const float* position_y = world.getPositionsY();
+	const float* position_z = world.getPositionsZ();
+	const float* radius = world.getRadii();
+	const float* inverse_mass = world.getInverseMasses();
+
+	end = std::min(end, m_leaf_order.size());
+	if ((begin >= end) || (m_root == NULL_NODE)) {
+		return;
+	}
+
+	// The tree is height balanced, so the stack never gets close to MAX_QUERY_DEPTH.
+	int32_t stack[MAX_QUERY_DEPTH];
+
+	// Bodies are queried in leaf order, neighboring queries then walk mostly the same nodes.
+	for (size_t i = begin; i < end; i++) {
+		uint32_t body_idx = m_leaf_order[i];
+		Aabb aabb = getBodyAabb(position_x, position_y, position_z, radius, body_idx);
+		bool is_static = (inverse_mass[body_idx] == 0.0f);
+
+		size_t stack_size = 0;
+		stack[stack_size++] = m_root;
+
+		while (stack_size > 0) {
+			const Node& node = m_nodes[stack[--stack_size]];
+			if (!isOverlapping(node.aabb, aabb)) {
+				continue;
+			}
+
+			if (node.child1 != NULL_NODE) {
+				stack[stack_size++] = node.child1;
+				stack[stack_size++] = node.child2;
+				continue;
+			}
+
+			uint32_t other_body_idx = node.body_idx;
+			if ((other_body_idx <= body_idx) || (is_static && (inverse_mass[other_body_idx] == 0.0f))) {
+				continue;
+			}
+
+			if (isOverlapping(aabb, getBodyAabb(position_x, position_y, position_z, radius, other_body_idx))) {
+				out_pairs.push_back({ body_idx, other_body_idx });
+			}
+		}
+	}
+}
+
+void DynamicAabbTree::clear()
+{
+	m_nodes.clear();
+	m_root = NULL_NODE;
+	m_free_list = NULL_NODE;
+	m_body_leaves.clear();
+	m_leaf_order.clear();
+	m_moved_flags.clear();
+	m_reinserted_count = 0;
+}
+
+uint32_t DynamicAabbTree::getHeight() const
+{
+	return (m_root != NULL_NODE) ? static_cast<uint32_t>(m_nodes[m_root].height) : 0;
+}
+
+size_t DynamicAabbTree::getLeavesCount() const
+{
+	return m_body_leaves.size();
+}
+
+size_t DynamicAabbTree::getReinsertedCount() const
+{
+	return m_reinserted_count;
+}
+
+int32_t DynamicAabbTree::allocateNode()
+{
+	int32_t node_idx = m_free_list;
+
+	if (node_idx != NULL_NODE) {
+		m_free_list = m_nodes[node_idx].parent;
+	}
+	else {
+		node_idx = static_cast<int32_t>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+
+	Node& node = m_nodes[node_idx];
+	node.parent = NULL_NODE;
+	node.child1 = NULL_NODE;
+	node.child2 = NULL_NODE;
+	node.height = 0;
+	node.body_idx = UINT32_MAX;
+
+	return node_idx;
+}
+
+void DynamicAabbTree::freeNode(int32_t node_idx)
+{
+	m_nodes[node_idx].parent = m_free_list;
+	m_nodes[node_idx].height = -1;
+	m_free_list = node_idx;
+}
+
+void DynamicAabbTree::insertLeaf(int32_t leaf_idx)
+{
+	if (m_root == NULL_NODE) {
+		m_root = leaf_idx;
+		m_nodes[leaf_idx].parent = NULL_NODE;
+		return;
+	}
+
+	Aabb leaf_aabb = m_nodes[leaf_idx].aabb;
+
+	auto getDescentCost = [this, &leaf_aabb](int32_t child_idx)
+	{
+		const Node& child = m_nodes[child_idx];
+		float combined_area = getSurfaceArea(combineAabbs(leaf_aabb, child.aabb));
+		return (child.child1 == NULL_NODE) ? combined_area : (combined_area - getSurfaceArea(child.aabb));
+	};
+
+	// Walk down while pushing the leaf further into a child is cheaper than making it the sibling of the current node.
+	int32_t sibling_idx = m_root;
+
+	while (m_nodes[sibling_idx].child1 != NULL_NODE) {
+		const Node& node = m_nodes[sibling_idx];
+		float area = getSurfaceArea(node.aabb);
+		float combined_area = getSurfaceArea(combineAabbs(node.aabb, leaf_aabb));
+		float cost = 2.0f * combined_area;
+		float inheritance_cost = 2.0f * (combined_area - area);
+		float cost1 = getDescentCost(node.child1) + inheritance_cost;
+		float cost2 = getDescentCost(node.child2) + inheritance_cost;
+
+		if ((cost < cost1) && (cost < cost2)) {
+			break;
+		}
+
+		sibling_idx = (cost1 < cost2) ? node.child1 : node.child2;
+	}
+
+	int32_t old_parent_idx = m_nodes[sibling_idx].parent;
+	int32_t new_parent_idx = allocateNode();
+
+	Node& new_parent = m_nodes[new_parent_idx];
+	new_parent.parent = old_parent_idx;
+	new_parent.aabb = combineAabbs(leaf_aabb, m_nodes[sibling_idx].aabb);
+	new_parent.height = m_nodes[sibling_idx].height + 1;
+	new_parent.child1 = sibling_idx;
+	new_parent.child2 = leaf_idx;
+
+	if (old_parent_idx != NULL_NODE) {
+		Node& old_parent = m_nodes[old_parent_idx];
+		if (old_parent.child1 == sibling_idx) {
+			old_parent.child1 = new_parent_idx;
+		}
+		else {
+			old_parent.child2 = new_parent_idx;
+		}
+	}
+	else {
+		m_root = new_parent_idx;
+	}
+
+	m_nodes[sibling_idx].parent = new_parent_idx;
+	m_nodes[leaf_idx].parent = new_parent_idx;
+
+	refitAncestors(new_parent_idx);
+}
+
+void DynamicAabbTree::removeLeaf(int32_t leaf_idx)
+{
+	if (leaf_idx == m_root) {
+		m_root = NULL_NODE;
+		return;
+	}
+
+	int32_t parent_idx = m_nodes[leaf_idx].parent;
+	int32_t grandparent_idx = m_nodes[parent_idx].parent;
+	int32_t sibling_idx = (m_nodes[parent_idx].child1 == leaf_idx) ? m_nodes[parent_idx].child2 : m_nodes[parent_idx].child1;
+
+	m_nodes[sibling_idx].parent = grandparent_idx;
+	freeNode(parent_idx);
+
+	if (grandparent_idx == NULL_NODE) {
+		m_root = sibling_idx;
+		return;
+	}
+
+	Node& grandparent = m_nodes[grandparent_idx];
+	if (grandparent.child1 == parent_idx) {
+		grandparent.child1 = sibling_idx;
+	}
+	else {
+		grandparent.child2 = sibling_idx;
+	}
+
+	refitAncestors(grandparent_idx);
+}
+
+int32_t DynamicAabbTree::balance(int32_t node_idx)
+{
+	Node& a = m_nodes[node_idx];
+	if ((a.child1 == NULL_NODE) || (a.height < 2)) {
+		return node_idx;
+	}
+
+	int32_t b_idx = a.child1;
+	int32_t c_idx = a.child2;
+	Node& b = m_nodes[b_idx];
+	Node& c = m_nodes[c_idx];
+	int32_t height_difference = c.height - b.height;
+
+	if ((height_difference >= -1) && (height_difference <= 1)) {
+		return node_idx;
+	}
+
+	// Rotate the taller child up into the place of the node, the node keeps the shorter grandchild.
+	bool rotate_c = (height_difference > 1);
+	int32_t up_idx = rotate_c ? c_idx : b_idx;
+	Node& up = rotate_c ? c : b;
+	Node& other = rotate_c ? b : c;
+	int32_t f_idx = up.child1;
+	int32_t g_idx = up.child2;
+	Node& f = m_nodes[f_idx];
+	Node& g = m_nodes[g_idx];
+
+	up.child1 = node_idx;
+	up.parent = a.parent;
+	a.parent = up_idx;
+
+	if (up.parent != NULL_NODE) {
+		Node& parent = m_nodes[up.parent];
+		if (parent.child1 == node_idx) {
+			parent.child1 = up_idx;
+		}
+		else {
+			parent.child2 = up_idx;
+		}
+	}
+	else {
+		m_root = up_idx;
+	}
+
+	int32_t kept_idx = (f.height > g.height) ? f_idx : g_idx;
+	int32_t moved_idx = (f.height > g.height) ? g_idx : f_idx;
+	Node& kept = m_nodes[kept_idx];
+	Node& moved = m_nodes[moved_idx];
+
+	up.child2 = kept_idx;
+	if (rotate_c) {
+		a.child2 = moved_idx;
+	}
+	else {
+		a.child1 = moved_idx;
+	}
+
+	moved.parent = node_idx;
+	a.aabb = combineAabbs(other.aabb, moved.aabb);
+	a.height = 1 + std::max(other.height, moved.height);
+	up.aabb = combineAabbs(a.aabb, kept.aabb);
+	up.height = 1 + std::max(a.height, kept.height);
+
+	return up_idx;
+}
+
+void DynamicAabbTree::refitAncestors(int32_t node_idx)
+{
+	while (node_idx != NULL_NODE) {
+		node_idx = balance(node_idx);
+
+		Node& node = m_nodes[node_idx];
+		const Node& child1 = m_nodes[node.child1];
+		const Node& child2 = m_nodes[node.child2];
+		node.height = 1 + std::max(child1.height, child2.height);
+		node.aabb = combineAabbs(child1.aabb, child2.aabb);
+
+		node_idx = node.parent;
+	}
+}
+
+void DynamicAabbTree::rebuild(const World& world, float margin, JobSystem* job_system)
+{
+	size_t bodies_count = world.getBodiesCount();
+
+	m_nodes.resize((bodies_count > 0) ? (bodies_count * 2 - 1) : 0);
+	m_root = NULL_NODE;
+	m_free_list = NULL_NODE;
+	m_body_leaves.resize(bodies_count);
+	m_leaf_order.resize(bodies_count);
+
+	for (size_t i = 0; i < bodies_count; i++) {
+		m_leaf_order[i] = static_cast<uint32_t>(i);
+	}
+
+	if (bodies_count > 0) {
+		m_root = 0;
+		m_nodes[m_root].parent = NULL_NODE;
+		buildNode(world, margin, 0, bodies_count, m_root, job_system);
+	}
+
+	m_reinserted_count = bodies_count;
+}
+
+void DynamicAabbTree::buildNode(const World& world, float margin, size_t begin, size_t end, int32_t node_idx, JobSystem* job_system)
+{
+	const float* positions[3] = { world.getPositionsX(), world.getPositionsY(), world.getPositionsZ() };
+	Node& node = m_nodes[node_idx];
+
+	if (end - begin == 1) {
+		uint32_t body_idx = m_leaf_order[begin];
+		node.child1 = NULL_NODE;
+		node.child2 = NULL_NODE;
+		node.height = 0;
+		node.body_idx = body_idx;
+		setFatAabb(node_idx, getBodyAabb(positions[0], positions[1], positions[2], world.getRadii(), body_idx), margin);
+		m_body_leaves[body_idx] = node_idx;
+		return;
+	}
+
+	// Median split along the longest axis of the body centers. A subtree of n leaves takes 2n - 1 nodes, so the
+	// nodes are laid out depth first and both halves can be built in parallel without allocating.
+	float center_min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float center_max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for (size_t i = begin; i < end; i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			center_min[axis] = std::min(center_min[axis], positions[axis][m_leaf_order[i]]);
+			center_max[axis] = std::max(center_max[axis], positions[axis][m_leaf_order[i]]);
+		}
+	}
+
+	int split_axis = 0;
+	for (int axis = 1; axis < 3; axis++) {
+		if (center_max[axis] - center_min[axis] > center_max[split_axis] - center_min[split_axis]) {
+			split_axis = axis;
+		}
+	}
+
+	const float* split_positions = positions[split_axis];
+	size_t middle = begin + (end - begin) / 2;
+	std::nth_element(m_leaf_order.begin() + begin, m_leaf_order.begin() + middle, m_leaf_order.begin() + end,
+		[split_positions](uint32_t a, uint32_t b) { return split_positions[a] < split_positions[b]; });
+
+	int32_t child1_idx = node_idx + 1;
+	int32_t child2_idx = node_idx + static_cast<int32_t>(2 * (middle - begin));
+	m_nodes[child1_idx].parent = node_idx;
+	m_nodes[child2_idx].parent = node_idx;
+
+	if ((job_system != nullptr) && (end - begin >= PARALLEL_BUILD_MIN_LEAVES_COUNT)) {
+		JobCounter counter;
+		job_system->schedule([&]() { buildNode(world, margin, begin, middle, child1_idx, job_system); }, &counter);
+		buildNode(world, margin, middle, end, child2_idx, job_system);
+		job_system->wait(counter);
+	}
+	else {
+		buildNode(world, margin, begin, middle, child1_idx, job_system);
+		buildNode(world, margin, middle, end, child2_idx, job_system);
+	}
+
+	node.child1 = child1_idx;
+	node.child2 = child2_idx;
+	node.body_idx = UINT32_MAX;
+	node.height = 1 + std::max(m_nodes[child1_idx].height, m_nodes[child2_idx].height);
+	node.aabb = combineAabbs(m_nodes[child1_idx].aabb, m_nodes[child2_idx].aabb);
+}
+
+void DynamicAabbTree::setFatAabb(int32_t leaf_idx, const Aabb& aabb, float margin)
+{
+	Aabb& fat_aabb = m_nodes[leaf_idx].aabb;
+	for (int axis = 0; axis < 3; axis++) {
+		fat_aabb.min[axis] = aabb.min[axis] - margin;
+		fat_aabb.max[axis] = aabb.max[axis] + margin;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "broadphase.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Simulator {
+	class World;
+	class JobSystem;
+
+	// Bounding volume hierarchy with one leaf per body. Leaves hold boxes fattened by a margin, so a body is only
+	// reinserted once it leaves its fat box. Inserts pick the cheapest sibling by surface area and keep the tree
+	// balanced with rotations. When most bodies are new or have moved, the tree is rebuilt top-down instead.
+	class DynamicAabbTree {
+	public:
+		void update(const World& world, float margin, size_t chunk_size, JobSystem* job_system);
+		void findPairs(const World& world, size_t begin, size_t end, std::vector<BroadphasePair>& out_pairs) const;
+		void clear();
+		uint32_t getHeight() const;
+		size_t getLeavesCount() const;
+		size_t getReinsertedCount() const;
+
+		static constexpr int32_t NULL_NODE = -1;
+		static constexpr size_t MAX_QUERY_DEPTH = 256;
+		static constexpr size_t PARALLEL_BUILD_MIN_LEAVES_COUNT = 16384;
+
+	private:
+		struct Node {
+			Aabb aabb;
+			int32_t parent;
+			int32_t child1;
+			int32_t child2;
+			int32_t height;
+			uint32_t body_idx;
+		};
+
+		int32_t allocateNode();
+		void freeNode(int32_t node_idx);
+		void insertLeaf(int32_t leaf_idx);
+		void removeLeaf(int32_t leaf_idx);
+		int32_t balance(int32_t node_idx);
+		void refitAncestors(int32_t node_idx);
+		void setFatAabb(int32_t leaf_idx, const Aabb& aabb, float margin);
+		void rebuild(const World& world, float margin, JobSystem* job_system);
+		void buildNode(const World& world, float margin, size_t begin, size_t end, int32_t node_idx, JobSystem* job_system);
+
+		std::vector<Node> m_nodes;
+		int32_t m_root = NULL_NODE;
+		int32_t m_free_list = NULL_NODE;
+		std::vector<int32_t> m_body_leaves;
+		std::vector<uint32_t> m_leaf_order;
+		std::vector<uint8_t> m_moved_flags;
+		size_t m_reinserted_count = 0;
+	};
+}
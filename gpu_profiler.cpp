@@ -0,0 +1,343 @@
+#include "gpu_profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+using namespace Simulator;
+
+GpuProfiler::~GpuProfiler()
+{
+	destroy();
+}
+
+bool GpuProfiler::create(VkDevice logical_device, float timestamp_period, uint32_t timestamp_valid_bits, bool calibrated_timestamps_supported,
+	uint32_t frame_slots_count, const VkAllocationCallbacks* allocation_callbacks, std::string& out_error_message)
+{
+	destroy();
+
+	if ((timestamp_valid_bits == 0) || (timestamp_period <= 0.0f) || (frame_slots_count == 0)) {
+		return true;
+	}
+
+	VkQueryPoolCreateInfo query_pool_create_info{};
+	query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	query_pool_create_info.pNext = nullptr;
+	query_pool_create_info.flags = 0;
+	query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	query_pool_create_info.queryCount = frame_slots_count * MAX_QUERIES_PER_FRAME;
+	query_pool_create_info.pipelineStatistics = 0;
+
+	VkResult vk_error = vkCreateQueryPool(logical_device, &query_pool_create_info, allocation_callbacks, &m_vk_query_pool);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan timestamp query pool. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_query_pool = VK_NULL_HANDLE;
+		return false;
+	}
+
+	m_vk_logical_device = logical_device;
+	m_allocation_callbacks = allocation_callbacks;
+	m_timestamp_period_us = static_cast<double>(timestamp_period) / 1000.0;
+	m_timestamp_mask = (timestamp_valid_bits >= 64) ? UINT64_MAX : ((1ull << timestamp_valid_bits) - 1);
+	m_frame_slots.assign(frame_slots_count, {});
+	m_current_slot = UINT32_MAX;
+	m_scope_stack.clear();
+	m_query_results.resize(MAX_QUERIES_PER_FRAME);
+	m_calibrated_timestamps_supported = calibrated_timestamps_supported;
+	m_calibrated_timestamps_supported = calibrate();
+	return true;
+}
+
+void GpuProfiler::destroy()
+{
+	if (m_vk_query_pool != VK_NULL_HANDLE) {
+		for (uint32_t i = 0; i < m_frame_slots.size(); i++) {
+			collectFrame(i);
+		}
+
+		vkDestroyQueryPool(m_vk_logical_device, m_vk_query_pool, m_allocation_callbacks);
+		m_vk_query_pool = VK_NULL_HANDLE;
+	}
+
+	m_vk_logical_device = VK_NULL_HANDLE;
+	m_calibrated_timestamps_supported = false;
+	m_frame_slots.clear();
+	m_current_slot = UINT32_MAX;
+	m_scope_stack.clear();
+}
+
+bool GpuProfiler::isEnabled() const
+{
+	return m_vk_query_pool != VK_NULL_HANDLE;
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer command_buffer, uint32_t frame_slot)
+{
+	if ((m_vk_query_pool == VK_NULL_HANDLE) || (frame_slot >= m_frame_slots.size())) {
+		return;
+	}
+
+	collectFrame(frame_slot);
+
+	FrameSlot& slot = m_frame_slots[frame_slot];
+	slot.scopes.clear();
+	slot.queries_count = 0;
+	slot.cpu_begin_us = getCpuTimestampUs();
+	slot.pending = false;
+
+	m_current_slot = frame_slot;
+	m_scope_stack.clear();
+
+	vkCmdResetQueryPool(command_buffer, m_vk_query_pool, frame_slot * MAX_QUERIES_PER_FRAME, MAX_QUERIES_PER_FRAME);
+	beginScope(command_buffer, "frame");
+}
+
+void GpuProfiler::endFrame(VkCommandBuffer command_buffer)
+{
+	if (m_current_slot == UINT32_MAX) {
+		return;
+	}
+
+	while (!m_scope_stack.empty()) {
+		endScope(command_buffer);
+	}
+
+	m_frame_slots[m_current_slot].pending = true;
+	m_current_slot = UINT32_MAX;
+}
+
+void GpuProfiler::beginScope(VkCommandBuffer command_buffer, const char* name)
+{
+	if (m_current_slot == UINT32_MAX) {
+		return;
+	}
+
+	FrameSlot& slot = m_frame_slots[m_current_slot];
+	if (slot.queries_count + 2 > MAX_QUERIES_PER_FRAME) {
+		m_scope_stack.push_back(UINT32_MAX);
+		return;
+	}
+
+	Scope scope;
+	scope.name = name;
+	scope.depth = static_cast<uint32_t>(m_scope_stack.size());
+	scope.begin_query = slot.queries_count++;
+	scope.end_query = slot.queries_count++;
+
+	m_scope_stack.push_back(static_cast<uint32_t>(slot.scopes.size()));
+	slot.scopes.push_back(scope);
+
+	vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, m_vk_query_pool,
+		m_current_slot * MAX_QUERIES_PER_FRAME + scope.begin_query);
+}
+
+void GpuProfiler::endScope(VkCommandBuffer command_buffer)
+{
+	if ((m_current_slot == UINT32_MAX) || m_scope_stack.empty()) {
+		return;
+	}
+
+	uint32_t scope_idx = m_scope_stack.back();
+	m_scope_stack.pop_back();
+
+	if (scope_idx == UINT32_MAX) {
+		return;
+	}
+
+	const Scope& scope = m_frame_slots[m_current_slot].scopes[scope_idx];
+	vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, m_vk_query_pool,
+		m_current_slot * MAX_QUERIES_PER_FRAME + scope.end_query);
+}
+
+uint64_t GpuProfiler::getCpuTimestampUs() const
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start_time).count();
+}
+
+void GpuProfiler::addCpuScope(const char* name, uint64_t begin_us, uint64_t end_us, uint32_t thread_id)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	addSample(name, false, 0, static_cast<double>(end_us - begin_us) / 1000.0);
+	addTraceEvent(name, static_cast<double>(begin_us), static_cast<double>(end_us), thread_id);
+}
+
+std::vector<ProfilerScopeStats> GpuProfiler::getScopeStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<ProfilerScopeStats> scope_stats;
+	scope_stats.reserve(m_scope_histories.size());
+
+	for (const auto& [name, history] : m_scope_histories) {
+		uint32_t window_size = static_cast<uint32_t>(std::min<uint64_t>(history.samples_count, STATS_WINDOW_SIZE));
+		if (window_size == 0) {
+			continue;
+		}
+
+		ProfilerScopeStats stats;
+		stats.name = name;
+		stats.gpu = history.gpu;
+		stats.depth = history.depth;
+		stats.samples_count = history.samples_count;
+		stats.last_ms = history.last_ms;
+		stats.min_ms = history.samples_ms[0];
+		stats.max_ms = history.samples_ms[0];
+
+		double total_ms = 0.0;
+		for (uint32_t i = 0; i < window_size; i++) {
+			total_ms += history.samples_ms[i];
+			stats.min_ms = std::min(stats.min_ms, history.samples_ms[i]);
+			stats.max_ms = std::max(stats.max_ms, history.samples_ms[i]);
+		}
+
+		stats.average_ms = total_ms / window_size;
+		scope_stats.push_back(stats);
+	}
+
+	std::stable_sort(scope_stats.begin(), scope_stats.end(),
+		[](const ProfilerScopeStats& a, const ProfilerScopeStats& b) { return (a.gpu != b.gpu) ? a.gpu : (a.depth < b.depth); });
+
+	return scope_stats;
+}
+
+size_t GpuProfiler::getTraceEventsCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_trace_events.size();
+}
+
+uint64_t GpuProfiler::getDroppedFramesCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_dropped_frames_count;
+}
+
+bool GpuProfiler::isCalibrated() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_calibrated_timestamps_supported;
+}
+
+bool GpuProfiler::writeChromeTrace(const std::filesystem::path& file_path, std::string& out_error_message) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::ofstream file(file_path, std::ofstream::out | std::ofstream::trunc);
+	if (!file.is_open()) {
+		out_error_message = "Failed to create trace file \"" + file_path.string() + "\".";
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_THREAD_ID << ",\"args\":{\"name\":\"" <<
+		(m_calibrated_timestamps_supported ? "GPU" : "GPU (frame relative)") << "\"}}";
+
+	for (const TraceEvent& event : m_trace_events) {
+		file << ",\n{\"name\":\"";
+		for (const char* c = event.name; *c != '\0'; c++) {
+			if ((*c == '"') || (*c == '\\')) {
+				file << '\\';
+			}
+			file << *c;
+		}
+		file << "\",\"cat\":\"" << ((event.thread_id == GPU_THREAD_ID) ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread_id <<
+			",\"ts\":" << event.begin_us << ",\"dur\":" << event.duration_us << "}";
+	}
+
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	file.flush();
+
+	if (!file.good()) {
+		out_error_message = "Failed to write trace file \"" + file_path.string() + "\".";
+		return false;
+	}
+
+	return true;
+}
+
+void GpuProfiler::collectFrame(uint32_t frame_slot)
+{
+	FrameSlot& slot = m_frame_slots[frame_slot];
+	if (!slot.pending || (slot.queries_count == 0)) {
+		return;
+	}
+
+	slot.pending = false;
+
+	VkResult vk_error = vkGetQueryPoolResults(m_vk_logical_device, m_vk_query_pool, frame_slot * MAX_QUERIES_PER_FRAME, slot.queries_count,
+		slot.queries_count * sizeof(uint64_t), m_query_results.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// VK_NOT_READY leaves the frame without results, the slot is reset and reused by the next frame.
+	if (vk_error != VK_SUCCESS) {
+		m_dropped_frames_count++;
+		return;
+	}
+
+	// Without calibration the device clock has no known CPU time, the frame begin is pinned to the CPU time it was recorded at.
+	bool calibrated = m_calibrated_timestamps_supported && calibrate();
+	uint64_t origin_ticks = calibrated ? m_calibration_ticks : m_query_results[slot.scopes.front().begin_query];
+	double origin_us = calibrated ? m_calibration_us : static_cast<double>(slot.cpu_begin_us);
+
+	for (const Scope& scope : slot.scopes) {
+		// The frame completed before it was collected, so its timestamps are usually older than the calibration point.
+		uint64_t offset_ticks = (m_query_results[scope.begin_query] - origin_ticks) & m_timestamp_mask;
+		double offset_us = (offset_ticks > (m_timestamp_mask >> 1)) ?
+			-static_cast<double>((m_timestamp_mask - offset_ticks) + 1) * m_timestamp_period_us : offset_ticks * m_timestamp_period_us;
+		uint64_t duration_ticks = (m_query_results[scope.end_query] - m_query_results[scope.begin_query]) & m_timestamp_mask;
+
+		double begin_us = origin_us + offset_us;
+		double duration_us = duration_ticks * m_timestamp_period_us;
+
+		addSample(scope.name, true, scope.depth, duration_us / 1000.0);
+		addTraceEvent(scope.name, begin_us, begin_us + duration_us, GPU_THREAD_ID);
+	}
+}
+
+bool GpuProfiler::calibrate()
+{
+	if (!m_calibrated_timestamps_supported) {
+		return false;
+	}
+
+	VkCalibratedTimestampInfoEXT timestamp_info{};
+	timestamp_info.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	timestamp_info.pNext = nullptr;
+	timestamp_info.timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+
+	// The device clock is read between two reads of the CPU clock, the midpoint is taken as its CPU time.
+	uint64_t ticks;
+	uint64_t max_deviation;
+	std::chrono::steady_clock::time_point cpu_begin = std::chrono::steady_clock::now();
+	VkResult vk_error = vkGetCalibratedTimestampsEXT(m_vk_logical_device, 1, &timestamp_info, &ticks, &max_deviation);
+	std::chrono::steady_clock::time_point cpu_end = std::chrono::steady_clock::now();
+	if (vk_error != VK_SUCCESS) {
+		m_calibrated_timestamps_supported = false;
+		return false;
+	}
+
+	m_calibration_ticks = ticks;
+	m_calibration_us = std::chrono::duration<double, std::micro>((cpu_begin - m_start_time) + (cpu_end - cpu_begin) / 2).count();
+	return true;
+}
+
+void GpuProfiler::addSample(const char* name, bool gpu, uint32_t depth, double duration_ms)
+{
+	ScopeHistory& history = m_scope_histories[name];
+	history.gpu = gpu;
+	history.depth = depth;
+	history.last_ms = duration_ms;
+	history.samples_ms[history.samples_count % STATS_WINDOW_SIZE] = duration_ms;
+	history.samples_count++;
+}
+
+void GpuProfiler::addTraceEvent(const char* name, double begin_us, double end_us, uint32_t thread_id)
+{
+	if (m_trace_events.size() >= MAX_TRACE_EVENTS) {
+		return;
+	}
+
+	m_trace_events.push_back({ name, begin_us, end_us - begin_us, thread_id });
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Volk/volk.h>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Simulator {
+	struct ProfilerScopeStats {
+		std::string name;
+		bool gpu = true;
+		uint32_t depth = 0;
+		uint64_t samples_count = 0;
+		double last_ms = 0.0;
+		double average_ms = 0.0;
+		double min_ms = 0.0;
+		double max_ms = 0.0;
+	};
+
+	class GpuProfiler {
+	public:
+		~GpuProfiler();
+		// With calibrated timestamps the GPU track shares the CPU time base, otherwise each frame is placed at its CPU begin time.
+		bool create(VkDevice logical_device, float timestamp_period, uint32_t timestamp_valid_bits, bool calibrated_timestamps_supported,
+			uint32_t frame_slots_count, const VkAllocationCallbacks* allocation_callbacks, std::string& out_error_message);
+		void destroy();
+		bool isEnabled() const;
+		void beginFrame(VkCommandBuffer command_buffer, uint32_t frame_slot);
+		void endFrame(VkCommandBuffer command_buffer);
+		void beginScope(VkCommandBuffer command_buffer, const char* name);
+		void endScope(VkCommandBuffer command_buffer);
+		uint64_t getCpuTimestampUs() const;
+		void addCpuScope(const char* name, uint64_t begin_us, uint64_t end_us, uint32_t thread_id);
+		std::vector<ProfilerScopeStats> getScopeStats() const;
+		size_t getTraceEventsCount() const;
+		uint64_t getDroppedFramesCount() const;
+		bool isCalibrated() const;
+		bool writeChromeTrace(const std::filesystem::path& file_path, std::string& out_error_message) const;
+
+		static constexpr uint32_t MAX_SCOPES_PER_FRAME = 64;
+		static constexpr uint32_t STATS_WINDOW_SIZE = 120;
+		static constexpr size_t MAX_TRACE_EVENTS = 200000;
+		static constexpr uint32_t GPU_THREAD_ID = 0;
+
+	private:
+		struct Scope {
+			const char* name;
+			uint32_t depth;
+			uint32_t begin_query;
+			uint32_t end_query;
+		};
+
+		struct FrameSlot {
+			std::vector<Scope> scopes;
+			uint32_t queries_count = 0;
+			uint64_t cpu_begin_us = 0;
+			bool pending = false;
+		};
+
+		struct ScopeHistory {
+			bool gpu = true;
+			uint32_t depth = 0;
+			uint64_t samples_count = 0;
+			double last_ms = 0.0;
+			double samples_ms[STATS_WINDOW_SIZE]{};
+		};
+
+		struct TraceEvent {
+			const char* name;
+			double begin_us;
+			double duration_us;
+			uint32_t thread_id;
+		};
+
+		void collectFrame(uint32_t frame_slot);
+		bool calibrate();
+		void addSample(const char* name, bool gpu, uint32_t depth, double duration_ms);
+		void addTraceEvent(const char* name, double begin_us, double end_us, uint32_t thread_id);
+
+		static constexpr uint32_t MAX_QUERIES_PER_FRAME = MAX_SCOPES_PER_FRAME * 2;
+
+		VkDevice m_vk_logical_device = VK_NULL_HANDLE;
+		const VkAllocationCallbacks* m_allocation_callbacks = nullptr;
+		VkQueryPool m_vk_query_pool = VK_NULL_HANDLE;
+		double m_timestamp_period_us = 0.0;
+		uint64_t m_timestamp_mask = 0;
+		bool m_calibrated_timestamps_supported = false;
+		uint64_t m_calibration_ticks = 0;
+		double m_calibration_us = 0.0;
+		std::vector<FrameSlot> m_frame_slots;
+		uint32_t m_current_slot = UINT32_MAX;
+		std::vector<uint32_t> m_scope_stack;
+		std::vector<uint64_t> m_query_results;
+		std::chrono::steady_clock::time_point m_start_time = std::chrono::steady_clock::now();
+		mutable std::mutex m_mutex;
+		std::map<std::string, ScopeHistory> m_scope_histories;
+		std::vector<TraceEvent> m_trace_events;
+		uint64_t m_dropped_frames_count = 0;
+	};
+}
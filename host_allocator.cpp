@@ -0,0 +1,235 @@
+#include "host_allocator.h"
+#include <algorithm>
+#include <new>
+#include <cstring>
+
+using namespace Simulator;
+
+static uintptr_t alignUp(uintptr_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+}
+
+HostAllocator::HostAllocator()
+{
+	m_callbacks.pUserData = this;
+	m_callbacks.pfnAllocation = allocationCallback;
+	m_callbacks.pfnReallocation = reallocationCallback;
+	m_callbacks.pfnFree = freeCallback;
+	m_callbacks.pfnInternalAllocation = internalAllocationCallback;
+	m_callbacks.pfnInternalFree = internalFreeCallback;
+}
+
+const VkAllocationCallbacks* HostAllocator::getCallbacks() const
+{
+	return &m_callbacks;
+}
+
+HostAllocatorStats HostAllocator::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+const char* HostAllocator::getScopeName(uint32_t scope)
+{
+	switch (scope) {
+	case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND:
+		return "command";
+	case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT:
+		return "object";
+	case VK_SYSTEM_ALLOCATION_SCOPE_CACHE:
+		return "cache";
+	case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE:
+		return "device";
+	case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE:
+		return "instance";
+	}
+
+	return "unknown";
+}
+
+void* HostAllocator::allocate(size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	if (size == 0) {
+		return nullptr;
+	}
+
+	alignment = std::max(alignment, alignof(AllocationHeader));
+	size_t required_size = sizeof(AllocationHeader) + size + alignment;
+	uint32_t scope_idx = std::min(static_cast<uint32_t>(scope), HostAllocatorStats::SCOPES_COUNT - 1);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	void* base = nullptr;
+	Source source = Source::HEAP;
+	uint32_t size_class_idx = 0;
+
+	if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+		if (!m_arena) {
+			m_arena.reset(new (std::nothrow) uint8_t[ARENA_SIZE]);
+		}
+
+		if (m_arena && (m_arena_offset + required_size <= ARENA_SIZE)) {
+			base = m_arena.get() + m_arena_offset;
+			m_arena_offset = alignUp(m_arena_offset + required_size, alignof(std::max_align_t));
+			m_arena_live_count++;
+			source = Source::ARENA;
+			m_stats.arena_allocations_count++;
+		}
+	}
+	else if (required_size <= POOL_MAX_CHUNK_SIZE) {
+		while ((POOL_MIN_CHUNK_SIZE << size_class_idx) < required_size) {
+			size_class_idx++;
+		}
+
+		base = allocateFromPool(size_class_idx);
+		if (base != nullptr) {
+			source = Source::POOL;
+			m_stats.pool_allocations_count++;
+		}
+	}
+
+	if (base == nullptr) {
+		base = ::operator new(required_size, std::nothrow);
+		if (base == nullptr) {
+			return nullptr;
+		}
+
+		source = Source::HEAP;
+		m_stats.heap_allocations_count++;
+	}
+
+	uintptr_t memory = alignUp(reinterpret_cast<uintptr_t>(base) + sizeof(AllocationHeader), alignment);
+
+	AllocationHeader* header = reinterpret_cast<AllocationHeader*>(memory - sizeof(AllocationHeader));
+	header->base = base;
+	header->size = size;
+	header->scope = scope_idx;
+	header->source = source;
+	header->size_class_idx = static_cast<uint16_t>(size_class_idx);
+
+	HostAllocationScopeStats& scope_stats = m_stats.scopes[scope_idx];
+	scope_stats.allocated_size += size;
+	scope_stats.peak_allocated_size = std::max(scope_stats.peak_allocated_size, scope_stats.allocated_size);
+	scope_stats.allocations_count++;
+	scope_stats.allocations_total_count++;
+
+	return reinterpret_cast<void*>(memory);
+}
+
+void* HostAllocator::reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	if (original == nullptr) {
+		return allocate(size, alignment, scope);
+	}
+
+	if (size == 0) {
+		free(original);
+		return nullptr;
+	}
+
+	void* memory = allocate(size, alignment, scope);
+	if (memory == nullptr) {
+		return nullptr;
+	}
+
+	const AllocationHeader* header = reinterpret_cast<const AllocationHeader*>(static_cast<uint8_t*>(original) - sizeof(AllocationHeader));
+	memcpy(memory, original, std::min(size, header->size));
+	free(original);
+	return memory;
+}
+
+void HostAllocator::free(void* memory)
+{
+	if (memory == nullptr) {
+		return;
+	}
+
+	AllocationHeader header;
+	memcpy(&header, static_cast<uint8_t*>(memory) - sizeof(AllocationHeader), sizeof(header));
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	HostAllocationScopeStats& scope_stats = m_stats.scopes[header.scope];
+	scope_stats.allocated_size -= header.size;
+	scope_stats.allocations_count--;
+
+	switch (header.source) {
+	case Source::ARENA:
+		m_arena_live_count--;
+		if (m_arena_live_count == 0) {
+			m_arena_offset = 0;
+			m_stats.arena_resets_count++;
+		}
+		break;
+	case Source::POOL:
+		m_pool_free_lists[header.size_class_idx].push_back(header.base);
+		break;
+	case Source::HEAP:
+		::operator delete(header.base);
+		break;
+	}
+}
+
+void* HostAllocator::allocateFromPool(uint32_t size_class_idx)
+{
+	std::vector<void*>& free_list = m_pool_free_lists[size_class_idx];
+
+	if (free_list.empty()) {
+		uint8_t* slab = new (std::nothrow) uint8_t[POOL_SLAB_SIZE];
+		if (slab == nullptr) {
+			return nullptr;
+		}
+
+		m_pool_slabs.emplace_back(slab);
+		m_stats.pool_slabs_size += POOL_SLAB_SIZE;
+
+		size_t chunk_size = POOL_MIN_CHUNK_SIZE << size_class_idx;
+		for (size_t offset = POOL_SLAB_SIZE; offset >= chunk_size; offset -= chunk_size) {
+			free_list.push_back(slab + offset - chunk_size);
+		}
+	}
+
+	void* chunk = free_list.back();
+	free_list.pop_back();
+	return chunk;
+}
+
+/**************************************************************************************/
+
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::allocationCallback(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+	return static_cast<HostAllocator*>(user_data)->allocate(size, alignment, scope);
+}
+
+VKAPI_ATTR void* VKAPI_CALL HostAllocator::reallocationCallback(void* user_data, void* original, size_t size, size_t alignment,
+	VkSystemAllocationScope scope)
+{
+	return static_cast<HostAllocator*>(user_data)->reallocate(original, size, alignment, scope);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::freeCallback(void* user_data, void* memory)
+{
+	static_cast<HostAllocator*>(user_data)->free(memory);
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalAllocationCallback(void* user_data, size_t size, VkInternalAllocationType type,
+	VkSystemAllocationScope scope)
+{
+	HostAllocator* allocator = static_cast<HostAllocator*>(user_data);
+	uint32_t scope_idx = std::min(static_cast<uint32_t>(scope), HostAllocatorStats::SCOPES_COUNT - 1);
+
+	std::lock_guard<std::mutex> lock(allocator->m_mutex);
+	allocator->m_stats.scopes[scope_idx].internal_allocated_size += size;
+}
+
+VKAPI_ATTR void VKAPI_CALL HostAllocator::internalFreeCallback(void* user_data, size_t size, VkInternalAllocationType type,
+	VkSystemAllocationScope scope)
+{
+	HostAllocator* allocator = static_cast<HostAllocator*>(user_data);
+	uint32_t scope_idx = std::min(static_cast<uint32_t>(scope), HostAllocatorStats::SCOPES_COUNT - 1);
+
+	std::lock_guard<std::mutex> lock(allocator->m_mutex);
+	allocator->m_stats.scopes[scope_idx].internal_allocated_size -= size;
+}
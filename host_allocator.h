@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Volk/volk.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Simulator {
+	struct HostAllocationScopeStats {
+		uint64_t allocated_size = 0;
+		uint64_t peak_allocated_size = 0;
+		uint64_t allocations_count = 0;
+		uint64_t allocations_total_count = 0;
+		uint64_t internal_allocated_size = 0;
+	};
+
+	struct HostAllocatorStats {
+		static constexpr uint32_t SCOPES_COUNT = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+
+		HostAllocationScopeStats scopes[SCOPES_COUNT];
+		uint64_t arena_allocations_count = 0;
+		uint64_t pool_allocations_count = 0;
+		uint64_t heap_allocations_count = 0;
+		uint64_t arena_resets_count = 0;
+		uint64_t pool_slabs_size = 0;
+	};
+
+	class HostAllocator {
+	public:
+		HostAllocator();
+		HostAllocator(const HostAllocator&) = delete;
+		HostAllocator& operator=(const HostAllocator&) = delete;
+		const VkAllocationCallbacks* getCallbacks() const;
+		HostAllocatorStats getStats() const;
+		static const char* getScopeName(uint32_t scope);
+
+		static constexpr size_t ARENA_SIZE = 256 * 1024;
+		static constexpr size_t POOL_SLAB_SIZE = 64 * 1024;
+		static constexpr size_t POOL_MIN_CHUNK_SIZE = 64;
+		static constexpr size_t POOL_MAX_CHUNK_SIZE = 4096;
+
+	private:
+		enum class Source : uint16_t {
+			ARENA,
+			POOL,
+			HEAP
+		};
+
+		struct AllocationHeader {
+			void* base;
+			size_t size;
+			uint32_t scope;
+			Source source;
+			uint16_t size_class_idx;
+		};
+
+		static constexpr uint32_t SIZE_CLASSES_COUNT = 7;
+
+		void* allocate(size_t size, size_t alignment, VkSystemAllocationScope scope);
+		void* reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+		void free(void* memory);
+		void* allocateFromPool(uint32_t size_class_idx);
+
+		static VKAPI_ATTR void* VKAPI_CALL allocationCallback(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope scope);
+		static VKAPI_ATTR void* VKAPI_CALL reallocationCallback(void* user_data, void* original, size_t size, size_t alignment,
+			VkSystemAllocationScope scope);
+		static VKAPI_ATTR void VKAPI_CALL freeCallback(void* user_data, void* memory);
+		static VKAPI_ATTR void VKAPI_CALL internalAllocationCallback(void* user_data, size_t size, VkInternalAllocationType type,
+			VkSystemAllocationScope scope);
+		static VKAPI_ATTR void VKAPI_CALL internalFreeCallback(void* user_data, size_t size, VkInternalAllocationType type,
+			VkSystemAllocationScope scope);
+
+		VkAllocationCallbacks m_callbacks{};
+		mutable std::mutex m_mutex;
+		std::unique_ptr<uint8_t[]> m_arena;
+		size_t m_arena_offset = 0;
+		uint64_t m_arena_live_count = 0;
+		std::vector<void*> m_pool_free_lists[SIZE_CLASSES_COUNT];
+		std::vector<std::unique_ptr<uint8_t[]>> m_pool_slabs;
+		HostAllocatorStats m_stats;
+	};
+}
@@ -0,0 +1,428 @@
+#include "instrumentation.h"
+#include "latency_histogram.h"
+#include "logger.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace Simulator;
+
+namespace {
+	struct Event {
+		uint32_t point_id;
+		uint64_t begin_ticks;
+		uint64_t value;
+	};
+
+	struct ThreadBuffer {
+		uint32_t thread_id = 0;
+		alignas(64) std::atomic<uint64_t> write_pos = 0;
+		alignas(64) std::atomic<uint64_t> read_pos = 0;
+		std::atomic<uint64_t> dropped_count = 0;
+		std::array<std::atomic<uint64_t>, Instrumentation::MAX_POINTS> counters{};
+		std::array<Event, Instrumentation::THREAD_EVENTS_CAPACITY> events;
+	};
+
+	struct PointInfo {
+		const char* name = nullptr;
+		InstrumentKind kind = InstrumentKind::SCOPE;
+	};
+
+	struct PointAggregate {
+		uint64_t count = 0;
+		uint64_t total = 0;
+		uint64_t min = UINT64_MAX;
+		uint64_t max = 0;
+		LatencyHistogram histogram;
+	};
+
+	struct TraceEvent {
+		uint32_t point_id;
+		uint32_t thread_id;
+		uint64_t begin_ticks;
+		uint64_t end_ticks;
+	};
+
+	struct State {
+		~State();
+		ThreadBuffer* getThreadBuffer();
+		void releaseThreadBuffer(ThreadBuffer* buffer);
+		void drain();
+		double getNanosecondsPerTick() const;
+		void workerProcess();
+		void stopWorker();
+
+		std::mutex points_mutex;
+		std::array<PointInfo, Instrumentation::MAX_POINTS> points;
+		uint32_t points_count = 0;
+		std::mutex buffers_mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		std::vector<ThreadBuffer*> free_buffers;
+		std::mutex aggregates_mutex;
+		std::array<std::unique_ptr<PointAggregate>, Instrumentation::MAX_POINTS> aggregates;
+		std::vector<TraceEvent> trace_events;
+		uint64_t base_ticks = Instrumentation::getTicks();
+		std::chrono::steady_clock::time_point base_time = std::chrono::steady_clock::now();
+		InstrumentationSettings settings;
+		std::thread worker_thread;
+		std::mutex worker_mutex;
+		std::condition_variable worker_variable;
+		bool worker_stopping = false;
+	};
+
+	State& getState()
+	{
+		static State state;
+		return state;
+	}
+
+	// Hands the buffer back when its thread exits, so short lived threads do not each leave a buffer behind.
+	struct ThreadBufferOwner {
+		~ThreadBufferOwner()
+		{
+			if (buffer != nullptr) {
+				getState().releaseThreadBuffer(buffer);
+			}
+		}
+
+		ThreadBuffer* buffer = nullptr;
+	};
+
+	thread_local ThreadBufferOwner t_thread_buffer;
+}
+
+State::~State()
+{
+	stopWorker();
+}
+
+ThreadBuffer* State::getThreadBuffer()
+{
+	if (t_thread_buffer.buffer == nullptr) {
+		std::lock_guard<std::mutex> lock(buffers_mutex);
+
+		// A reused buffer keeps its events, counters and trace thread id, its previous thread is gone so there is still one writer.
+		if (!free_buffers.empty()) {
+			t_thread_buffer.buffer = free_buffers.back();
+			free_buffers.pop_back();
+		}
+		else {
+			buffers.push_back(std::make_unique<ThreadBuffer>());
+			buffers.back()->thread_id = static_cast<uint32_t>(buffers.size());
+			t_thread_buffer.buffer = buffers.back().get();
+		}
+	}
+
+	return t_thread_buffer.buffer;
+}
+
+void State::releaseThreadBuffer(ThreadBuffer* buffer)
+{
+	std::lock_guard<std::mutex> lock(buffers_mutex);
+	free_buffers.push_back(buffer);
+}
+
+void State::drain()
+{
+	std::vector<ThreadBuffer*> thread_buffers;
+	{
+		std::lock_guard<std::mutex> lock(buffers_mutex);
+
+		thread_buffers.reserve(buffers.size());
+		for (const std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+			thread_buffers.push_back(buffer.get());
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(aggregates_mutex);
+
+	double ns_per_tick = getNanosecondsPerTick();
+
+	for (ThreadBuffer* buffer : thread_buffers) {
+		uint64_t read_pos = buffer->read_pos.load(std::memory_order_relaxed);
+		uint64_t write_pos = buffer->write_pos.load(std::memory_order_acquire);
+
+		for (; read_pos != write_pos; read_pos++) {
+			const Event& event = buffer->events[read_pos % Instrumentation::THREAD_EVENTS_CAPACITY];
+
+			std::unique_ptr<PointAggregate>& aggregate = aggregates[event.point_id];
+			if (aggregate == nullptr) {
+				aggregate = std::make_unique<PointAggregate>();
+			}
+
+			uint64_t value = event.value;
+			if (points[event.point_id].kind == InstrumentKind::SCOPE) {
+				value = static_cast<uint64_t>((event.value - event.begin_ticks) * ns_per_tick);
+
+				if (settings.trace && (trace_events.size() < Instrumentation::MAX_TRACE_EVENTS)) {
+					trace_events.push_back({ event.point_id, buffer->thread_id, event.begin_ticks, event.value });
+				}
+			}
+
+			aggregate->count++;
+			aggregate->total += value;
+			aggregate->min = std::min(aggregate->min, value);
+			aggregate->max = std::max(aggregate->max, value);
+			aggregate->histogram.add(value);
+		}
+
+		buffer->read_pos.store(read_pos, std::memory_order_release);
+	}
+}
+
+double State::getNanosecondsPerTick() const
+{
+	uint64_t elapsed_ticks = Instrumentation::getTicks() - base_ticks;
+	uint64_t elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - base_time).count();
+
+	return (elapsed_ticks > 0) ? (static_cast<double>(elapsed_ns) / elapsed_ticks) : 1.0;
+}
+
+void State::workerProcess()
+{
+	std::unique_lock<std::mutex> lock(worker_mutex);
+
+	while (!worker_stopping) {
+		worker_variable.wait_for(lock, settings.aggregation_interval, [this]() { return worker_stopping; });
+
+		lock.unlock();
+		drain();
+		lock.lock();
+	}
+}
+
+void State::stopWorker()
+{
+	if (!worker_thread.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(worker_mutex);
+		worker_stopping = true;
+	}
+
+	worker_variable.notify_all();
+	worker_thread.join();
+}
+
+/**************************************************************************************/
+
+uint32_t Instrumentation::registerPoint(const char* name, InstrumentKind kind)
+{
+	State& state = getState();
+	std::lock_guard<std::mutex> lock(state.points_mutex);
+
+	if (state.points_count >= MAX_POINTS) {
+		return INVALID_POINT;
+	}
+
+	state.points[state.points_count].name = name;
+	state.points[state.points_count].kind = kind;
+	return state.points_count++;
+}
+
+uint64_t Instrumentation::getTicks()
+{
+#ifdef _MSC_VER
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void Instrumentation::recordScope(uint32_t point_id, uint64_t begin_ticks, uint64_t end_ticks)
+{
+	if (point_id == INVALID_POINT) {
+		return;
+	}
+
+	ThreadBuffer* buffer = getState().getThreadBuffer();
+
+	uint64_t write_pos = buffer->write_pos.load(std::memory_order_relaxed);
+	if (write_pos - buffer->read_pos.load(std::memory_order_acquire) >= THREAD_EVENTS_CAPACITY) {
+		buffer->dropped_count.store(buffer->dropped_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return;
+	}
+
+	buffer->events[write_pos % THREAD_EVENTS_CAPACITY] = { point_id, begin_ticks, end_ticks };
+	buffer->write_pos.store(write_pos + 1, std::memory_order_release);
+}
+
+void Instrumentation::recordValue(uint32_t point_id, uint64_t value)
+{
+	recordScope(point_id, 0, value);
+}
+
+void Instrumentation::addCounter(uint32_t point_id, uint64_t value)
+{
+	if (point_id == INVALID_POINT) {
+		return;
+	}
+
+	std::atomic<uint64_t>& counter = getState().getThreadBuffer()->counters[point_id];
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void Instrumentation::start(const InstrumentationSettings& settings)
+{
+	State& state = getState();
+	state.stopWorker();
+
+	{
+		std::lock_guard<std::mutex> lock(state.aggregates_mutex);
+		state.settings = settings;
+	}
+
+	state.worker_stopping = false;
+	state.worker_thread = std::thread(&State::workerProcess, &state);
+}
+
+void Instrumentation::stop()
+{
+	getState().stopWorker();
+}
+
+std::vector<InstrumentStats> Instrumentation::getStats()
+{
+	State& state = getState();
+	state.drain();
+
+	uint32_t points_count;
+	std::array<PointInfo, MAX_POINTS> points;
+	{
+		std::lock_guard<std::mutex> lock(state.points_mutex);
+		points_count = state.points_count;
+		points = state.points;
+	}
+
+	std::vector<uint64_t> counters(points_count, 0);
+	{
+		std::lock_guard<std::mutex> lock(state.buffers_mutex);
+
+		for (const std::unique_ptr<ThreadBuffer>& buffer : state.buffers) {
+			for (uint32_t i = 0; i < points_count; i++) {
+				counters[i] += buffer->counters[i].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(state.aggregates_mutex);
+
+	std::vector<InstrumentStats> stats;
+	for (uint32_t i = 0; i < points_count; i++) {
+		InstrumentStats point_stats;
+		point_stats.name = points[i].name;
+		point_stats.kind = points[i].kind;
+
+		if (points[i].kind == InstrumentKind::COUNTER) {
+			point_stats.count = 1;
+			point_stats.total = counters[i];
+		}
+		else if (state.aggregates[i] != nullptr) {
+			const PointAggregate& aggregate = *state.aggregates[i];
+			point_stats.count = aggregate.count;
+			point_stats.total = aggregate.total;
+			point_stats.min = aggregate.min;
+			point_stats.max = aggregate.max;
+			point_stats.p50 = aggregate.histogram.getPercentile(50.0);
+			point_stats.p99 = aggregate.histogram.getPercentile(99.0);
+		}
+
+		if (point_stats.count > 0) {
+			stats.push_back(point_stats);
+		}
+	}
+
+	return stats;
+}
+
+uint64_t Instrumentation::getDroppedEventsCount()
+{
+	State& state = getState();
+	std::lock_guard<std::mutex> lock(state.buffers_mutex);
+
+	uint64_t dropped_count = 0;
+	for (const std::unique_ptr<ThreadBuffer>& buffer : state.buffers) {
+		dropped_count += buffer->dropped_count.load(std::memory_order_relaxed);
+	}
+
+	return dropped_count;
+}
+
+void Instrumentation::logStats(Logger& logger)
+{
+	for (const InstrumentStats& stats : getStats()) {
+		switch (stats.kind) {
+		case InstrumentKind::SCOPE:
+			logger.log<LogFormat::INSTRUMENTATION_SCOPE_STATS>(stats.name, stats.count, stats.total / 1e6, stats.total / 1e3 / stats.count,
+				stats.p50 / 1e3, stats.p99 / 1e3, stats.max / 1e3);
+			break;
+		case InstrumentKind::COUNTER:
+			logger.log<LogFormat::INSTRUMENTATION_COUNTER>(stats.name, stats.total);
+			break;
+		case InstrumentKind::HISTOGRAM:
+			logger.log<LogFormat::INSTRUMENTATION_HISTOGRAM>(stats.name, stats.count, stats.min, static_cast<double>(stats.total) / stats.count,
+				stats.p50, stats.p99, stats.max);
+			break;
+		}
+	}
+
+	uint64_t dropped_events_count = getDroppedEventsCount();
+	if (dropped_events_count > 0) {
+		logger.log<LogFormat::INSTRUMENTATION_DROPPED_EVENTS>(dropped_events_count);
+	}
+}
+
+bool Instrumentation::writeTrace(const std::filesystem::path& file_path, std::string& out_error_message)
+{
+	State& state = getState();
+	state.drain();
+
+	std::array<PointInfo, MAX_POINTS> points;
+	{
+		std::lock_guard<std::mutex> lock(state.points_mutex);
+		points = state.points;
+	}
+
+	std::ofstream file(file_path, std::ofstream::out | std::ofstream::trunc);
+	if (!file.is_open()) {
+		out_error_message = "Failed to create trace file \"" + file_path.string() + "\".";
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(state.aggregates_mutex);
+
+	double us_per_tick = state.getNanosecondsPerTick() / 1000.0;
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[\n";
+
+	bool first_event = true;
+	for (const TraceEvent& event : state.trace_events) {
+		file << (first_event ? "" : ",\n") << "{\"name\":\"" << points[event.point_id].name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" <<
+			event.thread_id << ",\"ts\":" << (event.begin_ticks - state.base_ticks) * us_per_tick << ",\"dur\":" <<
+			(event.end_ticks - event.begin_ticks) * us_per_tick << "}";
+		first_event = false;
+	}
+
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	file.flush();
+
+	if (!file.good()) {
+		out_error_message = "Failed to write trace file \"" + file_path.string() + "\".";
+		return false;
+	}
+
+	return true;
+}
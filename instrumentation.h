@@ -0,0 +1,102 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#ifndef SIMULATOR_INSTRUMENTATION
+#define SIMULATOR_INSTRUMENTATION 1
+#endif
+
+#define SIMULATOR_INSTRUMENT_CONCAT_(a, b) a##b
+#define SIMULATOR_INSTRUMENT_CONCAT(a, b) SIMULATOR_INSTRUMENT_CONCAT_(a, b)
+
+#if SIMULATOR_INSTRUMENTATION
+#define SIMULATOR_SCOPE_TIMER(name) \
+	static const uint32_t SIMULATOR_INSTRUMENT_CONCAT(instrument_point_, __LINE__) = \
+		::Simulator::Instrumentation::registerPoint(name, ::Simulator::InstrumentKind::SCOPE); \
+	::Simulator::ScopeTimer SIMULATOR_INSTRUMENT_CONCAT(instrument_scope_, __LINE__)(SIMULATOR_INSTRUMENT_CONCAT(instrument_point_, __LINE__))
+#define SIMULATOR_COUNTER_ADD(name, value) \
+	do { \
+		static const uint32_t instrument_point = ::Simulator::Instrumentation::registerPoint(name, ::Simulator::InstrumentKind::COUNTER); \
+		::Simulator::Instrumentation::addCounter(instrument_point, value); \
+	} while (false)
+#define SIMULATOR_HISTOGRAM_RECORD(name, value) \
+	do { \
+		static const uint32_t instrument_point = ::Simulator::Instrumentation::registerPoint(name, ::Simulator::InstrumentKind::HISTOGRAM); \
+		::Simulator::Instrumentation::recordValue(instrument_point, value); \
+	} while (false)
+#else
+#define SIMULATOR_SCOPE_TIMER(name) ((void)0)
+#define SIMULATOR_COUNTER_ADD(name, value) ((void)0)
+#define SIMULATOR_HISTOGRAM_RECORD(name, value) ((void)0)
+#endif
+
+namespace Simulator {
+	class Logger;
+
+	enum class InstrumentKind : uint8_t {
+		SCOPE,
+		COUNTER,
+		HISTOGRAM
+	};
+
+	struct InstrumentationSettings {
+		std::chrono::milliseconds aggregation_interval{ 100 };
+		bool trace = false;
+	};
+
+	struct InstrumentStats {
+		const char* name = nullptr;
+		InstrumentKind kind = InstrumentKind::SCOPE;
+		uint64_t count = 0;
+		uint64_t total = 0;
+		uint64_t min = 0;
+		uint64_t max = 0;
+		uint64_t p50 = 0;
+		uint64_t p99 = 0;
+	};
+
+	class Instrumentation {
+	public:
+		static uint32_t registerPoint(const char* name, InstrumentKind kind);
+		static uint64_t getTicks();
+		static void recordScope(uint32_t point_id, uint64_t begin_ticks, uint64_t end_ticks);
+		static void recordValue(uint32_t point_id, uint64_t value);
+		static void addCounter(uint32_t point_id, uint64_t value);
+
+		static void start(const InstrumentationSettings& settings);
+		static void stop();
+		static std::vector<InstrumentStats> getStats();
+		static uint64_t getDroppedEventsCount();
+		static void logStats(Logger& logger);
+		static bool writeTrace(const std::filesystem::path& file_path, std::string& out_error_message);
+
+		static constexpr uint32_t MAX_POINTS = 256;
+		static constexpr size_t THREAD_EVENTS_CAPACITY = 16384;
+		static constexpr size_t MAX_TRACE_EVENTS = 1000000;
+		static constexpr uint32_t INVALID_POINT = UINT32_MAX;
+	};
+
+	class ScopeTimer {
+	public:
+		explicit ScopeTimer(uint32_t point_id)
+			: m_point_id(point_id), m_begin_ticks(Instrumentation::getTicks())
+		{
+		}
+
+		~ScopeTimer()
+		{
+			Instrumentation::recordScope(m_point_id, m_begin_ticks, Instrumentation::getTicks());
+		}
+
+		ScopeTimer(const ScopeTimer&) = delete;
+		ScopeTimer& operator=(const ScopeTimer&) = delete;
+
+	private:
+		uint32_t m_point_id;
+		uint64_t m_begin_ticks;
+	};
+}
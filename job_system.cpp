@@ -0,0 +1,452 @@
+#include "job_system.h"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMULATOR_JOB_PAUSE() _mm_pause()
+#else
+#define SIMULATOR_JOB_PAUSE() std::this_thread::yield()
+#endif
+
+using namespace Simulator;
+
+static thread_local const JobSystem* t_job_system = nullptr;
+static thread_local uint32_t t_thread_index = 0;
+static thread_local uint32_t t_random_state = 0x9E3779B9u;
+
+static uint32_t getNextRandom(uint32_t& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+bool JobCounter::isDone() const
+{
+	// Also wait for the finishing jobs to let go of the counter, so it can be destroyed once this returns true.
+	return (m_pending_count.load(std::memory_order_acquire) == 0) && (m_finishing_count.load(std::memory_order_acquire) == 0);
+}
+
+/**************************************************************************************/
+
+JobSystem::~JobSystem()
+{
+	stop();
+}
+
+bool JobSystem::start(const JobSystemSettings& settings, std::string& out_error_message)
+{
+	if (m_started) {
+		out_error_message = "Job system is already started.";
+		return false;
+	}
+
+	m_settings = settings;
+	uint32_t workers_count = (settings.workers_count != JobSystemSettings::DEFAULT_WORKERS_COUNT) ? settings.workers_count :
+		getDefaultWorkersCount();
+
+	for (uint32_t i = 0; i < workers_count; i++) {
+		std::unique_ptr<Worker> worker = std::make_unique<Worker>();
+		if (!worker->deque.init(settings.deque_capacity, out_error_message)) {
+			m_workers.clear();
+			return false;
+		}
+
+		worker->random_state = (i + 1) * 0x9E3779B9u;
+		m_workers.push_back(std::move(worker));
+	}
+
+	m_stopping.store(false, std::memory_order_relaxed);
+
+	for (uint32_t i = 0; i < workers_count; i++) {
+		m_workers[i]->thread = std::thread(&JobSystem::workerProcess, this, i + 1);
+	}
+
+	m_started = true;
+	return true;
+}
+
+void JobSystem::stop()
+{
+	if (!m_started) {
+		return;
+	}
+
+	m_stopping.store(true, std::memory_order_seq_cst);
+	m_wake_semaphore.release(static_cast<ptrdiff_t>(m_workers.size()));
+
+	for (std::unique_ptr<Worker>& worker : m_workers) {
+		worker->thread.join();
+	}
+
+	// Jobs nobody waited for are dropped.
+	for (std::unique_ptr<Worker>& worker : m_workers) {
+		while (Job* job = worker->deque.pop()) {
+			delete job;
+		}
+	}
+
+	for (Job* job : m_injected_jobs) {
+		delete job;
+	}
+
+	while (m_wake_semaphore.try_acquire()) {
+	}
+
+	m_injected_jobs.clear();
+	m_injected_jobs_count.store(0, std::memory_order_relaxed);
+	m_sleeping_workers_count.store(0, std::memory_order_relaxed);
+	m_workers.clear();
+	m_started = false;
+}
+
+uint32_t JobSystem::getWorkersCount() const
+{
+	return static_cast<uint32_t>(m_workers.size());
+}
+
+uint32_t JobSystem::getThreadsCount() const
+{
+	return getWorkersCount() + 1;
+}
+
+void JobSystem::schedule(JobFunction function, JobCounter* counter)
+{
+	submit(createJob(std::move(function), counter));
+}
+
+void JobSystem::scheduleAfter(JobCounter& dependency, JobFunction function, JobCounter* counter)
+{
+	Job* job = createJob(std::move(function), counter);
+	{
+		std::lock_guard<std::mutex> lock(dependency.m_continuations_mutex);
+
+		if (dependency.m_pending_count.load(std::memory_order_acquire) > 0) {
+			job->next = dependency.m_continuations;
+			dependency.m_continuations = job;
+			return;
+		}
+	}
+
+	submit(job);
+}
+
+void JobSystem::parallelFor(size_t count, size_t min_chunk_size, JobRangeFunction function, JobCounter& counter)
+{
+	if (count == 0) {
+		return;
+	}
+
+	std::shared_ptr<RangeTask> task = std::make_shared<RangeTask>();
+	task->function = std::move(function);
+	task->chunk_size = std::max<size_t>(min_chunk_size, 1);
+
+	JobCounter* counter_ptr = &counter;
+	schedule([this, task, count, counter_ptr]() { runRange(task, 0, count, counter_ptr); }, counter_ptr);
+}
+
+void JobSystem::parallelFor(size_t count, size_t min_chunk_size, JobRangeFunction function)
+{
+	if (count == 0) {
+		return;
+	}
+
+	if (!m_started) {
+		function(0, count);
+		return;
+	}
+
+	std::shared_ptr<RangeTask> task = std::make_shared<RangeTask>();
+	task->function = std::move(function);
+	task->chunk_size = std::max<size_t>(min_chunk_size, 1);
+
+	// The caller runs the root range itself, as a counted job so the counter cannot drop to zero in between splits.
+	JobCounter counter;
+	JobCounter* counter_ptr = &counter;
+	execute(createJob([this, task, count, counter_ptr]() { runRange(task, 0, count, counter_ptr); }, counter_ptr), getCurrentWorker());
+	wait(counter);
+}
+
+void JobSystem::wait(const JobCounter& counter)
+{
+	Worker* worker = getCurrentWorker();
+	uint32_t idle_count = 0;
+
+	while (!counter.isDone()) {
+		Job* job = m_started ? findJob(worker) : nullptr;
+
+		if (job != nullptr) {
+			execute(job, worker);
+			idle_count = 0;
+		}
+		else if (++idle_count < m_settings.spin_count) {
+			SIMULATOR_JOB_PAUSE();
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+JobSystemStats JobSystem::getStats() const
+{
+	JobSystemStats stats;
+	stats.executed_jobs_count = m_external_executed_jobs_count.load(std::memory_order_relaxed);
+	stats.inline_jobs_count = m_inline_jobs_count.load(std::memory_order_relaxed);
+
+	for (const std::unique_ptr<Worker>& worker : m_workers) {
+		stats.executed_jobs_count += worker->executed_jobs_count.load(std::memory_order_relaxed);
+		stats.stolen_jobs_count += worker->stolen_jobs_count.load(std::memory_order_relaxed);
+	}
+
+	return stats;
+}
+
+uint32_t JobSystem::getThreadIndex()
+{
+	return t_thread_index;
+}
+
+uint32_t JobSystem::getDefaultWorkersCount()
+{
+	unsigned hardware_threads_count = std::thread::hardware_concurrency();
+	return (hardware_threads_count > 1) ? (hardware_threads_count - 1) : 1;
+}
+
+void JobSystem::workerProcess(uint32_t worker_idx)
+{
+	t_job_system = this;
+	t_thread_index = worker_idx;
+
+	Worker* worker = m_workers[worker_idx - 1].get();
+	uint32_t idle_count = 0;
+
+	while (!m_stopping.load(std::memory_order_acquire)) {
+		Job* job = findJob(worker);
+
+		if (job != nullptr) {
+			execute(job, worker);
+			idle_count = 0;
+			continue;
+		}
+
+		if (++idle_count < m_settings.spin_count) {
+			SIMULATOR_JOB_PAUSE();
+			continue;
+		}
+
+		idle_count = 0;
+
+		// Announce the sleep before the last look for work, wakeWorker() does the same in the opposite order.
+		m_sleeping_workers_count.fetch_add(1, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if (hasWork() || m_stopping.load(std::memory_order_acquire)) {
+			uint32_t sleeping_workers_count = m_sleeping_workers_count.load(std::memory_order_relaxed);
+			bool claimed = false;
+
+			while ((sleeping_workers_count > 0) && !claimed) {
+				claimed = m_sleeping_workers_count.compare_exchange_weak(sleeping_workers_count, sleeping_workers_count - 1,
+					std::memory_order_relaxed);
+			}
+
+			if (claimed) {
+				continue;
+			}
+		}
+
+		m_wake_semaphore.acquire();
+	}
+
+	t_job_system = nullptr;
+	t_thread_index = 0;
+}
+
+Job* JobSystem::createJob(JobFunction function, JobCounter* counter)
+{
+	Job* job = new Job;
+	job->function = std::move(function);
+	job->counter = counter;
+
+	if (counter != nullptr) {
+		counter->m_pending_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+void JobSystem::submit(Job* job)
+{
+	if (!m_started) {
+		execute(job, nullptr);
+		return;
+	}
+
+	Worker* worker = getCurrentWorker();
+
+	if (worker != nullptr) {
+		if (!worker->deque.push(job)) {
+			m_inline_jobs_count.fetch_add(1, std::memory_order_relaxed);
+			execute(job, worker);
+			return;
+		}
+	}
+	else {
+		std::lock_guard<std::mutex> lock(m_injected_jobs_mutex);
+		m_injected_jobs.push_back(job);
+		m_injected_jobs_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	wakeWorker();
+}
+
+Job* JobSystem::findJob(Worker* worker)
+{
+	if (worker != nullptr) {
+		if (Job* job = worker->deque.pop()) {
+			return job;
+		}
+	}
+
+	if (m_injected_jobs_count.load(std::memory_order_relaxed) > 0) {
+		std::lock_guard<std::mutex> lock(m_injected_jobs_mutex);
+
+		if (!m_injected_jobs.empty()) {
+			Job* job = m_injected_jobs.front();
+			m_injected_jobs.pop_front();
+			m_injected_jobs_count.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+
+	return stealJob(worker);
+}
+
+Job* JobSystem::stealJob(Worker* worker)
+{
+	size_t workers_count = m_workers.size();
+	if (workers_count == 0) {
+		return nullptr;
+	}
+
+	uint32_t& random_state = (worker != nullptr) ? worker->random_state : t_random_state;
+	size_t first_victim_idx = getNextRandom(random_state) % workers_count;
+
+	for (size_t i = 0; i < workers_count; i++) {
+		Worker* victim = m_workers[(first_victim_idx + i) % workers_count].get();
+		if (victim == worker) {
+			continue;
+		}
+
+		if (Job* job = victim->deque.steal()) {
+			if (worker != nullptr) {
+				worker->stolen_jobs_count.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+bool JobSystem::hasWork() const
+{
+	if (m_injected_jobs_count.load(std::memory_order_relaxed) > 0) {
+		return true;
+	}
+
+	for (const std::unique_ptr<Worker>& worker : m_workers) {
+		if (!worker->deque.isEmpty()) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::execute(Job* job, Worker* worker)
+{
+	job->function();
+
+	if (worker != nullptr) {
+		worker->executed_jobs_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	else {
+		m_external_executed_jobs_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	finish(job);
+}
+
+void JobSystem::finish(Job* job)
+{
+	JobCounter* counter = job->counter;
+	delete job;
+
+	if (counter == nullptr) {
+		return;
+	}
+
+	Job* continuation = nullptr;
+	counter->m_finishing_count.fetch_add(1, std::memory_order_relaxed);
+
+	if (counter->m_pending_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		std::lock_guard<std::mutex> lock(counter->m_continuations_mutex);
+
+		// More jobs may have been scheduled with the counter since it dropped to zero.
+		if (counter->m_pending_count.load(std::memory_order_acquire) == 0) {
+			continuation = counter->m_continuations;
+			counter->m_continuations = nullptr;
+		}
+	}
+
+	counter->m_finishing_count.fetch_sub(1, std::memory_order_release);
+
+	while (continuation != nullptr) {
+		Job* next = continuation->next;
+		continuation->next = nullptr;
+		submit(continuation);
+		continuation = next;
+	}
+}
+
+void JobSystem::runRange(const std::shared_ptr<RangeTask>& task, size_t begin, size_t end, JobCounter* counter)
+{
+	Worker* worker = getCurrentWorker();
+
+	// Lazy binary splitting: hand off half of the range only while the local deque is drained, i.e. when other
+	// threads may be looking for work, otherwise keep going chunk by chunk.
+	while (end - begin > task->chunk_size) {
+		if ((worker == nullptr) || worker->deque.isEmpty()) {
+			size_t middle = begin + (end - begin) / 2;
+			schedule([this, task, middle, end, counter]() { runRange(task, middle, end, counter); }, counter);
+			end = middle;
+		}
+		else {
+			task->function(begin, begin + task->chunk_size);
+			begin += task->chunk_size;
+		}
+	}
+
+	task->function(begin, end);
+}
+
+JobSystem::Worker* JobSystem::getCurrentWorker() const
+{
+	return ((t_job_system == this) && (t_thread_index > 0)) ? m_workers[t_thread_index - 1].get() : nullptr;
+}
+
+void JobSystem::wakeWorker()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	uint32_t sleeping_workers_count = m_sleeping_workers_count.load(std::memory_order_relaxed);
+
+	while (sleeping_workers_count > 0) {
+		if (m_sleeping_workers_count.compare_exchange_weak(sleeping_workers_count, sleeping_workers_count - 1, std::memory_order_relaxed)) {
+			m_wake_semaphore.release();
+			return;
+		}
+	}
+}
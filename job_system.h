@@ -0,0 +1,116 @@
+#pragma once
+
+#include "work_stealing_deque.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Simulator {
+	class JobCounter;
+
+	using JobFunction = std::function<void()>;
+	using JobRangeFunction = std::function<void(size_t begin, size_t end)>;
+
+	struct Job {
+		JobFunction function;
+		JobCounter* counter = nullptr;
+		Job* next = nullptr;
+	};
+
+	// Counts the unfinished jobs scheduled with it. Jobs scheduled after a counter run once it drops to zero.
+	class JobCounter {
+	public:
+		JobCounter() = default;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+		bool isDone() const;
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32_t> m_pending_count = 0;
+		std::atomic<uint32_t> m_finishing_count = 0;
+		std::mutex m_continuations_mutex;
+		Job* m_continuations = nullptr;
+	};
+
+	struct JobSystemSettings {
+		static constexpr uint32_t DEFAULT_WORKERS_COUNT = UINT32_MAX;
+
+		// Zero workers runs every job on the threads that wait for them.
+		uint32_t workers_count = DEFAULT_WORKERS_COUNT;
+		size_t deque_capacity = 4096;
+		uint32_t spin_count = 256;
+	};
+
+	struct JobSystemStats {
+		uint64_t executed_jobs_count = 0;
+		uint64_t stolen_jobs_count = 0;
+		uint64_t inline_jobs_count = 0;
+	};
+
+	class JobSystem {
+	public:
+		~JobSystem();
+		bool start(const JobSystemSettings& settings, std::string& out_error_message);
+		void stop();
+		uint32_t getWorkersCount() const;
+		uint32_t getThreadsCount() const;
+		void schedule(JobFunction function, JobCounter* counter = nullptr);
+		void scheduleAfter(JobCounter& dependency, JobFunction function, JobCounter* counter = nullptr);
+		void parallelFor(size_t count, size_t min_chunk_size, JobRangeFunction function, JobCounter& counter);
+		void parallelFor(size_t count, size_t min_chunk_size, JobRangeFunction function);
+		void wait(const JobCounter& counter);
+		JobSystemStats getStats() const;
+
+		// 1..workers count on the worker threads, 0 on any other thread.
+		static uint32_t getThreadIndex();
+		static uint32_t getDefaultWorkersCount();
+
+	private:
+		struct alignas(64) Worker {
+			WorkStealingDeque deque;
+			std::thread thread;
+			uint32_t random_state = 0;
+			std::atomic<uint64_t> executed_jobs_count = 0;
+			std::atomic<uint64_t> stolen_jobs_count = 0;
+		};
+
+		struct RangeTask {
+			JobRangeFunction function;
+			size_t chunk_size;
+		};
+
+		void workerProcess(uint32_t worker_idx);
+		Job* createJob(JobFunction function, JobCounter* counter);
+		void submit(Job* job);
+		Job* findJob(Worker* worker);
+		Job* stealJob(Worker* worker);
+		bool hasWork() const;
+		void execute(Job* job, Worker* worker);
+		void finish(Job* job);
+		void runRange(const std::shared_ptr<RangeTask>& task, size_t begin, size_t end, JobCounter* counter);
+		Worker* getCurrentWorker() const;
+		void wakeWorker();
+
+		JobSystemSettings m_settings;
+		std::vector<std::unique_ptr<Worker>> m_workers;
+		std::mutex m_injected_jobs_mutex;
+		std::deque<Job*> m_injected_jobs;
+		std::atomic<size_t> m_injected_jobs_count = 0;
+		std::atomic<uint64_t> m_external_executed_jobs_count = 0;
+		std::atomic<uint64_t> m_inline_jobs_count = 0;
+		std::atomic<uint32_t> m_sleeping_workers_count = 0;
+		std::counting_semaphore<> m_wake_semaphore{ 0 };
+		std::atomic<bool> m_stopping = false;
+		bool m_started = false;
+	};
+}
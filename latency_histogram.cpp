@@ -0,0 +1,85 @@
+#include "latency_histogram.h"
+#include <bit>
+#include <cmath>
+
+using namespace Simulator;
+
+void LatencyHistogram::add(uint64_t value)
+{
+	m_buckets[getBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+
+	uint64_t max = m_max.load(std::memory_order_relaxed);
+	while ((value > max) && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+	}
+}
+
+void LatencyHistogram::reset()
+{
+	for (std::atomic<uint64_t>& bucket : m_buckets) {
+		bucket.store(0, std::memory_order_relaxed);
+	}
+
+	m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+	uint64_t count = 0;
+
+	for (const std::atomic<uint64_t>& bucket : m_buckets) {
+		count += bucket.load(std::memory_order_relaxed);
+	}
+
+	return count;
+}
+
+uint64_t LatencyHistogram::getMax() const
+{
+	return m_max.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getPercentile(double percentile) const
+{
+	uint64_t count = getCount();
+	if (count == 0) {
+		return 0;
+	}
+
+	uint64_t target = static_cast<uint64_t>(std::ceil(static_cast<double>(count) * percentile / 100.0));
+	target = (target > 0) ? target : 1;
+	uint64_t cumulative_count = 0;
+
+	for (size_t i = 0; i < BUCKETS_COUNT; i++) {
+		cumulative_count += m_buckets[i].load(std::memory_order_relaxed);
+
+		if (cumulative_count >= target) {
+			uint64_t upper_bound = getBucketUpperBound(i);
+			uint64_t max = getMax();
+			return (upper_bound < max) ? upper_bound : max;
+		}
+	}
+
+	return getMax();
+}
+
+size_t LatencyHistogram::getBucketIndex(uint64_t value)
+{
+	if (value < SUB_BUCKETS_COUNT) {
+		return static_cast<size_t>(value);
+	}
+
+	size_t exponent = static_cast<size_t>(std::bit_width(value)) - 1;
+	size_t sub_bucket = static_cast<size_t>(value >> (exponent - 3)) - SUB_BUCKETS_COUNT;
+	return SUB_BUCKETS_COUNT + (exponent - 3) * SUB_BUCKETS_COUNT + sub_bucket;
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(size_t bucket_idx)
+{
+	if (bucket_idx < SUB_BUCKETS_COUNT) {
+		return bucket_idx;
+	}
+
+	size_t shift = (bucket_idx - SUB_BUCKETS_COUNT) / SUB_BUCKETS_COUNT;
+	uint64_t sub_bucket = (bucket_idx - SUB_BUCKETS_COUNT) % SUB_BUCKETS_COUNT;
+	return ((SUB_BUCKETS_COUNT + sub_bucket + 1) << shift) - 1;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Simulator {
+	class LatencyHistogram {
+	public:
+		void add(uint64_t value);
+		void reset();
+		uint64_t getCount() const;
+		uint64_t getMax() const;
+		uint64_t getPercentile(double percentile) const;
+
+	private:
+		static constexpr size_t SUB_BUCKETS_COUNT = 8;
+		static constexpr size_t BUCKETS_COUNT = SUB_BUCKETS_COUNT + (64 - 3) * SUB_BUCKETS_COUNT;
+
+		static size_t getBucketIndex(uint64_t value);
+		static uint64_t getBucketUpperBound(size_t bucket_idx);
+
+		std::array<std::atomic<uint64_t>, BUCKETS_COUNT> m_buckets{};
+		std::atomic<uint64_t> m_max = 0;
+	};
+}
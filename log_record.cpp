@@ -0,0 +1,234 @@
+#include "log_record.h"
+#include <cstring>
+#include <cstdio>
+
+using namespace Simulator;
+
+const char* Simulator::getLogFormatString(LogFormat format)
+{
+	if (static_cast<size_t>(format) >= std::size(LOG_FORMATS)) {
+		return nullptr;
+	}
+
+	return LOG_FORMATS[static_cast<size_t>(format)].format;
+}
+
+LogLevel Simulator::getLogRecordLevel(const char* record)
+{
+	return static_cast<LogLevel>(record[3]);
+}
+
+uint64_t Simulator::getLogRecordTimestamp(const char* record)
+{
+	uint64_t timestamp;
+	memcpy(&timestamp, record + 8, sizeof(timestamp));
+	return timestamp;
+}
+
+size_t Simulator::getLogRecordSize(const char* data, size_t available_size)
+{
+	if (available_size < LOG_RECORD_HEADER_SIZE) {
+		return 0;
+	}
+
+	uint32_t payload_size;
+	memcpy(&payload_size, data + 4, sizeof(payload_size));
+
+	size_t record_size = LOG_RECORD_HEADER_SIZE + payload_size;
+	return (record_size <= available_size) ? record_size : 0;
+}
+
+size_t Simulator::formatLogRecord(const char* record, size_t record_size, char* out_text, size_t text_capacity)
+{
+	if ((record_size < LOG_RECORD_HEADER_SIZE) || (text_capacity == 0)) {
+		return 0;
+	}
+
+	uint16_t format_id;
+	memcpy(&format_id, record, sizeof(format_id));
+	uint8_t args_count = static_cast<uint8_t>(record[2]);
+
+	const char* format = getLogFormatString(static_cast<LogFormat>(format_id));
+	char unknown_format[32];
+	if (format == nullptr) {
+		snprintf(unknown_format, sizeof(unknown_format), "[UNKNOWN FORMAT %u]", format_id);
+		format = unknown_format;
+	}
+
+	const char* arg = record + LOG_RECORD_HEADER_SIZE;
+	const char* record_end = record + record_size;
+	size_t text_size = 0;
+
+	auto append = [&](const char* data, size_t size)
+	{
+		size_t copy_size = (size < text_capacity - text_size) ? size : (text_capacity - text_size);
+		memcpy(out_text + text_size, data, copy_size);
+		text_size += copy_size;
+	};
+
+	for (const char* c = format; *c != '\0'; c++) {
+		bool hex = (strncmp(c, "{x}", 3) == 0);
+
+		if (!hex && (strncmp(c, "{}", 2) != 0)) {
+			append(c, 1);
+			continue;
+		}
+
+		c += hex ? 2 : 1;
+
+		if ((args_count == 0) || (arg >= record_end)) {
+			continue;
+		}
+
+		args_count--;
+		LogArgType arg_type = static_cast<LogArgType>(*arg++);
+		char number[32];
+		int number_size = 0;
+
+		switch (arg_type) {
+		case LogArgType::SIGNED: {
+			int64_t value;
+			if (static_cast<size_t>(record_end - arg) < sizeof(value)) {
+				arg = record_end;
+				break;
+			}
+
+			memcpy(&value, arg, sizeof(value));
+			arg += sizeof(value);
+			number_size = hex ? snprintf(number, sizeof(number), "%08llX", static_cast<unsigned long long>(value)) :
+				snprintf(number, sizeof(number), "%lld", static_cast<long long>(value));
+			break;
+		}
+		case LogArgType::UNSIGNED: {
+			uint64_t value;
+			if (static_cast<size_t>(record_end - arg) < sizeof(value)) {
+				arg = record_end;
+				break;
+			}
+
+			memcpy(&value, arg, sizeof(value));
+			arg += sizeof(value);
+			number_size = snprintf(number, sizeof(number), hex ? "%08llX" : "%llu", static_cast<unsigned long long>(value));
+			break;
+		}
+		case LogArgType::FLOAT: {
+			double value;
+			if (static_cast<size_t>(record_end - arg) < sizeof(value)) {
+				arg = record_end;
+				break;
+			}
+
+			memcpy(&value, arg, sizeof(value));
+			arg += sizeof(value);
+			number_size = snprintf(number, sizeof(number), "%f", value);
+			break;
+		}
+		case LogArgType::STRING: {
+			uint32_t string_size;
+			if (static_cast<size_t>(record_end - arg) < sizeof(string_size)) {
+				arg = record_end;
+				break;
+			}
+
+			memcpy(&string_size, arg, sizeof(string_size));
+			arg += sizeof(string_size);
+
+			if (static_cast<size_t>(record_end - arg) < string_size) {
+				arg = record_end;
+				break;
+			}
+
+			append(arg, string_size);
+			arg += string_size;
+			break;
+		}
+		default:
+			arg = record_end;
+			break;
+		}
+
+		if (number_size > 0) {
+			append(number, static_cast<size_t>(number_size));
+		}
+	}
+
+	return text_size;
+}
+
+LogRecordEncoder::LogRecordEncoder(char* data, size_t capacity, LogFormat format, LogLevel level, uint64_t timestamp) :
+	m_data(data),
+	m_capacity(capacity),
+	m_size(LOG_RECORD_HEADER_SIZE)
+{
+	uint16_t format_id = static_cast<uint16_t>(format);
+	memcpy(m_data, &format_id, sizeof(format_id));
+	m_data[3] = static_cast<char>(level);
+	memcpy(m_data + 8, &timestamp, sizeof(timestamp));
+}
+
+bool LogRecordEncoder::reserve(size_t size)
+{
+	if ((m_args_count == UINT8_MAX) || (m_size + 1 + size > m_capacity)) {
+		return false;
+	}
+
+	m_args_count++;
+	return true;
+}
+
+void LogRecordEncoder::addSigned(int64_t value)
+{
+	if (!reserve(sizeof(value))) {
+		return;
+	}
+
+	m_data[m_size++] = static_cast<char>(LogArgType::SIGNED);
+	memcpy(m_data + m_size, &value, sizeof(value));
+	m_size += sizeof(value);
+}
+
+void LogRecordEncoder::addUnsigned(uint64_t value)
+{
+	if (!reserve(sizeof(value))) {
+		return;
+	}
+
+	m_data[m_size++] = static_cast<char>(LogArgType::UNSIGNED);
+	memcpy(m_data + m_size, &value, sizeof(value));
+	m_size += sizeof(value);
+}
+
+void LogRecordEncoder::addFloat(double value)
+{
+	if (!reserve(sizeof(value))) {
+		return;
+	}
+
+	m_data[m_size++] = static_cast<char>(LogArgType::FLOAT);
+	memcpy(m_data + m_size, &value, sizeof(value));
+	m_size += sizeof(value);
+}
+
+void LogRecordEncoder::addString(std::string_view value)
+{
+	if (!reserve(sizeof(uint32_t))) {
+		return;
+	}
+
+	size_t available_size = m_capacity - m_size - 1 - sizeof(uint32_t);
+	uint32_t string_size = static_cast<uint32_t>((value.size() < available_size) ? value.size() : available_size);
+
+	m_data[m_size++] = static_cast<char>(LogArgType::STRING);
+	memcpy(m_data + m_size, &string_size, sizeof(string_size));
+	m_size += sizeof(string_size);
+	memcpy(m_data + m_size, value.data(), string_size);
+	m_size += string_size;
+}
+
+size_t LogRecordEncoder::finish()
+{
+	uint32_t payload_size = static_cast<uint32_t>(m_size - LOG_RECORD_HEADER_SIZE);
+	m_data[2] = static_cast<char>(m_args_count);
+	memcpy(m_data + 4, &payload_size, sizeof(payload_size));
+	return m_size;
+}
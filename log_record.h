@@ -0,0 +1,233 @@
+#pragma once
+
+#include <string_view>
+#include <type_traits>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef SIMULATOR_LOG_MIN_LEVEL
+#ifdef DEBUG
+#define SIMULATOR_LOG_MIN_LEVEL 0
+#else
+#define SIMULATOR_LOG_MIN_LEVEL 1
+#endif
+#endif
+
+namespace Simulator {
+	enum class LogLevel : uint8_t {
+		VERBOSE,
+		INFO,
+		WARNING,
+		ERR
+	};
+
+	static constexpr LogLevel LOG_MIN_LEVEL = static_cast<LogLevel>(SIMULATOR_LOG_MIN_LEVEL);
+
+	enum class LogFormat : uint16_t {
+		RAW_TEXT,
+		ERROR_MESSAGE,
+		LOGGER_DROPPED_MESSAGES,
+		UNHANDLED_EXCEPTION,
+		UNHANDLED_CPP_EXCEPTION,
+		MAIN_WINDOW_CLASS_REGISTRATION_FAILED,
+		MAIN_WINDOW_CREATION_FAILED,
+		MAIN_WINDOW_DATA_STORE_FAILED,
+		MAIN_WINDOW_DATA_STORE_FAILED_WINDOWS_ERROR,
+		OUTPUT_DIRECTORY_CREATION_FAILED,
+		PHYSICAL_DEVICES_FOUND,
+		PHYSICAL_DEVICE,
+		PHYSICAL_DEVICE_SELECTED,
+		HEADLESS_PHYSICAL_DEVICE_SELECTED,
+		HEADLESS_FRAMES_RENDERED,
+		VULKAN_LAYER_MESSAGE,
+		VULKAN_LAYER_MESSAGE_REPEATED,
+		PHYSICAL_DEVICE_SCORE,
+		PHYSICAL_DEVICE_UNSUPPORTED,
+		PHYSICAL_DEVICE_OVERRIDE_NOT_FOUND,
+		DEVICE_QUEUES,
+		SWAPCHAIN_CREATED,
+		SWAPCHAIN_PRESENT_MODE_FALLBACK,
+		SWAPCHAIN_REBUILT,
+		PIPELINE_CACHE_HIT,
+		PIPELINE_CACHE_MISS,
+		PIPELINE_CACHE_STATS,
+		STARTUP_PHASE,
+		RENDERER_STARTUP_TIMINGS,
+		STARTUP_COMPLETED,
+		FIRST_FRAME_PRESENTED,
+		MEMORY_HEAP_STATS,
+		MEMORY_ALLOCATOR_STATS,
+		HOST_MEMORY_SCOPE_STATS,
+		HOST_ALLOCATOR_STATS,
+		STAGING_UPLOADER_STATS,
+		PROFILER_SCOPE_STATS,
+		PROFILER_TRACE_WRITTEN,
+		INSTRUMENTATION_SCOPE_STATS,
+		INSTRUMENTATION_COUNTER,
+		INSTRUMENTATION_HISTOGRAM,
+		INSTRUMENTATION_DROPPED_EVENTS,
+		INSTRUMENTATION_TRACE_WRITTEN,
+		JOB_SYSTEM_STARTED,
+		JOB_SYSTEM_STATS,
+		SIMULATION_STARTED,
+		SIMULATION_STATS,
+		GPU_PARTICLES_CREATED,
+		COMPUTE_VERIFICATION,
+		COMPUTE_VERIFICATION_FAILED,
+		COMMAND_RECORDER_STATS,
+		RECORDING_BENCHMARK,
+		PARTICLE_DRAW_MODE,
+		GPU_DRIVEN_RECORDING_BENCHMARK,
+		PROFILER_DROPPED_FRAMES,
+		HEADLESS_FRAMES_CHECKSUM,
+		HEADLESS_FRAMES_CHECKSUM_MISMATCH,
+		COUNT
+	};
+
+	enum class LogArgType : uint8_t {
+		SIGNED,
+		UNSIGNED,
+		FLOAT,
+		STRING
+	};
+
+	enum class LogFileFormat {
+		TEXT,
+		BINARY
+	};
+
+	// {} formats an argument in decimal, {x} in upper case hexadecimal zero padded to at least 8 digits.
+	struct LogFormatInfo {
+		LogLevel level;
+		const char* format;
+	};
+
+	inline constexpr LogFormatInfo LOG_FORMATS[] = {
+		{ LogLevel::INFO, "{}" },
+		{ LogLevel::ERR, "[ERROR] {}" },
+		{ LogLevel::WARNING, "[WARNING] Logger dropped {} messages." },
+		{ LogLevel::ERR, "[ERROR] Unhandled exception 0x{x} at address 0x{x}." },
+		{ LogLevel::ERR, "[ERROR] Unhandled C++ exception." },
+		{ LogLevel::ERR, "[ERROR] Failed to register main window class. Windows error:{}" },
+		{ LogLevel::ERR, "[ERROR] Failed to create main window. Windows error:{}" },
+		{ LogLevel::ERR, "[ERROR] Failed to store main window data." },
+		{ LogLevel::ERR, "[ERROR] Failed to store main window data. Windows error:{}" },
+		{ LogLevel::ERR, "[ERROR] Failed to create output directory. {}" },
+		{ LogLevel::INFO, "[INFO] Found supported Vulkan physical devices:" },
+		{ LogLevel::INFO, "[INFO] \"{}\"." },
+		{ LogLevel::INFO, "[INFO] Selected \"{}\" for rendering." },
+		{ LogLevel::INFO, "[INFO] Selected \"{}\" for headless rendering." },
+		{ LogLevel::INFO, "[INFO] Rendered {} headless frames in {} s ({} frames/s)." },
+		{ LogLevel::VERBOSE, "[LAYER] {} {} {}" },
+		{ LogLevel::VERBOSE, "[LAYER] Message 0x{x} repeated {} times." },
+		{ LogLevel::INFO, "[INFO] \"{}\" {} score:{} (type:{} memory:{} queues:{} features:{} limits:{})." },
+		{ LogLevel::INFO, "[INFO] \"{}\" {} skipped. {}" },
+		{ LogLevel::WARNING, "[WARNING] Vulkan physical device \"{}\" not found, using the highest scored device." },
+		{ LogLevel::INFO, "[INFO] Queue families: graphics {}, present {}{}, compute {}{}, transfer {}{}." },
+		{ LogLevel::INFO, "[INFO] Swapchain {}x{}, {} images, present mode {}, {} frames in flight." },
+		{ LogLevel::WARNING, "[WARNING] Present mode {} not supported, using {}." },
+		{ LogLevel::VERBOSE, "[VERBOSE] Swapchain rebuilt at {}x{} ({} rebuilds)." },
+		{ LogLevel::INFO, "[INFO] Pipeline cache hit, loaded {} bytes from \"{}\" in {} ms." },
+		{ LogLevel::INFO, "[INFO] Pipeline cache miss. {} ({} ms)" },
+		{ LogLevel::INFO, "[INFO] Pipeline cache: {} pipeline hits, {} misses, {} {} bytes." },
+		{ LogLevel::INFO, "[INFO] Startup phase {}: {} ms (done at {} ms)." },
+		{ LogLevel::INFO, "[INFO] Renderer startup: Vulkan loading {} ms (waited {} ms), instance {} ms, device probes {} ms." },
+		{ LogLevel::INFO, "[INFO] Startup completed in {} ms." },
+		{ LogLevel::INFO, "[INFO] First frame presented {} ms after start." },
+		{ LogLevel::INFO, "[INFO] Memory heap {}: {} blocks, {} allocations ({} dedicated), used {} of {} bytes, fragmentation {}%." },
+		{ LogLevel::INFO, "[INFO] Memory allocator: {} of {} device allocations, {} allocations, {} frees, {} defragmentation moves." },
+		{ LogLevel::INFO, "[INFO] Host memory scope {}: {} allocations, peak {} bytes, {} bytes internal, {} allocations live ({} bytes)." },
+		{ LogLevel::INFO, "[INFO] Host allocator: {} arena, {} pool, {} heap allocations, {} arena resets, {} bytes in pool slabs." },
+		{ LogLevel::INFO, "[INFO] Staging uploader: {} uploads ({} bytes) in {} batches, {} direct writes ({} bytes), {} ring waits." },
+		{ LogLevel::INFO, "[INFO] {} scope {}: last {} ms, avg {} ms, min {} ms, max {} ms ({} samples)." },
+		{ LogLevel::INFO, "[INFO] Profiler trace with {} events written to \"{}\"." },
+		{ LogLevel::INFO, "[INFO] Scope {}: {} calls, total {} ms, avg {} us, p50 {} us, p99 {} us, max {} us." },
+		{ LogLevel::INFO, "[INFO] Counter {}: {}." },
+		{ LogLevel::INFO, "[INFO] Histogram {}: {} samples, min {}, avg {}, p50 {}, p99 {}, max {}." },
+		{ LogLevel::WARNING, "[WARNING] Instrumentation dropped {} events." },
+		{ LogLevel::INFO, "[INFO] Instrumentation trace written to \"{}\"." },
+		{ LogLevel::INFO, "[INFO] Job system started with {} worker threads." },
+		{ LogLevel::INFO, "[INFO] Job system: {} jobs executed, {} stolen, {} run inline on a full deque." },
+		{ LogLevel::INFO, "[INFO] Simulation thread started with {} bodies at {} steps per second." },
+		{ LogLevel::INFO, "[INFO] Simulation: {} steps ({} dropped), avg step {} ms, {} snapshots published, {} consumed." },
+		{ LogLevel::INFO, "[INFO] GPU particles created: {} particles in a {} byte storage buffer." },
+		{ LogLevel::INFO, "[INFO] Compute verification: {} particles, {} steps, GPU {} ms, CPU {} ms, max position error {}, max velocity error {}." },
+		{ LogLevel::ERR, "[ERROR] Compute verification failed: {} of {} particles outside tolerance {}." },
+		{ LogLevel::INFO, "[INFO] Command recorder: {} secondary command buffers recorded, {} allocated, {} pool resets." },
+		{ LogLevel::INFO, "[INFO] Recording benchmark: {} threads, {} draws in {} command buffers, avg {} ms, {} M draws/s." },
+		{ LogLevel::INFO, "[INFO] Particle draws: {}, {} requested." },
+		{ LogLevel::INFO, "[INFO] GPU driven recording benchmark: {} draws in {} command buffers, avg {} ms." },
+		{ LogLevel::WARNING, "[WARNING] Profiler dropped {} frames whose timestamps were not available." },
+		{ LogLevel::INFO, "[INFO] Headless frames checksum: 0x{x}." },
+		{ LogLevel::ERR, "[ERROR] Headless frames checksum 0x{x} does not match the expected 0x{x}." }
+	};
+
+	static_assert(std::size(LOG_FORMATS) == static_cast<size_t>(LogFormat::COUNT));
+
+	constexpr LogLevel getLogFormatLevel(LogFormat format)
+	{
+		return LOG_FORMATS[static_cast<size_t>(format)].level;
+	}
+
+	static constexpr char LOG_FILE_MAGIC[8] = { 'S', 'I', 'M', 'L', 'O', 'G', '\0', '\1' };
+	static constexpr size_t LOG_RECORD_HEADER_SIZE = 16;
+
+	const char* getLogFormatString(LogFormat format);
+	LogLevel getLogRecordLevel(const char* record);
+	uint64_t getLogRecordTimestamp(const char* record);
+	size_t getLogRecordSize(const char* data, size_t available_size);
+	size_t formatLogRecord(const char* record, size_t record_size, char* out_text, size_t text_capacity);
+
+	class LogRecordEncoder {
+	public:
+		LogRecordEncoder(char* data, size_t capacity, LogFormat format, LogLevel level, uint64_t timestamp);
+		void addSigned(int64_t value);
+		void addUnsigned(uint64_t value);
+		void addFloat(double value);
+		void addString(std::string_view value);
+		size_t finish();
+
+		template<typename T>
+		void add(const T& arg)
+		{
+			if constexpr (std::is_same_v<T, bool>) {
+				addUnsigned(arg ? 1 : 0);
+			}
+			else if constexpr (std::is_enum_v<T>) {
+				add(static_cast<std::underlying_type_t<T>>(arg));
+			}
+			else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+				addSigned(static_cast<int64_t>(arg));
+			}
+			else if constexpr (std::is_integral_v<T>) {
+				addUnsigned(static_cast<uint64_t>(arg));
+			}
+			else if constexpr (std::is_floating_point_v<T>) {
+				addFloat(static_cast<double>(arg));
+			}
+			else if constexpr (std::is_pointer_v<T> && !std::is_convertible_v<T, const char*>) {
+				addUnsigned(reinterpret_cast<uintptr_t>(arg));
+			}
+			else {
+				addString(std::string_view(arg));
+			}
+		}
+
+	private:
+		bool reserve(size_t size);
+
+		char* m_data;
+		size_t m_capacity;
+		size_t m_size;
+		uint8_t m_args_count = 0;
+	};
+
+	template<typename... Args>
+	size_t encodeLogRecord(char* out_data, size_t capacity, LogFormat format, LogLevel level, uint64_t timestamp, const Args&... args)
+	{
+		LogRecordEncoder encoder(out_data, capacity, format, level, timestamp);
+		(encoder.add(args), ...);
+		return encoder.finish();
+	}
+}
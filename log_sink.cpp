@@ -0,0 +1,197 @@
+#include <SDKDDKVer.h>
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include "log_sink.h"
+#include <cstring>
+#include <cstdio>
+
+using namespace Simulator;
+
+LogSink::~LogSink()
+{
+	close();
+}
+
+bool LogSink::open(const std::filesystem::path& file_path, size_t segment_size, uint32_t max_segments,
+	std::string_view segment_header, std::string& out_error_message)
+{
+	close();
+
+	if (segment_size <= segment_header.size()) {
+		out_error_message = "Log segment size is too small.";
+		return false;
+	}
+
+	m_file_path = file_path;
+	m_segment_header = segment_header;
+	m_segment_size = segment_size;
+	m_max_segments = (max_segments > 0) ? max_segments : 1;
+	m_segment_idx = 0;
+
+	removeStaleSegments();
+
+	if (!openSegment()) {
+		out_error_message = "Failed to create log file segment. Windows error:" + std::to_string(GetLastError()) + ".";
+		return false;
+	}
+
+	return true;
+}
+
+char* LogSink::reserve(size_t size)
+{
+	if (size > m_segment_size - m_segment_header.size()) {
+		return nullptr;
+	}
+
+	if ((m_view != nullptr) && (m_used_size + size <= m_segment_size)) {
+		return m_view + m_used_size;
+	}
+
+	if (m_view != nullptr) {
+		closeSegment();
+		m_segment_idx++;
+	}
+
+	if (!openSegment()) {
+		return nullptr;
+	}
+
+	if (m_segment_idx >= m_max_segments) {
+		std::error_code error;
+		std::filesystem::remove(getSegmentPath(m_segment_idx - m_max_segments), error);
+	}
+
+	return m_view + m_used_size;
+}
+
+void LogSink::commit(size_t size)
+{
+	m_used_size += size;
+}
+
+void LogSink::flush()
+{
+	if ((m_view == nullptr) || (m_flushed_size == m_used_size)) {
+		return;
+	}
+
+	FlushViewOfFile(m_view + m_flushed_size, m_used_size - m_flushed_size);
+	m_flushed_size = m_used_size;
+}
+
+void LogSink::close()
+{
+	if (m_view != nullptr) {
+		closeSegment();
+	}
+}
+
+size_t LogSink::getUnflushedSize() const
+{
+	return m_used_size - m_flushed_size;
+}
+
+uint64_t LogSink::getSegmentIndex() const
+{
+	return m_segment_idx;
+}
+
+bool LogSink::openSegment()
+{
+	m_file = CreateFileW(getSegmentPath(m_segment_idx).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+		nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE) {
+		m_file = nullptr;
+		return false;
+	}
+
+	uint64_t segment_size = m_segment_size;
+	m_file_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READWRITE, static_cast<DWORD>(segment_size >> 32),
+		static_cast<DWORD>(segment_size), nullptr);
+	if (m_file_mapping == nullptr) {
+		DWORD windows_error = GetLastError();
+		CloseHandle(m_file);
+		m_file = nullptr;
+		SetLastError(windows_error);
+		return false;
+	}
+
+	m_view = static_cast<char*>(MapViewOfFile(m_file_mapping, FILE_MAP_WRITE, 0, 0, m_segment_size));
+	if (m_view == nullptr) {
+		DWORD windows_error = GetLastError();
+		CloseHandle(m_file_mapping);
+		CloseHandle(m_file);
+		m_file_mapping = nullptr;
+		m_file = nullptr;
+		SetLastError(windows_error);
+		return false;
+	}
+
+	memcpy(m_view, m_segment_header.data(), m_segment_header.size());
+	m_used_size = m_segment_header.size();
+	m_flushed_size = 0;
+	return true;
+}
+
+void LogSink::closeSegment()
+{
+	UnmapViewOfFile(m_view);
+	CloseHandle(m_file_mapping);
+
+	LARGE_INTEGER used_size;
+	used_size.QuadPart = static_cast<LONGLONG>(m_used_size);
+	if (SetFilePointerEx(m_file, used_size, nullptr, FILE_BEGIN)) {
+		SetEndOfFile(m_file);
+	}
+
+	CloseHandle(m_file);
+
+	m_view = nullptr;
+	m_file_mapping = nullptr;
+	m_file = nullptr;
+	m_used_size = 0;
+	m_flushed_size = 0;
+}
+
+void LogSink::removeStaleSegments()
+{
+	std::filesystem::path directory = m_file_path.parent_path();
+	if (directory.empty()) {
+		directory = ".";
+	}
+
+	std::wstring prefix = m_file_path.stem().wstring() + L".";
+	std::wstring extension = m_file_path.extension().wstring();
+	std::error_code error;
+
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		std::wstring file_name = entry.path().filename().wstring();
+
+		if ((file_name.size() != prefix.size() + 6 + extension.size()) ||
+			(file_name.compare(0, prefix.size(), prefix) != 0) ||
+			(file_name.compare(prefix.size() + 6, extension.size(), extension) != 0)) {
+			continue;
+		}
+
+		bool numbered = true;
+		for (size_t i = prefix.size(); i < prefix.size() + 6; i++) {
+			numbered = numbered && (file_name[i] >= L'0') && (file_name[i] <= L'9');
+		}
+
+		if (numbered) {
+			std::error_code remove_error;
+			std::filesystem::remove(entry.path(), remove_error);
+		}
+	}
+}
+
+std::filesystem::path LogSink::getSegmentPath(uint64_t segment_idx) const
+{
+	char segment_number[32];
+	snprintf(segment_number, sizeof(segment_number), ".%06llu", static_cast<unsigned long long>(segment_idx));
+	std::filesystem::path segment_path = m_file_path;
+	segment_path.replace_filename(m_file_path.stem().string() + segment_number + m_file_path.extension().string());
+	return segment_path;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace Simulator {
+	class LogSink {
+	public:
+		~LogSink();
+		bool open(const std::filesystem::path& file_path, size_t segment_size, uint32_t max_segments,
+			std::string_view segment_header, std::string& out_error_message);
+		char* reserve(size_t size);
+		void commit(size_t size);
+		void flush();
+		void close();
+		size_t getUnflushedSize() const;
+		uint64_t getSegmentIndex() const;
+
+	private:
+		bool openSegment();
+		void closeSegment();
+		void removeStaleSegments();
+		std::filesystem::path getSegmentPath(uint64_t segment_idx) const;
+
+		std::filesystem::path m_file_path;
+		std::string m_segment_header;
+		size_t m_segment_size = 0;
+		uint32_t m_max_segments = 0;
+		uint64_t m_segment_idx = 0;
+		// Windows HANDLEs, kept as void* so the header does not pull in windows.h.
+		void* m_file = nullptr;
+		void* m_file_mapping = nullptr;
+		char* m_view = nullptr;
+		size_t m_used_size = 0;
+		size_t m_flushed_size = 0;
+	};
+}
@@ -1,4 +1,6 @@
 #include "logger.h"
+#include "instrumentation.h"
+#include <cstring>
 
 using namespace Simulator;
 
@@ -9,6 +11,11 @@ Logger::~Logger()
 }
 
 bool Logger::start(const std::string& log_file_name, std::string& out_error_message)
+{
+	return start(log_file_name, out_error_message, LoggerSettings());
+}
+
+bool Logger::start(const std::string& log_file_name, std::string& out_error_message, const LoggerSettings& settings)
 {
 	out_error_message.clear();
 	std::lock_guard lock(m_worker_thread_mutex);
@@ -22,10 +29,33 @@ bool Logger::start(const std::string& log_file_name, std::string& out_error_mess
 		m_worker_thread.join();
 	}
 
-	m_file.open(log_file_name, std::ofstream::out | std::ofstream::trunc);
+	if (!m_message_ring.init(settings.ring_capacity, settings.overflow_policy, out_error_message)) {
+		return false;
+	}
+
+	if (settings.segment_size < 2 * MAX_FORMATTED_RECORD_SIZE) {
+		out_error_message = "Log segment size is too small.";
+		return false;
+	}
+
+	m_settings = settings;
+	m_min_level = settings.min_level;
+	m_record_buffer.resize(MessageRing::MAX_MESSAGE_SIZE);
+	m_write_failed_count = 0;
+	m_accepted_records_count = 0;
+	m_written_records_count = 0;
+	m_written_bytes_count = 0;
+	m_drain_time_ns = 0;
+	m_sink_latency.reset();
+	m_flush_requested_count = 0;
+	m_flush_completed_count = 0;
 
-	if (!m_file.is_open()) {
-		out_error_message = "Failed to create log file.";
+	std::string_view segment_header;
+	if (m_settings.file_format == LogFileFormat::BINARY) {
+		segment_header = std::string_view(LOG_FILE_MAGIC, sizeof(LOG_FILE_MAGIC));
+	}
+
+	if (!m_sink.open(log_file_name, m_settings.segment_size, m_settings.max_segments, segment_header, out_error_message)) {
 		return false;
 	}
 
@@ -34,19 +64,47 @@ bool Logger::start(const std::string& log_file_name, std::string& out_error_mess
 	return true;
 }
 
-void Logger::logWrite(const std::string& message)
+void Logger::logWrite(std::string_view message)
 {
-	{
-		std::lock_guard lock(m_worker_thread_mutex);
+	logWrite(LogLevel::INFO, message);
+}
 
-		if (m_worker_thread_state != ThreadState::RUNNING) {
-			return;
+void Logger::logWrite(LogLevel level, std::string_view message)
+{
+	log(level, LogFormat::RAW_TEXT, message);
+}
+
+void Logger::setMinLevel(LogLevel level)
+{
+	m_min_level = level;
+}
+
+bool Logger::flush(std::chrono::milliseconds timeout)
+{
+	ThreadState state = m_worker_thread_state.load(std::memory_order_acquire);
+
+	if (state == ThreadState::STOPPED) {
+		return false;
+	}
+
+	uint64_t flush_request = m_flush_requested_count.fetch_add(1) + 1;
+	wakeWorker();
+
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+
+	while (m_flush_completed_count.load(std::memory_order_acquire) < flush_request) {
+		if (m_worker_thread_state.load(std::memory_order_acquire) == ThreadState::STOPPED) {
+			return true;
+		}
+
+		if (std::chrono::steady_clock::now() >= deadline) {
+			return false;
 		}
 
-		m_message_fifo.push(message);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
 	}
 
-	m_worker_thread_wait_variable.notify_all();
+	return true;
 }
 
 void Logger::requestStop()
@@ -62,7 +120,7 @@ void Logger::requestStop()
 		m_worker_thread_state = ThreadState::STOPPING;
 	}
 
-	m_worker_thread_wait_variable.notify_all();
+	wakeWorker();
 }
 
 void Logger::waitForStop()
@@ -81,32 +139,171 @@ void Logger::waitForStop()
 	}
 }
 
+uint64_t Logger::getDroppedMessagesCount() const
+{
+	return m_message_ring.getDroppedCount() + m_write_failed_count.load(std::memory_order_relaxed);
+}
+
+LoggerStats Logger::getStats() const
+{
+	LoggerStats stats;
+	stats.accepted_records_count = m_accepted_records_count.load(std::memory_order_relaxed);
+	stats.written_records_count = m_written_records_count.load(std::memory_order_relaxed);
+	stats.written_bytes_count = m_written_bytes_count.load(std::memory_order_relaxed);
+	stats.dropped_messages_count = getDroppedMessagesCount();
+	stats.drain_time_ns = m_drain_time_ns.load(std::memory_order_relaxed);
+	stats.sink_latency_p50_ns = m_sink_latency.getPercentile(50.0);
+	stats.sink_latency_p99_ns = m_sink_latency.getPercentile(99.0);
+	stats.sink_latency_p999_ns = m_sink_latency.getPercentile(99.9);
+	stats.sink_latency_max_ns = m_sink_latency.getMax();
+	return stats;
+}
+
+void Logger::wakeWorker()
+{
+	if (m_worker_thread_sleeping.load() && m_worker_thread_sleeping.exchange(false)) {
+		m_worker_thread_wake_semaphore.release();
+	}
+}
+
+bool Logger::isFlushRequested() const
+{
+	return m_flush_requested_count.load() != m_flush_completed_count.load();
+}
+
+void Logger::drainMessages()
+{
+	size_t record_size = 0;
+	uint64_t drain_start_time = 0;
+
+	while (m_message_ring.pop(m_record_buffer.data(), record_size)) {
+		if (drain_start_time == 0) {
+			drain_start_time = getTimestamp();
+		}
+
+		appendRecord(m_record_buffer.data(), record_size);
+
+		if (m_sink.getUnflushedSize() >= m_settings.flush_size_threshold) {
+			m_sink.flush();
+		}
+	}
+
+	if (drain_start_time != 0) {
+		m_drain_time_ns.fetch_add(getTimestamp() - drain_start_time, std::memory_order_relaxed);
+	}
+}
+
+void Logger::appendRecord(const char* record, size_t record_size)
+{
+	static constexpr char LINE_END[] = { '\r', '\n' };
+
+	const char* written_data = record;
+	size_t written_size = record_size;
+
+	// Text is formatted aside first, so the segment only has to fit the formatted size and not the worst case.
+	char text[MAX_FORMATTED_RECORD_SIZE + sizeof(LINE_END)];
+	if (m_settings.file_format == LogFileFormat::TEXT) {
+		written_size = formatLogRecord(record, record_size, text, MAX_FORMATTED_RECORD_SIZE);
+		memcpy(text + written_size, LINE_END, sizeof(LINE_END));
+		written_size += sizeof(LINE_END);
+		written_data = text;
+	}
+
+	char* data = m_sink.reserve(written_size);
+	if (data == nullptr) {
+		m_write_failed_count.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	memcpy(data, written_data, written_size);
+	m_sink.commit(written_size);
+
+	uint64_t now = getTimestamp();
+	uint64_t record_timestamp = getLogRecordTimestamp(record);
+	m_sink_latency.add((now > record_timestamp) ? (now - record_timestamp) : 0);
+	m_written_records_count.store(m_written_records_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	m_written_bytes_count.store(m_written_bytes_count.load(std::memory_order_relaxed) + written_size, std::memory_order_relaxed);
+}
+
+uint64_t Logger::getTimestamp()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void Logger::logProcess(Logger* logger)
 {
+	ThreadState expected_state = ThreadState::STARTING;
+	logger->m_worker_thread_state.compare_exchange_strong(expected_state, ThreadState::RUNNING);
+
+	auto last_write_time = std::chrono::steady_clock::now();
+
 	while (true) {
-		std::unique_lock<std::mutex> lock(logger->m_worker_thread_mutex);
+		bool stopping = (logger->m_worker_thread_state == ThreadState::STOPPING);
+		uint64_t flush_request = logger->m_flush_requested_count.load(std::memory_order_acquire);
 
-		logger->m_worker_thread_wait_variable.wait(lock,
-			[logger]()
-			{
-				return (!logger->m_message_fifo.empty()) || (logger->m_worker_thread_state != ThreadState::RUNNING);
-			}
-		);
+		// Nothing drains the ring after this pass, so producers blocked on a full ring must not keep waiting.
+		if (stopping) {
+			logger->m_message_ring.close();
 
-		if (logger->m_worker_thread_state == ThreadState::STARTING) {
-			logger->m_worker_thread_state = ThreadState::RUNNING;
+			// Producers that got past the state check before STOPPING still commit, the last pass must not run ahead of them.
+			while (logger->m_active_writers_count.load(std::memory_order_seq_cst) > 0) {
+				std::this_thread::yield();
+			}
 		}
 
-		if (!logger->m_message_fifo.empty()) {
-			logger->m_file << logger->m_message_fifo.front() << std::endl;
-			logger->m_message_fifo.pop();
+		SIMULATOR_HISTOGRAM_RECORD("Logger queue depth", logger->m_message_ring.getSize());
+		logger->drainMessages();
+
+		auto now = std::chrono::steady_clock::now();
+
+		if (stopping || (flush_request != logger->m_flush_completed_count.load(std::memory_order_relaxed)) ||
+			((logger->m_sink.getUnflushedSize() > 0) && (now - last_write_time >= logger->m_settings.flush_interval))) {
+			logger->m_sink.flush();
+			last_write_time = now;
+			logger->m_flush_completed_count.store(flush_request, std::memory_order_release);
 		}
 
-		if (logger->m_message_fifo.empty() && (logger->m_worker_thread_state != ThreadState::RUNNING)) {
-			logger->m_worker_thread_state = ThreadState::STOPPED;
-			lock.unlock();
+		if (stopping) {
+			logger->m_message_ring.dropRemaining();
+
+			uint64_t dropped_messages_count = logger->getDroppedMessagesCount();
+			if (dropped_messages_count > 0) {
+				size_t record_size = encodeLogRecord(logger->m_record_buffer.data(), logger->m_record_buffer.size(),
+					LogFormat::LOGGER_DROPPED_MESSAGES, LogLevel::WARNING, getTimestamp(), dropped_messages_count);
+				logger->appendRecord(logger->m_record_buffer.data(), record_size);
+			}
+
+			logger->m_sink.close();
+
+			{
+				std::lock_guard lock(logger->m_worker_thread_mutex);
+				logger->m_worker_thread_state = ThreadState::STOPPED;
+			}
+
 			logger->m_stop_wait_variable.notify_all();
 			return;
 		}
+
+		logger->m_worker_thread_sleeping = true;
+
+		if (!logger->m_message_ring.isEmpty() || logger->isFlushRequested() ||
+			(logger->m_worker_thread_state == ThreadState::STOPPING)) {
+			if (!logger->m_worker_thread_sleeping.exchange(false)) {
+				logger->m_worker_thread_wake_semaphore.acquire();
+			}
+
+			continue;
+		}
+
+		if (logger->m_sink.getUnflushedSize() > 0) {
+			if (!logger->m_worker_thread_wake_semaphore.try_acquire_until(last_write_time + logger->m_settings.flush_interval)) {
+				if (!logger->m_worker_thread_sleeping.exchange(false)) {
+					logger->m_worker_thread_wake_semaphore.acquire();
+				}
+			}
+		}
+		else {
+			logger->m_worker_thread_wake_semaphore.acquire();
+		}
 	}
-}
\ No newline at end of file
+}
@@ -1,19 +1,65 @@
 #pragma once
 
+#include "message_ring.h"
+#include "log_record.h"
+#include "log_sink.h"
+#include "latency_histogram.h"
 #include <string>
-#include <fstream>
+#include <string_view>
 #include <thread>
-#include <queue>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <semaphore>
+#include <condition_variable>
 
 namespace Simulator {
+	struct LoggerSettings {
+		MessageRing::OverflowPolicy overflow_policy = MessageRing::OverflowPolicy::BLOCK;
+		size_t ring_capacity = 2048;
+		size_t flush_size_threshold = 256 * 1024;
+		std::chrono::milliseconds flush_interval{ 100 };
+		size_t segment_size = 64 * 1024 * 1024;
+		uint32_t max_segments = 8;
+		LogFileFormat file_format = LogFileFormat::TEXT;
+		LogLevel min_level = LOG_MIN_LEVEL;
+	};
+
+	struct LoggerStats {
+		// Records that passed the state check, each one ends up either written or dropped.
+		uint64_t accepted_records_count = 0;
+		uint64_t written_records_count = 0;
+		uint64_t written_bytes_count = 0;
+		uint64_t dropped_messages_count = 0;
+		uint64_t drain_time_ns = 0;
+		// From enqueue until the record is copied into the mapped log segment, the OS writes it to disk later.
+		uint64_t sink_latency_p50_ns = 0;
+		uint64_t sink_latency_p99_ns = 0;
+		uint64_t sink_latency_p999_ns = 0;
+		uint64_t sink_latency_max_ns = 0;
+	};
+
 	class Logger {
 	public:
+		using OverflowPolicy = MessageRing::OverflowPolicy;
+
 		~Logger();
 		bool start(const std::string& log_file_name, std::string& out_error_message);
-		void logWrite(const std::string& message);
+		bool start(const std::string& log_file_name, std::string& out_error_message, const LoggerSettings& settings);
+		void logWrite(std::string_view message);
+		void logWrite(LogLevel level, std::string_view message);
+		template<LogFormat FORMAT, typename... Args>
+		void log(const Args&... args);
+		template<typename... Args>
+		void log(LogLevel level, LogFormat format, const Args&... args);
+		bool isEnabled(LogLevel level) const;
+		void setMinLevel(LogLevel level);
+		bool flush(std::chrono::milliseconds timeout);
 		void requestStop();
 		void waitForStop();
+		uint64_t getDroppedMessagesCount() const;
+		LoggerStats getStats() const;
 
 	private:
 		enum class ThreadState {
@@ -24,13 +70,87 @@ namespace Simulator {
 		};
 
 		static void logProcess(Logger* logger);
+		template<typename... Args>
+		void writeRecord(LogLevel level, LogFormat format, const Args&... args);
+		void wakeWorker();
+		bool isFlushRequested() const;
+		void drainMessages();
+		void appendRecord(const char* record, size_t record_size);
+		static uint64_t getTimestamp();
+
+		static constexpr size_t MAX_FORMATTED_RECORD_SIZE = MessageRing::MAX_MESSAGE_SIZE + 1024;
 
-		std::ofstream m_file;
-		std::queue<std::string> m_message_fifo;
+		LoggerSettings m_settings;
+		LogSink m_sink;
+		std::vector<char> m_record_buffer;
+		std::atomic<uint64_t> m_write_failed_count = 0;
+		std::atomic<uint64_t> m_accepted_records_count = 0;
+		std::atomic<uint32_t> m_active_writers_count = 0;
+		std::atomic<uint64_t> m_written_records_count = 0;
+		std::atomic<uint64_t> m_written_bytes_count = 0;
+		std::atomic<uint64_t> m_drain_time_ns = 0;
+		LatencyHistogram m_sink_latency;
+		MessageRing m_message_ring;
 		std::thread m_worker_thread;
-		ThreadState m_worker_thread_state = ThreadState::STOPPED;
+		std::atomic<ThreadState> m_worker_thread_state = ThreadState::STOPPED;
+		std::atomic<LogLevel> m_min_level = LOG_MIN_LEVEL;
+		std::atomic<bool> m_worker_thread_sleeping = false;
+		std::counting_semaphore<> m_worker_thread_wake_semaphore{ 0 };
+		std::atomic<uint64_t> m_flush_requested_count = 0;
+		std::atomic<uint64_t> m_flush_completed_count = 0;
 		std::mutex m_worker_thread_mutex;
-		std::condition_variable m_worker_thread_wait_variable;
 		std::condition_variable m_stop_wait_variable;
 	};
+
+	template<LogFormat FORMAT, typename... Args>
+	void Logger::log(const Args&... args)
+	{
+		constexpr LogLevel level = getLogFormatLevel(FORMAT);
+
+		if constexpr (level >= LOG_MIN_LEVEL) {
+			if (isEnabled(level)) {
+				writeRecord(level, FORMAT, args...);
+			}
+		}
+	}
+
+	template<typename... Args>
+	void Logger::log(LogLevel level, LogFormat format, const Args&... args)
+	{
+		if (isEnabled(level)) {
+			writeRecord(level, format, args...);
+		}
+	}
+
+	inline bool Logger::isEnabled(LogLevel level) const
+	{
+		return (level >= LOG_MIN_LEVEL) && (level >= m_min_level.load(std::memory_order_relaxed));
+	}
+
+	template<typename... Args>
+	void Logger::writeRecord(LogLevel level, LogFormat format, const Args&... args)
+	{
+		// Announced before the state check, so a stopping worker waits for this record instead of closing the sink under it.
+		m_active_writers_count.fetch_add(1, std::memory_order_seq_cst);
+		ThreadState state = m_worker_thread_state.load(std::memory_order_seq_cst);
+
+		if ((state != ThreadState::RUNNING) && (state != ThreadState::STARTING)) {
+			m_active_writers_count.fetch_sub(1, std::memory_order_release);
+			return;
+		}
+
+		m_accepted_records_count.fetch_add(1, std::memory_order_relaxed);
+
+		size_t pos;
+		char* record = m_message_ring.reserve(pos);
+		if (record == nullptr) {
+			m_active_writers_count.fetch_sub(1, std::memory_order_release);
+			return;
+		}
+
+		size_t record_size = encodeLogRecord(record, MessageRing::MAX_MESSAGE_SIZE, format, level, getTimestamp(), args...);
+		m_message_ring.commit(pos, record_size);
+		m_active_writers_count.fetch_sub(1, std::memory_order_release);
+		wakeWorker();
+	}
 }
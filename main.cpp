@@ -1,15 +1,106 @@
 #include <SDKDDKVer.h>
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <shellapi.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <future>
+
+#include "instrumentation.h"
+#include "job_system.h"
 #include "logger.h"
 #include "renderer.h"
+#include "simulation_thread.h"
+#include "validation_message_filter.h"
+
+struct CommandLineOptions {
+	bool headless = false;
+	bool binary_log = false;
+	Simulator::LogLevel log_level = Simulator::LOG_MIN_LEVEL;
+	size_t log_segment_size = Simulator::LoggerSettings().segment_size;
+	uint32_t log_segments_count = Simulator::LoggerSettings().max_segments;
+	uint64_t frames_count = 100;
+	uint32_t width = 1280;
+	uint32_t height = 720;
+	uint32_t offscreen_targets_count = 3;
+	std::filesystem::path output_dir;
+	bool check_frames_checksum = false;
+	uint64_t expected_frames_checksum = 0;
+	std::string device;
+	std::filesystem::path pipeline_cache_path = "pipeline_cache.bin";
+	std::filesystem::path gpu_trace_path;
+	std::filesystem::path cpu_trace_path;
+	uint32_t workers_count = Simulator::JobSystemSettings::DEFAULT_WORKERS_COUNT;
+	uint32_t simulation_rate = 60;
+	size_t simulation_bodies_count = Simulator::SimulationSettings().bodies_count;
+	bool gpu_particles = false;
+	bool verify_compute = false;
+	uint32_t verify_compute_steps = 120;
+	bool benchmark_recording = false;
+	uint32_t benchmark_draws_count = 100000;
+	Simulator::ParticleDrawMode particle_draw_mode = Simulator::ParticleDrawMode::GPU_DRIVEN;
+	Simulator::SwapchainSettings swapchain;
+};
 
 struct MainWindowUserData {
+	std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+	CommandLineOptions options;
 	Simulator::Logger logger;
+	Simulator::JobSystem job_system;
+	Simulator::SimulationThread simulation;
+	Simulator::SimulationFrame simulation_frame;
+	Simulator::ParticleStepParams particle_step_params;
+	uint64_t particle_steps_count = 0;
 	Simulator::Renderer renderer;
+	Simulator::ValidationMessageFilter validation_message_filter;
+	std::future<bool> renderer_startup;
+	bool renderer_ready = false;
+	bool first_frame_presented = false;
+	uint64_t frames_rendered = 0;
 };
 
+static constexpr UINT WM_RENDERER_READY = WM_APP + 1;
+static constexpr uint64_t PROFILER_STATS_INTERVAL_FRAMES = 600;
+static constexpr float COMPUTE_VERIFICATION_TOLERANCE = 1e-4f;
+static constexpr uint32_t RECORDING_BENCHMARK_ITERATIONS = 20;
+
+static uint64_t getSteadyTimestamp()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double getMilliseconds(uint64_t nanoseconds)
+{
+	return static_cast<double>(nanoseconds) / 1e6;
+}
+
+static double getMillisecondsSinceStart(const MainWindowUserData& app_data)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - app_data.start_time).count();
+}
+
+static void logStartupPhase(MainWindowUserData& app_data, const char* phase, std::chrono::steady_clock::time_point phase_start_time)
+{
+	auto now = std::chrono::steady_clock::now();
+	app_data.logger.log<Simulator::LogFormat::STARTUP_PHASE>(phase, std::chrono::duration<double, std::milli>(now - phase_start_time).count(),
+		std::chrono::duration<double, std::milli>(now - app_data.start_time).count());
+}
+
+static void logValidationMessageSummaries(MainWindowUserData& app_data, bool force)
+{
+	app_data.validation_message_filter.collectSummaries(getSteadyTimestamp(), force,
+		[&](const Simulator::ValidationMessageFilter::Summary& summary)
+		{
+			app_data.logger.log(summary.level, Simulator::LogFormat::VULKAN_LAYER_MESSAGE_REPEATED, summary.message_id, summary.repeated_count);
+		}
+	);
+}
+
 #ifdef DEBUG
 static VkBool32 VKAPI_PTR vulkanDebugCallback(
 	VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
@@ -17,107 +108,1135 @@ static VkBool32 VKAPI_PTR vulkanDebugCallback(
 	const VkDebugUtilsMessengerCallbackDataEXT* callback_data,
 	void* user_data)
 {
-	std::string severity_str;
+	Simulator::LogLevel level;
+	const char* severity_str;
 	if (message_severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+		level = Simulator::LogLevel::ERR;
 		severity_str = "[ERROR]";
 	}
 	else if (message_severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+		level = Simulator::LogLevel::WARNING;
 		severity_str = "[WARNING]";
 	}
 	else if (message_severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) {
+		level = Simulator::LogLevel::INFO;
 		severity_str = "[INFO]";
 	}
 	else if (message_severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT) {
+		level = Simulator::LogLevel::VERBOSE;
 		severity_str = "[VERBOSE]";
 	}
 	else {
+		level = Simulator::LogLevel::VERBOSE;
 		severity_str = "[UNKNOWN]";
 	}
 
-	std::string type_str = "[";
-	if (message_type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) {
-		type_str += "PERFORMANCE,";
+	auto app_data = static_cast<MainWindowUserData*>(user_data);
+	Simulator::Logger* logger = &(app_data->logger);
+
+	if (!logger->isEnabled(level)) {
+		return VK_FALSE;
+	}
+
+	static constexpr const char* const MESSAGE_TYPE_STRINGS[] = {
+		"[]",
+		"[GENERAL]",
+		"[VALIDATION]",
+		"[VALIDATION,GENERAL]",
+		"[PERFORMANCE]",
+		"[PERFORMANCE,GENERAL]",
+		"[PERFORMANCE,VALIDATION]",
+		"[PERFORMANCE,VALIDATION,GENERAL]"
+	};
+
+	const char* type_str = MESSAGE_TYPE_STRINGS[message_type &
+		(VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT)];
+
+	uint32_t message_id = Simulator::ValidationMessageFilter::getMessageId(callback_data->messageIdNumber, callback_data->pMessageIdName);
+	Simulator::ValidationMessageFilter::Summary summary;
+
+	if (!app_data->validation_message_filter.filter(message_id, level, getSteadyTimestamp(), summary)) {
+		return VK_FALSE;
 	}
-	if (message_type & VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT) {
-		type_str += "VALIDATION,";
+
+	if (summary.repeated_count > 0) {
+		logger->log(summary.level, Simulator::LogFormat::VULKAN_LAYER_MESSAGE_REPEATED, summary.message_id, summary.repeated_count);
+	}
+
+	logger->log(level, Simulator::LogFormat::VULKAN_LAYER_MESSAGE, severity_str, type_str, callback_data->pMessage);
+
+	return VK_FALSE;
+}
+#endif
+
+static constexpr std::chrono::milliseconds CRASH_LOG_FLUSH_TIMEOUT{ 1000 };
+static Simulator::Logger* s_crash_logger = nullptr;
+
+static LONG WINAPI crashHandler(EXCEPTION_POINTERS* exception_info)
+{
+	if (s_crash_logger != nullptr) {
+		s_crash_logger->log<Simulator::LogFormat::UNHANDLED_EXCEPTION>(
+			exception_info->ExceptionRecord->ExceptionCode, exception_info->ExceptionRecord->ExceptionAddress);
+		s_crash_logger->flush(CRASH_LOG_FLUSH_TIMEOUT);
 	}
-	if (message_type & VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT) {
-		type_str += "GENERAL,";
+
+	return EXCEPTION_CONTINUE_SEARCH;
+}
+
+static void terminateHandler()
+{
+	if (s_crash_logger != nullptr) {
+		s_crash_logger->log<Simulator::LogFormat::UNHANDLED_CPP_EXCEPTION>();
+		s_crash_logger->flush(CRASH_LOG_FLUSH_TIMEOUT);
 	}
-	if (type_str.size() > 1) {
-		type_str.pop_back();
+
+	std::abort();
+}
+
+static bool parseCommandLine(CommandLineOptions& out_options, std::string& out_error_message)
+{
+	int args_count = 0;
+	LPWSTR* args = CommandLineToArgvW(GetCommandLineW(), &args_count);
+	if (args == nullptr) {
+		out_error_message = "Failed to parse command line. Windows error:" + std::to_string(GetLastError());
+		return false;
 	}
-	type_str += "]";
 
-	auto logger = static_cast<Simulator::Logger*>(user_data);
+	bool success = true;
 
-	logger->logWrite("[LAYER] " + severity_str + " " + type_str + " " +
-		std::string(callback_data->pMessage));
+	for (int i = 1; i < args_count; i++) {
+		std::wstring arg(args[i]);
+		bool has_value = (i + 1) < args_count;
 
-	return VK_FALSE;
+		if (arg == L"--headless") {
+			out_options.headless = true;
+		}
+		else if (arg == L"--binary-log") {
+			out_options.binary_log = true;
+		}
+		else if ((arg == L"--log-level") && has_value) {
+			std::wstring level(args[++i]);
+
+			if (level == L"verbose") {
+				out_options.log_level = Simulator::LogLevel::VERBOSE;
+			}
+			else if (level == L"info") {
+				out_options.log_level = Simulator::LogLevel::INFO;
+			}
+			else if (level == L"warning") {
+				out_options.log_level = Simulator::LogLevel::WARNING;
+			}
+			else if (level == L"error") {
+				out_options.log_level = Simulator::LogLevel::ERR;
+			}
+			else {
+				out_error_message = "Invalid log level.";
+				success = false;
+				break;
+			}
+		}
+		else if ((arg == L"--log-segment-mb") && has_value) {
+			out_options.log_segment_size = static_cast<size_t>(std::wcstoull(args[++i], nullptr, 10)) * 1024 * 1024;
+		}
+		else if ((arg == L"--log-segments") && has_value) {
+			out_options.log_segments_count = std::wcstoul(args[++i], nullptr, 10);
+		}
+		else if ((arg == L"--frames") && has_value) {
+			out_options.frames_count = std::wcstoull(args[++i], nullptr, 10);
+		}
+		else if ((arg == L"--width") && has_value) {
+			out_options.width = std::wcstoul(args[++i], nullptr, 10);
+		}
+		else if ((arg == L"--height") && has_value) {
+			out_options.height = std::wcstoul(args[++i], nullptr, 10);
+		}
+		else if ((arg == L"--offscreen-targets") && has_value) {
+			out_options.offscreen_targets_count = std::wcstoul(args[++i], nullptr, 10);
+		}
+		else if ((arg == L"--output-dir") && has_value) {
+			out_options.output_dir = args[++i];
+		}
+		else if ((arg == L"--present-mode") && has_value) {
+			std::wstring present_mode(args[++i]);
+
+			if (present_mode == L"mailbox") {
+				out_options.swapchain.present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
+			}
+			else if (present_mode == L"immediate") {
+				out_options.swapchain.present_mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+			}
+			else if (present_mode == L"fifo") {
+				out_options.swapchain.present_mode = VK_PRESENT_MODE_FIFO_KHR;
+			}
+			else if (present_mode == L"fifo-relaxed") {
+				out_options.swapchain.present_mode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+			}
+			else {
+				out_error_message = "Invalid present mode.";
+				success = false;
+				break;
+			}
+		}
+		else if ((arg == L"--swapchain-images") && has_value) {
+			out_options.swapchain.images_count = std::wcstoul(args[++i], nullptr, 10);
+		}
+		else if ((arg == L"--frames-in-flight") && has_value) {
+			out_options.swapchain.frames_in_flight_count = std::wcstoul(args[++i], nullptr, 10);
+		}
+		else if ((arg == L"--pipeline-cache") && has_value) {
+			out_options.pipeline_cache_path = args[++i];
+		}
+		else if (arg == L"--no-pipeline-cache") {
+			out_options.pipeline_cache_path.clear();
+		}
+		else if ((arg == L"--gpu-trace") && has_value) {
+			out_options.gpu_trace_path = args[++i];
+		}
+		else if ((arg == L"--cpu-trace") && has_value) {
+			out_options.cpu_trace_path = args[++i];
+		}
+		else if ((arg == L"--workers") && has_value) {
+			out_options.workers_count = std::wcstoul(args[++i], nullptr, 10);
+		}
+		else if ((arg == L"--sim-rate") && has_value) {
+			out_options.simulation_rate = std::wcstoul(args[++i], nullptr, 10);
+			if (out_options.simulation_rate == 0) {
+				out_error_message = "Invalid simulation rate.";
+				success = false;
+				break;
+			}
+		}
+		else if ((arg == L"--sim-bodies") && has_value) {
+			out_options.simulation_bodies_count = static_cast<size_t>(std::wcstoull(args[++i], nullptr, 10));
+		}
+		else if (arg == L"--gpu-particles") {
+			out_options.gpu_particles = true;
+		}
+		else if (arg == L"--verify-compute") {
+			out_options.headless = true;
+			out_options.verify_compute = true;
+		}
+		else if ((arg == L"--expect-checksum") && has_value) {
+			out_options.check_frames_checksum = true;
+			out_options.expected_frames_checksum = std::wcstoull(args[++i], nullptr, 16);
+		}
+		else if ((arg == L"--verify-compute-steps") && has_value) {
+			out_options.verify_compute_steps = std::wcstoul(args[++i], nullptr, 10);
+		}
+		else if (arg == L"--benchmark-recording") {
+			out_options.headless = true;
+			out_options.benchmark_recording = true;
+		}
+		else if ((arg == L"--benchmark-draws") && has_value) {
+			out_options.benchmark_draws_count = std::wcstoul(args[++i], nullptr, 10);
+			if (out_options.benchmark_draws_count == 0) {
+				out_error_message = "Invalid benchmark draws count.";
+				success = false;
+				break;
+			}
+		}
+		else if ((arg == L"--particle-draws") && has_value) {
+			std::wstring draw_mode(args[++i]);
+			if (draw_mode == L"cpu") {
+				out_options.particle_draw_mode = Simulator::ParticleDrawMode::CPU_RECORDED;
+			}
+			else if (draw_mode == L"gpu") {
+				out_options.particle_draw_mode = Simulator::ParticleDrawMode::GPU_DRIVEN;
+			}
+			else {
+				out_error_message = "Invalid particle draw mode.";
+				success = false;
+				break;
+			}
+		}
+		else if ((arg == L"--device") && has_value) {
+			std::wstring device(args[++i]);
+			int device_size = WideCharToMultiByte(CP_UTF8, 0, device.c_str(), static_cast<int>(device.size()), nullptr, 0, nullptr, nullptr);
+			out_options.device.resize(device_size);
+			WideCharToMultiByte(CP_UTF8, 0, device.c_str(), static_cast<int>(device.size()), out_options.device.data(), device_size, nullptr, nullptr);
+		}
+		else {
+			out_error_message = "Invalid command line argument #" + std::to_string(i) + ".";
+			success = false;
+			break;
+		}
+	}
+
+	LocalFree(args);
+	return success;
+}
+
+// FNV-1a over 64-bit words, chained across frames in frame order.
+static uint64_t updateFramesChecksum(uint64_t checksum, const std::vector<uint8_t>& pixels)
+{
+	static constexpr uint64_t FNV_PRIME = 0x100000001B3ull;
+
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= pixels.size(); i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, pixels.data() + i, sizeof(word));
+		checksum = (checksum ^ word) * FNV_PRIME;
+	}
+
+	for (; i < pixels.size(); i++) {
+		checksum = (checksum ^ pixels[i]) * FNV_PRIME;
+	}
+
+	return checksum;
+}
+
+static bool saveHeadlessFrame(Simulator::Renderer& renderer, const CommandLineOptions& options, uint64_t frame_number,
+	uint32_t target_idx, std::vector<uint8_t>& pixels, uint64_t& frames_checksum, std::string& out_error_message)
+{
+	if (!renderer.readOffscreenFrame(target_idx, pixels, out_error_message)) {
+		return false;
+	}
+
+	frames_checksum = updateFramesChecksum(frames_checksum, pixels);
+
+	if (options.output_dir.empty()) {
+		return true;
+	}
+
+	char file_name[32];
+	snprintf(file_name, sizeof(file_name), "frame_%06llu.ppm", static_cast<unsigned long long>(frame_number));
+
+	return Simulator::Renderer::writeImageFile(options.output_dir / file_name, renderer.getOffscreenWidth(),
+		renderer.getOffscreenHeight(), pixels, out_error_message);
+}
+
+static bool selectPhysicalDevice(MainWindowUserData& app_data, VkPhysicalDevice& out_physical_device)
+{
+	std::string out_error_message;
+	std::vector<VkPhysicalDevice> out_supported_vk_physical_devices;
+	if (!app_data.renderer.getSupportedPhysicalDevices(out_supported_vk_physical_devices, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return false;
+	}
+
+	std::vector<Simulator::Renderer::PhysicalDeviceScore> ranked_devices;
+	bool ranked = app_data.renderer.rankPhysicalDevices(out_supported_vk_physical_devices, ranked_devices, out_error_message);
+
+	app_data.logger.log<Simulator::LogFormat::PHYSICAL_DEVICES_FOUND>();
+	for (const Simulator::Renderer::PhysicalDeviceScore& device : ranked_devices) {
+		std::string uuid = Simulator::Renderer::getDeviceUuidString(device.device_uuid);
+
+		if (device.extensions_supported) {
+			app_data.logger.log<Simulator::LogFormat::PHYSICAL_DEVICE_SCORE>(device.properties.deviceName, uuid, device.total_score,
+				device.device_type_score, device.memory_score, device.queues_score, device.features_score, device.limits_score);
+		}
+		else {
+			app_data.logger.log<Simulator::LogFormat::PHYSICAL_DEVICE_UNSUPPORTED>(device.properties.deviceName, uuid, device.unsupported_reason);
+		}
+	}
+
+	if (!ranked) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return false;
+	}
+
+	size_t device_idx = 0;
+	if (!app_data.options.device.empty() &&
+		!Simulator::Renderer::findPhysicalDevice(ranked_devices, app_data.options.device, device_idx)) {
+		app_data.logger.log<Simulator::LogFormat::PHYSICAL_DEVICE_OVERRIDE_NOT_FOUND>(app_data.options.device);
+		device_idx = 0;
+	}
+
+	out_physical_device = ranked_devices[device_idx].physical_device;
+	return true;
+}
+
+static void logDeviceQueues(MainWindowUserData& app_data)
+{
+	Simulator::DeviceQueue& present_queue = app_data.renderer.getPresentQueue();
+	Simulator::DeviceQueue& compute_queue = app_data.renderer.getComputeQueue();
+	Simulator::DeviceQueue& transfer_queue = app_data.renderer.getTransferQueue();
+
+	app_data.logger.log<Simulator::LogFormat::DEVICE_QUEUES>(app_data.renderer.getGraphicsQueue().getFamilyIndex(),
+		present_queue.getFamilyIndex(), present_queue.isShared() ? " (shared with graphics)" : "",
+		compute_queue.getFamilyIndex(), compute_queue.isShared() ? " (shared with graphics)" : " (dedicated)",
+		transfer_queue.getFamilyIndex(), transfer_queue.isShared() ? " (shared with graphics)" : " (dedicated)");
 }
+
+static bool createPipelineCache(MainWindowUserData& app_data)
+{
+	std::string out_error_message;
+	if (!app_data.renderer.createPipelineCache(app_data.options.pipeline_cache_path, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return false;
+	}
+
+	Simulator::PipelineCacheStats stats = app_data.renderer.getPipelineCache().getStats();
+	double load_time_ms = static_cast<double>(stats.load_time_ns) / 1e6;
+
+	if (stats.loaded) {
+		app_data.logger.log<Simulator::LogFormat::PIPELINE_CACHE_HIT>(stats.loaded_size, app_data.options.pipeline_cache_path.string(), load_time_ms);
+	}
+	else {
+		app_data.logger.log<Simulator::LogFormat::PIPELINE_CACHE_MISS>(stats.miss_reason, load_time_ms);
+	}
+
+	return true;
+}
+
+static void logPipelineCacheStats(MainWindowUserData& app_data)
+{
+	Simulator::PipelineCacheStats stats = app_data.renderer.getPipelineCache().getStats();
+
+	if (!stats.save_error_message.empty()) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(stats.save_error_message);
+	}
+
+	app_data.logger.log<Simulator::LogFormat::PIPELINE_CACHE_STATS>(stats.pipeline_hits_count, stats.pipeline_misses_count,
+		stats.saved ? "saved" : "unchanged", stats.saved_size);
+}
+
+static void logMemoryStats(MainWindowUserData& app_data)
+{
+	Simulator::MemoryAllocatorStats stats = app_data.renderer.getMemoryAllocator().getStats();
+
+	for (size_t i = 0; i < stats.heaps.size(); i++) {
+		const Simulator::MemoryHeapStats& heap_stats = stats.heaps[i];
+		if (heap_stats.blocks_count == 0) {
+			continue;
+		}
+
+		app_data.logger.log<Simulator::LogFormat::MEMORY_HEAP_STATS>(i, heap_stats.blocks_count, heap_stats.allocations_count,
+			heap_stats.dedicated_allocations_count, heap_stats.used_size, heap_stats.blocks_size, heap_stats.fragmentation * 100.0);
+	}
+
+	app_data.logger.log<Simulator::LogFormat::MEMORY_ALLOCATOR_STATS>(stats.device_allocations_count, stats.max_device_allocations_count,
+		stats.allocations_total_count, stats.frees_total_count, stats.defragmentation_moves_count);
+}
+
+static void logStagingUploaderStats(MainWindowUserData& app_data)
+{
+	Simulator::StagingUploaderStats stats = app_data.renderer.getStagingUploader().getStats();
+
+	app_data.logger.log<Simulator::LogFormat::STAGING_UPLOADER_STATS>(stats.uploads_count, stats.uploaded_size, stats.batches_count,
+		stats.direct_writes_count, stats.direct_written_size, stats.ring_waits_count);
+}
+
+static void logCommandRecorderStats(MainWindowUserData& app_data)
+{
+	Simulator::CommandRecorderStats stats = app_data.renderer.getCommandRecorderStats();
+	app_data.logger.log<Simulator::LogFormat::COMMAND_RECORDER_STATS>(stats.recorded_command_buffers_count, stats.allocated_command_buffers_count,
+		stats.pool_resets_count);
+}
+
+static void logProfilerStats(MainWindowUserData& app_data)
+{
+	for (const Simulator::ProfilerScopeStats& stats : app_data.renderer.getGpuProfiler().getScopeStats()) {
+		app_data.logger.log<Simulator::LogFormat::PROFILER_SCOPE_STATS>(stats.gpu ? "GPU" : "CPU", stats.name, stats.last_ms, stats.average_ms,
+			stats.min_ms, stats.max_ms, stats.samples_count);
+	}
+
+	uint64_t dropped_frames_count = app_data.renderer.getGpuProfiler().getDroppedFramesCount();
+	if (dropped_frames_count > 0) {
+		app_data.logger.log<Simulator::LogFormat::PROFILER_DROPPED_FRAMES>(dropped_frames_count);
+	}
+}
+
+static void writeProfilerTrace(MainWindowUserData& app_data)
+{
+	if (app_data.options.gpu_trace_path.empty()) {
+		return;
+	}
+
+	std::string out_error_message;
+	const Simulator::GpuProfiler& profiler = app_data.renderer.getGpuProfiler();
+	if (!profiler.writeChromeTrace(app_data.options.gpu_trace_path, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return;
+	}
+
+	app_data.logger.log<Simulator::LogFormat::PROFILER_TRACE_WRITTEN>(profiler.getTraceEventsCount(), app_data.options.gpu_trace_path.string());
+}
+
+static void writeInstrumentationTrace(MainWindowUserData& app_data)
+{
+	if (app_data.options.cpu_trace_path.empty()) {
+		return;
+	}
+
+	std::string out_error_message;
+	if (!Simulator::Instrumentation::writeTrace(app_data.options.cpu_trace_path, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return;
+	}
+
+	app_data.logger.log<Simulator::LogFormat::INSTRUMENTATION_TRACE_WRITTEN>(app_data.options.cpu_trace_path.string());
+}
+
+static void logHostMemoryStats(MainWindowUserData& app_data)
+{
+	Simulator::HostAllocatorStats stats = app_data.renderer.getHostAllocator().getStats();
+
+	for (uint32_t i = 0; i < Simulator::HostAllocatorStats::SCOPES_COUNT; i++) {
+		const Simulator::HostAllocationScopeStats& scope_stats = stats.scopes[i];
+		if ((scope_stats.allocations_total_count == 0) && (scope_stats.internal_allocated_size == 0)) {
+			continue;
+		}
+
+		app_data.logger.log<Simulator::LogFormat::HOST_MEMORY_SCOPE_STATS>(Simulator::HostAllocator::getScopeName(i),
+			scope_stats.allocations_total_count, scope_stats.peak_allocated_size, scope_stats.internal_allocated_size,
+			scope_stats.allocations_count, scope_stats.allocated_size);
+	}
+
+	app_data.logger.log<Simulator::LogFormat::HOST_ALLOCATOR_STATS>(stats.arena_allocations_count, stats.pool_allocations_count,
+		stats.heap_allocations_count, stats.arena_resets_count, stats.pool_slabs_size);
+}
+
+static bool startJobSystem(MainWindowUserData& app_data)
+{
+	Simulator::JobSystemSettings settings;
+	settings.workers_count = app_data.options.workers_count;
+
+	std::string out_error_message;
+	if (!app_data.job_system.start(settings, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return false;
+	}
+
+	app_data.logger.log<Simulator::LogFormat::JOB_SYSTEM_STARTED>(app_data.job_system.getWorkersCount());
+	return true;
+}
+
+static void logJobSystemStats(MainWindowUserData& app_data)
+{
+	Simulator::JobSystemStats stats = app_data.job_system.getStats();
+	app_data.logger.log<Simulator::LogFormat::JOB_SYSTEM_STATS>(stats.executed_jobs_count, stats.stolen_jobs_count, stats.inline_jobs_count);
+}
+
+static bool startSimulation(MainWindowUserData& app_data)
+{
+	Simulator::SimulationSettings settings;
+	settings.step_dt = 1.0 / app_data.options.simulation_rate;
+	settings.bodies_count = app_data.options.simulation_bodies_count;
+
+	std::string out_error_message;
+	if (!app_data.simulation.start(settings, &app_data.job_system, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return false;
+	}
+
+	app_data.logger.log<Simulator::LogFormat::SIMULATION_STARTED>(settings.bodies_count, app_data.options.simulation_rate);
+	return true;
+}
+
+static void logSimulationStats(MainWindowUserData& app_data)
+{
+	Simulator::SimulationStats stats = app_data.simulation.getStats();
+	double average_step_ms = (stats.steps_count > 0) ? (stats.total_step_ms / stats.steps_count) : 0.0;
+	app_data.logger.log<Simulator::LogFormat::SIMULATION_STATS>(stats.steps_count, stats.dropped_steps_count, average_step_ms,
+		stats.published_snapshots_count, stats.consumed_snapshots_count);
+}
+
+static bool initRenderer(MainWindowUserData& app_data, HINSTANCE app_instance, HWND window)
+{
+	std::string out_error_message;
+	auto phase_start_time = std::chrono::steady_clock::now();
+
+	bool initialized;
+	if (window == nullptr) {
+#ifdef DEBUG
+		initialized = app_data.renderer.initHeadless(out_error_message, vulkanDebugCallback, &app_data);
+#else
+		initialized = app_data.renderer.initHeadless(out_error_message);
 #endif
+	}
+	else {
+#ifdef DEBUG
+		initialized = app_data.renderer.init(out_error_message, app_instance, window, vulkanDebugCallback, &app_data);
+#else
+		initialized = app_data.renderer.init(out_error_message, app_instance, window);
+#endif
+	}
+
+	if (!initialized) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return false;
+	}
+
+	logStartupPhase(app_data, "instance", phase_start_time);
+	phase_start_time = std::chrono::steady_clock::now();
+
+	VkPhysicalDevice vk_physical_device;
+	if (!selectPhysicalDevice(app_data, vk_physical_device)) {
+		return false;
+	}
+
+	logStartupPhase(app_data, "device selection", phase_start_time);
+	phase_start_time = std::chrono::steady_clock::now();
+
+	if (!app_data.renderer.createLogicalDevice(vk_physical_device, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return false;
+	}
+
+	logStartupPhase(app_data, "logical device", phase_start_time);
+	logDeviceQueues(app_data);
+	phase_start_time = std::chrono::steady_clock::now();
+
+	if (!createPipelineCache(app_data)) {
+		return false;
+	}
+
+	logStartupPhase(app_data, "pipeline cache", phase_start_time);
+
+	const Simulator::Renderer::StartupTimings& timings = app_data.renderer.getStartupTimings();
+	app_data.logger.log<Simulator::LogFormat::RENDERER_STARTUP_TIMINGS>(getMilliseconds(timings.loading_ns), getMilliseconds(timings.loading_wait_ns),
+		getMilliseconds(timings.instance_ns), getMilliseconds(timings.device_probes_ns));
+
+	VkPhysicalDeviceProperties vk_physical_device_properties;
+	vkGetPhysicalDeviceProperties(vk_physical_device, &vk_physical_device_properties);
+
+	if (window == nullptr) {
+		app_data.logger.log<Simulator::LogFormat::HEADLESS_PHYSICAL_DEVICE_SELECTED>(vk_physical_device_properties.deviceName);
+	}
+	else {
+		app_data.logger.log<Simulator::LogFormat::PHYSICAL_DEVICE_SELECTED>(vk_physical_device_properties.deviceName);
+	}
+
+	return true;
+}
+
+static int runHeadless(MainWindowUserData& app_data, const CommandLineOptions& options)
+{
+	if (!initRenderer(app_data, nullptr, nullptr)) {
+		return -1;
+	}
+
+	std::string out_error_message;
+	if (!app_data.renderer.createOffscreenTargets(options.width, options.height, options.offscreen_targets_count, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return -1;
+	}
+
+	// The frames show the particles of the windowed scene, integrated on the GPU one fixed step per frame.
+	Simulator::World world;
+	Simulator::SimulationThread::createScene(world, options.simulation_bodies_count);
+
+	if (!app_data.renderer.createParticles(world, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return -1;
+	}
+
+	double dt = 1.0 / options.simulation_rate;
+
+	Simulator::ParticleStepParams params;
+	params.integration = world.getIntegrationParams(static_cast<float>(dt));
+	params.spring_stiffness = Simulator::SimulationSettings().spring_stiffness;
+
+	if (!options.output_dir.empty()) {
+		std::error_code error_code;
+		std::filesystem::create_directories(options.output_dir, error_code);
+		if (error_code) {
+			app_data.logger.log<Simulator::LogFormat::OUTPUT_DIRECTORY_CREATION_FAILED>(error_code.message());
+			return -1;
+		}
+	}
+
+	app_data.logger.log<Simulator::LogFormat::STARTUP_COMPLETED>(getMillisecondsSinceStart(app_data));
+
+	/**************************************************************************************/
+
+	uint32_t targets_count = app_data.renderer.getOffscreenTargetsCount();
+	std::vector<uint8_t> pixels;
+	uint64_t frames_checksum = 0xCBF29CE484222325ull;
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	for (uint64_t frame_number = 0; frame_number < options.frames_count; frame_number++) {
+		uint32_t target_idx = static_cast<uint32_t>(frame_number % targets_count);
+
+		if (app_data.renderer.isOffscreenFramePending(target_idx)) {
+			if (!saveHeadlessFrame(app_data.renderer, options, frame_number - targets_count, target_idx, pixels, frames_checksum,
+				out_error_message)) {
+				app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+				return -1;
+			}
+		}
+
+		app_data.renderer.queueParticleSteps(1, params);
+
+		if (!app_data.renderer.renderOffscreenFrame(frame_number, frame_number * dt, out_error_message)) {
+			app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+			return -1;
+		}
+
+		if (((frame_number + 1) % PROFILER_STATS_INTERVAL_FRAMES) == 0) {
+			logProfilerStats(app_data);
+			Simulator::Instrumentation::logStats(app_data.logger);
+		}
+
+		logValidationMessageSummaries(app_data, false);
+	}
+
+	uint64_t first_pending_frame = (options.frames_count > targets_count) ? (options.frames_count - targets_count) : 0;
+	for (uint64_t frame_number = first_pending_frame; frame_number < options.frames_count; frame_number++) {
+		uint32_t target_idx = static_cast<uint32_t>(frame_number % targets_count);
+
+		if (!saveHeadlessFrame(app_data.renderer, options, frame_number, target_idx, pixels, frames_checksum, out_error_message)) {
+			app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+			return -1;
+		}
+	}
+
+	std::chrono::duration<double> elapsed_time = std::chrono::steady_clock::now() - start_time;
+	double frames_per_second = (elapsed_time.count() > 0.0) ? (options.frames_count / elapsed_time.count()) : 0.0;
+
+	app_data.logger.log<Simulator::LogFormat::HEADLESS_FRAMES_RENDERED>(options.frames_count, elapsed_time.count(), frames_per_second);
+	app_data.logger.log<Simulator::LogFormat::HEADLESS_FRAMES_CHECKSUM>(frames_checksum);
+
+	bool checksum_matched = !options.check_frames_checksum || (frames_checksum == options.expected_frames_checksum);
+	if (!checksum_matched) {
+		app_data.logger.log<Simulator::LogFormat::HEADLESS_FRAMES_CHECKSUM_MISMATCH>(frames_checksum, options.expected_frames_checksum);
+	}
+
+	logMemoryStats(app_data);
+	logStagingUploaderStats(app_data);
+	app_data.renderer.destroy();
+	logProfilerStats(app_data);
+	writeProfilerTrace(app_data);
+	logPipelineCacheStats(app_data);
+	logHostMemoryStats(app_data);
+	logJobSystemStats(app_data);
+	Simulator::Instrumentation::logStats(app_data.logger);
+	writeInstrumentationTrace(app_data);
+	logValidationMessageSummaries(app_data, true);
+	return checksum_matched ? 0 : -1;
+}
+
+static int runComputeVerification(MainWindowUserData& app_data, const CommandLineOptions& options)
+{
+	if (!initRenderer(app_data, nullptr, nullptr)) {
+		return -1;
+	}
+
+	Simulator::World world;
+	world.setSimdPath(Simulator::SimdPath::SCALAR);
+	Simulator::SimulationThread::createScene(world, options.simulation_bodies_count);
+
+	std::string out_error_message;
+	if (!app_data.renderer.createParticles(world, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return -1;
+	}
+
+	app_data.logger.log<Simulator::LogFormat::STARTUP_COMPLETED>(getMillisecondsSinceStart(app_data));
+
+	/**************************************************************************************/
+
+	float dt = 1.0f / options.simulation_rate;
+	float spring_stiffness = Simulator::SimulationSettings().spring_stiffness;
+
+	Simulator::ParticleStepParams params;
+	params.integration = world.getIntegrationParams(dt);
+	params.spring_stiffness = spring_stiffness;
+
+	auto gpu_start_time = std::chrono::steady_clock::now();
+
+	std::vector<Simulator::GpuParticle> particles;
+	if (!app_data.renderer.runParticleSteps(options.verify_compute_steps, params, particles, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return -1;
+	}
+
+	auto cpu_start_time = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < options.verify_compute_steps; i++) {
+		Simulator::SimulationThread::applySpringForces(world, spring_stiffness);
+		world.step(dt, Simulator::IntegrationMethod::SEMI_IMPLICIT_EULER);
+	}
+
+	auto end_time = std::chrono::steady_clock::now();
+
+	Simulator::ParticleComparison comparison = Simulator::ParticleCompute::compare(world, particles, COMPUTE_VERIFICATION_TOLERANCE);
+	app_data.logger.log<Simulator::LogFormat::COMPUTE_VERIFICATION>(comparison.particles_count, options.verify_compute_steps,
+		std::chrono::duration<double, std::milli>(cpu_start_time - gpu_start_time).count(),
+		std::chrono::duration<double, std::milli>(end_time - cpu_start_time).count(), comparison.max_position_error, comparison.max_velocity_error);
+
+	if (comparison.mismatches_count > 0) {
+		app_data.logger.log<Simulator::LogFormat::COMPUTE_VERIFICATION_FAILED>(comparison.mismatches_count, comparison.particles_count,
+			COMPUTE_VERIFICATION_TOLERANCE);
+	}
+
+	logMemoryStats(app_data);
+	logStagingUploaderStats(app_data);
+	app_data.renderer.destroy();
+	logPipelineCacheStats(app_data);
+	logHostMemoryStats(app_data);
+	logValidationMessageSummaries(app_data, true);
+	return (comparison.mismatches_count == 0) ? 0 : 1;
+}
+
+static const char* getParticleDrawModeName(Simulator::ParticleDrawMode draw_mode)
+{
+	return (draw_mode == Simulator::ParticleDrawMode::GPU_DRIVEN) ? "GPU driven" : "CPU recorded";
+}
+
+static bool measureRecording(MainWindowUserData& app_data, Simulator::CommandRecorder& recorder, Simulator::JobSystem* job_system, uint32_t draws_count,
+	VkExtent2D extent, Simulator::ParticleDrawMode draw_mode, std::vector<VkCommandBuffer>& command_buffers, double& out_average_ms)
+{
+	std::string out_error_message;
+	double total_ms = 0.0;
+
+	// The first pass allocates the command buffers and is left out, the pool reset is part of every frame.
+	for (uint32_t i = 0; i <= RECORDING_BENCHMARK_ITERATIONS; i++) {
+		auto start_time = std::chrono::steady_clock::now();
+
+		if (!recorder.beginFrame(0, out_error_message) ||
+			!app_data.renderer.recordParticleDraws(recorder, job_system, draws_count, extent, draw_mode, command_buffers, out_error_message)) {
+			app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+			return false;
+		}
+
+		if (i > 0) {
+			total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+		}
+	}
+
+	out_average_ms = total_ms / RECORDING_BENCHMARK_ITERATIONS;
+	return true;
+}
+
+static uint32_t getNextBenchmarkDrawsCount(uint32_t draws_count, const CommandLineOptions& options)
+{
+	return static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(draws_count) * 10, options.benchmark_draws_count));
+}
+
+static int runRecordingBenchmark(MainWindowUserData& app_data, const CommandLineOptions& options)
+{
+	if (!initRenderer(app_data, nullptr, nullptr)) {
+		return -1;
+	}
+
+	Simulator::World world;
+	Simulator::SimulationThread::createScene(world, options.benchmark_draws_count);
+
+	std::string out_error_message;
+	if (!app_data.renderer.createParticles(world, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return -1;
+	}
+
+	app_data.logger.log<Simulator::LogFormat::STARTUP_COMPLETED>(getMillisecondsSinceStart(app_data));
+
+	/**************************************************************************************/
+
+	VkExtent2D extent{ options.width, options.height };
+	uint32_t max_threads_count = app_data.job_system.getThreadsCount();
+	std::vector<VkCommandBuffer> command_buffers;
+
+	uint32_t threads_count = 1;
+	while (true) {
+		Simulator::JobSystemSettings settings;
+		settings.workers_count = threads_count - 1;
+
+		Simulator::JobSystem job_system;
+		if (!job_system.start(settings, out_error_message)) {
+			app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+			return -1;
+		}
+
+		Simulator::CommandRecorder recorder;
+		if (!recorder.create(app_data.renderer.getLogicalDevice(), app_data.renderer.getGraphicsQueue().getFamilyIndex(), 1, threads_count,
+			app_data.renderer.getHostAllocator().getCallbacks(), out_error_message)) {
+			app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+			return -1;
+		}
+
+		uint32_t draws_count = std::min(1000u, options.benchmark_draws_count);
+		while (true) {
+			double average_ms;
+			if (!measureRecording(app_data, recorder, &job_system, draws_count, extent, Simulator::ParticleDrawMode::CPU_RECORDED, command_buffers,
+				average_ms)) {
+				return -1;
+			}
+
+			double draws_per_second = (average_ms > 0.0) ? (draws_count / (average_ms * 1000.0)) : 0.0;
+			app_data.logger.log<Simulator::LogFormat::RECORDING_BENCHMARK>(threads_count, draws_count, command_buffers.size(), average_ms,
+				draws_per_second);
+
+			if (draws_count == options.benchmark_draws_count) {
+				break;
+			}
+
+			draws_count = getNextBenchmarkDrawsCount(draws_count, options);
+		}
+
+		if (threads_count == max_threads_count) {
+			break;
+		}
+
+		threads_count = std::min(threads_count * 2, max_threads_count);
+	}
+
+	/**************************************************************************************/
+
+	// GPU driven draws are one indirect draw whatever the count, so a single thread records them.
+	if (app_data.renderer.isGpuDrivenDrawingSupported()) {
+		Simulator::CommandRecorder recorder;
+		if (!recorder.create(app_data.renderer.getLogicalDevice(), app_data.renderer.getGraphicsQueue().getFamilyIndex(), 1, 1,
+			app_data.renderer.getHostAllocator().getCallbacks(), out_error_message)) {
+			app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+			return -1;
+		}
+
+		uint32_t draws_count = std::min(1000u, options.benchmark_draws_count);
+		while (true) {
+			double average_ms;
+			if (!measureRecording(app_data, recorder, nullptr, draws_count, extent, Simulator::ParticleDrawMode::GPU_DRIVEN, command_buffers, average_ms)) {
+				return -1;
+			}
+
+			app_data.logger.log<Simulator::LogFormat::GPU_DRIVEN_RECORDING_BENCHMARK>(draws_count, command_buffers.size(), average_ms);
+
+			if (draws_count == options.benchmark_draws_count) {
+				break;
+			}
+
+			draws_count = getNextBenchmarkDrawsCount(draws_count, options);
+		}
+	}
+	else {
+		app_data.logger.log<Simulator::LogFormat::PARTICLE_DRAW_MODE>(getParticleDrawModeName(Simulator::ParticleDrawMode::CPU_RECORDED),
+			getParticleDrawModeName(Simulator::ParticleDrawMode::GPU_DRIVEN));
+	}
+
+	logMemoryStats(app_data);
+	app_data.renderer.destroy();
+	logPipelineCacheStats(app_data);
+	logHostMemoryStats(app_data);
+	logValidationMessageSummaries(app_data, true);
+	return 0;
+}
+
+static void logSwapchain(MainWindowUserData& app_data)
+{
+	const Simulator::Swapchain& swapchain = app_data.renderer.getSwapchain();
+	if (!swapchain.isCreated()) {
+		return;
+	}
+
+	VkExtent2D extent = swapchain.getExtent();
+	app_data.logger.log<Simulator::LogFormat::SWAPCHAIN_CREATED>(extent.width, extent.height, swapchain.getImagesCount(),
+		Simulator::Swapchain::getPresentModeName(swapchain.getPresentMode()), app_data.renderer.getFramesInFlightCount());
+
+	if (swapchain.getPresentMode() != app_data.options.swapchain.present_mode) {
+		app_data.logger.log<Simulator::LogFormat::SWAPCHAIN_PRESENT_MODE_FALLBACK>(
+			Simulator::Swapchain::getPresentModeName(app_data.options.swapchain.present_mode),
+			Simulator::Swapchain::getPresentModeName(swapchain.getPresentMode()));
+	}
+}
+
+static bool createGpuParticles(MainWindowUserData& app_data)
+{
+	Simulator::World world;
+	Simulator::SimulationThread::createScene(world, app_data.options.simulation_bodies_count);
+
+	std::string out_error_message;
+	if (!app_data.renderer.createParticles(world, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return false;
+	}
+
+	const Simulator::SimulationSettings& settings = app_data.simulation.getSettings();
+	app_data.particle_step_params.integration = world.getIntegrationParams(static_cast<float>(settings.step_dt));
+	app_data.particle_step_params.spring_stiffness = settings.spring_stiffness;
+	// Particles start from the initial scene and from here on advance at the simulation rate.
+	app_data.particle_steps_count = app_data.simulation.getStats().steps_count;
+
+	const Simulator::ParticleCompute& particle_compute = app_data.renderer.getParticleCompute();
+	app_data.logger.log<Simulator::LogFormat::GPU_PARTICLES_CREATED>(particle_compute.getParticlesCount(), particle_compute.getParticlesBufferSize());
+	app_data.logger.log<Simulator::LogFormat::PARTICLE_DRAW_MODE>(getParticleDrawModeName(app_data.renderer.getParticleDrawMode()),
+		getParticleDrawModeName(app_data.options.particle_draw_mode));
+	return true;
+}
+
+static bool renderWindowFrame(MainWindowUserData& app_data)
+{
+	app_data.simulation.interpolate(app_data.simulation_frame);
+
+	// The GPU particles take as many steps as the simulation thread did, so both run on the same fixed timestep. Steps beyond the
+	// per frame cap (after a minimize or a long frame) stay owed and are caught up over the next frames instead of being skipped.
+	if (app_data.renderer.getParticleCompute().isCreated() && (app_data.simulation_frame.steps_count > app_data.particle_steps_count)) {
+		uint64_t steps_count = std::min<uint64_t>(app_data.simulation_frame.steps_count - app_data.particle_steps_count,
+			app_data.simulation.getSettings().max_steps_per_update);
+		app_data.renderer.queueParticleSteps(static_cast<uint32_t>(steps_count), app_data.particle_step_params);
+		app_data.particle_steps_count += steps_count;
+	}
+
+	std::string out_error_message;
+	if (!app_data.renderer.renderFrame(app_data.simulation_frame.time, out_error_message)) {
+		app_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+		return false;
+	}
+
+	if (!app_data.first_frame_presented && app_data.renderer.getSwapchain().isCreated()) {
+		app_data.first_frame_presented = true;
+		app_data.logger.log<Simulator::LogFormat::FIRST_FRAME_PRESENTED>(getMillisecondsSinceStart(app_data));
+	}
+
+	app_data.frames_rendered++;
+	if ((app_data.frames_rendered % PROFILER_STATS_INTERVAL_FRAMES) == 0) {
+		logProfilerStats(app_data);
+		Simulator::Instrumentation::logStats(app_data.logger);
+		logValidationMessageSummaries(app_data, false);
+	}
+
+	return true;
+}
 
 static LRESULT CALLBACK wndProc(HWND window, UINT message, WPARAM wparam, LPARAM lparam)
 {
+	SIMULATOR_COUNTER_ADD("wndProc messages", 1);
+
 	switch (message) {
 	case WM_CREATE: {
+		SIMULATOR_SCOPE_TIMER("wndProc WM_CREATE");
+
 		auto create_info = reinterpret_cast<CREATESTRUCTA*>(lparam);
 		auto user_data = static_cast<MainWindowUserData*>(create_info->lpCreateParams);
 
 		SetLastError(0);
 		if (SetWindowLongPtr(window, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(user_data)) != 0) {
-			user_data->logger.logWrite("[ERROR] Failed to store main window data.");
+			user_data->logger.log<Simulator::LogFormat::MAIN_WINDOW_DATA_STORE_FAILED>();
 			return -1;
 		}
 
 		if (GetLastError() != ERROR_SUCCESS) {
-			user_data->logger.logWrite("[ERROR] Failed to store main window data. Windows error:" + std::to_string(GetLastError()));
+			user_data->logger.log<Simulator::LogFormat::MAIN_WINDOW_DATA_STORE_FAILED_WINDOWS_ERROR>(GetLastError());
 			return -1;
 		}
 
+		HINSTANCE app_instance = create_info->hInstance;
+		user_data->renderer_startup = std::async(std::launch::async, [user_data, app_instance, window]()
+			{
+				bool success = initRenderer(*user_data, app_instance, window);
+				PostMessage(window, WM_RENDERER_READY, 0, 0);
+				return success;
+			}
+		);
+
+		return 0;
+	}
+	case WM_RENDERER_READY: {
+		SIMULATOR_SCOPE_TIMER("wndProc WM_RENDERER_READY");
+
+		auto user_data = reinterpret_cast<MainWindowUserData*>(GetWindowLongPtr(window, GWLP_USERDATA));
+		if ((user_data == nullptr) || !user_data->renderer_startup.valid()) {
+			return 0;
+		}
+
+		if (!user_data->renderer_startup.get()) {
+			DestroyWindow(window);
+			return 0;
+		}
+
+		auto phase_start_time = std::chrono::steady_clock::now();
+
+		RECT client_rect;
+		GetClientRect(window, &client_rect);
+
 		std::string out_error_message;
-#ifdef DEBUG
-		if (!user_data->renderer.init(out_error_message, create_info->hInstance, window, vulkanDebugCallback, &(user_data->logger))) {
-#else
-		if (!user_data->renderer.init(out_error_message, create_info->hInstance, window)) {
-#endif
-			user_data->logger.logWrite("[ERROR] " + out_error_message);
-			return -1;
+		if (!user_data->renderer.createSwapchain(static_cast<uint32_t>(client_rect.right - client_rect.left),
+			static_cast<uint32_t>(client_rect.bottom - client_rect.top), user_data->options.swapchain, out_error_message)) {
+			user_data->logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+			DestroyWindow(window);
+			return 0;
 		}
 
-		std::vector<VkPhysicalDevice> out_supported_vk_physical_devices;
-		if (!user_data->renderer.getSupportedPhysicalDevices(out_supported_vk_physical_devices, out_error_message)) {
-			user_data->logger.logWrite("[ERROR] " + out_error_message);
-			return -1;
+		logStartupPhase(*user_data, "swapchain", phase_start_time);
+		logSwapchain(*user_data);
+
+		if (user_data->options.gpu_particles && !createGpuParticles(*user_data)) {
+			DestroyWindow(window);
+			return 0;
 		}
+		user_data->logger.log<Simulator::LogFormat::STARTUP_COMPLETED>(getMillisecondsSinceStart(*user_data));
 
-		user_data->logger.logWrite("[INFO] Found supported Vulkan physical devices:");
-		for (const VkPhysicalDevice& vk_physical_device : out_supported_vk_physical_devices) {
-			VkPhysicalDeviceProperties vk_physical_device_properties;
-			vkGetPhysicalDeviceProperties(vk_physical_device, &vk_physical_device_properties);
-			user_data->logger.logWrite("[INFO] \"" + std::string(vk_physical_device_properties.deviceName) + "\".");
+		user_data->renderer_ready = true;
+		InvalidateRect(window, nullptr, FALSE);
+		return 0;
+	}
+	case WM_SIZE: {
+		SIMULATOR_SCOPE_TIMER("wndProc WM_SIZE");
+
+		auto user_data = reinterpret_cast<MainWindowUserData*>(GetWindowLongPtr(window, GWLP_USERDATA));
+		if ((user_data == nullptr) || !user_data->renderer_ready) {
+			return 0;
 		}
 
-		if (!user_data->renderer.createLogicalDevice(out_supported_vk_physical_devices[0], out_error_message)) {
-			user_data->logger.logWrite("[ERROR] " + out_error_message);
-			return -1;
+		uint64_t rebuilds_count = user_data->renderer.getSwapchainRebuildsCount();
+
+		std::string out_error_message;
+		if (!user_data->renderer.resizeSwapchain(LOWORD(lparam), HIWORD(lparam), out_error_message)) {
+			user_data->logger.log<Simulator::LogFormat::ERROR_MESSAGE>(out_error_message);
+			DestroyWindow(window);
+			return 0;
 		}
 
-		VkPhysicalDeviceProperties vk_physical_device_properties;
-		vkGetPhysicalDeviceProperties(out_supported_vk_physical_devices[0], &vk_physical_device_properties);
-		user_data->logger.logWrite("[INFO] Selected \"" + std::string(vk_physical_device_properties.deviceName) + "\" for rendering.");
+		if (user_data->renderer.getSwapchainRebuildsCount() != rebuilds_count) {
+			VkExtent2D extent = user_data->renderer.getSwapchain().getExtent();
+			user_data->logger.log<Simulator::LogFormat::SWAPCHAIN_REBUILT>(extent.width, extent.height,
+				user_data->renderer.getSwapchainRebuildsCount());
+		}
+
+		return 0;
+	}
+	case WM_PAINT: {
+		SIMULATOR_SCOPE_TIMER("wndProc WM_PAINT");
+
+		auto user_data = reinterpret_cast<MainWindowUserData*>(GetWindowLongPtr(window, GWLP_USERDATA));
+		if ((user_data == nullptr) || !user_data->renderer_ready) {
+			return DefWindowProc(window, message, wparam, lparam);
+		}
 
+		// Frames come from the message loop, painting here only keeps the window drawn inside the modal size and move loops.
+		if (!renderWindowFrame(*user_data)) {
+			DestroyWindow(window);
+			return 0;
+		}
+
+		ValidateRect(window, nullptr);
 		return 0;
 	}
+	case WM_ERASEBKGND:
+		return 1;
 	case WM_DESTROY: {
+		SIMULATOR_SCOPE_TIMER("wndProc WM_DESTROY");
+
 		auto user_data = reinterpret_cast<MainWindowUserData*>(GetWindowLongPtr(window, GWLP_USERDATA));
 		if (user_data == nullptr) {
 			PostQuitMessage(GetLastError());
 			return 0;
 		}
 
+		user_data->simulation.stop();
+
+		if (user_data->renderer_startup.valid()) {
+			user_data->renderer_startup.wait();
+		}
+
+		if (user_data->renderer_ready) {
+			logMemoryStats(*user_data);
+			logStagingUploaderStats(*user_data);
+			logCommandRecorderStats(*user_data);
+		}
+
+		user_data->renderer_ready = false;
 		user_data->renderer.destroy();
+		logProfilerStats(*user_data);
+		writeProfilerTrace(*user_data);
+		logPipelineCacheStats(*user_data);
+		logHostMemoryStats(*user_data);
+		logSimulationStats(*user_data);
+		logJobSystemStats(*user_data);
+		Simulator::Instrumentation::logStats(user_data->logger);
+		writeInstrumentationTrace(*user_data);
+		logValidationMessageSummaries(*user_data, true);
 		PostQuitMessage(ERROR_SUCCESS);
 		return 0;
 	}
@@ -132,12 +1251,61 @@ int APIENTRY wWinMain(_In_ HINSTANCE app_instance, _In_opt_ HINSTANCE prev_app_i
 	UNREFERENCED_PARAMETER(cmd_line);
 
 	MainWindowUserData main_window_user_data;
+	main_window_user_data.renderer.startLoading();
+
+	CommandLineOptions& options = main_window_user_data.options;
+	std::string command_line_error_message;
+	bool command_line_valid = parseCommandLine(options, command_line_error_message);
+
+	Simulator::LoggerSettings logger_settings;
+	logger_settings.file_format = options.binary_log ? Simulator::LogFileFormat::BINARY : Simulator::LogFileFormat::TEXT;
+	logger_settings.min_level = options.log_level;
+	logger_settings.segment_size = options.log_segment_size;
+	logger_settings.max_segments = options.log_segments_count;
+
+	auto phase_start_time = std::chrono::steady_clock::now();
 
 	std::string out_error_message;
-	if (!main_window_user_data.logger.start("log.txt", out_error_message)) {
+	if (!main_window_user_data.logger.start(options.binary_log ? "log.bin" : "log.txt", out_error_message, logger_settings)) {
+		return -1;
+	}
+
+	s_crash_logger = &(main_window_user_data.logger);
+	SetUnhandledExceptionFilter(crashHandler);
+	std::set_terminate(terminateHandler);
+
+	logStartupPhase(main_window_user_data, "logger", phase_start_time);
+
+	Simulator::InstrumentationSettings instrumentation_settings;
+	instrumentation_settings.trace = !options.cpu_trace_path.empty();
+	Simulator::Instrumentation::start(instrumentation_settings);
+
+	if (!command_line_valid) {
+		main_window_user_data.logger.log<Simulator::LogFormat::ERROR_MESSAGE>(command_line_error_message);
+		return -1;
+	}
+
+	if (!startJobSystem(main_window_user_data)) {
 		return -1;
 	}
 
+	main_window_user_data.renderer.setJobSystem(&main_window_user_data.job_system);
+	main_window_user_data.renderer.setParticleDrawMode(options.particle_draw_mode);
+
+	if (options.benchmark_recording) {
+		return runRecordingBenchmark(main_window_user_data, options);
+	}
+
+	if (options.headless) {
+		return options.verify_compute ? runComputeVerification(main_window_user_data, options) : runHeadless(main_window_user_data, options);
+	}
+
+	if (!startSimulation(main_window_user_data)) {
+		return -1;
+	}
+
+	phase_start_time = std::chrono::steady_clock::now();
+
 	WNDCLASSEX main_window_class{};
 	main_window_class.cbSize = sizeof(WNDCLASSEX);
 	main_window_class.style = CS_HREDRAW | CS_VREDRAW;
@@ -153,7 +1321,7 @@ int APIENTRY wWinMain(_In_ HINSTANCE app_instance, _In_opt_ HINSTANCE prev_app_i
 	main_window_class.hIconSm = nullptr;
 
 	if (RegisterClassEx(&main_window_class) == 0) {
-		main_window_user_data.logger.logWrite("[ERROR] Failed to register main window class. Windows error:" + std::to_string(GetLastError()));
+		main_window_user_data.logger.log<Simulator::LogFormat::MAIN_WINDOW_CLASS_REGISTRATION_FAILED>(GetLastError());
 		return GetLastError();
 	}
 
@@ -161,16 +1329,31 @@ int APIENTRY wWinMain(_In_ HINSTANCE app_instance, _In_opt_ HINSTANCE prev_app_i
 		CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, nullptr, nullptr, app_instance, &main_window_user_data);
 
 	if (main_window == nullptr) {
-		main_window_user_data.logger.logWrite("[ERROR] Failed to create main window. Windows error:" + std::to_string(GetLastError()));
+		main_window_user_data.logger.log<Simulator::LogFormat::MAIN_WINDOW_CREATION_FAILED>(GetLastError());
 		return GetLastError();
 	}
 
 	ShowWindow(main_window, cmd_show);
+	logStartupPhase(main_window_user_data, "window", phase_start_time);
+
+	// Pending messages are drained before each frame. Rendering never waits for a message, only an idle window does.
+	MSG message{};
+	while (message.message != WM_QUIT) {
+		if (PeekMessage(&message, nullptr, 0, 0, PM_REMOVE)) {
+			TranslateMessage(&message);
+			DispatchMessage(&message);
+			continue;
+		}
 
-	MSG message;
-	while (GetMessage(&message, nullptr, 0, 0)) {
-		TranslateMessage(&message);
-		DispatchMessage(&message);
+		if (!main_window_user_data.renderer_ready || IsIconic(main_window)) {
+			WaitMessage();
+			continue;
+		}
+
+		SIMULATOR_SCOPE_TIMER("main loop frame");
+		if (!renderWindowFrame(main_window_user_data)) {
+			DestroyWindow(main_window);
+		}
 	}
 
 	return (int)message.wParam;
@@ -0,0 +1,602 @@
+#include "memory_allocator.h"
+#include <algorithm>
+#include <map>
+#include <set>
+
+using namespace Simulator;
+
+namespace Simulator {
+	struct MemoryBlock {
+		struct AllocationRecord {
+			uint32_t order;
+			VkDeviceSize size;
+			bool movable;
+			bool moving;
+		};
+
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		void* mapped_data = nullptr;
+		uint32_t memory_type_idx = 0;
+		MemoryResourceType resource_type = MemoryResourceType::BUFFER;
+		bool dedicated = false;
+		VkDeviceSize used_size = 0;
+		VkDeviceSize allocated_size = 0;
+		uint32_t max_order = 0;
+		std::vector<std::set<VkDeviceSize>> free_lists;
+		std::map<VkDeviceSize, AllocationRecord> allocations;
+
+		static VkDeviceSize getNodeSize(uint32_t order)
+		{
+			return MemoryAllocator::MIN_ALLOCATION_SIZE << order;
+		}
+
+		void initBuddy()
+		{
+			max_order = 0;
+			while (getNodeSize(max_order) < size) {
+				max_order++;
+			}
+
+			free_lists.assign(max_order + 1, {});
+			free_lists[max_order].insert(0);
+		}
+
+		bool allocate(VkDeviceSize allocation_size, VkDeviceSize alignment, bool movable, VkDeviceSize& out_offset)
+		{
+			VkDeviceSize required_size = std::max({ allocation_size, alignment, MemoryAllocator::MIN_ALLOCATION_SIZE });
+
+			uint32_t order = 0;
+			while ((order <= max_order) && (getNodeSize(order) < required_size)) {
+				order++;
+			}
+
+			uint32_t free_order = order;
+			while ((free_order <= max_order) && free_lists[free_order].empty()) {
+				free_order++;
+			}
+
+			if (free_order > max_order) {
+				return false;
+			}
+
+			VkDeviceSize offset = *free_lists[free_order].begin();
+			free_lists[free_order].erase(free_lists[free_order].begin());
+
+			while (free_order > order) {
+				free_order--;
+				free_lists[free_order].insert(offset + getNodeSize(free_order));
+			}
+
+			allocations[offset] = { order, allocation_size, movable, false };
+			used_size += allocation_size;
+			allocated_size += getNodeSize(order);
+			out_offset = offset;
+			return true;
+		}
+
+		void free(VkDeviceSize offset)
+		{
+			auto allocation_it = allocations.find(offset);
+			if (allocation_it == allocations.end()) {
+				return;
+			}
+
+			uint32_t order = allocation_it->second.order;
+			used_size -= allocation_it->second.size;
+			allocated_size -= getNodeSize(order);
+			allocations.erase(allocation_it);
+
+			while (order < max_order) {
+				VkDeviceSize buddy_offset = offset ^ getNodeSize(order);
+				auto buddy_it = free_lists[order].find(buddy_offset);
+				if (buddy_it == free_lists[order].end()) {
+					break;
+				}
+
+				free_lists[order].erase(buddy_it);
+				offset = std::min(offset, buddy_offset);
+				order++;
+			}
+
+			free_lists[order].insert(offset);
+		}
+
+		VkDeviceSize getLargestFreeSize() const
+		{
+			for (uint32_t order = max_order + 1; order > 0; order--) {
+				if (!free_lists[order - 1].empty()) {
+					return getNodeSize(order - 1);
+				}
+			}
+
+			return 0;
+		}
+	};
+}
+
+/**************************************************************************************/
+
+MemoryAllocator::MemoryAllocator() = default;
+
+MemoryAllocator::~MemoryAllocator()
+{
+	destroy();
+}
+
+bool MemoryAllocator::init(VkDevice logical_device, const VkPhysicalDeviceMemoryProperties& memory_properties, const VkPhysicalDeviceLimits& limits,
+	const VkAllocationCallbacks* allocation_callbacks, std::string& out_error_message)
+{
+	destroy();
+
+	if (memory_properties.memoryTypeCount == 0) {
+		out_error_message = "No Vulkan memory types available.";
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_vk_logical_device = logical_device;
+	m_allocation_callbacks = allocation_callbacks;
+	m_memory_properties = memory_properties;
+	m_buffer_image_granularity = std::max<VkDeviceSize>(limits.bufferImageGranularity, 1);
+	m_max_device_allocations_count = limits.maxMemoryAllocationCount;
+	m_device_allocations_count = 0;
+	m_allocations_total_count = 0;
+	m_frees_total_count = 0;
+	m_defragmentation_moves_count = 0;
+
+	m_pools.resize(m_memory_properties.memoryTypeCount * 2);
+	for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; i++) {
+		VkDeviceSize heap_size = m_memory_properties.memoryHeaps[m_memory_properties.memoryTypes[i].heapIndex].size;
+
+		VkDeviceSize block_size = DEFAULT_BLOCK_SIZE;
+		while ((block_size > MIN_ALLOCATION_SIZE) && (block_size > heap_size / 8)) {
+			block_size /= 2;
+		}
+
+		for (uint32_t j = 0; j < 2; j++) {
+			MemoryPool& pool = m_pools[i * 2 + j];
+			pool.memory_type_idx = i;
+			pool.resource_type = (j == 0) ? MemoryResourceType::BUFFER : MemoryResourceType::IMAGE;
+			pool.block_size = block_size;
+		}
+	}
+
+	return true;
+}
+
+void MemoryAllocator::destroy()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (MemoryPool& pool : m_pools) {
+		for (auto& block : pool.blocks) {
+			destroyBlock(*block);
+		}
+	}
+
+	for (auto& block : m_dedicated_blocks) {
+		destroyBlock(*block);
+	}
+
+	m_pools.clear();
+	m_dedicated_blocks.clear();
+	m_vk_logical_device = VK_NULL_HANDLE;
+}
+
+bool MemoryAllocator::allocate(const VkMemoryRequirements& requirements, MemoryUsage usage, MemoryResourceType resource_type, bool movable,
+	MemoryAllocation& out_allocation, std::string& out_error_message)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_vk_logical_device == VK_NULL_HANDLE) {
+		out_error_message = "Memory allocator not initialized.";
+		return false;
+	}
+
+	uint32_t memory_type_idx;
+	if (!selectMemoryType(requirements.memoryTypeBits, usage, memory_type_idx)) {
+		out_error_message = "Failed to find suitable Vulkan memory type.";
+		return false;
+	}
+
+	MemoryPool& pool = getPool(memory_type_idx, resource_type);
+
+	if (requirements.size > pool.block_size / 2) {
+		std::unique_ptr<MemoryBlock> block = createBlock(memory_type_idx, resource_type, requirements.size, true, out_error_message);
+		if (!block) {
+			return false;
+		}
+
+		block->allocations[0] = { 0, requirements.size, false, false };
+		block->used_size = requirements.size;
+		block->allocated_size = requirements.size;
+
+		out_allocation = {};
+		out_allocation.memory = block->memory;
+		out_allocation.offset = 0;
+		out_allocation.size = requirements.size;
+		out_allocation.mapped_data = block->mapped_data;
+		out_allocation.memory_type_idx = memory_type_idx;
+		out_allocation.block = block.get();
+
+		m_dedicated_blocks.push_back(std::move(block));
+		m_allocations_total_count++;
+		return true;
+	}
+
+	for (auto& block : pool.blocks) {
+		if (allocateFromBlock(*block, requirements.size, requirements.alignment, movable, out_allocation)) {
+			m_allocations_total_count++;
+			return true;
+		}
+	}
+
+	std::unique_ptr<MemoryBlock> block = createBlock(memory_type_idx, resource_type, pool.block_size, false, out_error_message);
+	if (!block) {
+		return false;
+	}
+
+	pool.blocks.push_back(std::move(block));
+	if (!allocateFromBlock(*pool.blocks.back(), requirements.size, requirements.alignment, movable, out_allocation)) {
+		out_error_message = "Failed to sub-allocate " + std::to_string(requirements.size) + " bytes from a new memory block.";
+		return false;
+	}
+
+	m_allocations_total_count++;
+	return true;
+}
+
+bool MemoryAllocator::allocateForBuffer(VkBuffer buffer, MemoryUsage usage, bool movable, MemoryAllocation& out_allocation, std::string& out_error_message)
+{
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(m_vk_logical_device, buffer, &memory_requirements);
+
+	if (!allocate(memory_requirements, usage, MemoryResourceType::BUFFER, movable, out_allocation, out_error_message)) {
+		return false;
+	}
+
+	VkResult vk_error = vkBindBufferMemory(m_vk_logical_device, buffer, out_allocation.memory, out_allocation.offset);
+	if (vk_error != VK_SUCCESS) {
+		free(out_allocation);
+		out_error_message = "Failed to bind Vulkan buffer memory. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	return true;
+}
+
+bool MemoryAllocator::allocateForImage(VkImage image, MemoryUsage usage, bool movable, MemoryAllocation& out_allocation, std::string& out_error_message)
+{
+	VkMemoryRequirements memory_requirements;
+	vkGetImageMemoryRequirements(m_vk_logical_device, image, &memory_requirements);
+
+	if (!allocate(memory_requirements, usage, MemoryResourceType::IMAGE, movable, out_allocation, out_error_message)) {
+		return false;
+	}
+
+	VkResult vk_error = vkBindImageMemory(m_vk_logical_device, image, out_allocation.memory, out_allocation.offset);
+	if (vk_error != VK_SUCCESS) {
+		free(out_allocation);
+		out_error_message = "Failed to bind Vulkan image memory. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	return true;
+}
+
+void MemoryAllocator::free(MemoryAllocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	freeLocked(allocation);
+}
+
+void MemoryAllocator::beginDefragmentation(uint32_t max_moves_count, std::vector<MemoryDefragmentationMove>& out_moves)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	out_moves.clear();
+
+	for (MemoryPool& pool : m_pools) {
+		if (pool.blocks.size() < 2) {
+			continue;
+		}
+
+		std::vector<MemoryBlock*> blocks;
+		for (auto& block : pool.blocks) {
+			blocks.push_back(block.get());
+		}
+
+		std::sort(blocks.begin(), blocks.end(), [](const MemoryBlock* a, const MemoryBlock* b) { return a->used_size > b->used_size; });
+
+		for (size_t i = blocks.size() - 1; (i > 0) && (out_moves.size() < max_moves_count); i--) {
+			MemoryBlock& src_block = *blocks[i];
+
+			for (auto& [offset, record] : src_block.allocations) {
+				if (out_moves.size() >= max_moves_count) {
+					break;
+				}
+
+				if (!record.movable || record.moving) {
+					continue;
+				}
+
+				MemoryDefragmentationMove move;
+				bool moved = false;
+
+				for (size_t j = 0; (j < i) && !moved; j++) {
+					moved = allocateFromBlock(*blocks[j], record.size, MemoryBlock::getNodeSize(record.order), true, move.dst);
+				}
+
+				if (!moved) {
+					continue;
+				}
+
+				// Destinations stay out of the pass until the move is committed, otherwise a later source block could move them again and
+				// the caller would be handed memory that endDefragmentation frees.
+				record.moving = true;
+				move.dst.block->allocations[move.dst.offset].moving = true;
+
+				move.src.memory = src_block.memory;
+				move.src.offset = offset;
+				move.src.size = record.size;
+				move.src.mapped_data = src_block.mapped_data ? static_cast<uint8_t*>(src_block.mapped_data) + offset : nullptr;
+				move.src.memory_type_idx = src_block.memory_type_idx;
+				move.src.block = &src_block;
+
+				out_moves.push_back(move);
+			}
+		}
+	}
+}
+
+void MemoryAllocator::endDefragmentation(const std::vector<MemoryDefragmentationMove>& moves)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (const MemoryDefragmentationMove& move : moves) {
+		move.dst.block->allocations[move.dst.offset].moving = false;
+		m_allocations_total_count++;
+
+		MemoryAllocation src = move.src;
+		freeLocked(src);
+		m_defragmentation_moves_count++;
+	}
+}
+
+MemoryAllocatorStats MemoryAllocator::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	MemoryAllocatorStats stats;
+	stats.heaps.resize(m_memory_properties.memoryHeapCount);
+	stats.device_allocations_count = m_device_allocations_count;
+	stats.max_device_allocations_count = m_max_device_allocations_count;
+	stats.allocations_total_count = m_allocations_total_count;
+	stats.frees_total_count = m_frees_total_count;
+	stats.defragmentation_moves_count = m_defragmentation_moves_count;
+
+	for (uint32_t i = 0; i < m_memory_properties.memoryHeapCount; i++) {
+		stats.heaps[i].heap_size = m_memory_properties.memoryHeaps[i].size;
+	}
+
+	for (const MemoryPool& pool : m_pools) {
+		for (const auto& block : pool.blocks) {
+			MemoryHeapStats& heap_stats = stats.heaps[m_memory_properties.memoryTypes[block->memory_type_idx].heapIndex];
+			heap_stats.blocks_size += block->size;
+			heap_stats.used_size += block->used_size;
+			heap_stats.free_size += block->size - block->allocated_size;
+			heap_stats.largest_free_size = std::max(heap_stats.largest_free_size, block->getLargestFreeSize());
+			heap_stats.blocks_count++;
+			heap_stats.allocations_count += static_cast<uint32_t>(block->allocations.size());
+		}
+	}
+
+	for (const auto& block : m_dedicated_blocks) {
+		MemoryHeapStats& heap_stats = stats.heaps[m_memory_properties.memoryTypes[block->memory_type_idx].heapIndex];
+		heap_stats.blocks_size += block->size;
+		heap_stats.used_size += block->used_size;
+		heap_stats.blocks_count++;
+		heap_stats.allocations_count++;
+		heap_stats.dedicated_allocations_count++;
+	}
+
+	for (MemoryHeapStats& heap_stats : stats.heaps) {
+		if (heap_stats.free_size > 0) {
+			heap_stats.fragmentation = 1.0 - static_cast<double>(heap_stats.largest_free_size) / static_cast<double>(heap_stats.free_size);
+		}
+	}
+
+	return stats;
+}
+
+const VkAllocationCallbacks* MemoryAllocator::getAllocationCallbacks() const
+{
+	return m_allocation_callbacks;
+}
+
+bool MemoryAllocator::isHostCoherent(const MemoryAllocation& allocation) const
+{
+	if (allocation.memory_type_idx >= m_memory_properties.memoryTypeCount) {
+		return false;
+	}
+
+	return (m_memory_properties.memoryTypes[allocation.memory_type_idx].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+}
+
+bool MemoryAllocator::findMemoryType(uint32_t memory_type_bits, VkMemoryPropertyFlags required_properties,
+	VkMemoryPropertyFlags preferred_properties, uint32_t& out_memory_type_idx) const
+{
+	uint32_t found_idx = UINT32_MAX;
+
+	for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; i++) {
+		if (!(memory_type_bits & (1u << i))) {
+			continue;
+		}
+
+		VkMemoryPropertyFlags flags = m_memory_properties.memoryTypes[i].propertyFlags;
+		if ((flags & required_properties) != required_properties) {
+			continue;
+		}
+
+		if ((flags & preferred_properties) == preferred_properties) {
+			out_memory_type_idx = i;
+			return true;
+		}
+
+		if (found_idx == UINT32_MAX) {
+			found_idx = i;
+		}
+	}
+
+	if (found_idx == UINT32_MAX) {
+		return false;
+	}
+
+	out_memory_type_idx = found_idx;
+	return true;
+}
+
+bool MemoryAllocator::selectMemoryType(uint32_t memory_type_bits, MemoryUsage usage, uint32_t& out_memory_type_idx) const
+{
+	switch (usage) {
+	case MemoryUsage::GPU_ONLY:
+		return findMemoryType(memory_type_bits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, out_memory_type_idx) ||
+			findMemoryType(memory_type_bits, 0, 0, out_memory_type_idx);
+	case MemoryUsage::UPLOAD:
+		return findMemoryType(memory_type_bits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, out_memory_type_idx);
+	case MemoryUsage::READBACK:
+		return findMemoryType(memory_type_bits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VK_MEMORY_PROPERTY_HOST_CACHED_BIT, out_memory_type_idx);
+	}
+
+	return false;
+}
+
+std::unique_ptr<MemoryBlock> MemoryAllocator::createBlock(uint32_t memory_type_idx, MemoryResourceType resource_type, VkDeviceSize size, bool dedicated,
+	std::string& out_error_message)
+{
+	if (m_device_allocations_count >= m_max_device_allocations_count) {
+		out_error_message = "Vulkan memory allocation count limit reached.";
+		return nullptr;
+	}
+
+	VkMemoryAllocateInfo memory_allocate_info{};
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.pNext = nullptr;
+	memory_allocate_info.allocationSize = size;
+	memory_allocate_info.memoryTypeIndex = memory_type_idx;
+
+	auto block = std::make_unique<MemoryBlock>();
+	block->size = size;
+	block->memory_type_idx = memory_type_idx;
+	block->resource_type = resource_type;
+	block->dedicated = dedicated;
+
+	VkResult vk_error = vkAllocateMemory(m_vk_logical_device, &memory_allocate_info, m_allocation_callbacks, &block->memory);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to allocate " + std::to_string(size) + " bytes of Vulkan memory. VK error:" + std::to_string(vk_error) + ".";
+		return nullptr;
+	}
+
+	m_device_allocations_count++;
+
+	if (m_memory_properties.memoryTypes[memory_type_idx].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		vk_error = vkMapMemory(m_vk_logical_device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped_data);
+		if (vk_error != VK_SUCCESS) {
+			destroyBlock(*block);
+			out_error_message = "Failed to map Vulkan memory. VK error:" + std::to_string(vk_error) + ".";
+			return nullptr;
+		}
+	}
+
+	if (!dedicated) {
+		block->initBuddy();
+	}
+
+	return block;
+}
+
+void MemoryAllocator::destroyBlock(MemoryBlock& block)
+{
+	if (block.memory == VK_NULL_HANDLE) {
+		return;
+	}
+
+	if (block.mapped_data) {
+		vkUnmapMemory(m_vk_logical_device, block.memory);
+		block.mapped_data = nullptr;
+	}
+
+	vkFreeMemory(m_vk_logical_device, block.memory, m_allocation_callbacks);
+	block.memory = VK_NULL_HANDLE;
+	m_device_allocations_count--;
+}
+
+bool MemoryAllocator::allocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, bool movable, MemoryAllocation& out_allocation)
+{
+	VkDeviceSize offset;
+	if (!block.allocate(size, alignment, movable, offset)) {
+		return false;
+	}
+
+	out_allocation = {};
+	out_allocation.memory = block.memory;
+	out_allocation.offset = offset;
+	out_allocation.size = size;
+	out_allocation.mapped_data = block.mapped_data ? static_cast<uint8_t*>(block.mapped_data) + offset : nullptr;
+	out_allocation.memory_type_idx = block.memory_type_idx;
+	out_allocation.block = &block;
+	return true;
+}
+
+void MemoryAllocator::freeLocked(MemoryAllocation& allocation)
+{
+	MemoryBlock* block = allocation.block;
+	if (!block) {
+		return;
+	}
+
+	if (block->dedicated) {
+		auto block_it = std::find_if(m_dedicated_blocks.begin(), m_dedicated_blocks.end(),
+			[block](const std::unique_ptr<MemoryBlock>& dedicated_block) { return dedicated_block.get() == block; });
+
+		if (block_it != m_dedicated_blocks.end()) {
+			destroyBlock(**block_it);
+			m_dedicated_blocks.erase(block_it);
+		}
+	}
+	else {
+		block->free(allocation.offset);
+		releaseEmptyBlocks(getPool(block->memory_type_idx, block->resource_type));
+	}
+
+	m_frees_total_count++;
+	allocation = {};
+}
+
+void MemoryAllocator::releaseEmptyBlocks(MemoryPool& pool)
+{
+	bool empty_block_kept = false;
+
+	for (auto block_it = pool.blocks.begin(); block_it != pool.blocks.end();) {
+		if (!(*block_it)->allocations.empty()) {
+			++block_it;
+		}
+		else if (!empty_block_kept) {
+			empty_block_kept = true;
+			++block_it;
+		}
+		else {
+			destroyBlock(**block_it);
+			block_it = pool.blocks.erase(block_it);
+		}
+	}
+}
+
+MemoryAllocator::MemoryPool& MemoryAllocator::getPool(uint32_t memory_type_idx, MemoryResourceType resource_type)
+{
+	bool separate_images = (resource_type == MemoryResourceType::IMAGE) && (m_buffer_image_granularity > 1);
+	return m_pools[memory_type_idx * 2 + (separate_images ? 1 : 0)];
+}
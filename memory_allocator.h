@@ -0,0 +1,114 @@
+#pragma once
+
+#include <Volk/volk.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Simulator {
+	enum class MemoryUsage {
+		GPU_ONLY,
+		UPLOAD,
+		READBACK
+	};
+
+	enum class MemoryResourceType {
+		BUFFER,
+		IMAGE
+	};
+
+	struct MemoryBlock;
+
+	struct MemoryAllocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		void* mapped_data = nullptr;
+		uint32_t memory_type_idx = UINT32_MAX;
+		MemoryBlock* block = nullptr;
+	};
+
+	struct MemoryDefragmentationMove {
+		MemoryAllocation src;
+		MemoryAllocation dst;
+	};
+
+	struct MemoryHeapStats {
+		VkDeviceSize heap_size = 0;
+		VkDeviceSize blocks_size = 0;
+		VkDeviceSize used_size = 0;
+		VkDeviceSize free_size = 0;
+		VkDeviceSize largest_free_size = 0;
+		uint32_t blocks_count = 0;
+		uint32_t allocations_count = 0;
+		uint32_t dedicated_allocations_count = 0;
+		double fragmentation = 0.0;
+	};
+
+	struct MemoryAllocatorStats {
+		std::vector<MemoryHeapStats> heaps;
+		uint32_t device_allocations_count = 0;
+		uint32_t max_device_allocations_count = 0;
+		uint64_t allocations_total_count = 0;
+		uint64_t frees_total_count = 0;
+		uint64_t defragmentation_moves_count = 0;
+	};
+
+	class MemoryAllocator {
+	public:
+		MemoryAllocator();
+		~MemoryAllocator();
+		bool init(VkDevice logical_device, const VkPhysicalDeviceMemoryProperties& memory_properties, const VkPhysicalDeviceLimits& limits,
+			const VkAllocationCallbacks* allocation_callbacks, std::string& out_error_message);
+		void destroy();
+		bool allocate(const VkMemoryRequirements& requirements, MemoryUsage usage, MemoryResourceType resource_type, bool movable,
+			MemoryAllocation& out_allocation, std::string& out_error_message);
+		bool allocateForBuffer(VkBuffer buffer, MemoryUsage usage, bool movable, MemoryAllocation& out_allocation, std::string& out_error_message);
+		bool allocateForImage(VkImage image, MemoryUsage usage, bool movable, MemoryAllocation& out_allocation, std::string& out_error_message);
+		void free(MemoryAllocation& allocation);
+		// Plans moves of movable allocations out of the least used blocks. The caller copies every src to its dst and rebinds its resources
+		// once the GPU is done with them, then calls endDefragmentation, which frees the sources.
+		void beginDefragmentation(uint32_t max_moves_count, std::vector<MemoryDefragmentationMove>& out_moves);
+		void endDefragmentation(const std::vector<MemoryDefragmentationMove>& moves);
+		MemoryAllocatorStats getStats() const;
+		const VkAllocationCallbacks* getAllocationCallbacks() const;
+		bool isHostCoherent(const MemoryAllocation& allocation) const;
+		bool findMemoryType(uint32_t memory_type_bits, VkMemoryPropertyFlags required_properties,
+			VkMemoryPropertyFlags preferred_properties, uint32_t& out_memory_type_idx) const;
+
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+		static constexpr VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+
+	private:
+		struct MemoryPool {
+			uint32_t memory_type_idx = 0;
+			MemoryResourceType resource_type = MemoryResourceType::BUFFER;
+			VkDeviceSize block_size = 0;
+			std::vector<std::unique_ptr<MemoryBlock>> blocks;
+		};
+
+		bool selectMemoryType(uint32_t memory_type_bits, MemoryUsage usage, uint32_t& out_memory_type_idx) const;
+		std::unique_ptr<MemoryBlock> createBlock(uint32_t memory_type_idx, MemoryResourceType resource_type, VkDeviceSize size, bool dedicated,
+			std::string& out_error_message);
+		void destroyBlock(MemoryBlock& block);
+		bool allocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, bool movable, MemoryAllocation& out_allocation);
+		void freeLocked(MemoryAllocation& allocation);
+		void releaseEmptyBlocks(MemoryPool& pool);
+		MemoryPool& getPool(uint32_t memory_type_idx, MemoryResourceType resource_type);
+
+		VkDevice m_vk_logical_device = VK_NULL_HANDLE;
+		const VkAllocationCallbacks* m_allocation_callbacks = nullptr;
+		VkPhysicalDeviceMemoryProperties m_memory_properties{};
+		VkDeviceSize m_buffer_image_granularity = 1;
+		uint32_t m_max_device_allocations_count = 0;
+		mutable std::mutex m_mutex;
+		std::vector<MemoryPool> m_pools;
+		std::vector<std::unique_ptr<MemoryBlock>> m_dedicated_blocks;
+		uint32_t m_device_allocations_count = 0;
+		uint64_t m_allocations_total_count = 0;
+		uint64_t m_frees_total_count = 0;
+		uint64_t m_defragmentation_moves_count = 0;
+	};
+}
@@ -0,0 +1,117 @@
+#include "memory_ring.h"
+
+using namespace Simulator;
+
+MemoryRing::~MemoryRing()
+{
+	destroy();
+}
+
+bool MemoryRing::create(MemoryAllocator& allocator, VkDevice logical_device, VkDeviceSize frame_size, VkBufferUsageFlags usage, uint32_t frames_count,
+	std::string& out_error_message)
+{
+	destroy();
+
+	if ((frame_size == 0) || (frames_count == 0)) {
+		out_error_message = "Invalid memory ring frame size or count.";
+		return false;
+	}
+
+	m_allocator = &allocator;
+	m_vk_logical_device = logical_device;
+	m_frame_size = frame_size;
+	m_frames_count = frames_count;
+	m_frame_idx = 0;
+	m_frame_used_size = 0;
+
+	VkBufferCreateInfo buffer_create_info{};
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.pNext = nullptr;
+	buffer_create_info.flags = 0;
+	buffer_create_info.size = frame_size * frames_count;
+	buffer_create_info.usage = usage;
+	buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	buffer_create_info.queueFamilyIndexCount = 0;
+	buffer_create_info.pQueueFamilyIndices = nullptr;
+
+	VkResult vk_error = vkCreateBuffer(m_vk_logical_device, &buffer_create_info, m_allocator->getAllocationCallbacks(), &m_vk_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan memory ring buffer. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_buffer = VK_NULL_HANDLE;
+		destroy();
+		return false;
+	}
+
+	if (!m_allocator->allocateForBuffer(m_vk_buffer, MemoryUsage::UPLOAD, false, m_allocation, out_error_message)) {
+		out_error_message = "Failed to allocate Vulkan memory ring buffer memory. " + out_error_message;
+		destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void MemoryRing::destroy()
+{
+	if (m_vk_buffer != VK_NULL_HANDLE) {
+		vkDestroyBuffer(m_vk_logical_device, m_vk_buffer, m_allocator->getAllocationCallbacks());
+		m_vk_buffer = VK_NULL_HANDLE;
+	}
+
+	if (m_allocator != nullptr) {
+		m_allocator->free(m_allocation);
+		m_allocator = nullptr;
+	}
+
+	m_vk_logical_device = VK_NULL_HANDLE;
+	m_frame_size = 0;
+	m_frames_count = 0;
+	m_frame_idx = 0;
+	m_frame_used_size = 0;
+}
+
+bool MemoryRing::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& out_offset, void*& out_mapped_data)
+{
+	if (m_vk_buffer == VK_NULL_HANDLE) {
+		return false;
+	}
+
+	VkDeviceSize offset = m_frame_used_size;
+	if (alignment > 1) {
+		offset = (offset + alignment - 1) / alignment * alignment;
+	}
+
+	if (offset + size > m_frame_size) {
+		return false;
+	}
+
+	m_frame_used_size = offset + size;
+	out_offset = static_cast<VkDeviceSize>(m_frame_idx) * m_frame_size + offset;
+	out_mapped_data = static_cast<uint8_t*>(m_allocation.mapped_data) + out_offset;
+	return true;
+}
+
+void MemoryRing::nextFrame()
+{
+	if (m_frames_count == 0) {
+		return;
+	}
+
+	m_frame_idx = (m_frame_idx + 1) % m_frames_count;
+	m_frame_used_size = 0;
+}
+
+VkBuffer MemoryRing::getBuffer() const
+{
+	return m_vk_buffer;
+}
+
+VkDeviceSize MemoryRing::getFrameSize() const
+{
+	return m_frame_size;
+}
+
+VkDeviceSize MemoryRing::getFrameUsedSize() const
+{
+	return m_frame_used_size;
+}
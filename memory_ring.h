@@ -0,0 +1,31 @@
+#pragma once
+
+#include "memory_allocator.h"
+#include <Volk/volk.h>
+#include <string>
+#include <cstdint>
+
+namespace Simulator {
+	class MemoryRing {
+	public:
+		~MemoryRing();
+		bool create(MemoryAllocator& allocator, VkDevice logical_device, VkDeviceSize frame_size, VkBufferUsageFlags usage, uint32_t frames_count,
+			std::string& out_error_message);
+		void destroy();
+		bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& out_offset, void*& out_mapped_data);
+		void nextFrame();
+		VkBuffer getBuffer() const;
+		VkDeviceSize getFrameSize() const;
+		VkDeviceSize getFrameUsedSize() const;
+
+	private:
+		MemoryAllocator* m_allocator = nullptr;
+		VkDevice m_vk_logical_device = VK_NULL_HANDLE;
+		VkBuffer m_vk_buffer = VK_NULL_HANDLE;
+		MemoryAllocation m_allocation;
+		VkDeviceSize m_frame_size = 0;
+		uint32_t m_frames_count = 0;
+		uint32_t m_frame_idx = 0;
+		VkDeviceSize m_frame_used_size = 0;
+	};
+}
@@ -0,0 +1,184 @@
+#include "message_ring.h"
+#include <thread>
+#include <cstring>
+
+using namespace Simulator;
+
+bool MessageRing::init(size_t capacity, OverflowPolicy overflow_policy, std::string& out_error_message)
+{
+	if ((capacity < 2) || ((capacity & (capacity - 1)) != 0)) {
+		out_error_message = "Message ring capacity must be a power of two.";
+		return false;
+	}
+
+	m_slots = std::make_unique<Slot[]>(capacity);
+	m_mask = capacity - 1;
+	m_overflow_policy = overflow_policy;
+
+	for (size_t i = 0; i < capacity; i++) {
+		m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		m_slots[i].size = 0;
+	}
+
+	m_enqueue_pos.store(0, std::memory_order_relaxed);
+	m_dequeue_pos.store(0, std::memory_order_relaxed);
+	m_dropped_count.store(0, std::memory_order_relaxed);
+	m_closed.store(false, std::memory_order_release);
+	return true;
+}
+
+bool MessageRing::push(const char* data, size_t size)
+{
+	size_t pos;
+	char* slot_data = reserve(pos);
+	if (slot_data == nullptr) {
+		return false;
+	}
+
+	size_t copy_size = (size < MAX_MESSAGE_SIZE) ? size : MAX_MESSAGE_SIZE;
+	memcpy(slot_data, data, copy_size);
+	commit(pos, copy_size);
+	return true;
+}
+
+char* MessageRing::reserve(size_t& out_pos)
+{
+	size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+
+	while (true) {
+		Slot& slot = m_slots[pos & m_mask];
+		size_t sequence = slot.sequence.load(std::memory_order_acquire);
+		intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+		if (diff == 0) {
+			if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				out_pos = pos;
+				return slot.data;
+			}
+		}
+		else if (diff < 0) {
+			switch (m_overflow_policy) {
+			case OverflowPolicy::DROP_NEWEST:
+				m_dropped_count.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+			case OverflowPolicy::DROP_OLDEST:
+				if (discardOldest()) {
+					m_dropped_count.fetch_add(1, std::memory_order_relaxed);
+				}
+				break;
+			case OverflowPolicy::BLOCK:
+				if (m_closed.load(std::memory_order_acquire)) {
+					m_dropped_count.fetch_add(1, std::memory_order_relaxed);
+					return nullptr;
+				}
+
+				std::this_thread::yield();
+				break;
+			}
+
+			pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		}
+		else {
+			pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+void MessageRing::commit(size_t pos, size_t size)
+{
+	Slot& slot = m_slots[pos & m_mask];
+	slot.size = size;
+	slot.sequence.store(pos + 1, std::memory_order_release);
+}
+
+bool MessageRing::pop(char* out_data, size_t& out_size)
+{
+	size_t pos;
+	Slot* slot = claimOldest(pos);
+	if (slot == nullptr) {
+		return false;
+	}
+
+	out_size = slot->size;
+	memcpy(out_data, slot->data, out_size);
+	slot->sequence.store(pos + m_mask + 1, std::memory_order_release);
+	return true;
+}
+
+void MessageRing::close()
+{
+	m_closed.store(true, std::memory_order_release);
+}
+
+uint64_t MessageRing::dropRemaining()
+{
+	uint64_t dropped_count = 0;
+
+	while (discardOldest()) {
+		dropped_count++;
+	}
+
+	// Reserved slots that were never committed cannot be claimed, they are still messages nobody will write.
+	dropped_count += getSize();
+	m_dequeue_pos.store(m_enqueue_pos.load(std::memory_order_acquire), std::memory_order_release);
+	m_dropped_count.fetch_add(dropped_count, std::memory_order_relaxed);
+	return dropped_count;
+}
+
+bool MessageRing::discardOldest()
+{
+	size_t pos;
+	Slot* slot = claimOldest(pos);
+	if (slot == nullptr) {
+		return false;
+	}
+
+	slot->sequence.store(pos + m_mask + 1, std::memory_order_release);
+	return true;
+}
+
+MessageRing::Slot* MessageRing::claimOldest(size_t& out_pos)
+{
+	size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+
+	while (true) {
+		Slot* slot = &m_slots[pos & m_mask];
+		size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+		if (diff == 0) {
+			if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				out_pos = pos;
+				return slot;
+			}
+		}
+		else if (diff < 0) {
+			return nullptr;
+		}
+		else {
+			pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+bool MessageRing::isEmpty() const
+{
+	return m_enqueue_pos.load(std::memory_order_seq_cst) == m_dequeue_pos.load(std::memory_order_seq_cst);
+}
+
+size_t MessageRing::getSize() const
+{
+	size_t dequeue_pos = m_dequeue_pos.load(std::memory_order_relaxed);
+	size_t enqueue_pos = m_enqueue_pos.load(std::memory_order_relaxed);
+	return (enqueue_pos > dequeue_pos) ? (enqueue_pos - dequeue_pos) : 0;
+}
+
+size_t MessageRing::getCapacity() const
+{
+	return m_mask + 1;
+}
+
+uint64_t MessageRing::getDroppedCount() const
+{
+	return m_dropped_count.load(std::memory_order_relaxed);
+}
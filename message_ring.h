@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace Simulator {
+	class MessageRing {
+	public:
+		enum class OverflowPolicy {
+			BLOCK,
+			DROP_NEWEST,
+			DROP_OLDEST
+		};
+
+		static constexpr size_t SLOT_SIZE = 2048;
+		static constexpr size_t MAX_MESSAGE_SIZE = SLOT_SIZE - 2 * sizeof(size_t);
+
+		bool init(size_t capacity, OverflowPolicy overflow_policy, std::string& out_error_message);
+		bool push(const char* data, size_t size);
+		char* reserve(size_t& out_pos);
+		void commit(size_t pos, size_t size);
+		bool pop(char* out_data, size_t& out_size);
+		// Once closed, producers blocked on a full ring give up and count their message as dropped.
+		void close();
+		// Discards whatever the last drain could not pop and counts it as dropped.
+		uint64_t dropRemaining();
+		bool isEmpty() const;
+		size_t getSize() const;
+		size_t getCapacity() const;
+		uint64_t getDroppedCount() const;
+
+	private:
+		struct alignas(64) Slot {
+			std::atomic<size_t> sequence;
+			size_t size;
+			char data[MAX_MESSAGE_SIZE];
+		};
+
+		static_assert(sizeof(Slot) == SLOT_SIZE);
+
+		bool discardOldest();
+		Slot* claimOldest(size_t& out_pos);
+
+		std::unique_ptr<Slot[]> m_slots;
+		size_t m_mask = 0;
+		OverflowPolicy m_overflow_policy = OverflowPolicy::BLOCK;
+		alignas(64) std::atomic<size_t> m_enqueue_pos = 0;
+		alignas(64) std::atomic<size_t> m_dequeue_pos = 0;
+		alignas(64) std::atomic<uint64_t> m_dropped_count = 0;
+		std::atomic<bool> m_closed = false;
+	};
+}
@@ -0,0 +1,408 @@
+#include "particle_compute.h"
+#include <algorithm>
+#include <cmath>
+
+// Generated from shaders/particles.comp by the shader build step.
+#include "shaders/particles.comp.h"
+
+using namespace Simulator;
+
+static_assert(sizeof(GpuParticle) == 32, "GpuParticle must match the std430 layout of the particles shader.");
+
+ParticleCompute::~ParticleCompute()
+{
+	destroy();
+}
+
+bool ParticleCompute::create(VkDevice logical_device, MemoryAllocator& allocator, PipelineCache& pipeline_cache, const std::vector<uint32_t>& queue_family_indices,
+	uint32_t particles_count, std::string& out_error_message)
+{
+	destroy();
+
+	if (particles_count == 0) {
+		out_error_message = "Invalid particles count.";
+		return false;
+	}
+
+	m_vk_logical_device = logical_device;
+	m_allocator = &allocator;
+	m_particles_count = particles_count;
+
+	std::vector<uint32_t> unique_queue_family_indices = queue_family_indices;
+	std::sort(unique_queue_family_indices.begin(), unique_queue_family_indices.end());
+	unique_queue_family_indices.erase(std::unique(unique_queue_family_indices.begin(), unique_queue_family_indices.end()), unique_queue_family_indices.end());
+
+	// Uploads may run on a dedicated transfer queue, concurrent sharing avoids ownership transfers for a buffer written once.
+	VkBufferCreateInfo buffer_create_info{};
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.pNext = nullptr;
+	buffer_create_info.flags = 0;
+	buffer_create_info.size = getParticlesBufferSize();
+	buffer_create_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	if (unique_queue_family_indices.size() > 1) {
+		buffer_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		buffer_create_info.queueFamilyIndexCount = static_cast<uint32_t>(unique_queue_family_indices.size());
+		buffer_create_info.pQueueFamilyIndices = unique_queue_family_indices.data();
+	}
+	else {
+		buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		buffer_create_info.queueFamilyIndexCount = 0;
+		buffer_create_info.pQueueFamilyIndices = nullptr;
+	}
+
+	VkResult vk_error = vkCreateBuffer(m_vk_logical_device, &buffer_create_info, m_allocator->getAllocationCallbacks(), &m_vk_particles_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles buffer. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_particles_buffer = VK_NULL_HANDLE;
+		destroy();
+		return false;
+	}
+
+	if (!m_allocator->allocateForBuffer(m_vk_particles_buffer, MemoryUsage::GPU_ONLY, false, m_particles_allocation, out_error_message)) {
+		out_error_message = "Failed to allocate Vulkan particles buffer memory. " + out_error_message;
+		destroy();
+		return false;
+	}
+
+	/**************************************************************************************/
+
+	VkDescriptorSetLayoutBinding descriptor_set_layout_binding{};
+	descriptor_set_layout_binding.binding = 0;
+	descriptor_set_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptor_set_layout_binding.descriptorCount = 1;
+	descriptor_set_layout_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	descriptor_set_layout_binding.pImmutableSamplers = nullptr;
+
+	VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+	descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptor_set_layout_create_info.pNext = nullptr;
+	descriptor_set_layout_create_info.flags = 0;
+	descriptor_set_layout_create_info.bindingCount = 1;
+	descriptor_set_layout_create_info.pBindings = &descriptor_set_layout_binding;
+
+	vk_error = vkCreateDescriptorSetLayout(m_vk_logical_device, &descriptor_set_layout_create_info, m_allocator->getAllocationCallbacks(),
+		&m_vk_descriptor_set_layout);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles descriptor set layout. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_descriptor_set_layout = VK_NULL_HANDLE;
+		destroy();
+		return false;
+	}
+
+	VkDescriptorPoolSize descriptor_pool_size{};
+	descriptor_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptor_pool_size.descriptorCount = 1;
+
+	VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptor_pool_create_info.pNext = nullptr;
+	descriptor_pool_create_info.flags = 0;
+	descriptor_pool_create_info.maxSets = 1;
+	descriptor_pool_create_info.poolSizeCount = 1;
+	descriptor_pool_create_info.pPoolSizes = &descriptor_pool_size;
+
+	vk_error = vkCreateDescriptorPool(m_vk_logical_device, &descriptor_pool_create_info, m_allocator->getAllocationCallbacks(), &m_vk_descriptor_pool);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles descriptor pool. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_descriptor_pool = VK_NULL_HANDLE;
+		destroy();
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+	descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_allocate_info.pNext = nullptr;
+	descriptor_set_allocate_info.descriptorPool = m_vk_descriptor_pool;
+	descriptor_set_allocate_info.descriptorSetCount = 1;
+	descriptor_set_allocate_info.pSetLayouts = &m_vk_descriptor_set_layout;
+
+	vk_error = vkAllocateDescriptorSets(m_vk_logical_device, &descriptor_set_allocate_info, &m_vk_descriptor_set);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to allocate Vulkan particles descriptor set. VK error:" + std::to_string(vk_error) + ".";
+		destroy();
+		return false;
+	}
+
+	VkDescriptorBufferInfo descriptor_buffer_info{};
+	descriptor_buffer_info.buffer = m_vk_particles_buffer;
+	descriptor_buffer_info.offset = 0;
+	descriptor_buffer_info.range = VK_WHOLE_SIZE;
+
+	VkWriteDescriptorSet write_descriptor_set{};
+	write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write_descriptor_set.pNext = nullptr;
+	write_descriptor_set.dstSet = m_vk_descriptor_set;
+	write_descriptor_set.dstBinding = 0;
+	write_descriptor_set.dstArrayElement = 0;
+	write_descriptor_set.descriptorCount = 1;
+	write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write_descriptor_set.pImageInfo = nullptr;
+	write_descriptor_set.pBufferInfo = &descriptor_buffer_info;
+	write_descriptor_set.pTexelBufferView = nullptr;
+
+	vkUpdateDescriptorSets(m_vk_logical_device, 1, &write_descriptor_set, 0, nullptr);
+
+	if (!createPipeline(pipeline_cache, out_error_message)) {
+		destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void ParticleCompute::destroy()
+{
+	if (m_vk_logical_device != VK_NULL_HANDLE) {
+		const VkAllocationCallbacks* allocation_callbacks = m_allocator->getAllocationCallbacks();
+
+		if (m_vk_pipeline != VK_NULL_HANDLE) {
+			vkDestroyPipeline(m_vk_logical_device, m_vk_pipeline, allocation_callbacks);
+			m_vk_pipeline = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_pipeline_layout != VK_NULL_HANDLE) {
+			vkDestroyPipelineLayout(m_vk_logical_device, m_vk_pipeline_layout, allocation_callbacks);
+			m_vk_pipeline_layout = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_descriptor_pool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(m_vk_logical_device, m_vk_descriptor_pool, allocation_callbacks);
+			m_vk_descriptor_pool = VK_NULL_HANDLE;
+			m_vk_descriptor_set = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_descriptor_set_layout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(m_vk_logical_device, m_vk_descriptor_set_layout, allocation_callbacks);
+			m_vk_descriptor_set_layout = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_particles_buffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(m_vk_logical_device, m_vk_particles_buffer, allocation_callbacks);
+			m_vk_particles_buffer = VK_NULL_HANDLE;
+		}
+	}
+
+	if (m_allocator != nullptr) {
+		m_allocator->free(m_particles_allocation);
+		m_allocator = nullptr;
+	}
+
+	m_vk_logical_device = VK_NULL_HANDLE;
+	m_particles_count = 0;
+}
+
+bool ParticleCompute::isCreated() const
+{
+	return m_vk_pipeline != VK_NULL_HANDLE;
+}
+
+bool ParticleCompute::upload(const World& world, StagingUploader& uploader, std::string& out_error_message)
+{
+	if (!isCreated()) {
+		out_error_message = "Particle compute not created.";
+		return false;
+	}
+
+	if (world.getBodiesCount() != m_particles_count) {
+		out_error_message = "World has " + std::to_string(world.getBodiesCount()) + " bodies, particle compute was created for " +
+			std::to_string(m_particles_count) + ".";
+		return false;
+	}
+
+	std::vector<GpuParticle> particles;
+	packWorld(world, particles);
+
+	return uploader.uploadBuffer(m_vk_particles_buffer, m_particles_allocation, 0, particles.data(), getParticlesBufferSize(), out_error_message);
+}
+
+void ParticleCompute::recordSteps(VkCommandBuffer command_buffer, uint32_t steps_count, const ParticleStepParams& params)
+{
+	if (!isCreated() || (steps_count == 0)) {
+		return;
+	}
+
+	VkBufferMemoryBarrier buffer_barrier{};
+	buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	buffer_barrier.pNext = nullptr;
+	buffer_barrier.srcAccessMask = 0;
+	buffer_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barrier.buffer = m_vk_particles_buffer;
+	buffer_barrier.offset = 0;
+	buffer_barrier.size = VK_WHOLE_SIZE;
+
+	// Reads of the previous frame have to finish before the particles are overwritten.
+	vkCmdPipelineBarrier(command_buffer, CONSUMER_STAGES, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &buffer_barrier, 0, nullptr);
+
+	PushConstants push_constants{};
+	push_constants.dt = params.integration.dt;
+	push_constants.gravity_x = params.integration.gravity_x;
+	push_constants.gravity_y = params.integration.gravity_y;
+	push_constants.gravity_z = params.integration.gravity_z;
+	push_constants.velocity_scale = params.integration.velocity_scale;
+	push_constants.spring_stiffness = params.spring_stiffness;
+	push_constants.particles_count = m_particles_count;
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vk_pipeline);
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vk_pipeline_layout, 0, 1, &m_vk_descriptor_set, 0, nullptr);
+	vkCmdPushConstants(command_buffer, m_vk_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &push_constants);
+
+	uint32_t groups_count = (m_particles_count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+	buffer_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+	for (uint32_t i = 0; i < steps_count; i++) {
+		vkCmdDispatch(command_buffer, groups_count, 1, 1);
+
+		bool last_step = (i + 1) == steps_count;
+		buffer_barrier.dstAccessMask = last_step ? CONSUMER_ACCESS : (VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, last_step ? CONSUMER_STAGES : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 1, &buffer_barrier, 0, nullptr);
+	}
+}
+
+VkBuffer ParticleCompute::getParticlesBuffer() const
+{
+	return m_vk_particles_buffer;
+}
+
+VkDeviceSize ParticleCompute::getParticlesBufferSize() const
+{
+	return static_cast<VkDeviceSize>(m_particles_count) * sizeof(GpuParticle);
+}
+
+uint32_t ParticleCompute::getParticlesCount() const
+{
+	return m_particles_count;
+}
+
+void ParticleCompute::packWorld(const World& world, std::vector<GpuParticle>& out_particles)
+{
+	out_particles.resize(world.getBodiesCount());
+
+	for (size_t i = 0; i < out_particles.size(); i++) {
+		GpuParticle& particle = out_particles[i];
+		particle.position[0] = world.getPositionsX()[i];
+		particle.position[1] = world.getPositionsY()[i];
+		particle.position[2] = world.getPositionsZ()[i];
+		particle.inverse_mass = world.getInverseMasses()[i];
+		particle.velocity[0] = world.getVelocitiesX()[i];
+		particle.velocity[1] = world.getVelocitiesY()[i];
+		particle.velocity[2] = world.getVelocitiesZ()[i];
+		particle.padding = 0.0f;
+	}
+}
+
+ParticleComparison ParticleCompute::compare(const World& world, const std::vector<GpuParticle>& particles, float tolerance)
+{
+	std::vector<GpuParticle> expected_particles;
+	packWorld(world, expected_particles);
+
+	ParticleComparison comparison;
+	comparison.particles_count = static_cast<uint32_t>(std::min(expected_particles.size(), particles.size()));
+	comparison.mismatches_count = static_cast<uint32_t>(std::max(expected_particles.size(), particles.size())) - comparison.particles_count;
+
+	// Errors are relative to the value once it is above 1, so large coordinates get the same number of matching digits.
+	auto getError = [](float expected, float actual)
+	{
+		return std::abs(actual - expected) / std::max(std::abs(expected), 1.0f);
+	};
+
+	for (uint32_t i = 0; i < comparison.particles_count; i++) {
+		float position_error = 0.0f;
+		float velocity_error = 0.0f;
+
+		for (int axis = 0; axis < 3; axis++) {
+			position_error = std::max(position_error, getError(expected_particles[i].position[axis], particles[i].position[axis]));
+			velocity_error = std::max(velocity_error, getError(expected_particles[i].velocity[axis], particles[i].velocity[axis]));
+		}
+
+		if (!(position_error <= tolerance) || !(velocity_error <= tolerance)) {
+			comparison.mismatches_count++;
+		}
+
+		comparison.max_position_error = std::max(comparison.max_position_error, position_error);
+		comparison.max_velocity_error = std::max(comparison.max_velocity_error, velocity_error);
+	}
+
+	return comparison;
+}
+
+bool ParticleCompute::createPipeline(PipelineCache& pipeline_cache, std::string& out_error_message)
+{
+	const VkAllocationCallbacks* allocation_callbacks = m_allocator->getAllocationCallbacks();
+
+	VkPushConstantRange push_constant_range{};
+	push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	push_constant_range.offset = 0;
+	push_constant_range.size = sizeof(PushConstants);
+
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_create_info.pNext = nullptr;
+	pipeline_layout_create_info.flags = 0;
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = &m_vk_descriptor_set_layout;
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	VkResult vk_error = vkCreatePipelineLayout(m_vk_logical_device, &pipeline_layout_create_info, allocation_callbacks, &m_vk_pipeline_layout);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles pipeline layout. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_pipeline_layout = VK_NULL_HANDLE;
+		return false;
+	}
+
+	VkShaderModuleCreateInfo shader_module_create_info{};
+	shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shader_module_create_info.pNext = nullptr;
+	shader_module_create_info.flags = 0;
+	shader_module_create_info.codeSize = sizeof(PARTICLES_COMP_SPIRV);
+	shader_module_create_info.pCode = PARTICLES_COMP_SPIRV;
+
+	VkShaderModule vk_shader_module;
+	vk_error = vkCreateShaderModule(m_vk_logical_device, &shader_module_create_info, allocation_callbacks, &vk_shader_module);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles shader module. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	VkPipelineCreationFeedback creation_feedback{};
+
+	VkPipelineCreationFeedbackCreateInfo creation_feedback_create_info{};
+	creation_feedback_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+	creation_feedback_create_info.pNext = nullptr;
+	creation_feedback_create_info.pPipelineCreationFeedback = &creation_feedback;
+	creation_feedback_create_info.pipelineStageCreationFeedbackCount = 0;
+	creation_feedback_create_info.pPipelineStageCreationFeedbacks = nullptr;
+
+	VkComputePipelineCreateInfo pipeline_create_info{};
+	pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipeline_create_info.pNext = &creation_feedback_create_info;
+	pipeline_create_info.flags = 0;
+	pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipeline_create_info.stage.pNext = nullptr;
+	pipeline_create_info.stage.flags = 0;
+	pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipeline_create_info.stage.module = vk_shader_module;
+	pipeline_create_info.stage.pName = "main";
+	pipeline_create_info.stage.pSpecializationInfo = nullptr;
+	pipeline_create_info.layout = m_vk_pipeline_layout;
+	pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+	pipeline_create_info.basePipelineIndex = -1;
+
+	vk_error = vkCreateComputePipelines(m_vk_logical_device, pipeline_cache.getHandle(), 1, &pipeline_create_info, allocation_callbacks, &m_vk_pipeline);
+	vkDestroyShaderModule(m_vk_logical_device, vk_shader_module, allocation_callbacks);
+
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles pipeline. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_pipeline = VK_NULL_HANDLE;
+		return false;
+	}
+
+	pipeline_cache.recordCreationFeedback(creation_feedback);
+	return true;
+}
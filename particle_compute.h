@@ -0,0 +1,81 @@
+#pragma once
+
+#include "memory_allocator.h"
+#include "pipeline_cache.h"
+#include "staging_uploader.h"
+#include "world.h"
+#include <Volk/volk.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Simulator {
+	struct GpuParticle {
+		float position[3];
+		float inverse_mass;
+		float velocity[3];
+		float padding;
+	};
+
+	struct ParticleStepParams {
+		IntegrationParams integration;
+		float spring_stiffness = 0.0f;
+	};
+
+	struct ParticleComparison {
+		uint32_t particles_count = 0;
+		uint32_t mismatches_count = 0;
+		float max_position_error = 0.0f;
+		float max_velocity_error = 0.0f;
+	};
+
+	// Particle state in a device local storage buffer, integrated in place by a compute shader. The step mirrors the CPU
+	// one (spring force, then semi-implicit Euler), so World stays the reference it is checked against.
+	class ParticleCompute {
+	public:
+		~ParticleCompute();
+		bool create(VkDevice logical_device, MemoryAllocator& allocator, PipelineCache& pipeline_cache, const std::vector<uint32_t>& queue_family_indices,
+			uint32_t particles_count, std::string& out_error_message);
+		void destroy();
+		bool isCreated() const;
+		bool upload(const World& world, StagingUploader& uploader, std::string& out_error_message);
+		void recordSteps(VkCommandBuffer command_buffer, uint32_t steps_count, const ParticleStepParams& params);
+		VkBuffer getParticlesBuffer() const;
+		VkDeviceSize getParticlesBufferSize() const;
+		uint32_t getParticlesCount() const;
+
+		static void packWorld(const World& world, std::vector<GpuParticle>& out_particles);
+		static ParticleComparison compare(const World& world, const std::vector<GpuParticle>& particles, float tolerance);
+
+		static constexpr uint32_t WORKGROUP_SIZE = 256;
+		// Barrier scope after the last step: later steps, vertex fetch of the particle buffer and copies out of it.
+		static constexpr VkPipelineStageFlags CONSUMER_STAGES = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+		static constexpr VkAccessFlags CONSUMER_ACCESS = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+			VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+	private:
+		struct PushConstants {
+			float dt;
+			float gravity_x;
+			float gravity_y;
+			float gravity_z;
+			float velocity_scale;
+			float spring_stiffness;
+			uint32_t particles_count;
+		};
+
+		bool createPipeline(PipelineCache& pipeline_cache, std::string& out_error_message);
+
+		VkDevice m_vk_logical_device = VK_NULL_HANDLE;
+		MemoryAllocator* m_allocator = nullptr;
+		VkBuffer m_vk_particles_buffer = VK_NULL_HANDLE;
+		MemoryAllocation m_particles_allocation;
+		VkDescriptorSetLayout m_vk_descriptor_set_layout = VK_NULL_HANDLE;
+		VkDescriptorPool m_vk_descriptor_pool = VK_NULL_HANDLE;
+		VkDescriptorSet m_vk_descriptor_set = VK_NULL_HANDLE;
+		VkPipelineLayout m_vk_pipeline_layout = VK_NULL_HANDLE;
+		VkPipeline m_vk_pipeline = VK_NULL_HANDLE;
+		uint32_t m_particles_count = 0;
+	};
+}
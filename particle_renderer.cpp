@@ -0,0 +1,841 @@
+#include "particle_renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+// Generated from shaders/particles.vert, shaders/particles.frag and shaders/particles_cull.comp by the shader build step.
+#include "shaders/particles.vert.h"
+#include "shaders/particles.frag.h"
+#include "shaders/particles_cull.comp.h"
+
+using namespace Simulator;
+
+// Corner i of the cube is at (i & 1, (i >> 1) & 1, (i >> 2) & 1), faces wind counter-clockwise seen from outside.
+static constexpr uint16_t CUBE_INDICES[ParticleRenderer::CUBE_INDICES_COUNT] = {
+	0, 4, 6, 0, 6, 2,
+	1, 3, 7, 1, 7, 5,
+	0, 1, 5, 0, 5, 4,
+	2, 6, 7, 2, 7, 3,
+	0, 2, 3, 0, 3, 1,
+	4, 5, 7, 4, 7, 6
+};
+
+ParticleRenderer::~ParticleRenderer()
+{
+	destroy();
+}
+
+bool ParticleRenderer::create(VkDevice logical_device, MemoryAllocator& allocator, PipelineCache& pipeline_cache, StagingUploader& uploader,
+	const std::vector<uint32_t>& queue_family_indices, const ParticleCompute& particle_compute, VkFormat color_format, VkFormat depth_format,
+	bool gpu_driven, std::string& out_error_message)
+{
+	destroy();
+
+	if (!particle_compute.isCreated()) {
+		out_error_message = "Particle compute not created.";
+		return false;
+	}
+
+	m_vk_logical_device = logical_device;
+	m_allocator = &allocator;
+	m_color_format = color_format;
+	m_depth_format = depth_format;
+	m_particles_count = particle_compute.getParticlesCount();
+
+	std::vector<uint32_t> unique_queue_family_indices = queue_family_indices;
+	std::sort(unique_queue_family_indices.begin(), unique_queue_family_indices.end());
+	unique_queue_family_indices.erase(std::unique(unique_queue_family_indices.begin(), unique_queue_family_indices.end()), unique_queue_family_indices.end());
+
+	VkBufferCreateInfo buffer_create_info{};
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.pNext = nullptr;
+	buffer_create_info.flags = 0;
+	buffer_create_info.size = sizeof(CUBE_INDICES);
+	buffer_create_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	if (unique_queue_family_indices.size() > 1) {
+		buffer_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		buffer_create_info.queueFamilyIndexCount = static_cast<uint32_t>(unique_queue_family_indices.size());
+		buffer_create_info.pQueueFamilyIndices = unique_queue_family_indices.data();
+	}
+	else {
+		buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		buffer_create_info.queueFamilyIndexCount = 0;
+		buffer_create_info.pQueueFamilyIndices = nullptr;
+	}
+
+	VkResult vk_error = vkCreateBuffer(m_vk_logical_device, &buffer_create_info, m_allocator->getAllocationCallbacks(), &m_vk_index_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles index buffer. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_index_buffer = VK_NULL_HANDLE;
+		destroy();
+		return false;
+	}
+
+	if (!m_allocator->allocateForBuffer(m_vk_index_buffer, MemoryUsage::GPU_ONLY, false, m_index_allocation, out_error_message)) {
+		out_error_message = "Failed to allocate Vulkan particles index buffer memory. " + out_error_message;
+		destroy();
+		return false;
+	}
+
+	if (!uploader.uploadBuffer(m_vk_index_buffer, m_index_allocation, 0, CUBE_INDICES, sizeof(CUBE_INDICES), out_error_message)) {
+		destroy();
+		return false;
+	}
+
+	/**************************************************************************************/
+
+	VkDescriptorSetLayoutBinding descriptor_set_layout_binding{};
+	descriptor_set_layout_binding.binding = 0;
+	descriptor_set_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptor_set_layout_binding.descriptorCount = 1;
+	descriptor_set_layout_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	descriptor_set_layout_binding.pImmutableSamplers = nullptr;
+
+	VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+	descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptor_set_layout_create_info.pNext = nullptr;
+	descriptor_set_layout_create_info.flags = 0;
+	descriptor_set_layout_create_info.bindingCount = 1;
+	descriptor_set_layout_create_info.pBindings = &descriptor_set_layout_binding;
+
+	vk_error = vkCreateDescriptorSetLayout(m_vk_logical_device, &descriptor_set_layout_create_info, m_allocator->getAllocationCallbacks(),
+		&m_vk_descriptor_set_layout);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles draw descriptor set layout. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_descriptor_set_layout = VK_NULL_HANDLE;
+		destroy();
+		return false;
+	}
+
+	VkDescriptorPoolSize descriptor_pool_size{};
+	descriptor_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptor_pool_size.descriptorCount = 1;
+
+	VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptor_pool_create_info.pNext = nullptr;
+	descriptor_pool_create_info.flags = 0;
+	descriptor_pool_create_info.maxSets = 1;
+	descriptor_pool_create_info.poolSizeCount = 1;
+	descriptor_pool_create_info.pPoolSizes = &descriptor_pool_size;
+
+	vk_error = vkCreateDescriptorPool(m_vk_logical_device, &descriptor_pool_create_info, m_allocator->getAllocationCallbacks(), &m_vk_descriptor_pool);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles draw descriptor pool. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_descriptor_pool = VK_NULL_HANDLE;
+		destroy();
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+	descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_allocate_info.pNext = nullptr;
+	descriptor_set_allocate_info.descriptorPool = m_vk_descriptor_pool;
+	descriptor_set_allocate_info.descriptorSetCount = 1;
+	descriptor_set_allocate_info.pSetLayouts = &m_vk_descriptor_set_layout;
+
+	vk_error = vkAllocateDescriptorSets(m_vk_logical_device, &descriptor_set_allocate_info, &m_vk_descriptor_set);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to allocate Vulkan particles draw descriptor set. VK error:" + std::to_string(vk_error) + ".";
+		destroy();
+		return false;
+	}
+
+	VkDescriptorBufferInfo descriptor_buffer_info{};
+	descriptor_buffer_info.buffer = particle_compute.getParticlesBuffer();
+	descriptor_buffer_info.offset = 0;
+	descriptor_buffer_info.range = VK_WHOLE_SIZE;
+
+	VkWriteDescriptorSet write_descriptor_set{};
+	write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write_descriptor_set.pNext = nullptr;
+	write_descriptor_set.dstSet = m_vk_descriptor_set;
+	write_descriptor_set.dstBinding = 0;
+	write_descriptor_set.dstArrayElement = 0;
+	write_descriptor_set.descriptorCount = 1;
+	write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write_descriptor_set.pImageInfo = nullptr;
+	write_descriptor_set.pBufferInfo = &descriptor_buffer_info;
+	write_descriptor_set.pTexelBufferView = nullptr;
+
+	vkUpdateDescriptorSets(m_vk_logical_device, 1, &write_descriptor_set, 0, nullptr);
+
+	/**************************************************************************************/
+
+	VkPushConstantRange push_constant_range{};
+	push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	push_constant_range.offset = 0;
+	push_constant_range.size = sizeof(PushConstants);
+
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_create_info.pNext = nullptr;
+	pipeline_layout_create_info.flags = 0;
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = &m_vk_descriptor_set_layout;
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	vk_error = vkCreatePipelineLayout(m_vk_logical_device, &pipeline_layout_create_info, m_allocator->getAllocationCallbacks(), &m_vk_pipeline_layout);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles draw pipeline layout. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_pipeline_layout = VK_NULL_HANDLE;
+		destroy();
+		return false;
+	}
+
+	if (!createPipeline(pipeline_cache, out_error_message)) {
+		destroy();
+		return false;
+	}
+
+	if (gpu_driven && !createCulling(pipeline_cache, unique_queue_family_indices, particle_compute, out_error_message)) {
+		destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void ParticleRenderer::destroy()
+{
+	if (m_vk_logical_device != VK_NULL_HANDLE) {
+		const VkAllocationCallbacks* allocation_callbacks = m_allocator->getAllocationCallbacks();
+
+		destroyPipeline();
+
+		if (m_vk_cull_pipeline != VK_NULL_HANDLE) {
+			vkDestroyPipeline(m_vk_logical_device, m_vk_cull_pipeline, allocation_callbacks);
+			m_vk_cull_pipeline = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_cull_pipeline_layout != VK_NULL_HANDLE) {
+			vkDestroyPipelineLayout(m_vk_logical_device, m_vk_cull_pipeline_layout, allocation_callbacks);
+			m_vk_cull_pipeline_layout = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_cull_descriptor_pool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(m_vk_logical_device, m_vk_cull_descriptor_pool, allocation_callbacks);
+			m_vk_cull_descriptor_pool = VK_NULL_HANDLE;
+			m_vk_cull_descriptor_set = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_cull_descriptor_set_layout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(m_vk_logical_device, m_vk_cull_descriptor_set_layout, allocation_callbacks);
+			m_vk_cull_descriptor_set_layout = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_draw_count_buffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(m_vk_logical_device, m_vk_draw_count_buffer, allocation_callbacks);
+			m_vk_draw_count_buffer = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_draw_commands_buffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(m_vk_logical_device, m_vk_draw_commands_buffer, allocation_callbacks);
+			m_vk_draw_commands_buffer = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_pipeline_layout != VK_NULL_HANDLE) {
+			vkDestroyPipelineLayout(m_vk_logical_device, m_vk_pipeline_layout, allocation_callbacks);
+			m_vk_pipeline_layout = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_descriptor_pool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(m_vk_logical_device, m_vk_descriptor_pool, allocation_callbacks);
+			m_vk_descriptor_pool = VK_NULL_HANDLE;
+			m_vk_descriptor_set = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_descriptor_set_layout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(m_vk_logical_device, m_vk_descriptor_set_layout, allocation_callbacks);
+			m_vk_descriptor_set_layout = VK_NULL_HANDLE;
+		}
+
+		if (m_vk_index_buffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(m_vk_logical_device, m_vk_index_buffer, allocation_callbacks);
+			m_vk_index_buffer = VK_NULL_HANDLE;
+		}
+	}
+
+	if (m_allocator != nullptr) {
+		m_allocator->free(m_index_allocation);
+		m_allocator->free(m_draw_commands_allocation);
+		m_allocator->free(m_draw_count_allocation);
+		m_allocator = nullptr;
+	}
+
+	m_vk_logical_device = VK_NULL_HANDLE;
+	m_color_format = VK_FORMAT_UNDEFINED;
+	m_depth_format = VK_FORMAT_UNDEFINED;
+	m_particles_count = 0;
+}
+
+bool ParticleRenderer::isCreated() const
+{
+	return m_vk_pipeline != VK_NULL_HANDLE;
+}
+
+bool ParticleRenderer::isGpuDriven() const
+{
+	return m_vk_cull_pipeline != VK_NULL_HANDLE;
+}
+
+bool ParticleRenderer::setColorFormat(VkFormat color_format, PipelineCache& pipeline_cache, std::string& out_error_message)
+{
+	if (!isCreated() || (color_format == m_color_format)) {
+		return true;
+	}
+
+	// The caller waits for the device to go idle before the swapchain, and with it the format, changes.
+	destroyPipeline();
+	m_color_format = color_format;
+	return createPipeline(pipeline_cache, out_error_message);
+}
+
+VkFormat ParticleRenderer::getColorFormat() const
+{
+	return m_color_format;
+}
+
+VkFormat ParticleRenderer::getDepthFormat() const
+{
+	return m_depth_format;
+}
+
+uint32_t ParticleRenderer::getParticlesCount() const
+{
+	return m_particles_count;
+}
+
+void ParticleRenderer::recordDraws(VkCommandBuffer command_buffer, uint32_t begin, uint32_t end, const ParticleDrawParams& params) const
+{
+	end = std::min(end, m_particles_count);
+	if (!isCreated() || (begin >= end)) {
+		return;
+	}
+
+	bindDrawState(command_buffer, params);
+
+	for (uint32_t particle_idx = begin; particle_idx < end; particle_idx++) {
+		vkCmdDrawIndexed(command_buffer, CUBE_INDICES_COUNT, 1, 0, 0, particle_idx);
+	}
+}
+
+void ParticleRenderer::recordCulling(VkCommandBuffer command_buffer, const ParticleDrawParams& params) const
+{
+	if (!isGpuDriven()) {
+		return;
+	}
+
+	// The previous frame's indirect draws must have read the commands and the count before they are overwritten.
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+		0, nullptr, 0, nullptr, 0, nullptr);
+
+	vkCmdFillBuffer(command_buffer, m_vk_draw_count_buffer, 0, sizeof(uint32_t), 0);
+
+	VkBufferMemoryBarrier buffer_barriers[2]{};
+	buffer_barriers[0].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	buffer_barriers[0].pNext = nullptr;
+	buffer_barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	buffer_barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	buffer_barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barriers[0].buffer = m_vk_draw_count_buffer;
+	buffer_barriers[0].offset = 0;
+	buffer_barriers[0].size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, buffer_barriers, 0, nullptr);
+
+	CullPushConstants push_constants{};
+	getFrustumPlanes(params.view_projection, push_constants.frustum_planes);
+	// Bounding sphere of the cube drawn around each particle.
+	push_constants.radius = PARTICLE_SIZE * 0.8660254f;
+	push_constants.particles_count = m_particles_count;
+	push_constants.index_count = CUBE_INDICES_COUNT;
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vk_cull_pipeline);
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_vk_cull_pipeline_layout, 0, 1, &m_vk_cull_descriptor_set, 0, nullptr);
+	vkCmdPushConstants(command_buffer, m_vk_cull_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &push_constants);
+	vkCmdDispatch(command_buffer, (m_particles_count + CULL_WORKGROUP_SIZE - 1) / CULL_WORKGROUP_SIZE, 1, 1);
+
+	buffer_barriers[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	buffer_barriers[0].dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	buffer_barriers[1] = buffer_barriers[0];
+	buffer_barriers[1].buffer = m_vk_draw_commands_buffer;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr,
+		static_cast<uint32_t>(std::size(buffer_barriers)), buffer_barriers, 0, nullptr);
+}
+
+void ParticleRenderer::recordIndirectDraws(VkCommandBuffer command_buffer, uint32_t max_draws_count, const ParticleDrawParams& params) const
+{
+	max_draws_count = std::min(max_draws_count, m_particles_count);
+	if (!isGpuDriven() || (max_draws_count == 0)) {
+		return;
+	}
+
+	bindDrawState(command_buffer, params);
+	vkCmdDrawIndexedIndirectCount(command_buffer, m_vk_draw_commands_buffer, 0, m_vk_draw_count_buffer, 0, max_draws_count,
+		sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void ParticleRenderer::getViewProjection(float aspect_ratio, float (&out_matrix)[16])
+{
+	float focal_length = 1.0f / std::tan(CAMERA_FOV_Y * 0.5f);
+	float depth_scale = CAMERA_FAR / (CAMERA_NEAR - CAMERA_FAR);
+
+	// Perspective projection times a view that moves the camera CAMERA_DISTANCE back along +z.
+	std::fill(std::begin(out_matrix), std::end(out_matrix), 0.0f);
+	out_matrix[0] = focal_length / aspect_ratio;
+	out_matrix[5] = -focal_length;
+	out_matrix[10] = depth_scale;
+	out_matrix[11] = -1.0f;
+	out_matrix[14] = -CAMERA_DISTANCE * depth_scale + CAMERA_NEAR * depth_scale;
+	out_matrix[15] = CAMERA_DISTANCE;
+}
+
+void ParticleRenderer::getFrustumPlanes(const float (&view_projection)[16], float (&out_planes)[24])
+{
+	// Gribb-Hartmann: each plane is a sum of the last row of the matrix and another row, row r being elements r, r + 4, r + 8, r + 12.
+	for (uint32_t plane_idx = 0; plane_idx < 6; plane_idx++) {
+		uint32_t row = plane_idx / 2;
+		float sign = (plane_idx % 2 == 0) ? 1.0f : -1.0f;
+
+		for (uint32_t i = 0; i < 4; i++) {
+			float w_row = (plane_idx == 4) ? 0.0f : view_projection[i * 4 + 3];
+			out_planes[plane_idx * 4 + i] = w_row + sign * view_projection[i * 4 + row];
+		}
+
+		float length = std::sqrt(out_planes[plane_idx * 4] * out_planes[plane_idx * 4] + out_planes[plane_idx * 4 + 1] * out_planes[plane_idx * 4 + 1] +
+			out_planes[plane_idx * 4 + 2] * out_planes[plane_idx * 4 + 2]);
+		if (length > 0.0f) {
+			for (uint32_t i = 0; i < 4; i++) {
+				out_planes[plane_idx * 4 + i] /= length;
+			}
+		}
+	}
+}
+
+bool ParticleRenderer::createCulling(PipelineCache& pipeline_cache, const std::vector<uint32_t>& unique_queue_family_indices,
+	const ParticleCompute& particle_compute, std::string& out_error_message)
+{
+	const VkAllocationCallbacks* allocation_callbacks = m_allocator->getAllocationCallbacks();
+
+	VkBufferCreateInfo buffer_create_info{};
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.pNext = nullptr;
+	buffer_create_info.flags = 0;
+	buffer_create_info.size = static_cast<VkDeviceSize>(m_particles_count) * sizeof(VkDrawIndexedIndirectCommand);
+	buffer_create_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+	if (unique_queue_family_indices.size() > 1) {
+		buffer_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		buffer_create_info.queueFamilyIndexCount = static_cast<uint32_t>(unique_queue_family_indices.size());
+		buffer_create_info.pQueueFamilyIndices = unique_queue_family_indices.data();
+	}
+	else {
+		buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		buffer_create_info.queueFamilyIndexCount = 0;
+		buffer_create_info.pQueueFamilyIndices = nullptr;
+	}
+
+	VkResult vk_error = vkCreateBuffer(m_vk_logical_device, &buffer_create_info, allocation_callbacks, &m_vk_draw_commands_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles draw commands buffer. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_draw_commands_buffer = VK_NULL_HANDLE;
+		return false;
+	}
+
+	if (!m_allocator->allocateForBuffer(m_vk_draw_commands_buffer, MemoryUsage::GPU_ONLY, false, m_draw_commands_allocation, out_error_message)) {
+		out_error_message = "Failed to allocate Vulkan particles draw commands buffer memory. " + out_error_message;
+		return false;
+	}
+
+	buffer_create_info.size = sizeof(uint32_t);
+	buffer_create_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	vk_error = vkCreateBuffer(m_vk_logical_device, &buffer_create_info, allocation_callbacks, &m_vk_draw_count_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles draw count buffer. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_draw_count_buffer = VK_NULL_HANDLE;
+		return false;
+	}
+
+	if (!m_allocator->allocateForBuffer(m_vk_draw_count_buffer, MemoryUsage::GPU_ONLY, false, m_draw_count_allocation, out_error_message)) {
+		out_error_message = "Failed to allocate Vulkan particles draw count buffer memory. " + out_error_message;
+		return false;
+	}
+
+	/**************************************************************************************/
+
+	// Binding 0 is the particles, 1 the draw commands and 2 the draw count.
+	VkDescriptorSetLayoutBinding descriptor_set_layout_bindings[3]{};
+	for (uint32_t i = 0; i < std::size(descriptor_set_layout_bindings); i++) {
+		descriptor_set_layout_bindings[i].binding = i;
+		descriptor_set_layout_bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptor_set_layout_bindings[i].descriptorCount = 1;
+		descriptor_set_layout_bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		descriptor_set_layout_bindings[i].pImmutableSamplers = nullptr;
+	}
+
+	VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{};
+	descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptor_set_layout_create_info.pNext = nullptr;
+	descriptor_set_layout_create_info.flags = 0;
+	descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(std::size(descriptor_set_layout_bindings));
+	descriptor_set_layout_create_info.pBindings = descriptor_set_layout_bindings;
+
+	vk_error = vkCreateDescriptorSetLayout(m_vk_logical_device, &descriptor_set_layout_create_info, allocation_callbacks, &m_vk_cull_descriptor_set_layout);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles cull descriptor set layout. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_cull_descriptor_set_layout = VK_NULL_HANDLE;
+		return false;
+	}
+
+	VkDescriptorPoolSize descriptor_pool_size{};
+	descriptor_pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptor_pool_size.descriptorCount = static_cast<uint32_t>(std::size(descriptor_set_layout_bindings));
+
+	VkDescriptorPoolCreateInfo descriptor_pool_create_info{};
+	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptor_pool_create_info.pNext = nullptr;
+	descriptor_pool_create_info.flags = 0;
+	descriptor_pool_create_info.maxSets = 1;
+	descriptor_pool_create_info.poolSizeCount = 1;
+	descriptor_pool_create_info.pPoolSizes = &descriptor_pool_size;
+
+	vk_error = vkCreateDescriptorPool(m_vk_logical_device, &descriptor_pool_create_info, allocation_callbacks, &m_vk_cull_descriptor_pool);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles cull descriptor pool. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_cull_descriptor_pool = VK_NULL_HANDLE;
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo descriptor_set_allocate_info{};
+	descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_allocate_info.pNext = nullptr;
+	descriptor_set_allocate_info.descriptorPool = m_vk_cull_descriptor_pool;
+	descriptor_set_allocate_info.descriptorSetCount = 1;
+	descriptor_set_allocate_info.pSetLayouts = &m_vk_cull_descriptor_set_layout;
+
+	vk_error = vkAllocateDescriptorSets(m_vk_logical_device, &descriptor_set_allocate_info, &m_vk_cull_descriptor_set);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to allocate Vulkan particles cull descriptor set. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	VkDescriptorBufferInfo descriptor_buffer_infos[3]{};
+	descriptor_buffer_infos[0].buffer = particle_compute.getParticlesBuffer();
+	descriptor_buffer_infos[1].buffer = m_vk_draw_commands_buffer;
+	descriptor_buffer_infos[2].buffer = m_vk_draw_count_buffer;
+
+	VkWriteDescriptorSet write_descriptor_sets[3]{};
+	for (uint32_t i = 0; i < std::size(write_descriptor_sets); i++) {
+		descriptor_buffer_infos[i].offset = 0;
+		descriptor_buffer_infos[i].range = VK_WHOLE_SIZE;
+
+		write_descriptor_sets[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write_descriptor_sets[i].pNext = nullptr;
+		write_descriptor_sets[i].dstSet = m_vk_cull_descriptor_set;
+		write_descriptor_sets[i].dstBinding = i;
+		write_descriptor_sets[i].dstArrayElement = 0;
+		write_descriptor_sets[i].descriptorCount = 1;
+		write_descriptor_sets[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write_descriptor_sets[i].pImageInfo = nullptr;
+		write_descriptor_sets[i].pBufferInfo = &descriptor_buffer_infos[i];
+		write_descriptor_sets[i].pTexelBufferView = nullptr;
+	}
+
+	vkUpdateDescriptorSets(m_vk_logical_device, static_cast<uint32_t>(std::size(write_descriptor_sets)), write_descriptor_sets, 0, nullptr);
+
+	/**************************************************************************************/
+
+	VkPushConstantRange push_constant_range{};
+	push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	push_constant_range.offset = 0;
+	push_constant_range.size = sizeof(CullPushConstants);
+
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info{};
+	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_create_info.pNext = nullptr;
+	pipeline_layout_create_info.flags = 0;
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = &m_vk_cull_descriptor_set_layout;
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	vk_error = vkCreatePipelineLayout(m_vk_logical_device, &pipeline_layout_create_info, allocation_callbacks, &m_vk_cull_pipeline_layout);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles cull pipeline layout. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_cull_pipeline_layout = VK_NULL_HANDLE;
+		return false;
+	}
+
+	VkShaderModuleCreateInfo shader_module_create_info{};
+	shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shader_module_create_info.pNext = nullptr;
+	shader_module_create_info.flags = 0;
+	shader_module_create_info.codeSize = sizeof(PARTICLES_CULL_COMP_SPIRV);
+	shader_module_create_info.pCode = PARTICLES_CULL_COMP_SPIRV;
+
+	VkShaderModule vk_shader_module;
+	vk_error = vkCreateShaderModule(m_vk_logical_device, &shader_module_create_info, allocation_callbacks, &vk_shader_module);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles cull shader module. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	VkPipelineCreationFeedback creation_feedback{};
+
+	VkPipelineCreationFeedbackCreateInfo creation_feedback_create_info{};
+	creation_feedback_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+	creation_feedback_create_info.pNext = nullptr;
+	creation_feedback_create_info.pPipelineCreationFeedback = &creation_feedback;
+	creation_feedback_create_info.pipelineStageCreationFeedbackCount = 0;
+	creation_feedback_create_info.pPipelineStageCreationFeedbacks = nullptr;
+
+	VkComputePipelineCreateInfo pipeline_create_info{};
+	pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipeline_create_info.pNext = &creation_feedback_create_info;
+	pipeline_create_info.flags = 0;
+	pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipeline_create_info.stage.pNext = nullptr;
+	pipeline_create_info.stage.flags = 0;
+	pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipeline_create_info.stage.module = vk_shader_module;
+	pipeline_create_info.stage.pName = "main";
+	pipeline_create_info.stage.pSpecializationInfo = nullptr;
+	pipeline_create_info.layout = m_vk_cull_pipeline_layout;
+	pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+	pipeline_create_info.basePipelineIndex = -1;
+
+	vk_error = vkCreateComputePipelines(m_vk_logical_device, pipeline_cache.getHandle(), 1, &pipeline_create_info, allocation_callbacks, &m_vk_cull_pipeline);
+	vkDestroyShaderModule(m_vk_logical_device, vk_shader_module, allocation_callbacks);
+
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles cull pipeline. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_cull_pipeline = VK_NULL_HANDLE;
+		return false;
+	}
+
+	pipeline_cache.recordCreationFeedback(creation_feedback);
+	return true;
+}
+
+bool ParticleRenderer::createPipeline(PipelineCache& pipeline_cache, std::string& out_error_message)
+{
+	const VkAllocationCallbacks* allocation_callbacks = m_allocator->getAllocationCallbacks();
+
+	VkShaderModuleCreateInfo shader_module_create_info{};
+	shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shader_module_create_info.pNext = nullptr;
+	shader_module_create_info.flags = 0;
+	shader_module_create_info.codeSize = sizeof(PARTICLES_VERT_SPIRV);
+	shader_module_create_info.pCode = PARTICLES_VERT_SPIRV;
+
+	VkShaderModule vk_vertex_shader_module;
+	VkResult vk_error = vkCreateShaderModule(m_vk_logical_device, &shader_module_create_info, allocation_callbacks, &vk_vertex_shader_module);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles vertex shader module. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	shader_module_create_info.codeSize = sizeof(PARTICLES_FRAG_SPIRV);
+	shader_module_create_info.pCode = PARTICLES_FRAG_SPIRV;
+
+	VkShaderModule vk_fragment_shader_module;
+	vk_error = vkCreateShaderModule(m_vk_logical_device, &shader_module_create_info, allocation_callbacks, &vk_fragment_shader_module);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles fragment shader module. VK error:" + std::to_string(vk_error) + ".";
+		vkDestroyShaderModule(m_vk_logical_device, vk_vertex_shader_module, allocation_callbacks);
+		return false;
+	}
+
+	VkPipelineShaderStageCreateInfo shader_stage_create_infos[2]{};
+	shader_stage_create_infos[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shader_stage_create_infos[0].pNext = nullptr;
+	shader_stage_create_infos[0].flags = 0;
+	shader_stage_create_infos[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shader_stage_create_infos[0].module = vk_vertex_shader_module;
+	shader_stage_create_infos[0].pName = "main";
+	shader_stage_create_infos[0].pSpecializationInfo = nullptr;
+	shader_stage_create_infos[1] = shader_stage_create_infos[0];
+	shader_stage_create_infos[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shader_stage_create_infos[1].module = vk_fragment_shader_module;
+
+	VkPipelineVertexInputStateCreateInfo vertex_input_state_create_info{};
+	vertex_input_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertex_input_state_create_info.pNext = nullptr;
+	vertex_input_state_create_info.flags = 0;
+	vertex_input_state_create_info.vertexBindingDescriptionCount = 0;
+	vertex_input_state_create_info.pVertexBindingDescriptions = nullptr;
+	vertex_input_state_create_info.vertexAttributeDescriptionCount = 0;
+	vertex_input_state_create_info.pVertexAttributeDescriptions = nullptr;
+
+	VkPipelineInputAssemblyStateCreateInfo input_assembly_state_create_info{};
+	input_assembly_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	input_assembly_state_create_info.pNext = nullptr;
+	input_assembly_state_create_info.flags = 0;
+	input_assembly_state_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	input_assembly_state_create_info.primitiveRestartEnable = VK_FALSE;
+
+	VkPipelineViewportStateCreateInfo viewport_state_create_info{};
+	viewport_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport_state_create_info.pNext = nullptr;
+	viewport_state_create_info.flags = 0;
+	viewport_state_create_info.viewportCount = 1;
+	viewport_state_create_info.pViewports = nullptr;
+	viewport_state_create_info.scissorCount = 1;
+	viewport_state_create_info.pScissors = nullptr;
+
+	VkPipelineRasterizationStateCreateInfo rasterization_state_create_info{};
+	rasterization_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterization_state_create_info.pNext = nullptr;
+	rasterization_state_create_info.flags = 0;
+	rasterization_state_create_info.depthClampEnable = VK_FALSE;
+	rasterization_state_create_info.rasterizerDiscardEnable = VK_FALSE;
+	rasterization_state_create_info.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterization_state_create_info.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterization_state_create_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterization_state_create_info.depthBiasEnable = VK_FALSE;
+	rasterization_state_create_info.depthBiasConstantFactor = 0.0f;
+	rasterization_state_create_info.depthBiasClamp = 0.0f;
+	rasterization_state_create_info.depthBiasSlopeFactor = 0.0f;
+	rasterization_state_create_info.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisample_state_create_info{};
+	multisample_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample_state_create_info.pNext = nullptr;
+	multisample_state_create_info.flags = 0;
+	multisample_state_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisample_state_create_info.sampleShadingEnable = VK_FALSE;
+	multisample_state_create_info.minSampleShading = 1.0f;
+	multisample_state_create_info.pSampleMask = nullptr;
+	multisample_state_create_info.alphaToCoverageEnable = VK_FALSE;
+	multisample_state_create_info.alphaToOneEnable = VK_FALSE;
+
+	VkPipelineDepthStencilStateCreateInfo depth_stencil_state_create_info{};
+	depth_stencil_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depth_stencil_state_create_info.pNext = nullptr;
+	depth_stencil_state_create_info.flags = 0;
+	depth_stencil_state_create_info.depthTestEnable = VK_TRUE;
+	depth_stencil_state_create_info.depthWriteEnable = VK_TRUE;
+	depth_stencil_state_create_info.depthCompareOp = VK_COMPARE_OP_LESS;
+	depth_stencil_state_create_info.depthBoundsTestEnable = VK_FALSE;
+	depth_stencil_state_create_info.stencilTestEnable = VK_FALSE;
+	depth_stencil_state_create_info.front = {};
+	depth_stencil_state_create_info.back = {};
+	depth_stencil_state_create_info.minDepthBounds = 0.0f;
+	depth_stencil_state_create_info.maxDepthBounds = 1.0f;
+
+	VkPipelineColorBlendAttachmentState color_blend_attachment_state{};
+	color_blend_attachment_state.blendEnable = VK_FALSE;
+	color_blend_attachment_state.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
+		VK_COLOR_COMPONENT_A_BIT;
+
+	VkPipelineColorBlendStateCreateInfo color_blend_state_create_info{};
+	color_blend_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	color_blend_state_create_info.pNext = nullptr;
+	color_blend_state_create_info.flags = 0;
+	color_blend_state_create_info.logicOpEnable = VK_FALSE;
+	color_blend_state_create_info.logicOp = VK_LOGIC_OP_COPY;
+	color_blend_state_create_info.attachmentCount = 1;
+	color_blend_state_create_info.pAttachments = &color_blend_attachment_state;
+
+	VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+	VkPipelineDynamicStateCreateInfo dynamic_state_create_info{};
+	dynamic_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamic_state_create_info.pNext = nullptr;
+	dynamic_state_create_info.flags = 0;
+	dynamic_state_create_info.dynamicStateCount = static_cast<uint32_t>(std::size(dynamic_states));
+	dynamic_state_create_info.pDynamicStates = dynamic_states;
+
+	VkPipelineCreationFeedback creation_feedback{};
+
+	VkPipelineCreationFeedbackCreateInfo creation_feedback_create_info{};
+	creation_feedback_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+	creation_feedback_create_info.pNext = nullptr;
+	creation_feedback_create_info.pPipelineCreationFeedback = &creation_feedback;
+	creation_feedback_create_info.pipelineStageCreationFeedbackCount = 0;
+	creation_feedback_create_info.pPipelineStageCreationFeedbacks = nullptr;
+
+	// Dynamic rendering with a depth attachment cleared to the far plane.
+	VkPipelineRenderingCreateInfo rendering_create_info{};
+	rendering_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	rendering_create_info.pNext = &creation_feedback_create_info;
+	rendering_create_info.viewMask = 0;
+	rendering_create_info.colorAttachmentCount = 1;
+	rendering_create_info.pColorAttachmentFormats = &m_color_format;
+	rendering_create_info.depthAttachmentFormat = m_depth_format;
+	rendering_create_info.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+
+	VkGraphicsPipelineCreateInfo pipeline_create_info{};
+	pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipeline_create_info.pNext = &rendering_create_info;
+	pipeline_create_info.flags = 0;
+	pipeline_create_info.stageCount = static_cast<uint32_t>(std::size(shader_stage_create_infos));
+	pipeline_create_info.pStages = shader_stage_create_infos;
+	pipeline_create_info.pVertexInputState = &vertex_input_state_create_info;
+	pipeline_create_info.pInputAssemblyState = &input_assembly_state_create_info;
+	pipeline_create_info.pTessellationState = nullptr;
+	pipeline_create_info.pViewportState = &viewport_state_create_info;
+	pipeline_create_info.pRasterizationState = &rasterization_state_create_info;
+	pipeline_create_info.pMultisampleState = &multisample_state_create_info;
+	pipeline_create_info.pDepthStencilState = &depth_stencil_state_create_info;
+	pipeline_create_info.pColorBlendState = &color_blend_state_create_info;
+	pipeline_create_info.pDynamicState = &dynamic_state_create_info;
+	pipeline_create_info.layout = m_vk_pipeline_layout;
+	pipeline_create_info.renderPass = VK_NULL_HANDLE;
+	pipeline_create_info.subpass = 0;
+	pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
+	pipeline_create_info.basePipelineIndex = -1;
+
+	vk_error = vkCreateGraphicsPipelines(m_vk_logical_device, pipeline_cache.getHandle(), 1, &pipeline_create_info, allocation_callbacks, &m_vk_pipeline);
+	vkDestroyShaderModule(m_vk_logical_device, vk_fragment_shader_module, allocation_callbacks);
+	vkDestroyShaderModule(m_vk_logical_device, vk_vertex_shader_module, allocation_callbacks);
+
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles draw pipeline. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_pipeline = VK_NULL_HANDLE;
+		return false;
+	}
+
+	pipeline_cache.recordCreationFeedback(creation_feedback);
+	return true;
+}
+
+void ParticleRenderer::destroyPipeline()
+{
+	if (m_vk_pipeline != VK_NULL_HANDLE) {
+		vkDestroyPipeline(m_vk_logical_device, m_vk_pipeline, m_allocator->getAllocationCallbacks());
+		m_vk_pipeline = VK_NULL_HANDLE;
+	}
+}
+
+void ParticleRenderer::bindDrawState(VkCommandBuffer command_buffer, const ParticleDrawParams& params) const
+{
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(params.extent.width);
+	viewport.height = static_cast<float>(params.extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.offset = { 0, 0 };
+	scissor.extent = params.extent;
+
+	PushConstants push_constants{};
+	std::copy(std::begin(params.view_projection), std::end(params.view_projection), push_constants.view_projection);
+	push_constants.particle_size = PARTICLE_SIZE;
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_vk_pipeline);
+	vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+	vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_vk_pipeline_layout, 0, 1, &m_vk_descriptor_set, 0, nullptr);
+	vkCmdBindIndexBuffer(command_buffer, m_vk_index_buffer, 0, VK_INDEX_TYPE_UINT16);
+	vkCmdPushConstants(command_buffer, m_vk_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants), &push_constants);
+}
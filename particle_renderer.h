@@ -0,0 +1,102 @@
+#pragma once
+
+#include "memory_allocator.h"
+#include "particle_compute.h"
+#include "pipeline_cache.h"
+#include "staging_uploader.h"
+#include <Volk/volk.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Simulator {
+	enum class ParticleDrawMode {
+		CPU_RECORDED,
+		GPU_DRIVEN
+	};
+
+	struct ParticleDrawParams {
+		float view_projection[16]{};
+		VkExtent2D extent{};
+	};
+
+	// Draws every particle as a cube, one indexed draw per particle. Positions are read straight from the particle compute
+	// buffer by instance index and the cube corners come from the vertex index, so there is no vertex buffer.
+	// When created GPU driven, a compute pass culls the particles against the view frustum and writes the draws of the visible
+	// ones, which a single indirect count draw then issues, so recording no longer depends on the particles count. Cubes are
+	// depth tested, so overlapping ones resolve the same whatever order the draws reach the GPU in.
+	class ParticleRenderer {
+	public:
+		~ParticleRenderer();
+		bool create(VkDevice logical_device, MemoryAllocator& allocator, PipelineCache& pipeline_cache, StagingUploader& uploader,
+			const std::vector<uint32_t>& queue_family_indices, const ParticleCompute& particle_compute, VkFormat color_format, VkFormat depth_format,
+			bool gpu_driven,
+			std::string& out_error_message);
+		void destroy();
+		bool isCreated() const;
+		bool isGpuDriven() const;
+		bool setColorFormat(VkFormat color_format, PipelineCache& pipeline_cache, std::string& out_error_message);
+		VkFormat getColorFormat() const;
+		VkFormat getDepthFormat() const;
+		uint32_t getParticlesCount() const;
+		void recordDraws(VkCommandBuffer command_buffer, uint32_t begin, uint32_t end, const ParticleDrawParams& params) const;
+		// Recorded in the primary command buffer outside of rendering, before the buffer that executes the indirect draws.
+		void recordCulling(VkCommandBuffer command_buffer, const ParticleDrawParams& params) const;
+		void recordIndirectDraws(VkCommandBuffer command_buffer, uint32_t max_draws_count, const ParticleDrawParams& params) const;
+
+		// Column-major, right-handed, looking at the scene origin with the Vulkan clip space (y down, depth 0..1).
+		static void getViewProjection(float aspect_ratio, float (&out_matrix)[16]);
+		// Clip planes x >= -w, x <= w, y >= -w, y <= w, z >= 0, z <= w as (nx, ny, nz, d) with normals pointing inside the frustum.
+		static void getFrustumPlanes(const float (&view_projection)[16], float (&out_planes)[24]);
+
+		static constexpr uint32_t CUBE_INDICES_COUNT = 36;
+		static constexpr uint32_t MIN_DRAWS_PER_COMMAND_BUFFER = 4096;
+		static constexpr float PARTICLE_SIZE = 0.5f;
+		static constexpr float CAMERA_DISTANCE = 200.0f;
+		static constexpr float CAMERA_FOV_Y = 1.0471976f;
+		static constexpr float CAMERA_NEAR = 1.0f;
+		static constexpr float CAMERA_FAR = 1000.0f;
+		static constexpr uint32_t CULL_WORKGROUP_SIZE = 256;
+
+	private:
+		struct PushConstants {
+			float view_projection[16];
+			float particle_size;
+		};
+
+		struct CullPushConstants {
+			float frustum_planes[24];
+			float radius;
+			uint32_t particles_count;
+			uint32_t index_count;
+		};
+
+		bool createCulling(PipelineCache& pipeline_cache, const std::vector<uint32_t>& unique_queue_family_indices, const ParticleCompute& particle_compute,
+			std::string& out_error_message);
+		bool createPipeline(PipelineCache& pipeline_cache, std::string& out_error_message);
+		void destroyPipeline();
+		void bindDrawState(VkCommandBuffer command_buffer, const ParticleDrawParams& params) const;
+
+		VkDevice m_vk_logical_device = VK_NULL_HANDLE;
+		MemoryAllocator* m_allocator = nullptr;
+		VkBuffer m_vk_index_buffer = VK_NULL_HANDLE;
+		MemoryAllocation m_index_allocation;
+		VkDescriptorSetLayout m_vk_descriptor_set_layout = VK_NULL_HANDLE;
+		VkDescriptorPool m_vk_descriptor_pool = VK_NULL_HANDLE;
+		VkDescriptorSet m_vk_descriptor_set = VK_NULL_HANDLE;
+		VkPipelineLayout m_vk_pipeline_layout = VK_NULL_HANDLE;
+		VkPipeline m_vk_pipeline = VK_NULL_HANDLE;
+		VkBuffer m_vk_draw_commands_buffer = VK_NULL_HANDLE;
+		MemoryAllocation m_draw_commands_allocation;
+		VkBuffer m_vk_draw_count_buffer = VK_NULL_HANDLE;
+		MemoryAllocation m_draw_count_allocation;
+		VkDescriptorSetLayout m_vk_cull_descriptor_set_layout = VK_NULL_HANDLE;
+		VkDescriptorPool m_vk_cull_descriptor_pool = VK_NULL_HANDLE;
+		VkDescriptorSet m_vk_cull_descriptor_set = VK_NULL_HANDLE;
+		VkPipelineLayout m_vk_cull_pipeline_layout = VK_NULL_HANDLE;
+		VkPipeline m_vk_cull_pipeline = VK_NULL_HANDLE;
+		VkFormat m_color_format = VK_FORMAT_UNDEFINED;
+		VkFormat m_depth_format = VK_FORMAT_UNDEFINED;
+		uint32_t m_particles_count = 0;
+	};
+}
@@ -0,0 +1,290 @@
+#include "pipeline_cache.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+using namespace Simulator;
+
+PipelineCache::~PipelineCache()
+{
+	destroy();
+}
+
+bool PipelineCache::create(VkDevice logical_device, const VkPhysicalDeviceProperties& physical_device_properties, const std::filesystem::path& file_path,
+	const VkAllocationCallbacks* allocation_callbacks, std::string& out_error_message)
+{
+	destroy();
+
+	m_vk_logical_device = logical_device;
+	m_allocation_callbacks = allocation_callbacks;
+	m_physical_device_properties = physical_device_properties;
+	m_file_path = file_path;
+	m_stats = {};
+	m_pipeline_hits_count = 0;
+	m_pipeline_misses_count = 0;
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	std::vector<uint8_t> data;
+	std::string miss_reason;
+	bool loaded = !m_file_path.empty() && readFile(data, miss_reason);
+
+	VkPipelineCacheCreateInfo pipeline_cache_create_info{};
+	pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipeline_cache_create_info.pNext = nullptr;
+	pipeline_cache_create_info.flags = 0;
+	pipeline_cache_create_info.initialDataSize = loaded ? data.size() : 0;
+	pipeline_cache_create_info.pInitialData = loaded ? data.data() : nullptr;
+
+	VkResult vk_error = vkCreatePipelineCache(m_vk_logical_device, &pipeline_cache_create_info, m_allocation_callbacks, &m_vk_pipeline_cache);
+	if ((vk_error != VK_SUCCESS) && loaded) {
+		loaded = false;
+		miss_reason = "Cache data rejected by the driver.";
+		pipeline_cache_create_info.initialDataSize = 0;
+		pipeline_cache_create_info.pInitialData = nullptr;
+		vk_error = vkCreatePipelineCache(m_vk_logical_device, &pipeline_cache_create_info, m_allocation_callbacks, &m_vk_pipeline_cache);
+	}
+
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan pipeline cache. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_pipeline_cache = VK_NULL_HANDLE;
+		return false;
+	}
+
+	m_loaded_data_hash = loaded ? getDataHash(data.data(), data.size()) : 0;
+	m_stats.loaded = loaded;
+	m_stats.miss_reason = loaded ? std::string() : (m_file_path.empty() ? "Cache file disabled." : miss_reason);
+	m_stats.loaded_size = loaded ? data.size() : 0;
+	m_stats.load_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+	return true;
+}
+
+bool PipelineCache::save(std::string& out_error_message)
+{
+	if (m_vk_pipeline_cache == VK_NULL_HANDLE) {
+		out_error_message = "Pipeline cache not created.";
+		return false;
+	}
+
+	if (m_file_path.empty()) {
+		return true;
+	}
+
+	size_t data_size;
+	VkResult vk_error = vkGetPipelineCacheData(m_vk_logical_device, m_vk_pipeline_cache, &data_size, nullptr);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to get Vulkan pipeline cache data size. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	std::vector<uint8_t> data(data_size);
+	vk_error = vkGetPipelineCacheData(m_vk_logical_device, m_vk_pipeline_cache, &data_size, data.data());
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to get Vulkan pipeline cache data. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	data.resize(data_size);
+	uint64_t data_hash = getDataHash(data.data(), data.size());
+
+	if (m_stats.loaded && (data_hash == m_loaded_data_hash)) {
+		return true;
+	}
+
+	/**************************************************************************************/
+
+	FileHeader header{};
+	header.magic = FILE_MAGIC;
+	header.version = FILE_VERSION;
+	header.vendor_id = m_physical_device_properties.vendorID;
+	header.device_id = m_physical_device_properties.deviceID;
+	header.driver_version = m_physical_device_properties.driverVersion;
+	memcpy(header.pipeline_cache_uuid, m_physical_device_properties.pipelineCacheUUID, VK_UUID_SIZE);
+	header.data_size = data.size();
+	header.data_hash = data_hash;
+
+	std::error_code error;
+	if (m_file_path.has_parent_path()) {
+		std::filesystem::create_directories(m_file_path.parent_path(), error);
+	}
+
+	std::filesystem::path temp_file_path = m_file_path;
+	temp_file_path += ".tmp";
+
+	{
+		std::ofstream file(temp_file_path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+		if (!file.is_open()) {
+			out_error_message = "Failed to create pipeline cache file \"" + temp_file_path.string() + "\".";
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		file.flush();
+
+		if (!file.good()) {
+			file.close();
+			std::filesystem::remove(temp_file_path, error);
+			out_error_message = "Failed to write pipeline cache file \"" + temp_file_path.string() + "\".";
+			return false;
+		}
+	}
+
+	std::filesystem::rename(temp_file_path, m_file_path, error);
+	if (error) {
+		std::error_code remove_error;
+		std::filesystem::remove(temp_file_path, remove_error);
+		out_error_message = "Failed to replace pipeline cache file \"" + m_file_path.string() + "\". " + error.message();
+		return false;
+	}
+
+	m_loaded_data_hash = data_hash;
+	m_stats.saved = true;
+	m_stats.saved_size = sizeof(header) + data.size();
+	return true;
+}
+
+void PipelineCache::destroy()
+{
+	if (m_vk_pipeline_cache == VK_NULL_HANDLE) {
+		return;
+	}
+
+	std::string out_error_message;
+	if (!save(out_error_message)) {
+		m_stats.save_error_message = out_error_message;
+	}
+
+	m_stats.pipeline_hits_count = m_pipeline_hits_count.load(std::memory_order_relaxed);
+	m_stats.pipeline_misses_count = m_pipeline_misses_count.load(std::memory_order_relaxed);
+
+	vkDestroyPipelineCache(m_vk_logical_device, m_vk_pipeline_cache, m_allocation_callbacks);
+	m_vk_pipeline_cache = VK_NULL_HANDLE;
+	m_vk_logical_device = VK_NULL_HANDLE;
+}
+
+void PipelineCache::recordCreationFeedback(const VkPipelineCreationFeedback& feedback)
+{
+	if (!(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)) {
+		return;
+	}
+
+	if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) {
+		m_pipeline_hits_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	else {
+		m_pipeline_misses_count.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+VkPipelineCache PipelineCache::getHandle() const
+{
+	return m_vk_pipeline_cache;
+}
+
+PipelineCacheStats PipelineCache::getStats() const
+{
+	PipelineCacheStats stats = m_stats;
+
+	if (m_vk_pipeline_cache != VK_NULL_HANDLE) {
+		stats.pipeline_hits_count = m_pipeline_hits_count.load(std::memory_order_relaxed);
+		stats.pipeline_misses_count = m_pipeline_misses_count.load(std::memory_order_relaxed);
+	}
+
+	return stats;
+}
+
+bool PipelineCache::readFile(std::vector<uint8_t>& out_data, std::string& out_miss_reason) const
+{
+	std::error_code error;
+	uint64_t file_size = std::filesystem::file_size(m_file_path, error);
+	if (error) {
+		out_miss_reason = "No cache file.";
+		return false;
+	}
+
+	std::ifstream file(m_file_path, std::ifstream::in | std::ifstream::binary);
+	if (!file.is_open()) {
+		out_miss_reason = "Failed to open cache file.";
+		return false;
+	}
+
+	FileHeader header;
+	if ((file_size < sizeof(header)) || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+		out_miss_reason = "Cache file truncated.";
+		return false;
+	}
+
+	if (!isHeaderValid(header, out_miss_reason)) {
+		return false;
+	}
+
+	if (header.data_size != file_size - sizeof(header)) {
+		out_miss_reason = "Cache file size mismatch.";
+		return false;
+	}
+
+	out_data.resize(static_cast<size_t>(header.data_size));
+	if (!file.read(reinterpret_cast<char*>(out_data.data()), out_data.size())) {
+		out_miss_reason = "Cache file truncated.";
+		return false;
+	}
+
+	if (getDataHash(out_data.data(), out_data.size()) != header.data_hash) {
+		out_miss_reason = "Cache data checksum mismatch.";
+		return false;
+	}
+
+	VkPipelineCacheHeaderVersionOne vk_header;
+	if (out_data.size() < sizeof(vk_header)) {
+		out_miss_reason = "Cache data too small.";
+		return false;
+	}
+
+	memcpy(&vk_header, out_data.data(), sizeof(vk_header));
+	if ((vk_header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) ||
+		(vk_header.vendorID != m_physical_device_properties.vendorID) ||
+		(vk_header.deviceID != m_physical_device_properties.deviceID) ||
+		(memcmp(vk_header.pipelineCacheUUID, m_physical_device_properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)) {
+		out_miss_reason = "Cache data header mismatch.";
+		return false;
+	}
+
+	return true;
+}
+
+bool PipelineCache::isHeaderValid(const FileHeader& header, std::string& out_miss_reason) const
+{
+	if ((header.magic != FILE_MAGIC) || (header.version != FILE_VERSION)) {
+		out_miss_reason = "Unknown cache file format.";
+		return false;
+	}
+
+	if ((header.vendor_id != m_physical_device_properties.vendorID) || (header.device_id != m_physical_device_properties.deviceID)) {
+		out_miss_reason = "Cache created on a different device.";
+		return false;
+	}
+
+	if (header.driver_version != m_physical_device_properties.driverVersion) {
+		out_miss_reason = "Cache created with a different driver version.";
+		return false;
+	}
+
+	if (memcmp(header.pipeline_cache_uuid, m_physical_device_properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+		out_miss_reason = "Cache UUID mismatch.";
+		return false;
+	}
+
+	return true;
+}
+
+uint64_t PipelineCache::getDataHash(const uint8_t* data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+
+	return hash;
+}
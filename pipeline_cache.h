@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Volk/volk.h>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Simulator {
+	struct PipelineCacheStats {
+		bool loaded = false;
+		std::string miss_reason;
+		size_t loaded_size = 0;
+		uint64_t load_time_ns = 0;
+		bool saved = false;
+		size_t saved_size = 0;
+		std::string save_error_message;
+		uint64_t pipeline_hits_count = 0;
+		uint64_t pipeline_misses_count = 0;
+	};
+
+	class PipelineCache {
+	public:
+		~PipelineCache();
+		bool create(VkDevice logical_device, const VkPhysicalDeviceProperties& physical_device_properties, const std::filesystem::path& file_path,
+			const VkAllocationCallbacks* allocation_callbacks, std::string& out_error_message);
+		bool save(std::string& out_error_message);
+		void destroy();
+		void recordCreationFeedback(const VkPipelineCreationFeedback& feedback);
+		VkPipelineCache getHandle() const;
+		PipelineCacheStats getStats() const;
+
+	private:
+		struct FileHeader {
+			uint32_t magic;
+			uint32_t version;
+			uint32_t vendor_id;
+			uint32_t device_id;
+			uint32_t driver_version;
+			uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+			uint64_t data_size;
+			uint64_t data_hash;
+		};
+
+		bool readFile(std::vector<uint8_t>& out_data, std::string& out_miss_reason) const;
+		bool isHeaderValid(const FileHeader& header, std::string& out_miss_reason) const;
+		static uint64_t getDataHash(const uint8_t* data, size_t size);
+
+		static constexpr uint32_t FILE_MAGIC = 0x43505053;
+		static constexpr uint32_t FILE_VERSION = 1;
+
+		VkDevice m_vk_logical_device = VK_NULL_HANDLE;
+		const VkAllocationCallbacks* m_allocation_callbacks = nullptr;
+		VkPipelineCache m_vk_pipeline_cache = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties m_physical_device_properties{};
+		std::filesystem::path m_file_path;
+		uint64_t m_loaded_data_hash = 0;
+		PipelineCacheStats m_stats;
+		std::atomic<uint64_t> m_pipeline_hits_count = 0;
+		std::atomic<uint64_t> m_pipeline_misses_count = 0;
+	};
+}
@@ -1,4 +1,13 @@
 #include "renderer.h"
+#include "instrumentation.h"
+#include "job_system.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <future>
 
 using namespace Simulator;
 
@@ -14,25 +23,94 @@ bool Renderer::init(
 #endif
 )
 {
-	if (m_initialized) {
-		out_error_message = "Renderer already initialized.";
+	SIMULATOR_SCOPE_TIMER("Renderer::init");
+
+#ifdef DEBUG
+	if (!createInstance(out_error_message, false, vulkan_debug_callback, vulkan_debug_callback_user_data)) {
+#else
+	if (!createInstance(out_error_message, false)) {
+#endif
+		return false;
+	}
+
+	VkWin32SurfaceCreateInfoKHR create_info{};
+	create_info.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
+	create_info.pNext = nullptr;
+	create_info.flags = 0;
+	create_info.hinstance = app_instance;
+	create_info.hwnd = window;
+
+	VkResult vk_error = vkCreateWin32SurfaceKHR(m_vk_instance, &create_info, m_host_allocator.getCallbacks(), &m_vk_surface);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan rendering surface. VK error:" + std::to_string(vk_error) + ".";
 		destroy();
 		return false;
 	}
 
-	if (volkInitialize() != VK_SUCCESS) {
-		out_error_message = "Vulkan not found on this system.";
+	m_headless = false;
+	m_initialized = true;
+	return true;
+}
+
+bool Renderer::initHeadless(
+	std::string& out_error_message
+#ifdef DEBUG
+	, PFN_vkDebugUtilsMessengerCallbackEXT vulkan_debug_callback, void* vulkan_debug_callback_user_data
+#endif
+)
+{
+	SIMULATOR_SCOPE_TIMER("Renderer::initHeadless");
+
+#ifdef DEBUG
+	if (!createInstance(out_error_message, true, vulkan_debug_callback, vulkan_debug_callback_user_data)) {
+#else
+	if (!createInstance(out_error_message, true)) {
+#endif
+		return false;
+	}
+
+	m_headless = true;
+	m_initialized = true;
+	return true;
+}
+
+bool Renderer::createInstance(
+	std::string& out_error_message, bool headless
+#ifdef DEBUG
+	, PFN_vkDebugUtilsMessengerCallbackEXT vulkan_debug_callback, void* vulkan_debug_callback_user_data
+#endif
+)
+{
+	SIMULATOR_SCOPE_TIMER("Renderer::createInstance");
+
+	if (m_initialized) {
+		out_error_message = "Renderer already initialized.";
 		destroy();
 		return false;
 	}
 
-	uint32_t vk_version = volkGetInstanceVersion();
-	if (vk_version == 0) {
-		out_error_message = "Failed to get Vulkan version.";
+	auto wait_start_time = std::chrono::steady_clock::now();
+
+	bool loaded;
+	if (m_loading.valid()) {
+		loaded = m_loading.get();
+		if (!loaded) {
+			out_error_message = m_loading_error_message;
+		}
+	}
+	else {
+		loaded = load(out_error_message);
+	}
+
+	auto instance_start_time = std::chrono::steady_clock::now();
+	m_startup_timings.loading_wait_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(instance_start_time - wait_start_time).count();
+
+	if (!loaded) {
 		destroy();
 		return false;
 	}
 
+	uint32_t vk_version = m_instance_capabilities.getApiVersion();
 	if ((VK_API_VERSION_VARIANT(vk_version) != 0) ||
 		(VK_API_VERSION_MAJOR(vk_version) != 1) ||
 		(VK_API_VERSION_MINOR(vk_version) < 3)) {
@@ -45,46 +123,17 @@ bool Renderer::init(
 		return false;
 	}
 
+	VkResult vk_error = VK_SUCCESS;
+
 	/**************************************************************************************/
 
 #ifdef DEBUG
-	uint32_t supported_instance_layers_count;
-	VkResult vk_error = vkEnumerateInstanceLayerProperties(&supported_instance_layers_count, nullptr);
-	if (vk_error != VK_SUCCESS) {
-		out_error_message = "Failed to enumerate Vulkan instance layers. VK error:" + std::to_string(vk_error) + ".";
-		destroy();
-		return false;
-	}
-
-	if (supported_instance_layers_count == 0) {
-		out_error_message = "No Vulkan instance layers found.";
-		destroy();
-		return false;
-	}
-
-	std::vector<VkLayerProperties> supported_instance_layers(supported_instance_layers_count);
-	vk_error = vkEnumerateInstanceLayerProperties(&supported_instance_layers_count, supported_instance_layers.data());
-	if (vk_error != VK_SUCCESS) {
-		out_error_message = "Failed to enumerate Vulkan instance layers. VK error:" + std::to_string(vk_error) + ".";
-		destroy();
-		return false;
-	}
-
 	std::vector<const char*> instance_layers{
 		VK_LAYER_KHRONOS_VALIDATION_NAME
 	};
 
 	for (const char* const instance_layer : instance_layers) {
-		bool found = false;
-
-		for (const VkLayerProperties& supported_instance_layer : supported_instance_layers) {
-			if (std::string(instance_layer) == std::string(supported_instance_layer.layerName)) {
-				found = true;
-				break;
-			}
-		}
-
-		if (!found) {
+		if (!m_instance_capabilities.hasLayer(instance_layer)) {
 			out_error_message = "Vulkan instance layer \"" + std::string(instance_layer) + "\" not supported.";
 			destroy();
 			return false;
@@ -94,47 +143,19 @@ bool Renderer::init(
 
 	/**************************************************************************************/
 
-	std::vector<const char*> instance_extensions{
-		 VK_KHR_SURFACE_EXTENSION_NAME,
-		 VK_KHR_WIN32_SURFACE_EXTENSION_NAME
-#ifdef DEBUG
-		 , VK_EXT_DEBUG_UTILS_EXTENSION_NAME
-#endif
-	};
-
-	uint32_t supported_instance_extensions_count;
-	vk_error = vkEnumerateInstanceExtensionProperties(nullptr, &supported_instance_extensions_count, nullptr);
-	if (vk_error != VK_SUCCESS) {
-		out_error_message = "Failed to enumerate Vulkan instance extensions. VK error:" + std::to_string(vk_error) + ".";
-		destroy();
-		return false;
-	}
+	std::vector<const char*> instance_extensions;
 
-	if (supported_instance_extensions_count == 0) {
-		out_error_message = "No Vulkan instance extensions found.";
-		destroy();
-		return false;
+	if (!headless) {
+		instance_extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+		instance_extensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
 	}
 
-	std::vector<VkExtensionProperties> supported_instance_extensions(supported_instance_extensions_count);
-	vk_error = vkEnumerateInstanceExtensionProperties(nullptr, &supported_instance_extensions_count, supported_instance_extensions.data());
-	if (vk_error != VK_SUCCESS) {
-		out_error_message = "Failed to enumerate Vulkan instance extensions. VK error:" + std::to_string(vk_error) + ".";
-		destroy();
-		return false;
-	}
+#ifdef DEBUG
+	instance_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+#endif
 
 	for (const char* const instance_extension : instance_extensions) {
-		bool found = false;
-
-		for (const VkExtensionProperties& supported_instance_extension : supported_instance_extensions) {
-			if (std::string(instance_extension) == std::string(supported_instance_extension.extensionName)) {
-				found = true;
-				break;
-			}
-		}
-
-		if (!found) {
+		if (!m_instance_capabilities.hasExtension(instance_extension)) {
 			out_error_message = "Vulkan instance extension \"" + std::string(instance_extension) + "\" not supported.";
 			destroy();
 			return false;
@@ -188,7 +209,7 @@ bool Renderer::init(
 	inst_info.enabledExtensionCount = static_cast<uint32_t>(instance_extensions.size());
 	inst_info.ppEnabledExtensionNames = instance_extensions.data();
 
-	vk_error = vkCreateInstance(&inst_info, nullptr, &m_vk_instance);
+	vk_error = vkCreateInstance(&inst_info, m_host_allocator.getCallbacks(), &m_vk_instance);
 	if (vk_error != VK_SUCCESS) {
 		out_error_message = "Failed to create Vulkan instance. VK error:" + std::to_string(vk_error) + ".";
 		destroy();
@@ -200,7 +221,7 @@ bool Renderer::init(
 	/**************************************************************************************/
 
 #ifdef DEBUG
-	vk_error = vkCreateDebugUtilsMessengerEXT(m_vk_instance, &debug_messenger_info, nullptr, &m_vk_debug_messenger);
+	vk_error = vkCreateDebugUtilsMessengerEXT(m_vk_instance, &debug_messenger_info, m_host_allocator.getCallbacks(), &m_vk_debug_messenger);
 	if (vk_error != VK_SUCCESS) {
 		out_error_message = "Failed to create Vulkan debug messenger. VK error:" + std::to_string(vk_error) + ".";
 		destroy();
@@ -208,55 +229,106 @@ bool Renderer::init(
 	}
 #endif
 
-	/**************************************************************************************/
+	m_startup_timings.instance_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - instance_start_time).count();
+	return true;
+}
 
-	VkWin32SurfaceCreateInfoKHR create_info{};
-	create_info.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-	create_info.pNext = nullptr;
-	create_info.flags = 0;
-	create_info.hinstance = app_instance;
-	create_info.hwnd = window;
+void Renderer::startLoading()
+{
+	if (m_loading.valid() || m_instance_capabilities.isLoaded()) {
+		return;
+	}
 
-	vk_error = vkCreateWin32SurfaceKHR(m_vk_instance, &create_info, nullptr, &m_vk_surface);
-	if (vk_error != VK_SUCCESS) {
-		out_error_message = "Failed to create Vulkan rendering surface. VK error:" + std::to_string(vk_error) + ".";
-		destroy();
+	m_loading = std::async(std::launch::async, [this]() { return load(m_loading_error_message); });
+}
+
+void Renderer::setJobSystem(JobSystem* job_system)
+{
+	m_job_system = job_system;
+}
+
+bool Renderer::load(std::string& out_error_message)
+{
+	SIMULATOR_SCOPE_TIMER("Renderer::load");
+
+	if (m_instance_capabilities.isLoaded()) {
+		return true;
+	}
+
+	auto start_time = std::chrono::steady_clock::now();
+
+	if (volkInitialize() != VK_SUCCESS) {
+		out_error_message = "Vulkan not found on this system.";
 		return false;
 	}
 
-	m_initialized = true;
+	if (!m_instance_capabilities.load(out_error_message)) {
+		return false;
+	}
+
+	m_startup_timings.loading_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
 	return true;
 }
 
 void Renderer::destroy()
 {
+	destroyOffscreenTargets();
+	destroyFrameResources();
+	m_particle_renderer.destroy();
+	m_particle_compute.destroy();
+	m_pending_particle_steps_count = 0;
+	destroyDepthTarget();
+	m_swapchain.destroy();
+	m_pipeline_cache.destroy();
+	m_staging_uploader.destroy();
+	m_memory_allocator.destroy();
+
 	if (m_vk_logical_device != VK_NULL_HANDLE) {
-		vkDestroyDevice(m_vk_logical_device, nullptr);
+		vkDestroyDevice(m_vk_logical_device, m_host_allocator.getCallbacks());
 		m_vk_logical_device = VK_NULL_HANDLE;
 	}
 
 	if ((m_vk_instance != VK_NULL_HANDLE) && (m_vk_surface != VK_NULL_HANDLE)) {
-		vkDestroySurfaceKHR(m_vk_instance, m_vk_surface, nullptr);
+		vkDestroySurfaceKHR(m_vk_instance, m_vk_surface, m_host_allocator.getCallbacks());
 		m_vk_surface = VK_NULL_HANDLE;
 	}
 
 #ifdef DEBUG
 	if ((m_vk_instance != VK_NULL_HANDLE) && (m_vk_debug_messenger != VK_NULL_HANDLE)) {
-		vkDestroyDebugUtilsMessengerEXT(m_vk_instance, m_vk_debug_messenger, nullptr);
+		vkDestroyDebugUtilsMessengerEXT(m_vk_instance, m_vk_debug_messenger, m_host_allocator.getCallbacks());
 		m_vk_debug_messenger = VK_NULL_HANDLE;
 	}
 #endif
 
 	if (m_vk_instance != VK_NULL_HANDLE) {
-		vkDestroyInstance(m_vk_instance, nullptr);
+		vkDestroyInstance(m_vk_instance, m_host_allocator.getCallbacks());
 		m_vk_instance = VK_NULL_HANDLE;
 	}
 
+	if (m_loading.valid()) {
+		m_loading.wait();
+	}
+
+	m_vk_physical_device = VK_NULL_HANDLE;
+	m_depth_format = VK_FORMAT_UNDEFINED;
+	m_gpu_driven_drawing_supported = false;
+	m_calibrated_timestamps_supported = false;
+	m_device_capabilities.clear();
+	m_graphics_queue.reset();
+	m_present_queue.reset();
+	m_compute_queue.reset();
+	m_transfer_queue.reset();
+	m_swapchain_width = 0;
+	m_swapchain_height = 0;
+	m_swapchain_rebuilds_count = 0;
+	m_headless = false;
 	m_initialized = false;
 }
 
 bool Renderer::getSupportedPhysicalDevices(std::vector<VkPhysicalDevice>& out_supported_devices, std::string& out_error_message)
 {
+	SIMULATOR_SCOPE_TIMER("Renderer::getSupportedPhysicalDevices");
+
 	if (!m_initialized) {
 		out_error_message = "Renderer not initialized.";
 		return false;
@@ -283,102 +355,64 @@ bool Renderer::getSupportedPhysicalDevices(std::vector<VkPhysicalDevice>& out_su
 
 	/**************************************************************************************/
 
-	for (const VkPhysicalDevice& physical_device : physical_devices) {
-		VkPhysicalDeviceProperties physical_device_properties;
-		vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
+	auto probes_start_time = std::chrono::steady_clock::now();
 
-		/**************************************************************************************/
+	std::vector<DeviceCapabilities> device_capabilities(physical_devices_count);
+	std::vector<std::string> probe_error_messages(physical_devices_count);
+	std::vector<std::future<bool>> probes;
 
-#ifdef DEBUG
-		uint32_t supported_device_layers_count;
-		VkResult vk_error = vkEnumerateDeviceLayerProperties(physical_device, &supported_device_layers_count, nullptr);
-		if (vk_error != VK_SUCCESS) {
-			out_error_message = "Failed to enumerate layers for Vulkan physical device: \"" + std::string(physical_device_properties.deviceName) + "\". "
-				"VK error:" + std::to_string(vk_error) + ".";
-			return false;
-		}
+	for (uint32_t i = 1; i < physical_devices_count; i++) {
+		probes.push_back(std::async(std::launch::async, [&, i]()
+			{
+				return device_capabilities[i].load(physical_devices[i], m_vk_surface, probe_error_messages[i]);
+			}
+		));
+	}
 
-		if (supported_device_layers_count == 0) {
-			out_error_message = "No layers found for Vulkan physical device: \"" + std::string(physical_device_properties.deviceName) + "\".";
-			return false;
-		}
+	bool probes_succeeded = device_capabilities[0].load(physical_devices[0], m_vk_surface, probe_error_messages[0]);
+	if (!probes_succeeded) {
+		out_error_message = probe_error_messages[0];
+	}
 
-		std::vector<VkLayerProperties> supported_device_layers(supported_device_layers_count);
-		vk_error = vkEnumerateDeviceLayerProperties(physical_device, &supported_device_layers_count, supported_device_layers.data());
-		if (vk_error != VK_SUCCESS) {
-			out_error_message = "Failed to enumerate layers for Vulkan physical device: \"" + std::string(physical_device_properties.deviceName) + "\". "
-				"VK error:" + std::to_string(vk_error) + ".";
-			return false;
+	for (uint32_t i = 1; i < physical_devices_count; i++) {
+		if (!probes[i - 1].get() && probes_succeeded) {
+			out_error_message = probe_error_messages[i];
+			probes_succeeded = false;
 		}
+	}
 
-		bool device_supported = true;
-
-		std::vector<const char*> device_layers{
-			VK_LAYER_KHRONOS_VALIDATION_NAME
-		};
+	m_startup_timings.device_probes_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - probes_start_time).count();
 
-		for (const char* const device_layer : device_layers) {
-			bool device_layer_found = false;
+	if (!probes_succeeded) {
+		return false;
+	}
 
-			for (const VkLayerProperties& supported_device_layer : supported_device_layers) {
-				if (std::string(device_layer) == std::string(supported_device_layer.layerName)) {
-					device_layer_found = true;
-					break;
-				}
-			}
+	m_device_capabilities = std::move(device_capabilities);
 
-			if (!device_layer_found) {
-				device_supported = false;
-			}
-		}
+	/**************************************************************************************/
 
-		if (!device_supported) {
-			break;
+	for (const DeviceCapabilities& capabilities : m_device_capabilities) {
+#ifdef DEBUG
+		if (!capabilities.hasLayer(VK_LAYER_KHRONOS_VALIDATION_NAME)) {
+			continue;
 		}
 #endif
 
-		/**************************************************************************************/
-
-		uint32_t queue_families_count;
-		vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, nullptr);
-
-		if (queue_families_count == 0) {
-			out_error_message = "No Vulkan queue families found for physical device \"" + std::string(physical_device_properties.deviceName) + "\".";
-			return false;
+		if (!capabilities.isTimelineSemaphoreSupported() || !capabilities.isSynchronization2Supported()) {
+			continue;
 		}
 
-		std::vector<VkQueueFamilyProperties> queue_families_props(queue_families_count);
-		vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, queue_families_props.data());
-
 		bool graphics_queue_family_found = false;
 		bool present_queue_family_found = false;
+		const std::vector<VkQueueFamilyProperties>& queue_families = capabilities.getQueueFamilies();
 
-		for (uint32_t i = 0; i < queue_families_props.size(); i++) {
-			if (queue_families_props[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-				graphics_queue_family_found = true;
-			}
-
-			VkBool32 presentation_supported = false;
-			vk_error = vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, m_vk_surface, &presentation_supported);
-			if (vk_error != VK_SUCCESS) {
-				out_error_message = "Failed to query Vulkan physical device \"" + std::string(physical_device_properties.deviceName) +
-					"\" for presentation support. VK error:" + std::to_string(vk_error) + ".";
-				return false;
-			}
-
-			if (presentation_supported) {
-				present_queue_family_found = true;
-			}
-
-			if (graphics_queue_family_found && present_queue_family_found) {
-				break;
-			}
+		for (uint32_t i = 0; i < queue_families.size(); i++) {
+			graphics_queue_family_found = graphics_queue_family_found || (queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT);
+			present_queue_family_found = present_queue_family_found || capabilities.isPresentSupported(i);
 		}
 
-		device_supported = graphics_queue_family_found && present_queue_family_found;
-
-		if (device_supported) {
-			out_supported_devices.push_back(physical_device);
+		if (graphics_queue_family_found && present_queue_family_found) {
+			out_supported_devices.push_back(capabilities.getPhysicalDevice());
 		}
 	}
 
@@ -392,114 +426,323 @@ bool Renderer::getSupportedPhysicalDevices(std::vector<VkPhysicalDevice>& out_su
 	return true;
 }
 
-bool Renderer::createLogicalDevice(const VkPhysicalDevice& physical_device, std::string& out_error_message)
+const DeviceCapabilities* Renderer::getDeviceCapabilities(VkPhysicalDevice physical_device) const
+{
+	for (const DeviceCapabilities& capabilities : m_device_capabilities) {
+		if (capabilities.getPhysicalDevice() == physical_device) {
+			return &capabilities;
+		}
+	}
+
+	return nullptr;
+}
+
+const Renderer::StartupTimings& Renderer::getStartupTimings() const
+{
+	return m_startup_timings;
+}
+
+bool Renderer::rankPhysicalDevices(const std::vector<VkPhysicalDevice>& physical_devices, std::vector<PhysicalDeviceScore>& out_ranked_devices,
+	std::string& out_error_message) const
 {
 	if (!m_initialized) {
 		out_error_message = "Renderer not initialized.";
 		return false;
 	}
 
-	if (m_vk_logical_device != VK_NULL_HANDLE) {
-		out_error_message = "Vulkan logical device already created.";
-		return false;
-	}
+	std::vector<const char*> required_extensions = getRequiredDeviceExtensions();
 
-	VkPhysicalDeviceProperties physical_device_properties;
-	vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
+	out_ranked_devices.clear();
 
-	/**************************************************************************************/
+	for (const VkPhysicalDevice& physical_device : physical_devices) {
+		const DeviceCapabilities* capabilities = getDeviceCapabilities(physical_device);
+		if (capabilities == nullptr) {
+			out_error_message = "Vulkan physical device capabilities not probed.";
+			return false;
+		}
 
-#ifdef DEBUG
-	std::vector<const char*> device_layers{
-		VK_LAYER_KHRONOS_VALIDATION_NAME
-	};
+		PhysicalDeviceScore score;
+		score.physical_device = physical_device;
+		score.properties = capabilities->getProperties();
+		memcpy(score.device_uuid, capabilities->getDeviceUuid(), VK_UUID_SIZE);
+		score.extensions_supported = areDeviceExtensionsSupported(*capabilities, required_extensions, score.unsupported_reason);
 
-	uint32_t supported_device_layers_count;
-	VkResult vk_error = vkEnumerateDeviceLayerProperties(physical_device, &supported_device_layers_count, nullptr);
-	if (vk_error != VK_SUCCESS) {
-		out_error_message = "Failed to enumerate layers for Vulkan physical device: \"" + std::string(physical_device_properties.deviceName) + "\". "
-			"VK error:" + std::to_string(vk_error) + ".";
-		return false;
-	}
+		/**************************************************************************************/
 
-	if (supported_device_layers_count == 0) {
-		out_error_message = "No layers found for Vulkan physical device: \"" + std::string(physical_device_properties.deviceName) + "\".";
-		return false;
-	}
+		switch (score.properties.deviceType) {
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+			score.device_type_score = 1000;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+			score.device_type_score = 500;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+			score.device_type_score = 200;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_CPU:
+			score.device_type_score = 10;
+			break;
+		default:
+			score.device_type_score = 0;
+			break;
+		}
 
-	std::vector<VkLayerProperties> supported_device_layers(supported_device_layers_count);
-	vk_error = vkEnumerateDeviceLayerProperties(physical_device, &supported_device_layers_count, supported_device_layers.data());
-	if (vk_error != VK_SUCCESS) {
-		out_error_message = "Failed to enumerate layers for Vulkan physical device: \"" + std::string(physical_device_properties.deviceName) + "\". "
-			"VK error:" + std::to_string(vk_error) + ".";
-		return false;
-	}
+		/**************************************************************************************/
 
-	for (const char* const device_layer : device_layers) {
-		bool layer_found = false;
+		const VkPhysicalDeviceMemoryProperties& memory_properties = capabilities->getMemoryProperties();
 
-		for (const VkLayerProperties& supported_device_layer : supported_device_layers) {
-			if (std::string(device_layer) == std::string(supported_device_layer.layerName)) {
-				layer_found = true;
-				break;
+		VkDeviceSize device_local_heap_size = 0;
+		for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++) {
+			if ((memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) &&
+				(memory_properties.memoryHeaps[i].size > device_local_heap_size)) {
+				device_local_heap_size = memory_properties.memoryHeaps[i].size;
 			}
 		}
 
-		if (!layer_found) {
-			out_error_message = "Layer \"" + std::string(device_layer) + "\" not supported for Vulkan physical device: \"" +
-				std::string(physical_device_properties.deviceName) + "\".";
-			return false;
+		VkDeviceSize device_local_heap_size_gib = device_local_heap_size >> 30;
+		score.memory_score = 25 * static_cast<int64_t>((device_local_heap_size_gib < 16) ? device_local_heap_size_gib : 16);
+
+		/**************************************************************************************/
+
+		bool graphics_compute_family_found = false;
+		bool dedicated_compute_family_found = false;
+		bool dedicated_transfer_family_found = false;
+
+		for (const VkQueueFamilyProperties& queue_family_props : capabilities->getQueueFamilies()) {
+			VkQueueFlags flags = queue_family_props.queueFlags;
+
+			if ((flags & VK_QUEUE_GRAPHICS_BIT) && (flags & VK_QUEUE_COMPUTE_BIT)) {
+				graphics_compute_family_found = true;
+			}
+			else if (flags & VK_QUEUE_COMPUTE_BIT) {
+				dedicated_compute_family_found = true;
+			}
+			else if (flags & VK_QUEUE_TRANSFER_BIT) {
+				dedicated_transfer_family_found = true;
+			}
 		}
-	}
-#endif
 
-	/**************************************************************************************/
+		score.queues_score = (graphics_compute_family_found ? 50 : 0) + (dedicated_compute_family_found ? 100 : 0) +
+			(dedicated_transfer_family_found ? 100 : 0);
 
-	uint32_t queue_families_count;
-	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, nullptr);
+		/**************************************************************************************/
 
-	if (queue_families_count == 0) {
-		out_error_message = "No Vulkan queue families found for physical device \"" + std::string(physical_device_properties.deviceName) + "\".";
-		return false;
-	}
+		const VkPhysicalDeviceFeatures& features = capabilities->getFeatures();
 
-	std::vector<VkQueueFamilyProperties> queue_families_props(queue_families_count);
-	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, queue_families_props.data());
+		score.features_score = (features.multiDrawIndirect ? 30 : 0) + (features.drawIndirectFirstInstance ? 10 : 0) +
+			(features.samplerAnisotropy ? 20 : 0) + (features.shaderInt64 ? 10 : 0) + (features.fillModeNonSolid ? 10 : 0) +
+			((VK_API_VERSION_MINOR(score.properties.apiVersion) >= 3) ? 100 : 0);
 
-	bool graphics_queue_family_found = false;
-	bool present_queue_family_found = false;
+		/**************************************************************************************/
 
-	uint32_t graphics_queue_family_idx = 0;
-	uint32_t present_queue_family_idx = 0;
+		const VkPhysicalDeviceLimits& limits = score.properties.limits;
 
-	for (uint32_t i = 0; i < queue_families_props.size(); i++) {
-		if (queue_families_props[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-			graphics_queue_family_idx = i;
-			graphics_queue_family_found = true;
+		score.limits_score = (limits.maxImageDimension2D / 1024) + (limits.maxComputeSharedMemorySize / 1024) +
+			(limits.timestampComputeAndGraphics ? 20 : 0);
+
+		score.total_score = score.device_type_score + score.memory_score + score.queues_score + score.features_score + score.limits_score;
+
+		out_ranked_devices.push_back(score);
+	}
+
+	std::stable_sort(out_ranked_devices.begin(), out_ranked_devices.end(),
+		[](const PhysicalDeviceScore& a, const PhysicalDeviceScore& b)
+		{
+			if (a.extensions_supported != b.extensions_supported) {
+				return a.extensions_supported;
+			}
+
+			return a.total_score > b.total_score;
 		}
+	);
 
-		VkBool32 presentation_supported = false;
-		vk_error = vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, m_vk_surface, &presentation_supported);
-		if (vk_error != VK_SUCCESS) {
-			out_error_message = "Failed to query Vulkan physical device \"" + std::string(physical_device_properties.deviceName) +
-				"\" for presentation support. VK error:" + std::to_string(vk_error) + ".";
+	if (out_ranked_devices.empty() || !out_ranked_devices[0].extensions_supported) {
+		out_error_message = "No Vulkan physical device supports the required extensions.";
+		return false;
+	}
+
+	return true;
+}
+
+bool Renderer::findPhysicalDevice(const std::vector<PhysicalDeviceScore>& ranked_devices, std::string_view name_or_uuid, size_t& out_device_idx)
+{
+	auto equalsIgnoreCase = [](std::string_view a, std::string_view b)
+	{
+		if (a.size() != b.size()) {
 			return false;
 		}
 
-		if (presentation_supported) {
-			present_queue_family_idx = i;
-			present_queue_family_found = true;
+		for (size_t i = 0; i < a.size(); i++) {
+			if (tolower(static_cast<unsigned char>(a[i])) != tolower(static_cast<unsigned char>(b[i]))) {
+				return false;
+			}
 		}
 
-		if (graphics_queue_family_found && present_queue_family_found) {
-			break;
+		return true;
+	};
+
+	std::string uuid;
+	for (char c : name_or_uuid) {
+		if (c != '-') {
+			uuid += static_cast<char>(tolower(static_cast<unsigned char>(c)));
 		}
 	}
 
-	if (!(graphics_queue_family_found && present_queue_family_found)) {
-		out_error_message = "No Vulkan supported queue families found for physical device \"" + std::string(physical_device_properties.deviceName) + "\".";
-		return false;
-	}
+	for (size_t i = 0; i < ranked_devices.size(); i++) {
+		if (!ranked_devices[i].extensions_supported) {
+			continue;
+		}
+
+		std::string device_uuid = getDeviceUuidString(ranked_devices[i].device_uuid);
+		device_uuid.erase(std::remove(device_uuid.begin(), device_uuid.end(), '-'), device_uuid.end());
+
+		if (equalsIgnoreCase(name_or_uuid, ranked_devices[i].properties.deviceName) || (uuid == device_uuid)) {
+			out_device_idx = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+std::string Renderer::getDeviceUuidString(const uint8_t (&device_uuid)[VK_UUID_SIZE])
+{
+	static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+	std::string uuid;
+	for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+		if ((i == 4) || (i == 6) || (i == 8) || (i == 10)) {
+			uuid += '-';
+		}
+
+		uuid += HEX_DIGITS[device_uuid[i] >> 4];
+		uuid += HEX_DIGITS[device_uuid[i] & 0xF];
+	}
+
+	return uuid;
+}
+
+bool Renderer::createLogicalDevice(const VkPhysicalDevice& physical_device, std::string& out_error_message)
+{
+	SIMULATOR_SCOPE_TIMER("Renderer::createLogicalDevice");
+
+	if (!m_initialized) {
+		out_error_message = "Renderer not initialized.";
+		return false;
+	}
+
+	if (m_vk_logical_device != VK_NULL_HANDLE) {
+		out_error_message = "Vulkan logical device already created.";
+		return false;
+	}
+
+	const DeviceCapabilities* capabilities = getDeviceCapabilities(physical_device);
+	if (capabilities == nullptr) {
+		out_error_message = "Vulkan physical device capabilities not probed.";
+		return false;
+	}
+
+	const VkPhysicalDeviceProperties& physical_device_properties = capabilities->getProperties();
+
+	/**************************************************************************************/
+
+#ifdef DEBUG
+	std::vector<const char*> device_layers{
+		VK_LAYER_KHRONOS_VALIDATION_NAME
+	};
+
+	for (const char* const device_layer : device_layers) {
+		if (!capabilities->hasLayer(device_layer)) {
+			out_error_message = "Layer \"" + std::string(device_layer) + "\" not supported for Vulkan physical device: \"" +
+				std::string(physical_device_properties.deviceName) + "\".";
+			return false;
+		}
+	}
+#endif
+
+	/**************************************************************************************/
+
+	const std::vector<VkQueueFamilyProperties>& queue_families_props = capabilities->getQueueFamilies();
+
+	if (queue_families_props.empty()) {
+		out_error_message = "No Vulkan queue families found for physical device \"" + std::string(physical_device_properties.deviceName) + "\".";
+		return false;
+	}
+
+	bool graphics_queue_family_found = false;
+	bool present_queue_family_found = false;
+	bool compute_queue_family_found = false;
+	bool transfer_queue_family_found = false;
+
+	uint32_t graphics_queue_family_idx = 0;
+	uint32_t graphics_queue_family_rank = 0;
+	uint32_t present_queue_family_idx = 0;
+	uint32_t compute_queue_family_idx = 0;
+	uint32_t transfer_queue_family_idx = 0;
+
+	for (uint32_t i = 0; i < queue_families_props.size(); i++) {
+		VkQueueFlags queue_flags = queue_families_props[i].queueFlags;
+
+		bool presentation_supported = capabilities->isPresentSupported(i);
+
+		if (queue_flags & VK_QUEUE_GRAPHICS_BIT) {
+			uint32_t graphics_family_rank = (presentation_supported ? 2 : 0) + ((queue_flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 0);
+
+			if (!graphics_queue_family_found || (graphics_family_rank > graphics_queue_family_rank)) {
+				graphics_queue_family_idx = i;
+				graphics_queue_family_rank = graphics_family_rank;
+				graphics_queue_family_found = true;
+			}
+		}
+		else if (queue_flags & VK_QUEUE_COMPUTE_BIT) {
+			if (!compute_queue_family_found) {
+				compute_queue_family_idx = i;
+				compute_queue_family_found = true;
+			}
+		}
+		else if (queue_flags & VK_QUEUE_TRANSFER_BIT) {
+			if (!transfer_queue_family_found) {
+				transfer_queue_family_idx = i;
+				transfer_queue_family_found = true;
+			}
+		}
+
+		if (presentation_supported && !present_queue_family_found) {
+			present_queue_family_idx = i;
+			present_queue_family_found = true;
+		}
+	}
+
+	if (graphics_queue_family_found && (graphics_queue_family_rank >= 2)) {
+		present_queue_family_idx = graphics_queue_family_idx;
+	}
+
+	if (!(graphics_queue_family_found && present_queue_family_found)) {
+		out_error_message = "No Vulkan supported queue families found for physical device \"" + std::string(physical_device_properties.deviceName) + "\".";
+		return false;
+	}
+
+	/**************************************************************************************/
+
+	std::vector<const char*> device_extensions = getRequiredDeviceExtensions();
+	if (!areDeviceExtensionsSupported(*capabilities, device_extensions, out_error_message)) {
+		return false;
+	}
+
+	// Calibrated timestamps put the profiler's GPU scopes on the CPU time line, without them the GPU track is frame relative.
+	bool calibrated_timestamps_supported = false;
+	if (capabilities->hasExtension(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME)) {
+		uint32_t time_domains_count = 0;
+		vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(physical_device, &time_domains_count, nullptr);
+		std::vector<VkTimeDomainEXT> time_domains(time_domains_count);
+		if (vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(physical_device, &time_domains_count, time_domains.data()) == VK_SUCCESS) {
+			calibrated_timestamps_supported = std::find(time_domains.begin(), time_domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != time_domains.end();
+		}
+	}
+
+	if (calibrated_timestamps_supported) {
+		device_extensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	}
 
 	/**************************************************************************************/
 
@@ -509,21 +752,54 @@ bool Renderer::createLogicalDevice(const VkPhysicalDevice& physical_device, std:
 	device_queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 	device_queue_create_info.pNext = nullptr;
 	device_queue_create_info.flags = 0;
-	device_queue_create_info.queueFamilyIndex = graphics_queue_family_idx;
+	device_queue_create_info.queueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 	device_queue_create_info.queueCount = 1;
 	device_queue_create_info.pQueuePriorities = &device_queue_priority;
 
-	std::vector<VkDeviceQueueCreateInfo> device_queue_create_infos{ device_queue_create_info };
-	if (present_queue_family_idx != graphics_queue_family_idx) {
-		device_queue_create_info.queueFamilyIndex = present_queue_family_idx;
+	// Present may land on the compute or transfer family, and each family may be requested only once.
+	std::vector<uint32_t> queue_family_indices{ graphics_queue_family_idx, present_queue_family_idx };
+	if (compute_queue_family_found) {
+		queue_family_indices.push_back(compute_queue_family_idx);
+	}
+
+	if (transfer_queue_family_found) {
+		queue_family_indices.push_back(transfer_queue_family_idx);
+	}
+
+	std::sort(queue_family_indices.begin(), queue_family_indices.end());
+	queue_family_indices.erase(std::unique(queue_family_indices.begin(), queue_family_indices.end()), queue_family_indices.end());
+
+	std::vector<VkDeviceQueueCreateInfo> device_queue_create_infos;
+	device_queue_create_infos.reserve(queue_family_indices.size());
+	for (uint32_t queue_family_idx : queue_family_indices) {
+		device_queue_create_info.queueFamilyIndex = queue_family_idx;
 		device_queue_create_infos.push_back(device_queue_create_info);
 	}
 
+	// GPU driven drawing writes one indirect command per visible particle, with the particle index as first instance.
+	const VkPhysicalDeviceFeatures& supported_device_features = capabilities->getFeatures();
+	bool gpu_driven_drawing_supported = supported_device_features.multiDrawIndirect && supported_device_features.drawIndirectFirstInstance &&
+		capabilities->isDrawIndirectCountSupported();
+
 	VkPhysicalDeviceFeatures enabled_device_features{};
+	enabled_device_features.multiDrawIndirect = gpu_driven_drawing_supported ? VK_TRUE : VK_FALSE;
+	enabled_device_features.drawIndirectFirstInstance = gpu_driven_drawing_supported ? VK_TRUE : VK_FALSE;
+
+	VkPhysicalDeviceVulkan13Features enabled_vulkan13_features{};
+	enabled_vulkan13_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+	enabled_vulkan13_features.pNext = nullptr;
+	enabled_vulkan13_features.synchronization2 = VK_TRUE;
+	enabled_vulkan13_features.dynamicRendering = VK_TRUE;
+
+	VkPhysicalDeviceVulkan12Features enabled_vulkan12_features{};
+	enabled_vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	enabled_vulkan12_features.pNext = &enabled_vulkan13_features;
+	enabled_vulkan12_features.timelineSemaphore = VK_TRUE;
+	enabled_vulkan12_features.drawIndirectCount = gpu_driven_drawing_supported ? VK_TRUE : VK_FALSE;
 
 	VkDeviceCreateInfo device_create_info{};
 	device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-	device_create_info.pNext = nullptr;
+	device_create_info.pNext = &enabled_vulkan12_features;
 	device_create_info.flags = 0;
 	device_create_info.queueCreateInfoCount = static_cast<uint32_t>(device_queue_create_infos.size());
 	device_create_info.pQueueCreateInfos = device_queue_create_infos.data();
@@ -534,11 +810,11 @@ bool Renderer::createLogicalDevice(const VkPhysicalDevice& physical_device, std:
 	device_create_info.enabledLayerCount = 0;
 	device_create_info.ppEnabledLayerNames = nullptr;
 #endif
-	device_create_info.enabledExtensionCount = 0;
-	device_create_info.ppEnabledExtensionNames = nullptr;
+	device_create_info.enabledExtensionCount = static_cast<uint32_t>(device_extensions.size());
+	device_create_info.ppEnabledExtensionNames = device_extensions.data();
 	device_create_info.pEnabledFeatures = &enabled_device_features;
 
-	vk_error = vkCreateDevice(physical_device, &device_create_info, nullptr, &m_vk_logical_device);
+	VkResult vk_error = vkCreateDevice(physical_device, &device_create_info, m_host_allocator.getCallbacks(), &m_vk_logical_device);
 	if (vk_error != VK_SUCCESS) {
 		out_error_message = "Failed to create Vulkan logical device. VK error:" + std::to_string(vk_error) + ".";
 		destroy();
@@ -547,48 +823,1563 @@ bool Renderer::createLogicalDevice(const VkPhysicalDevice& physical_device, std:
 
 	volkLoadDevice(m_vk_logical_device);
 
+	m_vk_physical_device = physical_device;
+	m_depth_format = findDepthFormat(physical_device);
+	m_gpu_driven_drawing_supported = gpu_driven_drawing_supported;
+	m_calibrated_timestamps_supported = calibrated_timestamps_supported;
+
+	VkQueue vk_queue;
+	vkGetDeviceQueue(m_vk_logical_device, graphics_queue_family_idx, 0, &vk_queue);
+	m_graphics_queue.init(vk_queue, graphics_queue_family_idx, DeviceQueue::Type::GRAPHICS);
+
+	if (compute_queue_family_found) {
+		vkGetDeviceQueue(m_vk_logical_device, compute_queue_family_idx, 0, &vk_queue);
+		m_compute_queue.init(vk_queue, compute_queue_family_idx, DeviceQueue::Type::COMPUTE);
+	}
+	else {
+		m_compute_queue.initShared(m_graphics_queue, DeviceQueue::Type::COMPUTE);
+	}
+
+	if (transfer_queue_family_found) {
+		vkGetDeviceQueue(m_vk_logical_device, transfer_queue_family_idx, 0, &vk_queue);
+		m_transfer_queue.init(vk_queue, transfer_queue_family_idx, DeviceQueue::Type::TRANSFER);
+	}
+	else {
+		m_transfer_queue.initShared(m_graphics_queue, DeviceQueue::Type::TRANSFER);
+	}
+
+	// A queue reached through two roles has to share one submit mutex.
+	if (present_queue_family_idx == graphics_queue_family_idx) {
+		m_present_queue.initShared(m_graphics_queue, DeviceQueue::Type::PRESENT);
+	}
+	else if (compute_queue_family_found && present_queue_family_idx == compute_queue_family_idx) {
+		m_present_queue.initShared(m_compute_queue, DeviceQueue::Type::PRESENT);
+	}
+	else if (transfer_queue_family_found && present_queue_family_idx == transfer_queue_family_idx) {
+		m_present_queue.initShared(m_transfer_queue, DeviceQueue::Type::PRESENT);
+	}
+	else {
+		vkGetDeviceQueue(m_vk_logical_device, present_queue_family_idx, 0, &vk_queue);
+		m_present_queue.init(vk_queue, present_queue_family_idx, DeviceQueue::Type::PRESENT);
+	}
+
+	if (!m_memory_allocator.init(m_vk_logical_device, capabilities->getMemoryProperties(), physical_device_properties.limits,
+		m_host_allocator.getCallbacks(), out_error_message)) {
+		destroy();
+		return false;
+	}
+
+	if (!m_staging_uploader.create(m_vk_logical_device, m_memory_allocator, m_transfer_queue, STAGING_RING_SIZE, out_error_message)) {
+		destroy();
+		return false;
+	}
+
 	return true;
 }
 
-bool Renderer::areDeviceExtensionsSupported(const VkPhysicalDevice& physical_device, const std::vector<const char*>& extensions, std::string& out_error_message)
+bool Renderer::createOffscreenTargets(uint32_t width, uint32_t height, uint32_t targets_count, std::string& out_error_message)
 {
-	VkPhysicalDeviceProperties device_properties;
-	vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+	if (m_vk_logical_device == VK_NULL_HANDLE) {
+		out_error_message = "Vulkan logical device not created.";
+		return false;
+	}
 
-	uint32_t supported_extensions_count;
-	VkResult vk_error = vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &supported_extensions_count, nullptr);
-	if (vk_error != VK_SUCCESS) {
-		out_error_message = "Failed to enumerate extensions for Vulkan physical device: \"" + std::string(device_properties.deviceName) + "\". "
-			"VK error:" + std::to_string(vk_error) + ".";
+	if (!m_offscreen_targets.empty()) {
+		out_error_message = "Offscreen targets already created.";
+		return false;
+	}
+
+	if (!m_headless) {
+		out_error_message = "Offscreen targets need a headless renderer.";
 		return false;
 	}
 
-	if (supported_extensions_count == 0) {
-		out_error_message = "No device extensions found for for Vulkan physical device: \"" + std::string(device_properties.deviceName) + "\".";
+	if ((width == 0) || (height == 0) || (targets_count == 0)) {
+		out_error_message = "Invalid offscreen targets size or count.";
 		return false;
 	}
 
-	std::vector<VkExtensionProperties> supported_extensions(supported_extensions_count);
-	vk_error = vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &supported_extensions_count, supported_extensions.data());
+	m_offscreen_width = width;
+	m_offscreen_height = height;
+
+	VkCommandPoolCreateInfo command_pool_create_info{};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.pNext = nullptr;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	command_pool_create_info.queueFamilyIndex = m_graphics_queue.getFamilyIndex();
+
+	VkResult vk_error = vkCreateCommandPool(m_vk_logical_device, &command_pool_create_info, m_host_allocator.getCallbacks(), &m_vk_offscreen_command_pool);
 	if (vk_error != VK_SUCCESS) {
-		out_error_message = "Failed to enumerate extensions for Vulkan physical device: \"" + std::string(device_properties.deviceName) + "\". "
-			"VK error:" + std::to_string(vk_error) + ".";
+		out_error_message = "Failed to create Vulkan offscreen command pool. VK error:" + std::to_string(vk_error) + ".";
+		destroyOffscreenTargets();
 		return false;
 	}
 
-	for (const char* const extension : extensions) {
-		bool found = false;
+	m_offscreen_targets.resize(targets_count);
+
+	for (OffscreenTarget& target : m_offscreen_targets) {
+		VkImageCreateInfo image_create_info{};
+		image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		image_create_info.pNext = nullptr;
+		image_create_info.flags = 0;
+		image_create_info.imageType = VK_IMAGE_TYPE_2D;
+		image_create_info.format = OFFSCREEN_FORMAT;
+		image_create_info.extent = { width, height, 1 };
+		image_create_info.mipLevels = 1;
+		image_create_info.arrayLayers = 1;
+		image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+		image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+		image_create_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		image_create_info.queueFamilyIndexCount = 0;
+		image_create_info.pQueueFamilyIndices = nullptr;
+		image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		vk_error = vkCreateImage(m_vk_logical_device, &image_create_info, m_host_allocator.getCallbacks(), &target.image);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to create Vulkan offscreen image. VK error:" + std::to_string(vk_error) + ".";
+			destroyOffscreenTargets();
+			return false;
+		}
 
-		for (const VkExtensionProperties& supported_extension : supported_extensions) {
-			if (std::string(extension) == std::string(supported_extension.extensionName)) {
-				found = true;
-				break;
-			}
+		if (!m_memory_allocator.allocateForImage(target.image, MemoryUsage::GPU_ONLY, false, target.image_allocation, out_error_message)) {
+			out_error_message = "Failed to allocate Vulkan offscreen image memory. " + out_error_message;
+			destroyOffscreenTargets();
+			return false;
+		}
+
+		VkImageViewCreateInfo image_view_create_info{};
+		image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		image_view_create_info.pNext = nullptr;
+		image_view_create_info.flags = 0;
+		image_view_create_info.image = target.image;
+		image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		image_view_create_info.format = OFFSCREEN_FORMAT;
+		image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		image_view_create_info.subresourceRange.baseMipLevel = 0;
+		image_view_create_info.subresourceRange.levelCount = 1;
+		image_view_create_info.subresourceRange.baseArrayLayer = 0;
+		image_view_create_info.subresourceRange.layerCount = 1;
+
+		vk_error = vkCreateImageView(m_vk_logical_device, &image_view_create_info, m_host_allocator.getCallbacks(), &target.image_view);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to create Vulkan offscreen image view. VK error:" + std::to_string(vk_error) + ".";
+			target.image_view = VK_NULL_HANDLE;
+			destroyOffscreenTargets();
+			return false;
+		}
+
+		/**************************************************************************************/
+
+		VkBufferCreateInfo buffer_create_info{};
+		buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_create_info.pNext = nullptr;
+		buffer_create_info.flags = 0;
+		buffer_create_info.size = static_cast<VkDeviceSize>(width) * height * 4;
+		buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		buffer_create_info.queueFamilyIndexCount = 0;
+		buffer_create_info.pQueueFamilyIndices = nullptr;
+
+		vk_error = vkCreateBuffer(m_vk_logical_device, &buffer_create_info, m_host_allocator.getCallbacks(), &target.readback_buffer);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to create Vulkan offscreen readback buffer. VK error:" + std::to_string(vk_error) + ".";
+			destroyOffscreenTargets();
+			return false;
+		}
+
+		if (!m_memory_allocator.allocateForBuffer(target.readback_buffer, MemoryUsage::READBACK, false, target.readback_allocation, out_error_message)) {
+			out_error_message = "Failed to allocate Vulkan offscreen readback memory. " + out_error_message;
+			destroyOffscreenTargets();
+			return false;
+		}
+
+		target.readback_data = target.readback_allocation.mapped_data;
+
+		/**************************************************************************************/
+
+		VkCommandBufferAllocateInfo command_buffer_allocate_info{};
+		command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_allocate_info.pNext = nullptr;
+		command_buffer_allocate_info.commandPool = m_vk_offscreen_command_pool;
+		command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		command_buffer_allocate_info.commandBufferCount = 1;
+
+		vk_error = vkAllocateCommandBuffers(m_vk_logical_device, &command_buffer_allocate_info, &target.command_buffer);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to allocate Vulkan offscreen command buffer. VK error:" + std::to_string(vk_error) + ".";
+			destroyOffscreenTargets();
+			return false;
+		}
+
+		VkFenceCreateInfo fence_create_info{};
+		fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fence_create_info.pNext = nullptr;
+		fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		vk_error = vkCreateFence(m_vk_logical_device, &fence_create_info, m_host_allocator.getCallbacks(), &target.fence);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to create Vulkan offscreen fence. VK error:" + std::to_string(vk_error) + ".";
+			destroyOffscreenTargets();
+			return false;
+		}
+	}
+
+	if (!createDepthTarget({ width, height }, out_error_message)) {
+		destroyOffscreenTargets();
+		return false;
+	}
+
+	if (!createGpuProfiler(targets_count, out_error_message)) {
+		destroyOffscreenTargets();
+		return false;
+	}
+
+	return true;
+}
+
+std::vector<const char*> Renderer::getRequiredDeviceExtensions() const
+{
+	std::vector<const char*> extensions;
+
+	if (!m_headless) {
+		extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	}
+
+	return extensions;
+}
+
+VkDevice Renderer::getLogicalDevice() const
+{
+	return m_vk_logical_device;
+}
+
+DeviceQueue& Renderer::getGraphicsQueue()
+{
+	return m_graphics_queue;
+}
+
+DeviceQueue& Renderer::getPresentQueue()
+{
+	return m_present_queue;
+}
+
+DeviceQueue& Renderer::getComputeQueue()
+{
+	return m_compute_queue;
+}
+
+DeviceQueue& Renderer::getTransferQueue()
+{
+	return m_transfer_queue;
+}
+
+bool Renderer::createPipelineCache(const std::filesystem::path& file_path, std::string& out_error_message)
+{
+	if (m_vk_logical_device == VK_NULL_HANDLE) {
+		out_error_message = "Vulkan logical device not created.";
+		return false;
+	}
+
+	const DeviceCapabilities* capabilities = getDeviceCapabilities(m_vk_physical_device);
+	if (capabilities == nullptr) {
+		out_error_message = "Vulkan physical device capabilities not probed.";
+		return false;
+	}
+
+	return m_pipeline_cache.create(m_vk_logical_device, capabilities->getProperties(), file_path, m_host_allocator.getCallbacks(), out_error_message);
+}
+
+PipelineCache& Renderer::getPipelineCache()
+{
+	return m_pipeline_cache;
+}
+
+MemoryAllocator& Renderer::getMemoryAllocator()
+{
+	return m_memory_allocator;
+}
+
+StagingUploader& Renderer::getStagingUploader()
+{
+	return m_staging_uploader;
+}
+
+const HostAllocator& Renderer::getHostAllocator() const
+{
+	return m_host_allocator;
+}
+
+void Renderer::destroyOffscreenTargets()
+{
+	if (m_vk_logical_device == VK_NULL_HANDLE) {
+		m_offscreen_targets.clear();
+		return;
+	}
+
+	if (!m_offscreen_targets.empty()) {
+		vkDeviceWaitIdle(m_vk_logical_device);
+	}
+
+	for (OffscreenTarget& target : m_offscreen_targets) {
+		if (target.fence != VK_NULL_HANDLE) {
+			vkDestroyFence(m_vk_logical_device, target.fence, m_host_allocator.getCallbacks());
+		}
+
+		if (target.readback_buffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(m_vk_logical_device, target.readback_buffer, m_host_allocator.getCallbacks());
+		}
+
+		m_memory_allocator.free(target.readback_allocation);
+
+		if (target.image_view != VK_NULL_HANDLE) {
+			vkDestroyImageView(m_vk_logical_device, target.image_view, m_host_allocator.getCallbacks());
+		}
+
+		if (target.image != VK_NULL_HANDLE) {
+			vkDestroyImage(m_vk_logical_device, target.image, m_host_allocator.getCallbacks());
 		}
 
-		if (!found) {
+		m_memory_allocator.free(target.image_allocation);
+	}
+
+	m_offscreen_targets.clear();
+	destroyDepthTarget();
+	m_gpu_profiler.destroy();
+
+	if (m_vk_offscreen_command_pool != VK_NULL_HANDLE) {
+		vkDestroyCommandPool(m_vk_logical_device, m_vk_offscreen_command_pool, m_host_allocator.getCallbacks());
+		m_vk_offscreen_command_pool = VK_NULL_HANDLE;
+	}
+
+	m_offscreen_width = 0;
+	m_offscreen_height = 0;
+}
+
+bool Renderer::renderOffscreenFrame(uint64_t frame_number, double simulation_time, std::string& out_error_message)
+{
+	if (m_offscreen_targets.empty()) {
+		out_error_message = "Offscreen targets not created.";
+		return false;
+	}
+
+	uint64_t cpu_begin_us = m_gpu_profiler.getCpuTimestampUs();
+
+	uint32_t target_idx = static_cast<uint32_t>(frame_number % m_offscreen_targets.size());
+	OffscreenTarget& target = m_offscreen_targets[target_idx];
+
+	VkResult vk_error = vkWaitForFences(m_vk_logical_device, 1, &target.fence, VK_TRUE, UINT64_MAX);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to wait for Vulkan offscreen fence. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	vk_error = vkResetFences(m_vk_logical_device, 1, &target.fence);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to reset Vulkan offscreen fence. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	vk_error = vkResetCommandBuffer(target.command_buffer, 0);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to reset Vulkan offscreen command buffer. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	VkCommandBufferBeginInfo command_buffer_begin_info{};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.pNext = nullptr;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	command_buffer_begin_info.pInheritanceInfo = nullptr;
+
+	vk_error = vkBeginCommandBuffer(target.command_buffer, &command_buffer_begin_info);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to begin Vulkan offscreen command buffer. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	ParticleDrawMode draw_mode = getParticleDrawMode();
+	VkExtent2D extent{ m_offscreen_width, m_offscreen_height };
+
+	m_gpu_profiler.beginFrame(target.command_buffer, target_idx);
+	recordParticleUpdate(target.command_buffer, extent, draw_mode);
+
+	// A single offscreen command buffer per frame, so the draws are recorded inline instead of in secondary command buffers.
+	m_gpu_profiler.beginScope(target.command_buffer, "draw");
+	beginScenePass(target.command_buffer, target.image, target.image_view, extent, simulation_time, false);
+
+	if (m_particle_renderer.isCreated()) {
+		ParticleDrawParams params = getParticleDrawParams(extent);
+
+		if (draw_mode == ParticleDrawMode::GPU_DRIVEN) {
+			m_particle_renderer.recordIndirectDraws(target.command_buffer, m_particle_renderer.getParticlesCount(), params);
+		}
+		else {
+			m_particle_renderer.recordDraws(target.command_buffer, 0, m_particle_renderer.getParticlesCount(), params);
+		}
+	}
+
+	vkCmdEndRendering(target.command_buffer);
+
+	m_gpu_profiler.endScope(target.command_buffer);
+	m_gpu_profiler.beginScope(target.command_buffer, "readback copy");
+
+	VkImageMemoryBarrier image_barrier{};
+	image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_barrier.pNext = nullptr;
+	image_barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	image_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	image_barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	image_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.image = target.image;
+	image_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_barrier.subresourceRange.baseMipLevel = 0;
+	image_barrier.subresourceRange.levelCount = 1;
+	image_barrier.subresourceRange.baseArrayLayer = 0;
+	image_barrier.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(target.command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &image_barrier);
+
+	VkBufferImageCopy copy_region{};
+	copy_region.bufferOffset = 0;
+	copy_region.bufferRowLength = 0;
+	copy_region.bufferImageHeight = 0;
+	copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	copy_region.imageSubresource.mipLevel = 0;
+	copy_region.imageSubresource.baseArrayLayer = 0;
+	copy_region.imageSubresource.layerCount = 1;
+	copy_region.imageOffset = { 0, 0, 0 };
+	copy_region.imageExtent = { m_offscreen_width, m_offscreen_height, 1 };
+
+	vkCmdCopyImageToBuffer(target.command_buffer, target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target.readback_buffer, 1, &copy_region);
+
+	VkBufferMemoryBarrier buffer_barrier{};
+	buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	buffer_barrier.pNext = nullptr;
+	buffer_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	buffer_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barrier.buffer = target.readback_buffer;
+	buffer_barrier.offset = 0;
+	buffer_barrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(target.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+		0, 0, nullptr, 1, &buffer_barrier, 0, nullptr);
+
+	m_gpu_profiler.endScope(target.command_buffer);
+	m_gpu_profiler.endFrame(target.command_buffer);
+
+	vk_error = vkEndCommandBuffer(target.command_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to end Vulkan offscreen command buffer. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	std::vector<VkSemaphoreSubmitInfo> wait_semaphore_submit_infos;
+	if (!addUploadWait(wait_semaphore_submit_infos, out_error_message)) {
+		return false;
+	}
+
+	VkCommandBufferSubmitInfo command_buffer_submit_info{};
+	command_buffer_submit_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+	command_buffer_submit_info.pNext = nullptr;
+	command_buffer_submit_info.commandBuffer = target.command_buffer;
+	command_buffer_submit_info.deviceMask = 0;
+
+	VkSubmitInfo2 submit_info{};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+	submit_info.pNext = nullptr;
+	submit_info.flags = 0;
+	submit_info.waitSemaphoreInfoCount = static_cast<uint32_t>(wait_semaphore_submit_infos.size());
+	submit_info.pWaitSemaphoreInfos = wait_semaphore_submit_infos.data();
+	submit_info.commandBufferInfoCount = 1;
+	submit_info.pCommandBufferInfos = &command_buffer_submit_info;
+	submit_info.signalSemaphoreInfoCount = 0;
+	submit_info.pSignalSemaphoreInfos = nullptr;
+
+	vk_error = m_graphics_queue.submit2(1, &submit_info, target.fence);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to submit Vulkan offscreen frame. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	target.pending = true;
+	m_gpu_profiler.addCpuScope("renderOffscreenFrame", cpu_begin_us, m_gpu_profiler.getCpuTimestampUs(), 1);
+	return true;
+}
+
+bool Renderer::readOffscreenFrame(uint32_t target_idx, std::vector<uint8_t>& out_rgba_pixels, std::string& out_error_message)
+{
+	if (target_idx >= m_offscreen_targets.size()) {
+		out_error_message = "Invalid offscreen target index.";
+		return false;
+	}
+
+	OffscreenTarget& target = m_offscreen_targets[target_idx];
+
+	if (!target.pending) {
+		out_error_message = "No offscreen frame pending for readback.";
+		return false;
+	}
+
+	VkResult vk_error = vkWaitForFences(m_vk_logical_device, 1, &target.fence, VK_TRUE, UINT64_MAX);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to wait for Vulkan offscreen fence. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	size_t frame_size = static_cast<size_t>(m_offscreen_width) * m_offscreen_height * 4;
+	out_rgba_pixels.resize(frame_size);
+	memcpy(out_rgba_pixels.data(), target.readback_data, frame_size);
+
+	target.pending = false;
+	return true;
+}
+
+bool Renderer::isOffscreenFramePending(uint32_t target_idx) const
+{
+	return (target_idx < m_offscreen_targets.size()) && m_offscreen_targets[target_idx].pending;
+}
+
+uint32_t Renderer::getOffscreenTargetsCount() const
+{
+	return static_cast<uint32_t>(m_offscreen_targets.size());
+}
+
+uint32_t Renderer::getOffscreenWidth() const
+{
+	return m_offscreen_width;
+}
+
+uint32_t Renderer::getOffscreenHeight() const
+{
+	return m_offscreen_height;
+}
+
+bool Renderer::writeImageFile(const std::filesystem::path& file_path, uint32_t width, uint32_t height,
+	const std::vector<uint8_t>& rgba_pixels, std::string& out_error_message)
+{
+	if (rgba_pixels.size() < static_cast<size_t>(width) * height * 4) {
+		out_error_message = "Image data smaller than image size.";
+		return false;
+	}
+
+	std::ofstream file(file_path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if (!file.is_open()) {
+		out_error_message = "Failed to create image file \"" + file_path.string() + "\".";
+		return false;
+	}
+
+	file << "P6\n" << width << " " << height << "\n255\n";
+
+	std::vector<uint8_t> rgb_row(static_cast<size_t>(width) * 3);
+	for (uint32_t y = 0; y < height; y++) {
+		const uint8_t* rgba_row = rgba_pixels.data() + static_cast<size_t>(y) * width * 4;
+
+		for (uint32_t x = 0; x < width; x++) {
+			rgb_row[x * 3 + 0] = rgba_row[x * 4 + 0];
+			rgb_row[x * 3 + 1] = rgba_row[x * 4 + 1];
+			rgb_row[x * 3 + 2] = rgba_row[x * 4 + 2];
+		}
+
+		file.write(reinterpret_cast<const char*>(rgb_row.data()), rgb_row.size());
+	}
+
+	if (!file.good()) {
+		out_error_message = "Failed to write image file \"" + file_path.string() + "\".";
+		return false;
+	}
+
+	return true;
+}
+
+bool Renderer::createSwapchain(uint32_t width, uint32_t height, const SwapchainSettings& settings, std::string& out_error_message)
+{
+	if ((m_vk_logical_device == VK_NULL_HANDLE) || (m_vk_surface == VK_NULL_HANDLE)) {
+		out_error_message = "Vulkan logical device or surface not created.";
+		return false;
+	}
+
+	if (!m_frames.empty()) {
+		out_error_message = "Swapchain already created.";
+		return false;
+	}
+
+	if ((settings.images_count == 0) || (settings.frames_in_flight_count == 0)) {
+		out_error_message = "Invalid swapchain images or frames in flight count.";
+		return false;
+	}
+
+	m_swapchain_settings = settings;
+	m_swapchain_width = width;
+	m_swapchain_height = height;
+	m_frame_number = 0;
+
+	if (!createFrameResources(settings.frames_in_flight_count, out_error_message)) {
+		return false;
+	}
+
+	if ((width == 0) || (height == 0)) {
+		return true;
+	}
+
+	return rebuildSwapchain(out_error_message);
+}
+
+bool Renderer::resizeSwapchain(uint32_t width, uint32_t height, std::string& out_error_message)
+{
+	if (m_frames.empty()) {
+		return true;
+	}
+
+	m_swapchain_width = width;
+	m_swapchain_height = height;
+
+	if ((width == 0) || (height == 0)) {
+		return true;
+	}
+
+	VkExtent2D extent = m_swapchain.getExtent();
+	if (m_swapchain.isCreated() && (extent.width == width) && (extent.height == height)) {
+		return true;
+	}
+
+	return rebuildSwapchain(out_error_message);
+}
+
+bool Renderer::renderFrame(double simulation_time, std::string& out_error_message)
+{
+	if (!m_swapchain.isCreated() || (m_swapchain_width == 0) || (m_swapchain_height == 0)) {
+		return true;
+	}
+
+	uint64_t cpu_begin_us = m_gpu_profiler.getCpuTimestampUs();
+	FrameResources& frame = m_frames[m_frame_number % m_frames.size()];
+
+	VkResult vk_error = vkWaitForFences(m_vk_logical_device, 1, &frame.fence, VK_TRUE, UINT64_MAX);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to wait for Vulkan frame fence. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	uint32_t image_idx;
+	VkResult acquire_result = m_swapchain.acquireNextImage(frame.image_available_semaphore, image_idx);
+	if (acquire_result == VK_ERROR_OUT_OF_DATE_KHR) {
+		return rebuildSwapchain(out_error_message);
+	}
+
+	if ((acquire_result != VK_SUCCESS) && (acquire_result != VK_SUBOPTIMAL_KHR)) {
+		out_error_message = "Failed to acquire Vulkan swapchain image. VK error:" + std::to_string(acquire_result) + ".";
+		return false;
+	}
+
+	vk_error = vkResetFences(m_vk_logical_device, 1, &frame.fence);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to reset Vulkan frame fence. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	if (!recordFrame(frame, image_idx, simulation_time, out_error_message)) {
+		return false;
+	}
+
+	VkSemaphoreSubmitInfo semaphore_submit_info{};
+	semaphore_submit_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+	semaphore_submit_info.pNext = nullptr;
+	semaphore_submit_info.semaphore = frame.image_available_semaphore;
+	semaphore_submit_info.value = 0;
+	semaphore_submit_info.stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+	semaphore_submit_info.deviceIndex = 0;
+
+	std::vector<VkSemaphoreSubmitInfo> wait_semaphore_submit_infos{ semaphore_submit_info };
+	if (!addUploadWait(wait_semaphore_submit_infos, out_error_message)) {
+		return false;
+	}
+
+	VkSemaphoreSubmitInfo signal_semaphore_submit_info = semaphore_submit_info;
+	signal_semaphore_submit_info.semaphore = m_swapchain.getRenderFinishedSemaphore(image_idx);
+	signal_semaphore_submit_info.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+	VkCommandBufferSubmitInfo command_buffer_submit_info{};
+	command_buffer_submit_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+	command_buffer_submit_info.pNext = nullptr;
+	command_buffer_submit_info.commandBuffer = frame.command_buffer;
+	command_buffer_submit_info.deviceMask = 0;
+
+	VkSubmitInfo2 submit_info{};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+	submit_info.pNext = nullptr;
+	submit_info.flags = 0;
+	submit_info.waitSemaphoreInfoCount = static_cast<uint32_t>(wait_semaphore_submit_infos.size());
+	submit_info.pWaitSemaphoreInfos = wait_semaphore_submit_infos.data();
+	submit_info.commandBufferInfoCount = 1;
+	submit_info.pCommandBufferInfos = &command_buffer_submit_info;
+	submit_info.signalSemaphoreInfoCount = 1;
+	submit_info.pSignalSemaphoreInfos = &signal_semaphore_submit_info;
+
+	vk_error = m_graphics_queue.submit2(1, &submit_info, frame.fence);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to submit Vulkan frame. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	m_frame_number++;
+	m_frame_upload_ring.nextFrame();
+	m_gpu_profiler.addCpuScope("renderFrame", cpu_begin_us, m_gpu_profiler.getCpuTimestampUs(), 1);
+
+	vk_error = m_swapchain.present(m_present_queue, image_idx);
+	if ((vk_error == VK_ERROR_OUT_OF_DATE_KHR) || (vk_error == VK_SUBOPTIMAL_KHR) || (acquire_result == VK_SUBOPTIMAL_KHR)) {
+		return rebuildSwapchain(out_error_message);
+	}
+
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to present Vulkan swapchain image. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	return true;
+}
+
+const Swapchain& Renderer::getSwapchain() const
+{
+	return m_swapchain;
+}
+
+uint32_t Renderer::getFramesInFlightCount() const
+{
+	return static_cast<uint32_t>(m_frames.size());
+}
+
+uint64_t Renderer::getSwapchainRebuildsCount() const
+{
+	return m_swapchain_rebuilds_count;
+}
+
+MemoryRing& Renderer::getFrameUploadRing()
+{
+	return m_frame_upload_ring;
+}
+
+GpuProfiler& Renderer::getGpuProfiler()
+{
+	return m_gpu_profiler;
+}
+
+bool Renderer::createParticles(const World& world, std::string& out_error_message)
+{
+	if (m_vk_logical_device == VK_NULL_HANDLE) {
+		out_error_message = "Vulkan logical device not created.";
+		return false;
+	}
+
+	std::vector<uint32_t> queue_family_indices{ m_graphics_queue.getFamilyIndex(), m_transfer_queue.getFamilyIndex() };
+	if (!m_particle_compute.create(m_vk_logical_device, m_memory_allocator, m_pipeline_cache, queue_family_indices,
+		static_cast<uint32_t>(world.getBodiesCount()), out_error_message)) {
+		return false;
+	}
+
+	if (!m_particle_compute.upload(world, m_staging_uploader, out_error_message)) {
+		m_particle_compute.destroy();
+		return false;
+	}
+
+	VkFormat color_format = m_swapchain.isCreated() ? m_swapchain.getFormat() : OFFSCREEN_FORMAT;
+	if (!m_particle_renderer.create(m_vk_logical_device, m_memory_allocator, m_pipeline_cache, m_staging_uploader, queue_family_indices,
+		m_particle_compute, color_format, m_depth_format, m_gpu_driven_drawing_supported, out_error_message)) {
+		m_particle_compute.destroy();
+		return false;
+	}
+
+	m_pending_particle_steps_count = 0;
+	return true;
+}
+
+void Renderer::queueParticleSteps(uint32_t steps_count, const ParticleStepParams& params)
+{
+	if (!m_particle_compute.isCreated()) {
+		return;
+	}
+
+	m_pending_particle_steps_count += steps_count;
+	m_particle_step_params = params;
+}
+
+bool Renderer::runParticleSteps(uint32_t steps_count, const ParticleStepParams& params, std::vector<GpuParticle>& out_particles,
+	std::string& out_error_message)
+{
+	if (!m_particle_compute.isCreated()) {
+		out_error_message = "Particles not created.";
+		return false;
+	}
+
+	VkCommandPool vk_command_pool = VK_NULL_HANDLE;
+	VkFence vk_fence = VK_NULL_HANDLE;
+	VkBuffer vk_readback_buffer = VK_NULL_HANDLE;
+	MemoryAllocation readback_allocation;
+
+	auto destroyResources = [&]()
+	{
+		if (vk_readback_buffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(m_vk_logical_device, vk_readback_buffer, m_host_allocator.getCallbacks());
+		}
+
+		m_memory_allocator.free(readback_allocation);
+
+		if (vk_fence != VK_NULL_HANDLE) {
+			vkDestroyFence(m_vk_logical_device, vk_fence, m_host_allocator.getCallbacks());
+		}
+
+		if (vk_command_pool != VK_NULL_HANDLE) {
+			vkDestroyCommandPool(m_vk_logical_device, vk_command_pool, m_host_allocator.getCallbacks());
+		}
+	};
+
+	VkBufferCreateInfo buffer_create_info{};
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.pNext = nullptr;
+	buffer_create_info.flags = 0;
+	buffer_create_info.size = m_particle_compute.getParticlesBufferSize();
+	buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	buffer_create_info.queueFamilyIndexCount = 0;
+	buffer_create_info.pQueueFamilyIndices = nullptr;
+
+	VkResult vk_error = vkCreateBuffer(m_vk_logical_device, &buffer_create_info, m_host_allocator.getCallbacks(), &vk_readback_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles readback buffer. VK error:" + std::to_string(vk_error) + ".";
+		vk_readback_buffer = VK_NULL_HANDLE;
+		destroyResources();
+		return false;
+	}
+
+	if (!m_memory_allocator.allocateForBuffer(vk_readback_buffer, MemoryUsage::READBACK, false, readback_allocation, out_error_message)) {
+		out_error_message = "Failed to allocate Vulkan particles readback memory. " + out_error_message;
+		destroyResources();
+		return false;
+	}
+
+	VkCommandPoolCreateInfo command_pool_create_info{};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.pNext = nullptr;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	command_pool_create_info.queueFamilyIndex = m_graphics_queue.getFamilyIndex();
+
+	vk_error = vkCreateCommandPool(m_vk_logical_device, &command_pool_create_info, m_host_allocator.getCallbacks(), &vk_command_pool);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles command pool. VK error:" + std::to_string(vk_error) + ".";
+		vk_command_pool = VK_NULL_HANDLE;
+		destroyResources();
+		return false;
+	}
+
+	VkCommandBufferAllocateInfo command_buffer_allocate_info{};
+	command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	command_buffer_allocate_info.pNext = nullptr;
+	command_buffer_allocate_info.commandPool = vk_command_pool;
+	command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	command_buffer_allocate_info.commandBufferCount = 1;
+
+	VkCommandBuffer vk_command_buffer;
+	vk_error = vkAllocateCommandBuffers(m_vk_logical_device, &command_buffer_allocate_info, &vk_command_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to allocate Vulkan particles command buffer. VK error:" + std::to_string(vk_error) + ".";
+		destroyResources();
+		return false;
+	}
+
+	VkFenceCreateInfo fence_create_info{};
+	fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fence_create_info.pNext = nullptr;
+	fence_create_info.flags = 0;
+
+	vk_error = vkCreateFence(m_vk_logical_device, &fence_create_info, m_host_allocator.getCallbacks(), &vk_fence);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan particles fence. VK error:" + std::to_string(vk_error) + ".";
+		vk_fence = VK_NULL_HANDLE;
+		destroyResources();
+		return false;
+	}
+
+	/**************************************************************************************/
+
+	VkCommandBufferBeginInfo command_buffer_begin_info{};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.pNext = nullptr;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	command_buffer_begin_info.pInheritanceInfo = nullptr;
+
+	vk_error = vkBeginCommandBuffer(vk_command_buffer, &command_buffer_begin_info);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to begin Vulkan particles command buffer. VK error:" + std::to_string(vk_error) + ".";
+		destroyResources();
+		return false;
+	}
+
+	m_particle_compute.recordSteps(vk_command_buffer, steps_count, params);
+
+	VkBufferCopy copy_region{};
+	copy_region.srcOffset = 0;
+	copy_region.dstOffset = 0;
+	copy_region.size = m_particle_compute.getParticlesBufferSize();
+
+	vkCmdCopyBuffer(vk_command_buffer, m_particle_compute.getParticlesBuffer(), vk_readback_buffer, 1, &copy_region);
+
+	VkBufferMemoryBarrier buffer_barrier{};
+	buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	buffer_barrier.pNext = nullptr;
+	buffer_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	buffer_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barrier.buffer = vk_readback_buffer;
+	buffer_barrier.offset = 0;
+	buffer_barrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &buffer_barrier, 0, nullptr);
+
+	vk_error = vkEndCommandBuffer(vk_command_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to end Vulkan particles command buffer. VK error:" + std::to_string(vk_error) + ".";
+		destroyResources();
+		return false;
+	}
+
+	std::vector<VkSemaphoreSubmitInfo> wait_semaphore_submit_infos;
+	if (!addUploadWait(wait_semaphore_submit_infos, out_error_message)) {
+		destroyResources();
+		return false;
+	}
+
+	VkCommandBufferSubmitInfo command_buffer_submit_info{};
+	command_buffer_submit_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+	command_buffer_submit_info.pNext = nullptr;
+	command_buffer_submit_info.commandBuffer = vk_command_buffer;
+	command_buffer_submit_info.deviceMask = 0;
+
+	VkSubmitInfo2 submit_info{};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+	submit_info.pNext = nullptr;
+	submit_info.flags = 0;
+	submit_info.waitSemaphoreInfoCount = static_cast<uint32_t>(wait_semaphore_submit_infos.size());
+	submit_info.pWaitSemaphoreInfos = wait_semaphore_submit_infos.data();
+	submit_info.commandBufferInfoCount = 1;
+	submit_info.pCommandBufferInfos = &command_buffer_submit_info;
+	submit_info.signalSemaphoreInfoCount = 0;
+	submit_info.pSignalSemaphoreInfos = nullptr;
+
+	vk_error = m_graphics_queue.submit2(1, &submit_info, vk_fence);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to submit Vulkan particles steps. VK error:" + std::to_string(vk_error) + ".";
+		destroyResources();
+		return false;
+	}
+
+	vk_error = vkWaitForFences(m_vk_logical_device, 1, &vk_fence, VK_TRUE, UINT64_MAX);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to wait for Vulkan particles fence. VK error:" + std::to_string(vk_error) + ".";
+		destroyResources();
+		return false;
+	}
+
+	out_particles.resize(m_particle_compute.getParticlesCount());
+	memcpy(out_particles.data(), readback_allocation.mapped_data, static_cast<size_t>(m_particle_compute.getParticlesBufferSize()));
+
+	destroyResources();
+	return true;
+}
+
+const ParticleCompute& Renderer::getParticleCompute() const
+{
+	return m_particle_compute;
+}
+
+const ParticleRenderer& Renderer::getParticleRenderer() const
+{
+	return m_particle_renderer;
+}
+
+bool Renderer::isGpuDrivenDrawingSupported() const
+{
+	return m_gpu_driven_drawing_supported;
+}
+
+void Renderer::setParticleDrawMode(ParticleDrawMode draw_mode)
+{
+	m_particle_draw_mode = draw_mode;
+}
+
+ParticleDrawMode Renderer::getParticleDrawMode() const
+{
+	if ((m_particle_draw_mode != ParticleDrawMode::GPU_DRIVEN) || !m_gpu_driven_drawing_supported) {
+		return ParticleDrawMode::CPU_RECORDED;
+	}
+
+	// A single indirect count draw issues at most maxDrawIndirectCount draws, the rest of the particles would be silently dropped.
+	const DeviceCapabilities* capabilities = getDeviceCapabilities(m_vk_physical_device);
+	if ((capabilities != nullptr) && (m_particle_renderer.getParticlesCount() > capabilities->getProperties().limits.maxDrawIndirectCount)) {
+		return ParticleDrawMode::CPU_RECORDED;
+	}
+
+	return ParticleDrawMode::GPU_DRIVEN;
+}
+
+bool Renderer::recordParticleDraws(CommandRecorder& recorder, JobSystem* job_system, uint32_t draws_count, VkExtent2D extent, ParticleDrawMode draw_mode,
+	std::vector<VkCommandBuffer>& out_command_buffers, std::string& out_error_message)
+{
+	if (!m_particle_renderer.isCreated()) {
+		out_error_message = "Particles not created.";
+		return false;
+	}
+
+	if ((draw_mode == ParticleDrawMode::GPU_DRIVEN) && !m_particle_renderer.isGpuDriven()) {
+		out_error_message = "GPU driven drawing not supported.";
+		return false;
+	}
+
+	VkFormat color_format = m_particle_renderer.getColorFormat();
+	uint32_t max_draw_indirect_count = getDeviceCapabilities(m_vk_physical_device)->getProperties().limits.maxDrawIndirectCount;
+
+	if ((draw_mode == ParticleDrawMode::GPU_DRIVEN) && (draws_count > max_draw_indirect_count)) {
+		out_error_message = std::to_string(draws_count) + " GPU driven draws exceed the maximum indirect draw count " +
+			std::to_string(max_draw_indirect_count) + ".";
+		return false;
+	}
+
+	VkCommandBufferInheritanceRenderingInfo inheritance_rendering_info{};
+	inheritance_rendering_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+	inheritance_rendering_info.pNext = nullptr;
+	inheritance_rendering_info.flags = 0;
+	inheritance_rendering_info.viewMask = 0;
+	inheritance_rendering_info.colorAttachmentCount = 1;
+	inheritance_rendering_info.pColorAttachmentFormats = &color_format;
+	inheritance_rendering_info.depthAttachmentFormat = m_particle_renderer.getDepthFormat();
+	inheritance_rendering_info.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+	inheritance_rendering_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkCommandBufferInheritanceInfo inheritance_info{};
+	inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance_info.pNext = &inheritance_rendering_info;
+	inheritance_info.renderPass = VK_NULL_HANDLE;
+	inheritance_info.subpass = 0;
+	inheritance_info.framebuffer = VK_NULL_HANDLE;
+	inheritance_info.occlusionQueryEnable = VK_FALSE;
+	inheritance_info.queryFlags = 0;
+	inheritance_info.pipelineStatistics = 0;
+
+	ParticleDrawParams params = getParticleDrawParams(extent);
+
+	// A single indirect draw covers every particle, its recording cost does not depend on the particles count.
+	if (draw_mode == ParticleDrawMode::GPU_DRIVEN) {
+		return recorder.record(nullptr, 1, 1, inheritance_info, [this, &params, draws_count](VkCommandBuffer command_buffer, uint32_t, uint32_t)
+			{
+				m_particle_renderer.recordIndirectDraws(command_buffer, draws_count, params);
+			},
+			out_command_buffers, out_error_message);
+	}
+
+	return recorder.record(job_system, draws_count, ParticleRenderer::MIN_DRAWS_PER_COMMAND_BUFFER, inheritance_info,
+		[this, &params](VkCommandBuffer command_buffer, uint32_t begin, uint32_t end)
+		{
+			m_particle_renderer.recordDraws(command_buffer, begin, end, params);
+		},
+		out_command_buffers, out_error_message);
+}
+
+CommandRecorderStats Renderer::getCommandRecorderStats() const
+{
+	return m_command_recorder.getStats();
+}
+
+ParticleDrawParams Renderer::getParticleDrawParams(VkExtent2D extent) const
+{
+	ParticleDrawParams params;
+	params.extent = extent;
+	ParticleRenderer::getViewProjection(static_cast<float>(extent.width) / std::max(extent.height, 1u), params.view_projection);
+	return params;
+}
+
+bool Renderer::createFrameResources(uint32_t frames_count, std::string& out_error_message)
+{
+	m_frames.resize(frames_count);
+
+	for (FrameResources& frame : m_frames) {
+		VkCommandPoolCreateInfo command_pool_create_info{};
+		command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		command_pool_create_info.pNext = nullptr;
+		command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		command_pool_create_info.queueFamilyIndex = m_graphics_queue.getFamilyIndex();
+
+		VkResult vk_error = vkCreateCommandPool(m_vk_logical_device, &command_pool_create_info, m_host_allocator.getCallbacks(), &frame.command_pool);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to create Vulkan frame command pool. VK error:" + std::to_string(vk_error) + ".";
+			destroyFrameResources();
+			return false;
+		}
+
+		VkCommandBufferAllocateInfo command_buffer_allocate_info{};
+		command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_allocate_info.pNext = nullptr;
+		command_buffer_allocate_info.commandPool = frame.command_pool;
+		command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		command_buffer_allocate_info.commandBufferCount = 1;
+
+		vk_error = vkAllocateCommandBuffers(m_vk_logical_device, &command_buffer_allocate_info, &frame.command_buffer);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to allocate Vulkan frame command buffer. VK error:" + std::to_string(vk_error) + ".";
+			destroyFrameResources();
+			return false;
+		}
+
+		VkFenceCreateInfo fence_create_info{};
+		fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fence_create_info.pNext = nullptr;
+		fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		vk_error = vkCreateFence(m_vk_logical_device, &fence_create_info, m_host_allocator.getCallbacks(), &frame.fence);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to create Vulkan frame fence. VK error:" + std::to_string(vk_error) + ".";
+			destroyFrameResources();
+			return false;
+		}
+
+		VkSemaphoreCreateInfo semaphore_create_info{};
+		semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphore_create_info.pNext = nullptr;
+		semaphore_create_info.flags = 0;
+
+		vk_error = vkCreateSemaphore(m_vk_logical_device, &semaphore_create_info, m_host_allocator.getCallbacks(), &frame.image_available_semaphore);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to create Vulkan frame semaphore. VK error:" + std::to_string(vk_error) + ".";
+			destroyFrameResources();
+			return false;
+		}
+	}
+
+	if (!m_frame_upload_ring.create(m_memory_allocator, m_vk_logical_device, FRAME_UPLOAD_RING_SIZE,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		frames_count, out_error_message)) {
+		destroyFrameResources();
+		return false;
+	}
+
+	if (!createGpuProfiler(frames_count, out_error_message)) {
+		destroyFrameResources();
+		return false;
+	}
+
+	uint32_t threads_count = (m_job_system != nullptr) ? m_job_system->getThreadsCount() : 1;
+	if (!m_command_recorder.create(m_vk_logical_device, m_graphics_queue.getFamilyIndex(), frames_count, threads_count, m_host_allocator.getCallbacks(),
+		out_error_message)) {
+		destroyFrameResources();
+		return false;
+	}
+
+	return true;
+}
+
+void Renderer::destroyFrameResources()
+{
+	if (m_vk_logical_device == VK_NULL_HANDLE) {
+		m_frames.clear();
+		return;
+	}
+
+	if (!m_frames.empty()) {
+		vkDeviceWaitIdle(m_vk_logical_device);
+	}
+
+	for (FrameResources& frame : m_frames) {
+		if (frame.image_available_semaphore != VK_NULL_HANDLE) {
+			vkDestroySemaphore(m_vk_logical_device, frame.image_available_semaphore, m_host_allocator.getCallbacks());
+		}
+
+		if (frame.fence != VK_NULL_HANDLE) {
+			vkDestroyFence(m_vk_logical_device, frame.fence, m_host_allocator.getCallbacks());
+		}
+
+		if (frame.command_pool != VK_NULL_HANDLE) {
+			vkDestroyCommandPool(m_vk_logical_device, frame.command_pool, m_host_allocator.getCallbacks());
+		}
+	}
+
+	m_command_recorder.destroy();
+	m_secondary_command_buffers.clear();
+	m_frame_upload_ring.destroy();
+	m_gpu_profiler.destroy();
+	m_frames.clear();
+	m_frame_number = 0;
+}
+
+bool Renderer::createGpuProfiler(uint32_t frame_slots_count, std::string& out_error_message)
+{
+	const DeviceCapabilities* capabilities = getDeviceCapabilities(m_vk_physical_device);
+	if (capabilities == nullptr) {
+		out_error_message = "Vulkan physical device capabilities not probed.";
+		return false;
+	}
+
+	const std::vector<VkQueueFamilyProperties>& queue_families = capabilities->getQueueFamilies();
+	uint32_t timestamp_valid_bits = (m_graphics_queue.getFamilyIndex() < queue_families.size()) ?
+		queue_families[m_graphics_queue.getFamilyIndex()].timestampValidBits : 0;
+
+	return m_gpu_profiler.create(m_vk_logical_device, capabilities->getProperties().limits.timestampPeriod, timestamp_valid_bits,
+		m_calibrated_timestamps_supported, frame_slots_count, m_host_allocator.getCallbacks(), out_error_message);
+}
+
+bool Renderer::addUploadWait(std::vector<VkSemaphoreSubmitInfo>& wait_semaphore_submit_infos, std::string& out_error_message)
+{
+	uint64_t upload_timeline_value;
+	if (!m_staging_uploader.flush(upload_timeline_value, out_error_message)) {
+		return false;
+	}
+
+	if (upload_timeline_value == 0) {
+		return true;
+	}
+
+	VkSemaphoreSubmitInfo semaphore_submit_info{};
+	semaphore_submit_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+	semaphore_submit_info.pNext = nullptr;
+	semaphore_submit_info.semaphore = m_staging_uploader.getTimelineSemaphore();
+	semaphore_submit_info.value = upload_timeline_value;
+	semaphore_submit_info.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+	semaphore_submit_info.deviceIndex = 0;
+
+	wait_semaphore_submit_infos.push_back(semaphore_submit_info);
+	return true;
+}
+
+bool Renderer::rebuildSwapchain(std::string& out_error_message)
+{
+	VkResult vk_error = vkDeviceWaitIdle(m_vk_logical_device);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to wait for Vulkan device idle. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	std::vector<uint32_t> queue_family_indices{ m_graphics_queue.getFamilyIndex() };
+	if (m_present_queue.getFamilyIndex() != m_graphics_queue.getFamilyIndex()) {
+		queue_family_indices.push_back(m_present_queue.getFamilyIndex());
+	}
+
+	if (!m_swapchain.create(m_vk_physical_device, m_vk_logical_device, m_vk_surface, queue_family_indices, m_swapchain_width, m_swapchain_height,
+		m_swapchain_settings.present_mode, m_swapchain_settings.images_count, m_host_allocator.getCallbacks(), out_error_message)) {
+		return false;
+	}
+
+	if (!createDepthTarget(m_swapchain.getExtent(), out_error_message)) {
+		return false;
+	}
+
+	if (!m_particle_renderer.setColorFormat(m_swapchain.getFormat(), m_pipeline_cache, out_error_message)) {
+		return false;
+	}
+
+	m_swapchain_rebuilds_count++;
+	return true;
+}
+
+VkFormat Renderer::findDepthFormat(VkPhysicalDevice physical_device)
+{
+	for (VkFormat format : DEPTH_FORMAT_CANDIDATES) {
+		VkFormatProperties format_properties;
+		vkGetPhysicalDeviceFormatProperties(physical_device, format, &format_properties);
+
+		if (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+			return format;
+		}
+	}
+
+	// Depth attachment support of D16 is required by the specification.
+	return VK_FORMAT_D16_UNORM;
+}
+
+bool Renderer::createDepthTarget(VkExtent2D extent, std::string& out_error_message)
+{
+	destroyDepthTarget();
+
+	VkImageCreateInfo image_create_info{};
+	image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	image_create_info.pNext = nullptr;
+	image_create_info.flags = 0;
+	image_create_info.imageType = VK_IMAGE_TYPE_2D;
+	image_create_info.format = m_depth_format;
+	image_create_info.extent = { extent.width, extent.height, 1 };
+	image_create_info.mipLevels = 1;
+	image_create_info.arrayLayers = 1;
+	image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+	image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	image_create_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	image_create_info.queueFamilyIndexCount = 0;
+	image_create_info.pQueueFamilyIndices = nullptr;
+	image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VkResult vk_error = vkCreateImage(m_vk_logical_device, &image_create_info, m_host_allocator.getCallbacks(), &m_vk_depth_image);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan depth image. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_depth_image = VK_NULL_HANDLE;
+		return false;
+	}
+
+	if (!m_memory_allocator.allocateForImage(m_vk_depth_image, MemoryUsage::GPU_ONLY, false, m_depth_image_allocation, out_error_message)) {
+		out_error_message = "Failed to allocate Vulkan depth image memory. " + out_error_message;
+		destroyDepthTarget();
+		return false;
+	}
+
+	VkImageViewCreateInfo image_view_create_info{};
+	image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	image_view_create_info.pNext = nullptr;
+	image_view_create_info.flags = 0;
+	image_view_create_info.image = m_vk_depth_image;
+	image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	image_view_create_info.format = m_depth_format;
+	image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+	image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	image_view_create_info.subresourceRange.baseMipLevel = 0;
+	image_view_create_info.subresourceRange.levelCount = 1;
+	image_view_create_info.subresourceRange.baseArrayLayer = 0;
+	image_view_create_info.subresourceRange.layerCount = 1;
+
+	vk_error = vkCreateImageView(m_vk_logical_device, &image_view_create_info, m_host_allocator.getCallbacks(), &m_vk_depth_image_view);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan depth image view. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_depth_image_view = VK_NULL_HANDLE;
+		destroyDepthTarget();
+		return false;
+	}
+
+	return true;
+}
+
+void Renderer::destroyDepthTarget()
+{
+	if (m_vk_logical_device == VK_NULL_HANDLE) {
+		return;
+	}
+
+	if (m_vk_depth_image_view != VK_NULL_HANDLE) {
+		vkDestroyImageView(m_vk_logical_device, m_vk_depth_image_view, m_host_allocator.getCallbacks());
+		m_vk_depth_image_view = VK_NULL_HANDLE;
+	}
+
+	if (m_vk_depth_image != VK_NULL_HANDLE) {
+		vkDestroyImage(m_vk_logical_device, m_vk_depth_image, m_host_allocator.getCallbacks());
+		m_vk_depth_image = VK_NULL_HANDLE;
+	}
+
+	m_memory_allocator.free(m_depth_image_allocation);
+}
+
+void Renderer::recordParticleUpdate(VkCommandBuffer command_buffer, VkExtent2D extent, ParticleDrawMode draw_mode)
+{
+	if (m_pending_particle_steps_count > 0) {
+		m_gpu_profiler.beginScope(command_buffer, "particles");
+		m_particle_compute.recordSteps(command_buffer, m_pending_particle_steps_count, m_particle_step_params);
+		m_gpu_profiler.endScope(command_buffer);
+		m_pending_particle_steps_count = 0;
+	}
+
+	if (m_particle_renderer.isCreated() && (draw_mode == ParticleDrawMode::GPU_DRIVEN)) {
+		m_gpu_profiler.beginScope(command_buffer, "cull");
+		m_particle_renderer.recordCulling(command_buffer, getParticleDrawParams(extent));
+		m_gpu_profiler.endScope(command_buffer);
+	}
+}
+
+void Renderer::beginScenePass(VkCommandBuffer command_buffer, VkImage color_image, VkImageView color_image_view, VkExtent2D extent, double simulation_time,
+	bool secondary_contents)
+{
+	VkImageSubresourceRange subresource_range{};
+	subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresource_range.baseMipLevel = 0;
+	subresource_range.levelCount = 1;
+	subresource_range.baseArrayLayer = 0;
+	subresource_range.layerCount = 1;
+
+	VkImageMemoryBarrier image_barrier{};
+	image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_barrier.pNext = nullptr;
+	image_barrier.srcAccessMask = 0;
+	image_barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	image_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	image_barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.image = color_image;
+	image_barrier.subresourceRange = subresource_range;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &image_barrier);
+
+	// One depth image serves every frame in flight. The previous frame's clear and depth writes happen in both the early and the late
+	// fragment tests, so both stages have to finish before this frame clears it again.
+	VkImageMemoryBarrier depth_image_barrier{};
+	depth_image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	depth_image_barrier.pNext = nullptr;
+	depth_image_barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	depth_image_barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	depth_image_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depth_image_barrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depth_image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	depth_image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	depth_image_barrier.image = m_vk_depth_image;
+	depth_image_barrier.subresourceRange = subresource_range;
+	depth_image_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 0, 0, nullptr, 0, nullptr, 1, &depth_image_barrier);
+
+	// Follows the simulation clock, so the animation speed does not depend on the frame rate.
+	float phase = static_cast<float>(std::fmod(simulation_time, CLEAR_COLOR_PERIOD) / CLEAR_COLOR_PERIOD);
+
+	VkClearColorValue clear_color{};
+	clear_color.float32[0] = phase;
+	clear_color.float32[1] = 1.0f - phase;
+	clear_color.float32[2] = 0.5f;
+	clear_color.float32[3] = 1.0f;
+
+	VkRenderingAttachmentInfo color_attachment_info{};
+	color_attachment_info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	color_attachment_info.pNext = nullptr;
+	color_attachment_info.imageView = color_image_view;
+	color_attachment_info.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	color_attachment_info.resolveMode = VK_RESOLVE_MODE_NONE;
+	color_attachment_info.resolveImageView = VK_NULL_HANDLE;
+	color_attachment_info.resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	color_attachment_info.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	color_attachment_info.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	color_attachment_info.clearValue.color = clear_color;
+
+	VkRenderingAttachmentInfo depth_attachment_info{};
+	depth_attachment_info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	depth_attachment_info.pNext = nullptr;
+	depth_attachment_info.imageView = m_vk_depth_image_view;
+	depth_attachment_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depth_attachment_info.resolveMode = VK_RESOLVE_MODE_NONE;
+	depth_attachment_info.resolveImageView = VK_NULL_HANDLE;
+	depth_attachment_info.resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depth_attachment_info.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depth_attachment_info.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depth_attachment_info.clearValue.depthStencil = { 1.0f, 0 };
+
+	// With secondary contents the primary buffer may only execute the secondary ones until the rendering ends.
+	VkRenderingInfo rendering_info{};
+	rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+	rendering_info.pNext = nullptr;
+	rendering_info.flags = secondary_contents ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+	rendering_info.renderArea.offset = { 0, 0 };
+	rendering_info.renderArea.extent = extent;
+	rendering_info.layerCount = 1;
+	rendering_info.viewMask = 0;
+	rendering_info.colorAttachmentCount = 1;
+	rendering_info.pColorAttachments = &color_attachment_info;
+	rendering_info.pDepthAttachment = &depth_attachment_info;
+	rendering_info.pStencilAttachment = nullptr;
+
+	vkCmdBeginRendering(command_buffer, &rendering_info);
+}
+
+bool Renderer::recordFrame(const FrameResources& frame, uint32_t image_idx, double simulation_time, std::string& out_error_message)
+{
+	VkResult vk_error = vkResetCommandPool(m_vk_logical_device, frame.command_pool, 0);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to reset Vulkan frame command pool. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	// The frame fence also covers the secondary buffers recorded for this frame slot.
+	if (!m_command_recorder.beginFrame(static_cast<uint32_t>(m_frame_number % m_frames.size()), out_error_message)) {
+		return false;
+	}
+
+	ParticleDrawMode draw_mode = getParticleDrawMode();
+
+	m_secondary_command_buffers.clear();
+	if (m_particle_renderer.isCreated()) {
+		SIMULATOR_SCOPE_TIMER("renderer record draws");
+
+		if (!recordParticleDraws(m_command_recorder, m_job_system, m_particle_renderer.getParticlesCount(), m_swapchain.getExtent(), draw_mode,
+			m_secondary_command_buffers, out_error_message)) {
+			return false;
+		}
+	}
+
+	VkCommandBufferBeginInfo command_buffer_begin_info{};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.pNext = nullptr;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	command_buffer_begin_info.pInheritanceInfo = nullptr;
+
+	vk_error = vkBeginCommandBuffer(frame.command_buffer, &command_buffer_begin_info);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to begin Vulkan frame command buffer. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	m_gpu_profiler.beginFrame(frame.command_buffer, static_cast<uint32_t>(m_frame_number % m_frames.size()));
+	recordParticleUpdate(frame.command_buffer, m_swapchain.getExtent(), draw_mode);
+
+	m_gpu_profiler.beginScope(frame.command_buffer, "draw");
+	beginScenePass(frame.command_buffer, m_swapchain.getImage(image_idx), m_swapchain.getImageView(image_idx), m_swapchain.getExtent(), simulation_time,
+		!m_secondary_command_buffers.empty());
+
+	if (!m_secondary_command_buffers.empty()) {
+		vkCmdExecuteCommands(frame.command_buffer, static_cast<uint32_t>(m_secondary_command_buffers.size()), m_secondary_command_buffers.data());
+	}
+
+	vkCmdEndRendering(frame.command_buffer);
+
+	m_gpu_profiler.endScope(frame.command_buffer);
+
+	VkImageMemoryBarrier image_barrier{};
+	image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_barrier.pNext = nullptr;
+	image_barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	image_barrier.dstAccessMask = 0;
+	image_barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	image_barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.image = m_swapchain.getImage(image_idx);
+	image_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_barrier.subresourceRange.baseMipLevel = 0;
+	image_barrier.subresourceRange.levelCount = 1;
+	image_barrier.subresourceRange.baseArrayLayer = 0;
+	image_barrier.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(frame.command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &image_barrier);
+
+	m_gpu_profiler.endFrame(frame.command_buffer);
+
+	vk_error = vkEndCommandBuffer(frame.command_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to end Vulkan frame command buffer. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	return true;
+}
+
+bool Renderer::areDeviceExtensionsSupported(const DeviceCapabilities& capabilities, const std::vector<const char*>& extensions, std::string& out_error_message)
+{
+	for (const char* const extension : extensions) {
+		if (!capabilities.hasExtension(extension)) {
 			out_error_message = "Extension \"" + std::string(extension) + "\" not supported for Vulkan physical device: \"" +
-				std::string(device_properties.deviceName) + "\".";
+				std::string(capabilities.getProperties().deviceName) + "\".";
 			return false;
 		}
 	}
@@ -1,36 +1,224 @@
 #pragma once
 
+#include "command_recorder.h"
+#include "device_queue.h"
+#include "gpu_profiler.h"
+#include "host_allocator.h"
+#include "memory_allocator.h"
+#include "memory_ring.h"
+#include "particle_compute.h"
+#include "particle_renderer.h"
+#include "pipeline_cache.h"
+#include "staging_uploader.h"
+#include "swapchain.h"
+#include "vulkan_capabilities.h"
 #include <Volk/volk.h>
+#include <future>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <filesystem>
 
 namespace Simulator {
+	class JobSystem;
+
 	class Renderer {
 	public:
+		struct PhysicalDeviceScore {
+			VkPhysicalDevice physical_device = VK_NULL_HANDLE;
+			VkPhysicalDeviceProperties properties{};
+			uint8_t device_uuid[VK_UUID_SIZE]{};
+			bool extensions_supported = false;
+			std::string unsupported_reason;
+			int64_t device_type_score = 0;
+			int64_t memory_score = 0;
+			int64_t queues_score = 0;
+			int64_t features_score = 0;
+			int64_t limits_score = 0;
+			int64_t total_score = 0;
+		};
+
+		struct StartupTimings {
+			uint64_t loading_ns = 0;
+			uint64_t loading_wait_ns = 0;
+			uint64_t instance_ns = 0;
+			uint64_t device_probes_ns = 0;
+		};
+
 		~Renderer();
+		void startLoading();
+		// Draws are recorded on the job system when one is set before the swapchain is created.
+		void setJobSystem(JobSystem* job_system);
 		bool init(
 			std::string& out_error_message, HINSTANCE app_instance, HWND window
 #ifdef DEBUG
 			, PFN_vkDebugUtilsMessengerCallbackEXT vulkan_debug_callback, void* vulkan_debug_callback_user_data
+#endif
+		);
+		bool initHeadless(
+			std::string& out_error_message
+#ifdef DEBUG
+			, PFN_vkDebugUtilsMessengerCallbackEXT vulkan_debug_callback, void* vulkan_debug_callback_user_data
 #endif
 		);
 		void destroy();
 		bool getSupportedPhysicalDevices(std::vector<VkPhysicalDevice>& out_supported_devices, std::string& out_error_message);
+		const DeviceCapabilities* getDeviceCapabilities(VkPhysicalDevice physical_device) const;
+		const StartupTimings& getStartupTimings() const;
+		bool rankPhysicalDevices(const std::vector<VkPhysicalDevice>& physical_devices, std::vector<PhysicalDeviceScore>& out_ranked_devices,
+			std::string& out_error_message) const;
+		static bool findPhysicalDevice(const std::vector<PhysicalDeviceScore>& ranked_devices, std::string_view name_or_uuid, size_t& out_device_idx);
+		static std::string getDeviceUuidString(const uint8_t (&device_uuid)[VK_UUID_SIZE]);
 		bool createLogicalDevice(const VkPhysicalDevice& physical_device, std::string& out_error_message);
+		VkDevice getLogicalDevice() const;
+		DeviceQueue& getGraphicsQueue();
+		DeviceQueue& getPresentQueue();
+		DeviceQueue& getComputeQueue();
+		DeviceQueue& getTransferQueue();
+		bool createPipelineCache(const std::filesystem::path& file_path, std::string& out_error_message);
+		PipelineCache& getPipelineCache();
+		MemoryAllocator& getMemoryAllocator();
+		StagingUploader& getStagingUploader();
+		const HostAllocator& getHostAllocator() const;
+		// Headless only, the offscreen targets share one depth target of their size.
+		bool createOffscreenTargets(uint32_t width, uint32_t height, uint32_t targets_count, std::string& out_error_message);
+		// Renders the particles into target frame_number % getOffscreenTargetsCount() and queues its readback.
+		bool renderOffscreenFrame(uint64_t frame_number, double simulation_time, std::string& out_error_message);
+		bool readOffscreenFrame(uint32_t target_idx, std::vector<uint8_t>& out_rgba_pixels, std::string& out_error_message);
+		bool isOffscreenFramePending(uint32_t target_idx) const;
+		uint32_t getOffscreenTargetsCount() const;
+		uint32_t getOffscreenWidth() const;
+		uint32_t getOffscreenHeight() const;
+		static bool writeImageFile(const std::filesystem::path& file_path, uint32_t width, uint32_t height,
+			const std::vector<uint8_t>& rgba_pixels, std::string& out_error_message);
+		bool createSwapchain(uint32_t width, uint32_t height, const SwapchainSettings& settings, std::string& out_error_message);
+		bool resizeSwapchain(uint32_t width, uint32_t height, std::string& out_error_message);
+		bool renderFrame(double simulation_time, std::string& out_error_message);
+		const Swapchain& getSwapchain() const;
+		uint32_t getFramesInFlightCount() const;
+		uint64_t getSwapchainRebuildsCount() const;
+		MemoryRing& getFrameUploadRing();
+		GpuProfiler& getGpuProfiler();
+		bool createParticles(const World& world, std::string& out_error_message);
+		// Steps are recorded into the next frame before anything reads the particles.
+		void queueParticleSteps(uint32_t steps_count, const ParticleStepParams& params);
+		bool runParticleSteps(uint32_t steps_count, const ParticleStepParams& params, std::vector<GpuParticle>& out_particles,
+			std::string& out_error_message);
+		const ParticleCompute& getParticleCompute() const;
+		const ParticleRenderer& getParticleRenderer() const;
+		bool isGpuDrivenDrawingSupported() const;
+		// GPU driven drawing falls back to recorded draws on devices without indirect draw count support, or when the particles
+		// do not fit in a single indirect draw.
+		void setParticleDrawMode(ParticleDrawMode draw_mode);
+		ParticleDrawMode getParticleDrawMode() const;
+		// Records the particle draws into secondary command buffers from the recorder's current frame, in particle order. GPU driven
+		// draws are a single indirect draw of the commands written by the culling pass; the depth test keeps the image independent of
+		// the order the pass wrote them.
+		bool recordParticleDraws(CommandRecorder& recorder, JobSystem* job_system, uint32_t draws_count, VkExtent2D extent, ParticleDrawMode draw_mode,
+			std::vector<VkCommandBuffer>& out_command_buffers, std::string& out_error_message);
+		CommandRecorderStats getCommandRecorderStats() const;
 
 	private:
-		static bool areDeviceExtensionsSupported(const VkPhysicalDevice& physical_device, const std::vector<const char*>& extensions, std::string& out_error_message);
+		struct OffscreenTarget {
+			VkImage image = VK_NULL_HANDLE;
+			MemoryAllocation image_allocation;
+			VkImageView image_view = VK_NULL_HANDLE;
+			VkBuffer readback_buffer = VK_NULL_HANDLE;
+			MemoryAllocation readback_allocation;
+			void* readback_data = nullptr;
+			VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			bool pending = false;
+		};
+
+		struct FrameResources {
+			VkCommandPool command_pool = VK_NULL_HANDLE;
+			VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			VkSemaphore image_available_semaphore = VK_NULL_HANDLE;
+		};
+
+		bool createInstance(
+			std::string& out_error_message, bool headless
+#ifdef DEBUG
+			, PFN_vkDebugUtilsMessengerCallbackEXT vulkan_debug_callback, void* vulkan_debug_callback_user_data
+#endif
+		);
+		bool load(std::string& out_error_message);
+		std::vector<const char*> getRequiredDeviceExtensions() const;
+		void destroyOffscreenTargets();
+		bool createFrameResources(uint32_t frames_count, std::string& out_error_message);
+		void destroyFrameResources();
+		bool createGpuProfiler(uint32_t frame_slots_count, std::string& out_error_message);
+		bool addUploadWait(std::vector<VkSemaphoreSubmitInfo>& wait_semaphore_submit_infos, std::string& out_error_message);
+		bool rebuildSwapchain(std::string& out_error_message);
+		static VkFormat findDepthFormat(VkPhysicalDevice physical_device);
+		bool createDepthTarget(VkExtent2D extent, std::string& out_error_message);
+		void destroyDepthTarget();
+		ParticleDrawParams getParticleDrawParams(VkExtent2D extent) const;
+		void recordParticleUpdate(VkCommandBuffer command_buffer, VkExtent2D extent, ParticleDrawMode draw_mode);
+		void beginScenePass(VkCommandBuffer command_buffer, VkImage color_image, VkImageView color_image_view, VkExtent2D extent, double simulation_time,
+			bool secondary_contents);
+		bool recordFrame(const FrameResources& frame, uint32_t image_idx, double simulation_time, std::string& out_error_message);
+		static bool areDeviceExtensionsSupported(const DeviceCapabilities& capabilities, const std::vector<const char*>& extensions, std::string& out_error_message);
 
 #ifdef DEBUG
 		static constexpr const char* const VK_LAYER_KHRONOS_VALIDATION_NAME = "VK_LAYER_KHRONOS_validation";
 #endif
+		static constexpr VkFormat OFFSCREEN_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+		static constexpr VkDeviceSize FRAME_UPLOAD_RING_SIZE = 4ull * 1024 * 1024;
+		static constexpr VkDeviceSize STAGING_RING_SIZE = 32ull * 1024 * 1024;
+		static constexpr double CLEAR_COLOR_PERIOD = 4.0;
+		static constexpr VkFormat DEPTH_FORMAT_CANDIDATES[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D16_UNORM };
 
+		HostAllocator m_host_allocator;
 		bool m_initialized = false;
+		bool m_headless = false;
+		std::future<bool> m_loading;
+		std::string m_loading_error_message;
+		InstanceCapabilities m_instance_capabilities;
+		std::vector<DeviceCapabilities> m_device_capabilities;
+		StartupTimings m_startup_timings;
 		VkInstance m_vk_instance = VK_NULL_HANDLE;
 #ifdef DEBUG
 		VkDebugUtilsMessengerEXT m_vk_debug_messenger = VK_NULL_HANDLE;
 #endif
 		VkSurfaceKHR m_vk_surface = VK_NULL_HANDLE;
+		VkPhysicalDevice m_vk_physical_device = VK_NULL_HANDLE;
 		VkDevice m_vk_logical_device = VK_NULL_HANDLE;
+		DeviceQueue m_graphics_queue;
+		DeviceQueue m_present_queue;
+		DeviceQueue m_compute_queue;
+		DeviceQueue m_transfer_queue;
+		PipelineCache m_pipeline_cache;
+		MemoryAllocator m_memory_allocator;
+		StagingUploader m_staging_uploader;
+		VkCommandPool m_vk_offscreen_command_pool = VK_NULL_HANDLE;
+		std::vector<OffscreenTarget> m_offscreen_targets;
+		uint32_t m_offscreen_width = 0;
+		uint32_t m_offscreen_height = 0;
+		Swapchain m_swapchain;
+		SwapchainSettings m_swapchain_settings;
+		VkFormat m_depth_format = VK_FORMAT_UNDEFINED;
+		VkImage m_vk_depth_image = VK_NULL_HANDLE;
+		MemoryAllocation m_depth_image_allocation;
+		VkImageView m_vk_depth_image_view = VK_NULL_HANDLE;
+		std::vector<FrameResources> m_frames;
+		MemoryRing m_frame_upload_ring;
+		GpuProfiler m_gpu_profiler;
+		JobSystem* m_job_system = nullptr;
+		CommandRecorder m_command_recorder;
+		std::vector<VkCommandBuffer> m_secondary_command_buffers;
+		ParticleCompute m_particle_compute;
+		ParticleRenderer m_particle_renderer;
+		ParticleDrawMode m_particle_draw_mode = ParticleDrawMode::GPU_DRIVEN;
+		bool m_gpu_driven_drawing_supported = false;
+		bool m_calibrated_timestamps_supported = false;
+		uint32_t m_pending_particle_steps_count = 0;
+		ParticleStepParams m_particle_step_params;
+		uint64_t m_frame_number = 0;
+		uint32_t m_swapchain_width = 0;
+		uint32_t m_swapchain_height = 0;
+		uint64_t m_swapchain_rebuilds_count = 0;
 	};
 }
@@ -0,0 +1,27 @@
+#version 450
+
+struct Particle {
+	vec4 position_inverse_mass;
+	vec4 velocity;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Particles {
+	Particle particles[];
+};
+
+layout(push_constant) uniform DrawParams {
+	mat4 view_projection;
+	float particle_size;
+} params;
+
+layout(location = 0) out vec3 out_color;
+
+void main()
+{
+	// Cube corners come from the bits of the vertex index, the particle from the instance index set by the draw.
+	vec3 corner = vec3(gl_VertexIndex & 1, (gl_VertexIndex >> 1) & 1, (gl_VertexIndex >> 2) & 1);
+	vec3 position = particles[gl_InstanceIndex].position_inverse_mass.xyz + (corner - 0.5) * params.particle_size;
+
+	gl_Position = params.view_projection * vec4(position, 1.0);
+	out_color = mix(vec3(0.9, 0.45, 0.1), vec3(1.0, 0.85, 0.4), corner);
+}
@@ -0,0 +1,225 @@
+#include "simulation_thread.h"
+#include "instrumentation.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace Simulator;
+
+static constexpr float SCENE_EXTENT = 50.0f;
+static constexpr float MAX_INITIAL_SPEED = 5.0f;
+static constexpr float BODY_RADIUS = 0.25f;
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+}
+
+bool SimulationThread::start(const SimulationSettings& settings, JobSystem* job_system, std::string& out_error_message)
+{
+	if (m_started) {
+		out_error_message = "Simulation thread is already started.";
+		return false;
+	}
+
+	if ((settings.step_dt <= 0.0) || (settings.max_steps_per_update == 0)) {
+		out_error_message = "Simulation step must be positive and at least one step must run per update.";
+		return false;
+	}
+
+	m_settings = settings;
+	m_job_system = job_system;
+	createScene(m_world, m_settings.bodies_count);
+
+	m_time = 0.0;
+	m_previous_snapshot = SimulationSnapshot();
+	m_steps_count.store(0, std::memory_order_relaxed);
+	m_dropped_steps_count.store(0, std::memory_order_relaxed);
+	m_published_snapshots_count.store(0, std::memory_order_relaxed);
+	m_consumed_snapshots_count.store(0, std::memory_order_relaxed);
+	m_total_step_ns.store(0, std::memory_order_relaxed);
+
+	m_start_time = std::chrono::steady_clock::now();
+	m_stopping.store(false, std::memory_order_relaxed);
+	m_thread = std::thread(&SimulationThread::simulationProcess, this);
+	m_started = true;
+	return true;
+}
+
+void SimulationThread::stop()
+{
+	if (!m_started) {
+		return;
+	}
+
+	m_stopping.store(true, std::memory_order_relaxed);
+	m_thread.join();
+	m_started = false;
+}
+
+bool SimulationThread::isStarted() const
+{
+	return m_started;
+}
+
+const SimulationSettings& SimulationThread::getSettings() const
+{
+	return m_settings;
+}
+
+bool SimulationThread::interpolate(SimulationFrame& out_frame)
+{
+	// The buffer given back to the writer is about to be overwritten anyway, so it trades places with the previous
+	// snapshot instead of being copied.
+	if (m_snapshots.hasNewData()) {
+		std::swap(m_previous_snapshot, m_snapshots.getReadBuffer());
+		m_snapshots.acquire();
+		m_consumed_snapshots_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	const SimulationSnapshot& latest = m_snapshots.getReadBuffer();
+	if (latest.steps_count == 0) {
+		return false;
+	}
+
+	const SimulationSnapshot& previous = (m_previous_snapshot.steps_count != 0) ? m_previous_snapshot : latest;
+	double render_timestamp = getSecondsSinceStart() - m_settings.step_dt;
+	double span = latest.timestamp - previous.timestamp;
+	double alpha = (span > 0.0) ? std::clamp((render_timestamp - previous.timestamp) / span, 0.0, 1.0) : 1.0;
+
+	out_frame.steps_count = latest.steps_count;
+	out_frame.time = previous.time + (latest.time - previous.time) * alpha;
+	out_frame.alpha = static_cast<float>(alpha);
+	return true;
+}
+
+bool SimulationThread::interpolate(SimulationFrame& out_frame, SimulationPositions& out_positions)
+{
+	if (!interpolate(out_frame)) {
+		return false;
+	}
+
+	const SimulationSnapshot& latest = m_snapshots.getReadBuffer();
+	const SimulationSnapshot& previous = (m_previous_snapshot.steps_count != 0) ? m_previous_snapshot : latest;
+
+	size_t bodies_count = latest.position_x.size();
+	out_positions.position_x.resize(bodies_count);
+	out_positions.position_y.resize(bodies_count);
+	out_positions.position_z.resize(bodies_count);
+
+	for (size_t i = 0; i < bodies_count; i++) {
+		out_positions.position_x[i] = previous.position_x[i] + (latest.position_x[i] - previous.position_x[i]) * out_frame.alpha;
+		out_positions.position_y[i] = previous.position_y[i] + (latest.position_y[i] - previous.position_y[i]) * out_frame.alpha;
+		out_positions.position_z[i] = previous.position_z[i] + (latest.position_z[i] - previous.position_z[i]) * out_frame.alpha;
+	}
+
+	return true;
+}
+
+SimulationStats SimulationThread::getStats() const
+{
+	SimulationStats stats;
+	stats.steps_count = m_steps_count.load(std::memory_order_relaxed);
+	stats.dropped_steps_count = m_dropped_steps_count.load(std::memory_order_relaxed);
+	stats.published_snapshots_count = m_published_snapshots_count.load(std::memory_order_relaxed);
+	stats.consumed_snapshots_count = m_consumed_snapshots_count.load(std::memory_order_relaxed);
+	stats.total_step_ms = static_cast<double>(m_total_step_ns.load(std::memory_order_relaxed)) / 1e6;
+	return stats;
+}
+
+void SimulationThread::simulationProcess()
+{
+	auto step_duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(m_settings.step_dt));
+	auto next_step_time = m_start_time + step_duration;
+
+	while (!m_stopping.load(std::memory_order_relaxed)) {
+		std::this_thread::sleep_until(next_step_time);
+
+		auto now = std::chrono::steady_clock::now();
+		uint32_t steps_count = 0;
+
+		while ((next_step_time <= now) && (steps_count < m_settings.max_steps_per_update)) {
+			SIMULATOR_SCOPE_TIMER("simulation step");
+
+			auto step_start_time = std::chrono::steady_clock::now();
+			applySpringForces(m_world, m_settings.spring_stiffness);
+			if (m_job_system != nullptr) {
+				m_world.step(static_cast<float>(m_settings.step_dt), m_settings.method, *m_job_system);
+			}
+			else {
+				m_world.step(static_cast<float>(m_settings.step_dt), m_settings.method);
+			}
+
+			m_time += m_settings.step_dt;
+			m_total_step_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - step_start_time).count(),
+				std::memory_order_relaxed);
+			m_steps_count.fetch_add(1, std::memory_order_relaxed);
+			next_step_time += step_duration;
+			steps_count++;
+		}
+
+		if (next_step_time <= now) {
+			uint64_t dropped_steps_count = (now - next_step_time) / step_duration + 1;
+			m_dropped_steps_count.fetch_add(dropped_steps_count, std::memory_order_relaxed);
+			next_step_time += step_duration * dropped_steps_count;
+		}
+
+		if (steps_count > 0) {
+			publishSnapshot(std::chrono::duration<double>(next_step_time - step_duration - m_start_time).count());
+		}
+	}
+}
+
+void SimulationThread::createScene(World& world, size_t bodies_count)
+{
+	std::mt19937 random_engine(1);
+	std::uniform_real_distribution<float> position_distribution(-SCENE_EXTENT, SCENE_EXTENT);
+	std::uniform_real_distribution<float> velocity_distribution(-MAX_INITIAL_SPEED, MAX_INITIAL_SPEED);
+
+	world.clear();
+	world.reserve(bodies_count);
+	world.setGravity(0.0f, 0.0f, 0.0f);
+
+	for (size_t i = 0; i < bodies_count; i++) {
+		float x = position_distribution(random_engine);
+		float y = position_distribution(random_engine);
+		float z = position_distribution(random_engine);
+		world.addBody(x, y, z, velocity_distribution(random_engine), velocity_distribution(random_engine), velocity_distribution(random_engine),
+			1.0f, BODY_RADIUS);
+	}
+}
+
+void SimulationThread::applySpringForces(World& world, float stiffness)
+{
+	const float* position_x = world.getPositionsX();
+	const float* position_y = world.getPositionsY();
+	const float* position_z = world.getPositionsZ();
+
+	for (size_t i = 0; i < world.getBodiesCount(); i++) {
+		uint32_t body_idx = static_cast<uint32_t>(i);
+		world.applyForce(body_idx, -position_x[i] * stiffness, -position_y[i] * stiffness, -position_z[i] * stiffness);
+	}
+}
+
+void SimulationThread::publishSnapshot(double timestamp)
+{
+	SIMULATOR_SCOPE_TIMER("simulation publish");
+
+	size_t bodies_count = m_world.getBodiesCount();
+	SimulationSnapshot& snapshot = m_snapshots.getWriteBuffer();
+	snapshot.steps_count = m_steps_count.load(std::memory_order_relaxed);
+	snapshot.time = m_time;
+	snapshot.timestamp = timestamp;
+	snapshot.position_x.assign(m_world.getPositionsX(), m_world.getPositionsX() + bodies_count);
+	snapshot.position_y.assign(m_world.getPositionsY(), m_world.getPositionsY() + bodies_count);
+	snapshot.position_z.assign(m_world.getPositionsZ(), m_world.getPositionsZ() + bodies_count);
+
+	m_snapshots.publish();
+	m_published_snapshots_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+double SimulationThread::getSecondsSinceStart() const
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start_time).count();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "triple_buffer.h"
+#include "world.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Simulator {
+	class JobSystem;
+
+	struct SimulationSettings {
+		double step_dt = 1.0 / 60.0;
+		// Steps beyond this per wake up are dropped, so a stall never turns into a catch up spiral.
+		uint32_t max_steps_per_update = 8;
+		size_t bodies_count = 10000;
+		float spring_stiffness = 1.0f;
+		IntegrationMethod method = IntegrationMethod::SEMI_IMPLICIT_EULER;
+	};
+
+	struct SimulationSnapshot {
+		uint64_t steps_count = 0;
+		double time = 0.0;
+		// Seconds since the simulation started at which the state was due, used to place it on the render clock.
+		double timestamp = 0.0;
+		std::vector<float> position_x;
+		std::vector<float> position_y;
+		std::vector<float> position_z;
+	};
+
+	struct SimulationFrame {
+		uint64_t steps_count = 0;
+		double time = 0.0;
+		float alpha = 0.0f;
+	};
+
+	struct SimulationPositions {
+		std::vector<float> position_x;
+		std::vector<float> position_y;
+		std::vector<float> position_z;
+	};
+
+	struct SimulationStats {
+		uint64_t steps_count = 0;
+		uint64_t dropped_steps_count = 0;
+		uint64_t published_snapshots_count = 0;
+		uint64_t consumed_snapshots_count = 0;
+		double total_step_ms = 0.0;
+	};
+
+	// Steps a World at a fixed rate on its own thread and hands snapshots to the render thread through a triple buffer.
+	class SimulationThread {
+	public:
+		~SimulationThread();
+		bool start(const SimulationSettings& settings, JobSystem* job_system, std::string& out_error_message);
+		void stop();
+		bool isStarted() const;
+		const SimulationSettings& getSettings() const;
+		// Render thread only. Interpolates the clock between the two latest snapshots one step behind the wall clock.
+		bool interpolate(SimulationFrame& out_frame);
+		// Also interpolates the body positions, for callers that draw the bodies.
+		bool interpolate(SimulationFrame& out_frame, SimulationPositions& out_positions);
+		SimulationStats getStats() const;
+
+		static void createScene(World& world, size_t bodies_count);
+		// Pulls every body back to the origin, so the scene keeps moving without flying apart.
+		static void applySpringForces(World& world, float stiffness);
+
+	private:
+		void simulationProcess();
+		void publishSnapshot(double timestamp);
+		double getSecondsSinceStart() const;
+
+		SimulationSettings m_settings;
+		JobSystem* m_job_system = nullptr;
+		World m_world;
+		double m_time = 0.0;
+		std::thread m_thread;
+		std::atomic<bool> m_stopping = false;
+		bool m_started = false;
+		std::chrono::steady_clock::time_point m_start_time;
+		TripleBuffer<SimulationSnapshot> m_snapshots;
+		SimulationSnapshot m_previous_snapshot;
+		std::atomic<uint64_t> m_steps_count = 0;
+		std::atomic<uint64_t> m_dropped_steps_count = 0;
+		std::atomic<uint64_t> m_published_snapshots_count = 0;
+		std::atomic<uint64_t> m_consumed_snapshots_count = 0;
+		std::atomic<uint64_t> m_total_step_ns = 0;
+	};
+}
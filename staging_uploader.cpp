@@ -0,0 +1,505 @@
+#include "staging_uploader.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace Simulator;
+
+StagingUploader::~StagingUploader()
+{
+	destroy();
+}
+
+bool StagingUploader::create(VkDevice logical_device, MemoryAllocator& allocator, DeviceQueue& queue, VkDeviceSize ring_size, std::string& out_error_message)
+{
+	destroy();
+
+	if (ring_size == 0) {
+		out_error_message = "Invalid staging ring size.";
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_vk_logical_device = logical_device;
+	m_allocator = &allocator;
+	m_queue = &queue;
+	m_ring_size = ring_size;
+	m_ring_head = 0;
+	m_ring_used_size = 0;
+	m_last_timeline_value = 0;
+	m_stats = {};
+
+	const VkAllocationCallbacks* allocation_callbacks = m_allocator->getAllocationCallbacks();
+
+	VkCommandPoolCreateInfo command_pool_create_info{};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.pNext = nullptr;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	command_pool_create_info.queueFamilyIndex = m_queue->getFamilyIndex();
+
+	VkResult vk_error = vkCreateCommandPool(m_vk_logical_device, &command_pool_create_info, allocation_callbacks, &m_vk_command_pool);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan staging command pool. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_command_pool = VK_NULL_HANDLE;
+		return false;
+	}
+
+	VkSemaphoreTypeCreateInfo semaphore_type_create_info{};
+	semaphore_type_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	semaphore_type_create_info.pNext = nullptr;
+	semaphore_type_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	semaphore_type_create_info.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphore_create_info{};
+	semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphore_create_info.pNext = &semaphore_type_create_info;
+	semaphore_create_info.flags = 0;
+
+	vk_error = vkCreateSemaphore(m_vk_logical_device, &semaphore_create_info, allocation_callbacks, &m_vk_timeline_semaphore);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan staging timeline semaphore. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_timeline_semaphore = VK_NULL_HANDLE;
+		return false;
+	}
+
+	VkBufferCreateInfo buffer_create_info{};
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.pNext = nullptr;
+	buffer_create_info.flags = 0;
+	buffer_create_info.size = m_ring_size;
+	buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	buffer_create_info.queueFamilyIndexCount = 0;
+	buffer_create_info.pQueueFamilyIndices = nullptr;
+
+	vk_error = vkCreateBuffer(m_vk_logical_device, &buffer_create_info, allocation_callbacks, &m_vk_ring_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan staging ring buffer. VK error:" + std::to_string(vk_error) + ".";
+		m_vk_ring_buffer = VK_NULL_HANDLE;
+		return false;
+	}
+
+	if (!m_allocator->allocateForBuffer(m_vk_ring_buffer, MemoryUsage::UPLOAD, false, m_ring_allocation, out_error_message)) {
+		out_error_message = "Failed to allocate Vulkan staging ring memory. " + out_error_message;
+		return false;
+	}
+
+	return true;
+}
+
+void StagingUploader::destroy()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_vk_logical_device == VK_NULL_HANDLE) {
+		return;
+	}
+
+	const VkAllocationCallbacks* allocation_callbacks = m_allocator->getAllocationCallbacks();
+
+	if (!m_submitted_batches.empty()) {
+		VkSemaphoreWaitInfo semaphore_wait_info{};
+		semaphore_wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		semaphore_wait_info.pNext = nullptr;
+		semaphore_wait_info.flags = 0;
+		semaphore_wait_info.semaphoreCount = 1;
+		semaphore_wait_info.pSemaphores = &m_vk_timeline_semaphore;
+		semaphore_wait_info.pValues = &m_last_timeline_value;
+
+		vkWaitSemaphores(m_vk_logical_device, &semaphore_wait_info, UINT64_MAX);
+	}
+
+	if (m_vk_ring_buffer != VK_NULL_HANDLE) {
+		vkDestroyBuffer(m_vk_logical_device, m_vk_ring_buffer, allocation_callbacks);
+		m_vk_ring_buffer = VK_NULL_HANDLE;
+	}
+
+	m_allocator->free(m_ring_allocation);
+
+	if (m_vk_timeline_semaphore != VK_NULL_HANDLE) {
+		vkDestroySemaphore(m_vk_logical_device, m_vk_timeline_semaphore, allocation_callbacks);
+		m_vk_timeline_semaphore = VK_NULL_HANDLE;
+	}
+
+	if (m_vk_command_pool != VK_NULL_HANDLE) {
+		vkDestroyCommandPool(m_vk_logical_device, m_vk_command_pool, allocation_callbacks);
+		m_vk_command_pool = VK_NULL_HANDLE;
+	}
+
+	m_recording_batch = {};
+	m_submitted_batches.clear();
+	m_free_command_buffers.clear();
+	m_ring_size = 0;
+	m_ring_head = 0;
+	m_ring_used_size = 0;
+	m_allocator = nullptr;
+	m_queue = nullptr;
+	m_vk_logical_device = VK_NULL_HANDLE;
+}
+
+bool StagingUploader::uploadBuffer(VkBuffer buffer, const MemoryAllocation& allocation, VkDeviceSize offset, const void* data, VkDeviceSize size,
+	std::string& out_error_message)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_vk_ring_buffer == VK_NULL_HANDLE) {
+		out_error_message = "Staging uploader not created.";
+		return false;
+	}
+
+	if ((allocation.mapped_data != nullptr) && m_allocator->isHostCoherent(allocation)) {
+		memcpy(static_cast<uint8_t*>(allocation.mapped_data) + offset, data, static_cast<size_t>(size));
+		m_stats.direct_writes_count++;
+		m_stats.direct_written_size += size;
+		return true;
+	}
+
+	const uint8_t* src_data = static_cast<const uint8_t*>(data);
+	VkDeviceSize max_chunk_size = std::max<VkDeviceSize>(m_ring_size / 2, COPY_ALIGNMENT);
+
+	for (VkDeviceSize copied_size = 0; copied_size < size;) {
+		VkDeviceSize chunk_size = std::min(size - copied_size, max_chunk_size);
+
+		VkDeviceSize ring_offset;
+		if (!allocateRing(chunk_size, ring_offset, out_error_message)) {
+			return false;
+		}
+
+		memcpy(static_cast<uint8_t*>(m_ring_allocation.mapped_data) + ring_offset, src_data + copied_size, static_cast<size_t>(chunk_size));
+
+		VkBufferCopy copy_region{};
+		copy_region.srcOffset = ring_offset;
+		copy_region.dstOffset = offset + copied_size;
+		copy_region.size = chunk_size;
+
+		vkCmdCopyBuffer(m_recording_batch.command_buffer, m_vk_ring_buffer, buffer, 1, &copy_region);
+		copied_size += chunk_size;
+	}
+
+	m_stats.uploads_count++;
+	m_stats.uploaded_size += size;
+	return true;
+}
+
+bool StagingUploader::uploadImage(const ImageUpload& upload, const void* data, VkDeviceSize size, std::string& out_error_message)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_vk_ring_buffer == VK_NULL_HANDLE) {
+		out_error_message = "Staging uploader not created.";
+		return false;
+	}
+
+	if (size > m_ring_size) {
+		out_error_message = "Image upload of " + std::to_string(size) + " bytes exceeds staging ring size.";
+		return false;
+	}
+
+	VkDeviceSize ring_offset;
+	if (!allocateRing(size, ring_offset, out_error_message)) {
+		return false;
+	}
+
+	memcpy(static_cast<uint8_t*>(m_ring_allocation.mapped_data) + ring_offset, data, static_cast<size_t>(size));
+
+	VkImageMemoryBarrier2 image_barrier{};
+	image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+	image_barrier.pNext = nullptr;
+	image_barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+	image_barrier.srcAccessMask = VK_ACCESS_2_NONE;
+	image_barrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+	image_barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+	image_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	image_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.image = upload.image;
+	image_barrier.subresourceRange.aspectMask = upload.subresource.aspectMask;
+	image_barrier.subresourceRange.baseMipLevel = upload.subresource.mipLevel;
+	image_barrier.subresourceRange.levelCount = 1;
+	image_barrier.subresourceRange.baseArrayLayer = upload.subresource.baseArrayLayer;
+	image_barrier.subresourceRange.layerCount = upload.subresource.layerCount;
+
+	VkDependencyInfo dependency_info{};
+	dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+	dependency_info.pNext = nullptr;
+	dependency_info.dependencyFlags = 0;
+	dependency_info.memoryBarrierCount = 0;
+	dependency_info.pMemoryBarriers = nullptr;
+	dependency_info.bufferMemoryBarrierCount = 0;
+	dependency_info.pBufferMemoryBarriers = nullptr;
+	dependency_info.imageMemoryBarrierCount = 1;
+	dependency_info.pImageMemoryBarriers = &image_barrier;
+
+	vkCmdPipelineBarrier2(m_recording_batch.command_buffer, &dependency_info);
+
+	VkBufferImageCopy copy_region{};
+	copy_region.bufferOffset = ring_offset;
+	copy_region.bufferRowLength = 0;
+	copy_region.bufferImageHeight = 0;
+	copy_region.imageSubresource = upload.subresource;
+	copy_region.imageOffset = upload.offset;
+	copy_region.imageExtent = upload.extent;
+
+	vkCmdCopyBufferToImage(m_recording_batch.command_buffer, m_vk_ring_buffer, upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy_region);
+
+	image_barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+	image_barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+	image_barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+	image_barrier.dstAccessMask = VK_ACCESS_2_NONE;
+	image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	image_barrier.newLayout = upload.final_layout;
+
+	vkCmdPipelineBarrier2(m_recording_batch.command_buffer, &dependency_info);
+
+	m_stats.uploads_count++;
+	m_stats.uploaded_size += size;
+	return true;
+}
+
+bool StagingUploader::flush(uint64_t& out_timeline_value, std::string& out_error_message)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	collectBatches();
+
+	if (!submitBatch(out_error_message)) {
+		return false;
+	}
+
+	out_timeline_value = m_last_timeline_value;
+	return true;
+}
+
+bool StagingUploader::wait(uint64_t timeline_value, std::string& out_error_message)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	VkSemaphoreWaitInfo semaphore_wait_info{};
+	semaphore_wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	semaphore_wait_info.pNext = nullptr;
+	semaphore_wait_info.flags = 0;
+	semaphore_wait_info.semaphoreCount = 1;
+	semaphore_wait_info.pSemaphores = &m_vk_timeline_semaphore;
+	semaphore_wait_info.pValues = &timeline_value;
+
+	VkResult vk_error = vkWaitSemaphores(m_vk_logical_device, &semaphore_wait_info, WAIT_TIMEOUT_NS);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to wait for Vulkan staging timeline semaphore. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	collectBatches();
+	return true;
+}
+
+bool StagingUploader::isCreated() const
+{
+	return m_vk_ring_buffer != VK_NULL_HANDLE;
+}
+
+VkSemaphore StagingUploader::getTimelineSemaphore() const
+{
+	return m_vk_timeline_semaphore;
+}
+
+StagingUploaderStats StagingUploader::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+bool StagingUploader::allocateRing(VkDeviceSize size, VkDeviceSize& out_offset, std::string& out_error_message)
+{
+	if (size > m_ring_size) {
+		out_error_message = "Staging allocation of " + std::to_string(size) + " bytes exceeds staging ring size.";
+		return false;
+	}
+
+	while (true) {
+		if (m_ring_used_size == 0) {
+			m_ring_head = 0;
+		}
+
+		VkDeviceSize offset = (m_ring_head + COPY_ALIGNMENT - 1) / COPY_ALIGNMENT * COPY_ALIGNMENT;
+		if (offset + size > m_ring_size) {
+			offset = 0;
+		}
+
+		VkDeviceSize consumed_size = (offset >= m_ring_head) ? (offset - m_ring_head + size) : (m_ring_size - m_ring_head + size);
+
+		if (consumed_size <= m_ring_size - m_ring_used_size) {
+			if (!beginBatch(out_error_message)) {
+				return false;
+			}
+
+			m_ring_head = (offset + size) % m_ring_size;
+			m_ring_used_size += consumed_size;
+			m_recording_batch.ring_used_size += consumed_size;
+			out_offset = offset;
+			return true;
+		}
+
+		if (m_recording_batch.command_buffer != VK_NULL_HANDLE) {
+			if (!submitBatch(out_error_message)) {
+				return false;
+			}
+		}
+
+		if (m_submitted_batches.empty()) {
+			out_error_message = "Staging ring exhausted.";
+			return false;
+		}
+
+		m_stats.ring_waits_count++;
+
+		if (!waitOldestBatch(out_error_message)) {
+			return false;
+		}
+	}
+}
+
+bool StagingUploader::beginBatch(std::string& out_error_message)
+{
+	if (m_recording_batch.command_buffer != VK_NULL_HANDLE) {
+		return true;
+	}
+
+	VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+	VkResult vk_error;
+
+	if (!m_free_command_buffers.empty()) {
+		command_buffer = m_free_command_buffers.back();
+		m_free_command_buffers.pop_back();
+
+		vk_error = vkResetCommandBuffer(command_buffer, 0);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to reset Vulkan staging command buffer. VK error:" + std::to_string(vk_error) + ".";
+			return false;
+		}
+	}
+	else {
+		VkCommandBufferAllocateInfo command_buffer_allocate_info{};
+		command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_allocate_info.pNext = nullptr;
+		command_buffer_allocate_info.commandPool = m_vk_command_pool;
+		command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		command_buffer_allocate_info.commandBufferCount = 1;
+
+		vk_error = vkAllocateCommandBuffers(m_vk_logical_device, &command_buffer_allocate_info, &command_buffer);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to allocate Vulkan staging command buffer. VK error:" + std::to_string(vk_error) + ".";
+			return false;
+		}
+	}
+
+	VkCommandBufferBeginInfo command_buffer_begin_info{};
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.pNext = nullptr;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	command_buffer_begin_info.pInheritanceInfo = nullptr;
+
+	vk_error = vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info);
+	if (vk_error != VK_SUCCESS) {
+		m_free_command_buffers.push_back(command_buffer);
+		out_error_message = "Failed to begin Vulkan staging command buffer. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	m_recording_batch.command_buffer = command_buffer;
+	return true;
+}
+
+bool StagingUploader::submitBatch(std::string& out_error_message)
+{
+	if (m_recording_batch.command_buffer == VK_NULL_HANDLE) {
+		return true;
+	}
+
+	VkResult vk_error = vkEndCommandBuffer(m_recording_batch.command_buffer);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to end Vulkan staging command buffer. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	uint64_t timeline_value = m_last_timeline_value + 1;
+
+	VkCommandBufferSubmitInfo command_buffer_submit_info{};
+	command_buffer_submit_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+	command_buffer_submit_info.pNext = nullptr;
+	command_buffer_submit_info.commandBuffer = m_recording_batch.command_buffer;
+	command_buffer_submit_info.deviceMask = 0;
+
+	VkSemaphoreSubmitInfo signal_semaphore_submit_info{};
+	signal_semaphore_submit_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+	signal_semaphore_submit_info.pNext = nullptr;
+	signal_semaphore_submit_info.semaphore = m_vk_timeline_semaphore;
+	signal_semaphore_submit_info.value = timeline_value;
+	signal_semaphore_submit_info.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+	signal_semaphore_submit_info.deviceIndex = 0;
+
+	VkSubmitInfo2 submit_info{};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+	submit_info.pNext = nullptr;
+	submit_info.flags = 0;
+	submit_info.waitSemaphoreInfoCount = 0;
+	submit_info.pWaitSemaphoreInfos = nullptr;
+	submit_info.commandBufferInfoCount = 1;
+	submit_info.pCommandBufferInfos = &command_buffer_submit_info;
+	submit_info.signalSemaphoreInfoCount = 1;
+	submit_info.pSignalSemaphoreInfos = &signal_semaphore_submit_info;
+
+	vk_error = m_queue->submit2(1, &submit_info, VK_NULL_HANDLE);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to submit Vulkan staging batch. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	m_recording_batch.timeline_value = timeline_value;
+	m_submitted_batches.push_back(m_recording_batch);
+	m_recording_batch = {};
+	m_last_timeline_value = timeline_value;
+	m_stats.batches_count++;
+	return true;
+}
+
+bool StagingUploader::waitOldestBatch(std::string& out_error_message)
+{
+	uint64_t timeline_value = m_submitted_batches.front().timeline_value;
+
+	VkSemaphoreWaitInfo semaphore_wait_info{};
+	semaphore_wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	semaphore_wait_info.pNext = nullptr;
+	semaphore_wait_info.flags = 0;
+	semaphore_wait_info.semaphoreCount = 1;
+	semaphore_wait_info.pSemaphores = &m_vk_timeline_semaphore;
+	semaphore_wait_info.pValues = &timeline_value;
+
+	VkResult vk_error = vkWaitSemaphores(m_vk_logical_device, &semaphore_wait_info, WAIT_TIMEOUT_NS);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to wait for Vulkan staging timeline semaphore. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	collectBatches();
+	return true;
+}
+
+void StagingUploader::collectBatches()
+{
+	if (m_submitted_batches.empty()) {
+		return;
+	}
+
+	uint64_t completed_value;
+	if (vkGetSemaphoreCounterValue(m_vk_logical_device, m_vk_timeline_semaphore, &completed_value) != VK_SUCCESS) {
+		return;
+	}
+
+	while (!m_submitted_batches.empty() && (m_submitted_batches.front().timeline_value <= completed_value)) {
+		const Batch& batch = m_submitted_batches.front();
+		m_ring_used_size -= batch.ring_used_size;
+		m_free_command_buffers.push_back(batch.command_buffer);
+		m_submitted_batches.pop_front();
+	}
+}
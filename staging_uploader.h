@@ -0,0 +1,80 @@
+#pragma once
+
+#include "device_queue.h"
+#include "memory_allocator.h"
+#include <Volk/volk.h>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Simulator {
+	struct StagingUploaderStats {
+		uint64_t uploads_count = 0;
+		uint64_t uploaded_size = 0;
+		uint64_t direct_writes_count = 0;
+		uint64_t direct_written_size = 0;
+		uint64_t batches_count = 0;
+		uint64_t ring_waits_count = 0;
+	};
+
+	struct ImageUpload {
+		VkImage image = VK_NULL_HANDLE;
+		VkImageSubresourceLayers subresource{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		VkOffset3D offset{ 0, 0, 0 };
+		VkExtent3D extent{ 0, 0, 1 };
+		VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	};
+
+	class StagingUploader {
+	public:
+		~StagingUploader();
+		bool create(VkDevice logical_device, MemoryAllocator& allocator, DeviceQueue& queue, VkDeviceSize ring_size, std::string& out_error_message);
+		void destroy();
+		// Mapped host coherent targets are written directly, so the GPU must not be using the written range; other targets are copied
+		// through the staging ring and become visible once the flushed batch signals.
+		bool uploadBuffer(VkBuffer buffer, const MemoryAllocation& allocation, VkDeviceSize offset, const void* data, VkDeviceSize size,
+			std::string& out_error_message);
+		bool uploadImage(const ImageUpload& upload, const void* data, VkDeviceSize size, std::string& out_error_message);
+		bool flush(uint64_t& out_timeline_value, std::string& out_error_message);
+		bool wait(uint64_t timeline_value, std::string& out_error_message);
+		bool isCreated() const;
+		VkSemaphore getTimelineSemaphore() const;
+		StagingUploaderStats getStats() const;
+
+		static constexpr VkDeviceSize COPY_ALIGNMENT = 16;
+		static constexpr uint64_t WAIT_TIMEOUT_NS = 5'000'000'000ull;
+
+	private:
+		struct Batch {
+			VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+			uint64_t timeline_value = 0;
+			VkDeviceSize ring_used_size = 0;
+		};
+
+		// Reserves ring space for a copy recorded into the current batch, beginning the batch first so a failure leaves the ring untouched.
+		bool allocateRing(VkDeviceSize size, VkDeviceSize& out_offset, std::string& out_error_message);
+		bool beginBatch(std::string& out_error_message);
+		bool submitBatch(std::string& out_error_message);
+		bool waitOldestBatch(std::string& out_error_message);
+		void collectBatches();
+
+		VkDevice m_vk_logical_device = VK_NULL_HANDLE;
+		MemoryAllocator* m_allocator = nullptr;
+		DeviceQueue* m_queue = nullptr;
+		mutable std::mutex m_mutex;
+		VkCommandPool m_vk_command_pool = VK_NULL_HANDLE;
+		VkSemaphore m_vk_timeline_semaphore = VK_NULL_HANDLE;
+		VkBuffer m_vk_ring_buffer = VK_NULL_HANDLE;
+		MemoryAllocation m_ring_allocation;
+		VkDeviceSize m_ring_size = 0;
+		VkDeviceSize m_ring_head = 0;
+		VkDeviceSize m_ring_used_size = 0;
+		Batch m_recording_batch;
+		std::deque<Batch> m_submitted_batches;
+		std::vector<VkCommandBuffer> m_free_command_buffers;
+		uint64_t m_last_timeline_value = 0;
+		StagingUploaderStats m_stats;
+	};
+}
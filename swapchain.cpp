@@ -0,0 +1,316 @@
+#include "swapchain.h"
+
+using namespace Simulator;
+
+Swapchain::~Swapchain()
+{
+	destroy();
+}
+
+bool Swapchain::create(VkPhysicalDevice physical_device, VkDevice logical_device, VkSurfaceKHR surface, const std::vector<uint32_t>& queue_family_indices,
+	uint32_t width, uint32_t height, VkPresentModeKHR present_mode, uint32_t images_count, const VkAllocationCallbacks* allocation_callbacks,
+	std::string& out_error_message)
+{
+	VkSurfaceCapabilitiesKHR surface_capabilities;
+	VkResult vk_error = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &surface_capabilities);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to get Vulkan surface capabilities. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	uint32_t surface_formats_count;
+	vk_error = vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &surface_formats_count, nullptr);
+	if ((vk_error != VK_SUCCESS) || (surface_formats_count == 0)) {
+		out_error_message = "Failed to get Vulkan surface formats. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	std::vector<VkSurfaceFormatKHR> surface_formats(surface_formats_count);
+	vk_error = vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &surface_formats_count, surface_formats.data());
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to get Vulkan surface formats. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	uint32_t present_modes_count;
+	vk_error = vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_modes_count, nullptr);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to get Vulkan surface present modes. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	std::vector<VkPresentModeKHR> present_modes(present_modes_count);
+	vk_error = vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_modes_count, present_modes.data());
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to get Vulkan surface present modes. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	if (!(surface_capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+		out_error_message = "Vulkan surface does not support transfer destination images.";
+		return false;
+	}
+
+	/**************************************************************************************/
+
+	VkSurfaceFormatKHR surface_format = surface_formats[0];
+	for (const VkSurfaceFormatKHR& supported_surface_format : surface_formats) {
+		if (((supported_surface_format.format == VK_FORMAT_B8G8R8A8_UNORM) || (supported_surface_format.format == VK_FORMAT_R8G8B8A8_UNORM)) &&
+			(supported_surface_format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)) {
+			surface_format = supported_surface_format;
+			break;
+		}
+	}
+
+	VkPresentModeKHR selected_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+	for (VkPresentModeKHR supported_present_mode : present_modes) {
+		if (supported_present_mode == present_mode) {
+			selected_present_mode = present_mode;
+			break;
+		}
+	}
+
+	if (images_count < surface_capabilities.minImageCount) {
+		images_count = surface_capabilities.minImageCount;
+	}
+
+	if ((surface_capabilities.maxImageCount > 0) && (images_count > surface_capabilities.maxImageCount)) {
+		images_count = surface_capabilities.maxImageCount;
+	}
+
+	VkExtent2D extent = surface_capabilities.currentExtent;
+	if (extent.width == UINT32_MAX) {
+		extent.width = (width < surface_capabilities.minImageExtent.width) ? surface_capabilities.minImageExtent.width :
+			((width > surface_capabilities.maxImageExtent.width) ? surface_capabilities.maxImageExtent.width : width);
+		extent.height = (height < surface_capabilities.minImageExtent.height) ? surface_capabilities.minImageExtent.height :
+			((height > surface_capabilities.maxImageExtent.height) ? surface_capabilities.maxImageExtent.height : height);
+	}
+
+	if ((extent.width == 0) || (extent.height == 0)) {
+		out_error_message = "Vulkan surface has zero size.";
+		return false;
+	}
+
+	/**************************************************************************************/
+
+	VkSwapchainKHR old_swapchain = m_vk_swapchain;
+
+	VkSwapchainCreateInfoKHR swapchain_create_info{};
+	swapchain_create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+	swapchain_create_info.pNext = nullptr;
+	swapchain_create_info.flags = 0;
+	swapchain_create_info.surface = surface;
+	swapchain_create_info.minImageCount = images_count;
+	swapchain_create_info.imageFormat = surface_format.format;
+	swapchain_create_info.imageColorSpace = surface_format.colorSpace;
+	swapchain_create_info.imageExtent = extent;
+	swapchain_create_info.imageArrayLayers = 1;
+	swapchain_create_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	if (queue_family_indices.size() > 1) {
+		swapchain_create_info.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+		swapchain_create_info.queueFamilyIndexCount = static_cast<uint32_t>(queue_family_indices.size());
+		swapchain_create_info.pQueueFamilyIndices = queue_family_indices.data();
+	}
+	else {
+		swapchain_create_info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		swapchain_create_info.queueFamilyIndexCount = 0;
+		swapchain_create_info.pQueueFamilyIndices = nullptr;
+	}
+	swapchain_create_info.preTransform = surface_capabilities.currentTransform;
+	swapchain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+	swapchain_create_info.presentMode = selected_present_mode;
+	swapchain_create_info.clipped = VK_TRUE;
+	swapchain_create_info.oldSwapchain = old_swapchain;
+
+	VkSwapchainKHR vk_swapchain;
+	vk_error = vkCreateSwapchainKHR(logical_device, &swapchain_create_info, allocation_callbacks, &vk_swapchain);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to create Vulkan swapchain. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	destroy();
+
+	m_vk_logical_device = logical_device;
+	m_allocation_callbacks = allocation_callbacks;
+	m_vk_swapchain = vk_swapchain;
+	m_format = surface_format.format;
+	m_extent = extent;
+	m_present_mode = selected_present_mode;
+
+	/**************************************************************************************/
+
+	uint32_t swapchain_images_count;
+	vk_error = vkGetSwapchainImagesKHR(m_vk_logical_device, m_vk_swapchain, &swapchain_images_count, nullptr);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to get Vulkan swapchain images. VK error:" + std::to_string(vk_error) + ".";
+		destroy();
+		return false;
+	}
+
+	m_images.resize(swapchain_images_count);
+	vk_error = vkGetSwapchainImagesKHR(m_vk_logical_device, m_vk_swapchain, &swapchain_images_count, m_images.data());
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to get Vulkan swapchain images. VK error:" + std::to_string(vk_error) + ".";
+		destroy();
+		return false;
+	}
+
+	m_image_views.resize(swapchain_images_count, VK_NULL_HANDLE);
+	for (uint32_t i = 0; i < swapchain_images_count; i++) {
+		VkImageViewCreateInfo image_view_create_info{};
+		image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		image_view_create_info.pNext = nullptr;
+		image_view_create_info.flags = 0;
+		image_view_create_info.image = m_images[i];
+		image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		image_view_create_info.format = m_format;
+		image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+		image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		image_view_create_info.subresourceRange.baseMipLevel = 0;
+		image_view_create_info.subresourceRange.levelCount = 1;
+		image_view_create_info.subresourceRange.baseArrayLayer = 0;
+		image_view_create_info.subresourceRange.layerCount = 1;
+
+		vk_error = vkCreateImageView(m_vk_logical_device, &image_view_create_info, m_allocation_callbacks, &m_image_views[i]);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to create Vulkan swapchain image view. VK error:" + std::to_string(vk_error) + ".";
+			m_image_views[i] = VK_NULL_HANDLE;
+			destroy();
+			return false;
+		}
+	}
+
+	VkSemaphoreCreateInfo semaphore_create_info{};
+	semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphore_create_info.pNext = nullptr;
+	semaphore_create_info.flags = 0;
+
+	m_render_finished_semaphores.resize(swapchain_images_count, VK_NULL_HANDLE);
+	for (VkSemaphore& semaphore : m_render_finished_semaphores) {
+		vk_error = vkCreateSemaphore(m_vk_logical_device, &semaphore_create_info, m_allocation_callbacks, &semaphore);
+		if (vk_error != VK_SUCCESS) {
+			out_error_message = "Failed to create Vulkan swapchain semaphore. VK error:" + std::to_string(vk_error) + ".";
+			destroy();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Swapchain::destroy()
+{
+	destroyImageResources();
+
+	if (m_vk_swapchain != VK_NULL_HANDLE) {
+		vkDestroySwapchainKHR(m_vk_logical_device, m_vk_swapchain, m_allocation_callbacks);
+		m_vk_swapchain = VK_NULL_HANDLE;
+	}
+
+	m_extent = {};
+	m_format = VK_FORMAT_UNDEFINED;
+}
+
+void Swapchain::destroyImageResources()
+{
+	for (VkSemaphore semaphore : m_render_finished_semaphores) {
+		if (semaphore != VK_NULL_HANDLE) {
+			vkDestroySemaphore(m_vk_logical_device, semaphore, m_allocation_callbacks);
+		}
+	}
+
+	for (VkImageView image_view : m_image_views) {
+		if (image_view != VK_NULL_HANDLE) {
+			vkDestroyImageView(m_vk_logical_device, image_view, m_allocation_callbacks);
+		}
+	}
+
+	m_render_finished_semaphores.clear();
+	m_image_views.clear();
+	m_images.clear();
+}
+
+VkResult Swapchain::acquireNextImage(VkSemaphore image_available_semaphore, uint32_t& out_image_idx)
+{
+	return vkAcquireNextImageKHR(m_vk_logical_device, m_vk_swapchain, UINT64_MAX, image_available_semaphore, VK_NULL_HANDLE, &out_image_idx);
+}
+
+VkResult Swapchain::present(DeviceQueue& present_queue, uint32_t image_idx)
+{
+	VkPresentInfoKHR present_info{};
+	present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	present_info.pNext = nullptr;
+	present_info.waitSemaphoreCount = 1;
+	present_info.pWaitSemaphores = &m_render_finished_semaphores[image_idx];
+	present_info.swapchainCount = 1;
+	present_info.pSwapchains = &m_vk_swapchain;
+	present_info.pImageIndices = &image_idx;
+	present_info.pResults = nullptr;
+
+	return present_queue.present(present_info);
+}
+
+bool Swapchain::isCreated() const
+{
+	return m_vk_swapchain != VK_NULL_HANDLE;
+}
+
+VkSwapchainKHR Swapchain::getHandle() const
+{
+	return m_vk_swapchain;
+}
+
+VkFormat Swapchain::getFormat() const
+{
+	return m_format;
+}
+
+VkExtent2D Swapchain::getExtent() const
+{
+	return m_extent;
+}
+
+VkPresentModeKHR Swapchain::getPresentMode() const
+{
+	return m_present_mode;
+}
+
+uint32_t Swapchain::getImagesCount() const
+{
+	return static_cast<uint32_t>(m_images.size());
+}
+
+VkImage Swapchain::getImage(uint32_t image_idx) const
+{
+	return m_images[image_idx];
+}
+
+VkImageView Swapchain::getImageView(uint32_t image_idx) const
+{
+	return m_image_views[image_idx];
+}
+
+VkSemaphore Swapchain::getRenderFinishedSemaphore(uint32_t image_idx) const
+{
+	return m_render_finished_semaphores[image_idx];
+}
+
+const char* Swapchain::getPresentModeName(VkPresentModeKHR present_mode)
+{
+	switch (present_mode) {
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:
+		return "IMMEDIATE";
+	case VK_PRESENT_MODE_MAILBOX_KHR:
+		return "MAILBOX";
+	case VK_PRESENT_MODE_FIFO_KHR:
+		return "FIFO";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+		return "FIFO_RELAXED";
+	default:
+		return "UNKNOWN";
+	}
+}
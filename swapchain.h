@@ -0,0 +1,48 @@
+#pragma once
+
+#include "device_queue.h"
+#include <Volk/volk.h>
+#include <string>
+#include <vector>
+
+namespace Simulator {
+	struct SwapchainSettings {
+		VkPresentModeKHR present_mode = VK_PRESENT_MODE_FIFO_KHR;
+		uint32_t images_count = 3;
+		uint32_t frames_in_flight_count = 2;
+	};
+
+	class Swapchain {
+	public:
+		~Swapchain();
+		bool create(VkPhysicalDevice physical_device, VkDevice logical_device, VkSurfaceKHR surface, const std::vector<uint32_t>& queue_family_indices,
+			uint32_t width, uint32_t height, VkPresentModeKHR present_mode, uint32_t images_count, const VkAllocationCallbacks* allocation_callbacks,
+			std::string& out_error_message);
+		void destroy();
+		VkResult acquireNextImage(VkSemaphore image_available_semaphore, uint32_t& out_image_idx);
+		VkResult present(DeviceQueue& present_queue, uint32_t image_idx);
+		bool isCreated() const;
+		VkSwapchainKHR getHandle() const;
+		VkFormat getFormat() const;
+		VkExtent2D getExtent() const;
+		VkPresentModeKHR getPresentMode() const;
+		uint32_t getImagesCount() const;
+		VkImage getImage(uint32_t image_idx) const;
+		VkImageView getImageView(uint32_t image_idx) const;
+		VkSemaphore getRenderFinishedSemaphore(uint32_t image_idx) const;
+		static const char* getPresentModeName(VkPresentModeKHR present_mode);
+
+	private:
+		void destroyImageResources();
+
+		VkDevice m_vk_logical_device = VK_NULL_HANDLE;
+		const VkAllocationCallbacks* m_allocation_callbacks = nullptr;
+		VkSwapchainKHR m_vk_swapchain = VK_NULL_HANDLE;
+		VkFormat m_format = VK_FORMAT_UNDEFINED;
+		VkExtent2D m_extent{};
+		VkPresentModeKHR m_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+		std::vector<VkImage> m_images;
+		std::vector<VkImageView> m_image_views;
+		std::vector<VkSemaphore> m_render_finished_semaphores;
+	};
+}
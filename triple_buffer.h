@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace Simulator {
+	// Single producer, single consumer handoff of the latest value. The writer and the reader each own one buffer and swap
+	// it with the shared one, so neither side ever waits and the reader always sees the most recently published value.
+	template<typename T>
+	class TripleBuffer {
+	public:
+		T& getWriteBuffer()
+		{
+			return m_buffers[m_write_idx];
+		}
+
+		void publish()
+		{
+			uint8_t previous_state = m_shared_state.exchange(m_write_idx | DIRTY_BIT, std::memory_order_acq_rel);
+			m_write_idx = previous_state & INDEX_MASK;
+		}
+
+		bool hasNewData() const
+		{
+			return (m_shared_state.load(std::memory_order_relaxed) & DIRTY_BIT) != 0;
+		}
+
+		bool acquire()
+		{
+			if (!hasNewData()) {
+				return false;
+			}
+
+			uint8_t previous_state = m_shared_state.exchange(m_read_idx, std::memory_order_acq_rel);
+			m_read_idx = previous_state & INDEX_MASK;
+			return true;
+		}
+
+		T& getReadBuffer()
+		{
+			return m_buffers[m_read_idx];
+		}
+
+	private:
+		static constexpr uint8_t INDEX_MASK = 0x3;
+		static constexpr uint8_t DIRTY_BIT = 0x4;
+
+		T m_buffers[3];
+		alignas(64) uint8_t m_write_idx = 0;
+		alignas(64) std::atomic<uint8_t> m_shared_state = 1;
+		alignas(64) uint8_t m_read_idx = 2;
+	};
+}
@@ -0,0 +1,208 @@
+#include "uniform_grid.h"
+#include "job_system.h"
+#include "world.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Simulator;
+
+static constexpr float MAX_CELL_COORDINATE = 1e9f;
+static constexpr float MIN_CELL_SIZE = 1e-3f;
+
+static constexpr int32_t NEIGHBOR_OFFSETS[14][3] = {
+	{ 0, 0, 0 }, { 1, 0, 0 }, { -1, 1, 0 }, { 0, 1, 0 }, { 1, 1, 0 }, { -1, -1, 1 }, { 0, -1, 1 },
+	{ 1, -1, 1 }, { -1, 0, 1 }, { 0, 0, 1 }, { 1, 0, 1 }, { -1, 1, 1 }, { 0, 1, 1 }, { 1, 1, 1 }
+};
+
+template<typename Function>
+static void runRange(JobSystem* job_system, size_t count, size_t chunk_size, Function function)
+{
+	if (job_system != nullptr) {
+		job_system->parallelFor(count, chunk_size, function);
+	}
+	else {
+		function(0, count);
+	}
+}
+
+void UniformGrid::build(const World& world, float cell_size, size_t chunk_size, JobSystem* job_system)
+{
+	size_t bodies_count = world.getBodiesCount();
+	const float* position_x = world.getPositionsX();
+	const float* position_y = world.getPositionsY();
+	const float* position_z = world.getPositionsZ();
+	const float* radius = world.getRadii();
+	const float* inverse_mass = world.getInverseMasses();
+
+	float max_radius = 0.0f;
+	for (size_t i = 0; i < bodies_count; i++) {
+		max_radius = std::max(max_radius, radius[i]);
+	}
+
+	// Only the neighboring cells are searched, so a body must not span more than two cells along an axis.
+	cell_size = std::max(cell_size, max_radius * 2.0f);
+
+	m_cell_size = std::max(cell_size, MIN_CELL_SIZE);
+	m_inverse_cell_size = 1.0f / m_cell_size;
+	m_body_cells.resize(bodies_count * 3);
+
+	runRange(job_system, bodies_count, chunk_size, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++) {
+				m_body_cells[i * 3] = getCell(position_x[i]);
+				m_body_cells[i * 3 + 1] = getCell(position_y[i]);
+				m_body_cells[i * 3 + 2] = getCell(position_z[i]);
+			}
+		});
+
+	int32_t min_cell[3] = { INT32_MAX, INT32_MAX, INT32_MAX };
+	int32_t max_cell[3] = { INT32_MIN, INT32_MIN, INT32_MIN };
+	for (size_t i = 0; i < bodies_count; i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			min_cell[axis] = std::min(min_cell[axis], m_body_cells[i * 3 + axis]);
+			max_cell[axis] = std::max(max_cell[axis], m_body_cells[i * 3 + axis]);
+		}
+	}
+
+	// Each axis can span up to 2e9 cells, the product is kept in double so it cannot wrap around.
+	double dense_cells_count = 1.0;
+	for (int axis = 0; axis < 3; axis++) {
+		m_origin_cell[axis] = min_cell[axis];
+		m_dimensions[axis] = (bodies_count > 0) ? static_cast<uint32_t>(static_cast<int64_t>(max_cell[axis]) - min_cell[axis] + 1) : 1;
+		dense_cells_count *= m_dimensions[axis];
+	}
+
+	size_t max_dense_cells_count = std::max(bodies_count * MAX_DENSE_CELLS_PER_BODY, MIN_BUCKETS_COUNT);
+	m_hashed = (dense_cells_count > static_cast<double>(max_dense_cells_count));
+
+	if (m_hashed) {
+		size_t buckets_count = MIN_BUCKETS_COUNT;
+		while (buckets_count < bodies_count * 2) {
+			buckets_count *= 2;
+		}
+
+		m_buckets_count = static_cast<uint32_t>(buckets_count);
+		m_buckets_mask = m_buckets_count - 1;
+	}
+	else {
+		m_buckets_count = static_cast<uint32_t>(dense_cells_count);
+		m_buckets_mask = 0;
+	}
+
+	m_body_buckets.resize(bodies_count);
+
+	runRange(job_system, bodies_count, chunk_size, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++) {
+				m_body_buckets[i] = getBucket(m_body_cells[i * 3], m_body_cells[i * 3 + 1], m_body_cells[i * 3 + 2]);
+			}
+		});
+
+	// One extra bucket stays empty, cells outside of the dense bounds map to it.
+	m_bucket_starts.assign(static_cast<size_t>(m_buckets_count) + 2, 0);
+	for (size_t i = 0; i < bodies_count; i++) {
+		m_bucket_starts[m_body_buckets[i] + 1]++;
+	}
+
+	for (size_t i = 0; i <= m_buckets_count; i++) {
+		m_bucket_starts[i + 1] += m_bucket_starts[i];
+	}
+
+	m_bucket_cursors.assign(m_bucket_starts.begin(), m_bucket_starts.end() - 1);
+	m_sorted_body_indices.resize(bodies_count);
+	m_sorted_aabbs.resize(bodies_count);
+	m_sorted_cells.resize(bodies_count * 3);
+	m_sorted_static_flags.resize(bodies_count);
+
+	for (size_t i = 0; i < bodies_count; i++) {
+		uint32_t body_idx = static_cast<uint32_t>(i);
+		uint32_t sorted_idx = m_bucket_cursors[m_body_buckets[i]]++;
+
+		m_sorted_body_indices[sorted_idx] = body_idx;
+		m_sorted_aabbs[sorted_idx] = getBodyAabb(position_x, position_y, position_z, radius, body_idx);
+		m_sorted_cells[sorted_idx * 3] = m_body_cells[i * 3];
+		m_sorted_cells[sorted_idx * 3 + 1] = m_body_cells[i * 3 + 1];
+		m_sorted_cells[sorted_idx * 3 + 2] = m_body_cells[i * 3 + 2];
+		m_sorted_static_flags[sorted_idx] = (inverse_mass[i] == 0.0f) ? 1 : 0;
+	}
+}
+
+void UniformGrid::findPairs(size_t begin, size_t end, std::vector<BroadphasePair>& out_pairs) const
+{
+	end = std::min(end, m_sorted_body_indices.size());
+
+	for (size_t sorted_idx = begin; sorted_idx < end; sorted_idx++) {
+		uint32_t body_idx = m_sorted_body_indices[sorted_idx];
+		const Aabb& aabb = m_sorted_aabbs[sorted_idx];
+		const int32_t* cell = &m_sorted_cells[sorted_idx * 3];
+		bool is_static = (m_sorted_static_flags[sorted_idx] != 0);
+
+		// The own cell plus the 13 neighbors ahead of it, so every pair of cells is visited once.
+		for (const int32_t* offset : NEIGHBOR_OFFSETS) {
+			int32_t cell_x = cell[0] + offset[0];
+			int32_t cell_y = cell[1] + offset[1];
+			int32_t cell_z = cell[2] + offset[2];
+			uint32_t bucket = getBucket(cell_x, cell_y, cell_z);
+			bool is_own_cell = (offset == NEIGHBOR_OFFSETS[0]);
+			uint32_t first_idx = is_own_cell ? static_cast<uint32_t>(sorted_idx + 1) : m_bucket_starts[bucket];
+
+			for (uint32_t other_idx = first_idx; other_idx < m_bucket_starts[bucket + 1]; other_idx++) {
+				// Several cells can share a hashed bucket, only look at the bodies of the visited cell.
+				const int32_t* other_cell = &m_sorted_cells[other_idx * 3];
+				if (m_hashed && ((other_cell[0] != cell_x) || (other_cell[1] != cell_y) || (other_cell[2] != cell_z))) {
+					continue;
+				}
+
+				if ((is_static && (m_sorted_static_flags[other_idx] != 0)) || !isOverlapping(aabb, m_sorted_aabbs[other_idx])) {
+					continue;
+				}
+
+				uint32_t other_body_idx = m_sorted_body_indices[other_idx];
+				out_pairs.push_back({ std::min(body_idx, other_body_idx), std::max(body_idx, other_body_idx) });
+			}
+		}
+	}
+}
+
+float UniformGrid::getCellSize() const
+{
+	return m_cell_size;
+}
+
+size_t UniformGrid::getBucketsCount() const
+{
+	return m_buckets_count;
+}
+
+bool UniformGrid::isHashed() const
+{
+	return m_hashed;
+}
+
+int32_t UniformGrid::getCell(float position) const
+{
+	float coordinate = position * m_inverse_cell_size;
+	if (std::isnan(coordinate)) {
+		return 0;
+	}
+
+	return static_cast<int32_t>(std::floor(std::clamp(coordinate, -MAX_CELL_COORDINATE, MAX_CELL_COORDINATE)));
+}
+
+uint32_t UniformGrid::getBucket(int32_t cell_x, int32_t cell_y, int32_t cell_z) const
+{
+	if (m_hashed) {
+		uint32_t hash = (static_cast<uint32_t>(cell_x) * 73856093u) ^ (static_cast<uint32_t>(cell_y) * 19349663u) ^
+			(static_cast<uint32_t>(cell_z) * 83492791u);
+		return hash & m_buckets_mask;
+	}
+
+	uint32_t x = static_cast<uint32_t>(cell_x - m_origin_cell[0]);
+	uint32_t y = static_cast<uint32_t>(cell_y - m_origin_cell[1]);
+	uint32_t z = static_cast<uint32_t>(cell_z - m_origin_cell[2]);
+	if ((x >= m_dimensions[0]) || (y >= m_dimensions[1]) || (z >= m_dimensions[2])) {
+		return m_buckets_count;
+	}
+
+	return (z * m_dimensions[1] + y) * m_dimensions[0] + x;
+}
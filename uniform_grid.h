@@ -0,0 +1,47 @@
+#pragma once
+
+#include "aligned_allocator.h"
+#include "broadphase.h"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Simulator {
+	class World;
+	class JobSystem;
+
+	// Grid of cells at least as large as the largest body. Bodies are counting sorted by cell bucket, so the bodies of
+	// one cell are contiguous in memory. Buckets index the cells directly while the occupied bounds are small enough,
+	// which keeps neighboring cells close in memory, and fall back to a spatial hash for sparse scenes.
+	class UniformGrid {
+	public:
+		void build(const World& world, float cell_size, size_t chunk_size, JobSystem* job_system);
+		void findPairs(size_t begin, size_t end, std::vector<BroadphasePair>& out_pairs) const;
+		float getCellSize() const;
+		size_t getBucketsCount() const;
+		bool isHashed() const;
+
+		static constexpr size_t MIN_BUCKETS_COUNT = 1024;
+		static constexpr size_t MAX_DENSE_CELLS_PER_BODY = 8;
+
+	private:
+		int32_t getCell(float position) const;
+		uint32_t getBucket(int32_t cell_x, int32_t cell_y, int32_t cell_z) const;
+
+		float m_cell_size = 0.0f;
+		float m_inverse_cell_size = 0.0f;
+		bool m_hashed = true;
+		int32_t m_origin_cell[3]{};
+		uint32_t m_dimensions[3]{};
+		uint32_t m_buckets_count = 0;
+		uint32_t m_buckets_mask = 0;
+		std::vector<uint32_t> m_bucket_starts;
+		std::vector<uint32_t> m_bucket_cursors;
+		std::vector<uint32_t> m_body_buckets;
+		std::vector<int32_t> m_body_cells;
+		std::vector<uint32_t> m_sorted_body_indices;
+		AlignedVector<Aabb> m_sorted_aabbs;
+		AlignedVector<int32_t> m_sorted_cells;
+		std::vector<uint8_t> m_sorted_static_flags;
+	};
+}
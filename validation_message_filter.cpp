@@ -0,0 +1,83 @@
+#include "validation_message_filter.h"
+
+using namespace Simulator;
+
+static constexpr uint64_t ENTRY_KEY_USED_BIT = 1ull << 32;
+
+ValidationMessageFilter::ValidationMessageFilter(std::chrono::nanoseconds window) :
+	m_window_ns(static_cast<uint64_t>(window.count()))
+{
+}
+
+uint32_t ValidationMessageFilter::getMessageId(int32_t message_id_number, const char* message_id_name)
+{
+	if (message_id_number != 0) {
+		return static_cast<uint32_t>(message_id_number);
+	}
+
+	if (message_id_name == nullptr) {
+		return 0;
+	}
+
+	uint32_t hash = 2166136261u;
+	for (const char* c = message_id_name; *c != '\0'; c++) {
+		hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+	}
+
+	return (hash != 0) ? hash : 1;
+}
+
+bool ValidationMessageFilter::filter(uint32_t message_id, LogLevel level, uint64_t timestamp, Summary& out_summary)
+{
+	out_summary.repeated_count = 0;
+
+	Entry* entry = (message_id != 0) ? findEntry(message_id) : nullptr;
+	if (entry == nullptr) {
+		m_untracked_count.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	uint64_t window_start = entry->window_start.load(std::memory_order_relaxed);
+
+	if (isWindowExpired(window_start, timestamp) &&
+		entry->window_start.compare_exchange_strong(window_start, timestamp, std::memory_order_relaxed)) {
+		out_summary.message_id = message_id;
+		out_summary.level = entry->level.exchange(level, std::memory_order_relaxed);
+		out_summary.repeated_count = entry->suppressed_count.exchange(0, std::memory_order_relaxed);
+		return true;
+	}
+
+	entry->suppressed_count.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+uint64_t ValidationMessageFilter::getUntrackedCount() const
+{
+	return m_untracked_count.load(std::memory_order_relaxed);
+}
+
+ValidationMessageFilter::Entry* ValidationMessageFilter::findEntry(uint32_t message_id)
+{
+	uint64_t key = ENTRY_KEY_USED_BIT | message_id;
+	size_t idx = static_cast<size_t>((message_id * 2654435769u) >> (32 - TABLE_SIZE_LOG2)) & (TABLE_SIZE - 1);
+
+	for (size_t i = 0; i < MAX_PROBES_COUNT; i++) {
+		Entry& entry = m_entries[(idx + i) & (TABLE_SIZE - 1)];
+		uint64_t entry_key = entry.key.load(std::memory_order_acquire);
+
+		if (entry_key == key) {
+			return &entry;
+		}
+
+		if ((entry_key == 0) && (entry.key.compare_exchange_strong(entry_key, key, std::memory_order_acq_rel) || (entry_key == key))) {
+			return &entry;
+		}
+	}
+
+	return nullptr;
+}
+
+bool ValidationMessageFilter::isWindowExpired(uint64_t window_start, uint64_t timestamp) const
+{
+	return (window_start == 0) || ((timestamp >= window_start) && (timestamp - window_start >= m_window_ns));
+}
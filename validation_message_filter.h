@@ -0,0 +1,67 @@
+#pragma once
+
+#include "log_record.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Simulator {
+	class ValidationMessageFilter {
+	public:
+		struct Summary {
+			uint32_t message_id = 0;
+			LogLevel level = LogLevel::VERBOSE;
+			uint64_t repeated_count = 0;
+		};
+
+		static constexpr size_t TABLE_SIZE_LOG2 = 10;
+		static constexpr size_t TABLE_SIZE = size_t(1) << TABLE_SIZE_LOG2;
+		static constexpr size_t MAX_PROBES_COUNT = 32;
+
+		explicit ValidationMessageFilter(std::chrono::nanoseconds window = std::chrono::seconds(1));
+		static uint32_t getMessageId(int32_t message_id_number, const char* message_id_name);
+		bool filter(uint32_t message_id, LogLevel level, uint64_t timestamp, Summary& out_summary);
+		template<typename Report>
+		void collectSummaries(uint64_t timestamp, bool force, Report&& report);
+		uint64_t getUntrackedCount() const;
+
+	private:
+		struct Entry {
+			std::atomic<uint64_t> key = 0;
+			std::atomic<uint64_t> window_start = 0;
+			std::atomic<uint64_t> suppressed_count = 0;
+			std::atomic<LogLevel> level = LogLevel::VERBOSE;
+		};
+
+		Entry* findEntry(uint32_t message_id);
+		bool isWindowExpired(uint64_t window_start, uint64_t timestamp) const;
+
+		std::array<Entry, TABLE_SIZE> m_entries;
+		uint64_t m_window_ns;
+		std::atomic<uint64_t> m_untracked_count = 0;
+	};
+
+	template<typename Report>
+	void ValidationMessageFilter::collectSummaries(uint64_t timestamp, bool force, Report&& report)
+	{
+		for (Entry& entry : m_entries) {
+			uint64_t key = entry.key.load(std::memory_order_acquire);
+
+			if ((key == 0) || (entry.suppressed_count.load(std::memory_order_relaxed) == 0) ||
+				(!force && !isWindowExpired(entry.window_start.load(std::memory_order_relaxed), timestamp))) {
+				continue;
+			}
+
+			Summary summary;
+			summary.message_id = static_cast<uint32_t>(key);
+			summary.level = entry.level.load(std::memory_order_relaxed);
+			summary.repeated_count = entry.suppressed_count.exchange(0, std::memory_order_relaxed);
+
+			if (summary.repeated_count > 0) {
+				report(summary);
+			}
+		}
+	}
+}
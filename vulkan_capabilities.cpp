@@ -0,0 +1,257 @@
+#include "vulkan_capabilities.h"
+#include <cstring>
+
+using namespace Simulator;
+
+bool InstanceCapabilities::load(std::string& out_error_message)
+{
+	m_loaded = false;
+	m_layers.clear();
+	m_extensions.clear();
+
+	m_api_version = volkGetInstanceVersion();
+	if (m_api_version == 0) {
+		out_error_message = "Failed to get Vulkan version.";
+		return false;
+	}
+
+	VkResult vk_error = VK_SUCCESS;
+
+#ifdef DEBUG
+	uint32_t layers_count;
+	vk_error = vkEnumerateInstanceLayerProperties(&layers_count, nullptr);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to enumerate Vulkan instance layers. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	std::vector<VkLayerProperties> layers(layers_count);
+	vk_error = vkEnumerateInstanceLayerProperties(&layers_count, layers.data());
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to enumerate Vulkan instance layers. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	for (uint32_t i = 0; i < layers_count; i++) {
+		m_layers.emplace(layers[i].layerName);
+	}
+#endif
+
+	uint32_t extensions_count;
+	vk_error = vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, nullptr);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to enumerate Vulkan instance extensions. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	std::vector<VkExtensionProperties> extensions(extensions_count);
+	vk_error = vkEnumerateInstanceExtensionProperties(nullptr, &extensions_count, extensions.data());
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to enumerate Vulkan instance extensions. VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	for (uint32_t i = 0; i < extensions_count; i++) {
+		m_extensions.emplace(extensions[i].extensionName);
+	}
+
+	m_loaded = true;
+	return true;
+}
+
+bool InstanceCapabilities::isLoaded() const
+{
+	return m_loaded;
+}
+
+uint32_t InstanceCapabilities::getApiVersion() const
+{
+	return m_api_version;
+}
+
+bool InstanceCapabilities::hasLayer(std::string_view layer_name) const
+{
+	return m_layers.find(layer_name) != m_layers.end();
+}
+
+bool InstanceCapabilities::hasExtension(std::string_view extension_name) const
+{
+	return m_extensions.find(extension_name) != m_extensions.end();
+}
+
+/**************************************************************************************/
+
+bool DeviceCapabilities::load(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::string& out_error_message)
+{
+	m_physical_device = physical_device;
+
+	VkPhysicalDeviceIDProperties id_properties{};
+	id_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+	id_properties.pNext = nullptr;
+
+	VkPhysicalDeviceProperties2 properties2{};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties2.pNext = &id_properties;
+
+	vkGetPhysicalDeviceProperties2(physical_device, &properties2);
+	m_properties = properties2.properties;
+	memcpy(m_device_uuid, id_properties.deviceUUID, VK_UUID_SIZE);
+
+	vkGetPhysicalDeviceMemoryProperties(physical_device, &m_memory_properties);
+	vkGetPhysicalDeviceFeatures(physical_device, &m_features);
+
+	m_timeline_semaphore_supported = false;
+	m_synchronization2_supported = false;
+	m_draw_indirect_count_supported = false;
+
+	if (VK_API_VERSION_MINOR(m_properties.apiVersion) >= 3) {
+		VkPhysicalDeviceVulkan13Features vulkan13_features{};
+		vulkan13_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+		vulkan13_features.pNext = nullptr;
+
+		VkPhysicalDeviceVulkan12Features vulkan12_features{};
+		vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		vulkan12_features.pNext = &vulkan13_features;
+
+		VkPhysicalDeviceFeatures2 features2{};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &vulkan12_features;
+
+		vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+		m_timeline_semaphore_supported = (vulkan12_features.timelineSemaphore == VK_TRUE);
+		m_synchronization2_supported = (vulkan13_features.synchronization2 == VK_TRUE);
+		m_draw_indirect_count_supported = (vulkan12_features.drawIndirectCount == VK_TRUE);
+	}
+
+	/**************************************************************************************/
+
+	uint32_t queue_families_count;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, nullptr);
+
+	m_queue_families.resize(queue_families_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_families_count, m_queue_families.data());
+	m_queue_families.resize(queue_families_count);
+
+	m_present_supported.assign(queue_families_count, (surface == VK_NULL_HANDLE) ? VK_TRUE : VK_FALSE);
+
+	if (surface != VK_NULL_HANDLE) {
+		for (uint32_t i = 0; i < queue_families_count; i++) {
+			VkResult vk_error = vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &m_present_supported[i]);
+			if (vk_error != VK_SUCCESS) {
+				out_error_message = "Failed to query Vulkan physical device \"" + std::string(m_properties.deviceName) +
+					"\" for presentation support. VK error:" + std::to_string(vk_error) + ".";
+				return false;
+			}
+		}
+	}
+
+	/**************************************************************************************/
+
+	VkResult vk_error = VK_SUCCESS;
+	m_layers.clear();
+	m_extensions.clear();
+
+#ifdef DEBUG
+	uint32_t layers_count;
+	vk_error = vkEnumerateDeviceLayerProperties(physical_device, &layers_count, nullptr);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to enumerate layers for Vulkan physical device: \"" + std::string(m_properties.deviceName) + "\". "
+			"VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	std::vector<VkLayerProperties> layers(layers_count);
+	vk_error = vkEnumerateDeviceLayerProperties(physical_device, &layers_count, layers.data());
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to enumerate layers for Vulkan physical device: \"" + std::string(m_properties.deviceName) + "\". "
+			"VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	for (uint32_t i = 0; i < layers_count; i++) {
+		m_layers.emplace(layers[i].layerName);
+	}
+#endif
+
+	uint32_t extensions_count;
+	vk_error = vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extensions_count, nullptr);
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to enumerate extensions for Vulkan physical device: \"" + std::string(m_properties.deviceName) + "\". "
+			"VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	std::vector<VkExtensionProperties> extensions(extensions_count);
+	vk_error = vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extensions_count, extensions.data());
+	if (vk_error != VK_SUCCESS) {
+		out_error_message = "Failed to enumerate extensions for Vulkan physical device: \"" + std::string(m_properties.deviceName) + "\". "
+			"VK error:" + std::to_string(vk_error) + ".";
+		return false;
+	}
+
+	for (uint32_t i = 0; i < extensions_count; i++) {
+		m_extensions.emplace(extensions[i].extensionName);
+	}
+
+	return true;
+}
+
+VkPhysicalDevice DeviceCapabilities::getPhysicalDevice() const
+{
+	return m_physical_device;
+}
+
+const VkPhysicalDeviceProperties& DeviceCapabilities::getProperties() const
+{
+	return m_properties;
+}
+
+const uint8_t* DeviceCapabilities::getDeviceUuid() const
+{
+	return m_device_uuid;
+}
+
+const VkPhysicalDeviceMemoryProperties& DeviceCapabilities::getMemoryProperties() const
+{
+	return m_memory_properties;
+}
+
+const VkPhysicalDeviceFeatures& DeviceCapabilities::getFeatures() const
+{
+	return m_features;
+}
+
+const std::vector<VkQueueFamilyProperties>& DeviceCapabilities::getQueueFamilies() const
+{
+	return m_queue_families;
+}
+
+bool DeviceCapabilities::isTimelineSemaphoreSupported() const
+{
+	return m_timeline_semaphore_supported;
+}
+
+bool DeviceCapabilities::isSynchronization2Supported() const
+{
+	return m_synchronization2_supported;
+}
+
+bool DeviceCapabilities::isDrawIndirectCountSupported() const
+{
+	return m_draw_indirect_count_supported;
+}
+
+bool DeviceCapabilities::isPresentSupported(uint32_t queue_family_idx) const
+{
+	return (queue_family_idx < m_present_supported.size()) && (m_present_supported[queue_family_idx] == VK_TRUE);
+}
+
+bool DeviceCapabilities::hasLayer(std::string_view layer_name) const
+{
+	return m_layers.find(layer_name) != m_layers.end();
+}
+
+bool DeviceCapabilities::hasExtension(std::string_view extension_name) const
+{
+	return m_extensions.find(extension_name) != m_extensions.end();
+}
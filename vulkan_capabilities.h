@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Volk/volk.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
+
+namespace Simulator {
+	struct StringHash {
+		using is_transparent = void;
+
+		size_t operator()(std::string_view value) const
+		{
+			return std::hash<std::string_view>{}(value);
+		}
+	};
+
+	using StringSet = std::unordered_set<std::string, StringHash, std::equal_to<>>;
+
+	class InstanceCapabilities {
+	public:
+		bool load(std::string& out_error_message);
+		bool isLoaded() const;
+		uint32_t getApiVersion() const;
+		bool hasLayer(std::string_view layer_name) const;
+		bool hasExtension(std::string_view extension_name) const;
+
+	private:
+		bool m_loaded = false;
+		uint32_t m_api_version = 0;
+		StringSet m_layers;
+		StringSet m_extensions;
+	};
+
+	class DeviceCapabilities {
+	public:
+		bool load(VkPhysicalDevice physical_device, VkSurfaceKHR surface, std::string& out_error_message);
+		VkPhysicalDevice getPhysicalDevice() const;
+		const VkPhysicalDeviceProperties& getProperties() const;
+		const uint8_t* getDeviceUuid() const;
+		const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const;
+		const VkPhysicalDeviceFeatures& getFeatures() const;
+		bool isTimelineSemaphoreSupported() const;
+		bool isSynchronization2Supported() const;
+		bool isDrawIndirectCountSupported() const;
+		const std::vector<VkQueueFamilyProperties>& getQueueFamilies() const;
+		bool isPresentSupported(uint32_t queue_family_idx) const;
+		bool hasLayer(std::string_view layer_name) const;
+		bool hasExtension(std::string_view extension_name) const;
+
+	private:
+		VkPhysicalDevice m_physical_device = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties m_properties{};
+		uint8_t m_device_uuid[VK_UUID_SIZE]{};
+		VkPhysicalDeviceMemoryProperties m_memory_properties{};
+		VkPhysicalDeviceFeatures m_features{};
+		bool m_timeline_semaphore_supported = false;
+		bool m_synchronization2_supported = false;
+		bool m_draw_indirect_count_supported = false;
+		std::vector<VkQueueFamilyProperties> m_queue_families;
+		std::vector<VkBool32> m_present_supported;
+		StringSet m_layers;
+		StringSet m_extensions;
+	};
+}
@@ -0,0 +1,92 @@
+#include "work_stealing_deque.h"
+
+using namespace Simulator;
+
+bool WorkStealingDeque::init(size_t capacity, std::string& out_error_message)
+{
+	if ((capacity < 2) || ((capacity & (capacity - 1)) != 0)) {
+		out_error_message = "Work stealing deque capacity must be a power of two.";
+		return false;
+	}
+
+	m_jobs = std::make_unique<std::atomic<Job*>[]>(capacity);
+	for (size_t i = 0; i < capacity; i++) {
+		m_jobs[i].store(nullptr, std::memory_order_relaxed);
+	}
+
+	m_mask = static_cast<int64_t>(capacity - 1);
+	m_top.store(0, std::memory_order_relaxed);
+	m_bottom.store(0, std::memory_order_relaxed);
+
+	return true;
+}
+
+bool WorkStealingDeque::push(Job* job)
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	int64_t top = m_top.load(std::memory_order_acquire);
+
+	if (bottom - top > m_mask) {
+		return false;
+	}
+
+	m_jobs[bottom & m_mask].store(job, std::memory_order_relaxed);
+	m_bottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+Job* WorkStealingDeque::pop()
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = m_top.load(std::memory_order_relaxed);
+
+	if (top > bottom) {
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = m_jobs[bottom & m_mask].load(std::memory_order_relaxed);
+
+	if (top == bottom) {
+		// Last job, race the thieves for it.
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			job = nullptr;
+		}
+
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+Job* WorkStealingDeque::steal()
+{
+	int64_t top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom) {
+		return nullptr;
+	}
+
+	Job* job = m_jobs[top & m_mask].load(std::memory_order_relaxed);
+	if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+		return nullptr;
+	}
+
+	return job;
+}
+
+bool WorkStealingDeque::isEmpty() const
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	int64_t top = m_top.load(std::memory_order_relaxed);
+	return top >= bottom;
+}
+
+size_t WorkStealingDeque::getCapacity() const
+{
+	return static_cast<size_t>(m_mask + 1);
+}
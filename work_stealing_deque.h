@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace Simulator {
+	struct Job;
+
+	// Chase-Lev deque with a fixed capacity. Only the owner thread calls push() and pop(), any thread can call steal().
+	class WorkStealingDeque {
+	public:
+		bool init(size_t capacity, std::string& out_error_message);
+		bool push(Job* job);
+		Job* pop();
+		Job* steal();
+		bool isEmpty() const;
+		size_t getCapacity() const;
+
+	private:
+		std::unique_ptr<std::atomic<Job*>[]> m_jobs;
+		int64_t m_mask = 0;
+		alignas(64) std::atomic<int64_t> m_top = 0;
+		alignas(64) std::atomic<int64_t> m_bottom = 0;
+	};
+}
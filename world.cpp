@@ -0,0 +1,335 @@
+#include "world.h"
+#include "world_kernels.h"
+#include "job_system.h"
+#include <algorithm>
+
+#if defined(_MSC_VER) && defined(SIMULATOR_SIMD_X86)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+using namespace Simulator;
+
+static bool isAvx2Supported()
+{
+#if defined(_MSC_VER) && defined(SIMULATOR_SIMD_X86)
+	int cpu_info[4];
+	__cpuid(cpu_info, 0);
+	if (cpu_info[0] < 7) {
+		return false;
+	}
+
+	__cpuid(cpu_info, 1);
+	bool osxsave_supported = (cpu_info[2] & (1 << 27)) != 0;
+	bool avx_supported = (cpu_info[2] & (1 << 28)) != 0;
+	bool fma_supported = (cpu_info[2] & (1 << 12)) != 0;
+	if (!osxsave_supported || !avx_supported || !fma_supported || ((_xgetbv(0) & 0x6) != 0x6)) {
+		return false;
+	}
+
+	__cpuidex(cpu_info, 7, 0);
+	return (cpu_info[1] & (1 << 5)) != 0;
+#elif defined(SIMULATOR_SIMD_X86)
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+	return false;
+#endif
+}
+
+static size_t getPaddedCount(size_t count)
+{
+	return (count + World::STREAM_PADDING - 1) / World::STREAM_PADDING * World::STREAM_PADDING;
+}
+
+World::World()
+	: m_simd_path(getBestSimdPath())
+{
+}
+
+void World::reserve(size_t bodies_count)
+{
+	size_t padded_count = getPaddedCount(bodies_count);
+
+	for (Stream* stream : getAllStreams()) {
+		stream->reserve(padded_count);
+	}
+}
+
+void World::clear()
+{
+	for (Stream* stream : getAllStreams()) {
+		stream->clear();
+	}
+
+	m_bodies_count = 0;
+	m_history_dt = 0.0f;
+}
+
+uint32_t World::addBody(float x, float y, float z, float velocity_x, float velocity_y, float velocity_z, float mass, float radius)
+{
+	size_t body_idx = m_bodies_count++;
+
+	if (m_bodies_count > m_position_x.size()) {
+		size_t padded_count = getPaddedCount(m_bodies_count);
+
+		for (Stream* stream : getAllStreams()) {
+			stream->resize(padded_count, 0.0f);
+		}
+	}
+
+	float inverse_mass = (mass > 0.0f) ? (1.0f / mass) : 0.0f;
+	if (inverse_mass == 0.0f) {
+		velocity_x = 0.0f;
+		velocity_y = 0.0f;
+		velocity_z = 0.0f;
+	}
+
+	m_position_x[body_idx] = x;
+	m_position_y[body_idx] = y;
+	m_position_z[body_idx] = z;
+	m_previous_position_x[body_idx] = x - velocity_x * m_history_dt;
+	m_previous_position_y[body_idx] = y - velocity_y * m_history_dt;
+	m_previous_position_z[body_idx] = z - velocity_z * m_history_dt;
+	m_velocity_x[body_idx] = velocity_x;
+	m_velocity_y[body_idx] = velocity_y;
+	m_velocity_z[body_idx] = velocity_z;
+	m_force_x[body_idx] = 0.0f;
+	m_force_y[body_idx] = 0.0f;
+	m_force_z[body_idx] = 0.0f;
+	m_inverse_mass[body_idx] = inverse_mass;
+	m_radius[body_idx] = radius;
+
+	return static_cast<uint32_t>(body_idx);
+}
+
+size_t World::getBodiesCount() const
+{
+	return m_bodies_count;
+}
+
+void World::setGravity(float x, float y, float z)
+{
+	m_gravity[0] = x;
+	m_gravity[1] = y;
+	m_gravity[2] = z;
+}
+
+void World::setDamping(float damping)
+{
+	m_damping = std::max(damping, 0.0f);
+}
+
+void World::applyForce(uint32_t body_idx, float x, float y, float z)
+{
+	m_force_x[body_idx] += x;
+	m_force_y[body_idx] += y;
+	m_force_z[body_idx] += z;
+}
+
+void World::step(float dt, IntegrationMethod method)
+{
+	prepareStep(dt, method);
+	integrate(0, m_position_x.size(), dt, method);
+}
+
+void World::step(float dt, IntegrationMethod method, JobSystem& job_system)
+{
+	prepareStep(dt, method);
+
+	// Split on padding boundaries so every chunk stays on the vector path.
+	size_t blocks_count = m_position_x.size() / STREAM_PADDING;
+	job_system.parallelFor(blocks_count, PARALLEL_CHUNK_SIZE / STREAM_PADDING, [this, dt, method](size_t begin, size_t end)
+		{
+			integrate(begin * STREAM_PADDING, end * STREAM_PADDING, dt, method);
+		});
+}
+
+void World::prepareStep(float dt, IntegrationMethod method)
+{
+	if (method != IntegrationMethod::VERLET) {
+		m_history_dt = 0.0f;
+		return;
+	}
+
+	if (m_history_dt == dt) {
+		return;
+	}
+
+	for (size_t i = 0; i < m_bodies_count; i++) {
+		m_previous_position_x[i] = m_position_x[i] - m_velocity_x[i] * dt;
+		m_previous_position_y[i] = m_position_y[i] - m_velocity_y[i] * dt;
+		m_previous_position_z[i] = m_position_z[i] - m_velocity_z[i] * dt;
+	}
+
+	m_history_dt = dt;
+}
+
+void World::integrate(size_t begin, size_t end, float dt, IntegrationMethod method)
+{
+	end = std::min(end, m_position_x.size());
+	if ((begin >= end) || (dt <= 0.0f)) {
+		return;
+	}
+
+	getIntegrationKernel(m_simd_path, method)(getStreams(), begin, end, getIntegrationParams(dt));
+}
+
+bool World::setSimdPath(SimdPath path)
+{
+	if (!isSimdPathSupported(path)) {
+		return false;
+	}
+
+	m_simd_path = path;
+	return true;
+}
+
+SimdPath World::getSimdPath() const
+{
+	return m_simd_path;
+}
+
+const float* World::getPositionsX() const
+{
+	return m_position_x.data();
+}
+
+const float* World::getPositionsY() const
+{
+	return m_position_y.data();
+}
+
+const float* World::getPositionsZ() const
+{
+	return m_position_z.data();
+}
+
+const float* World::getVelocitiesX() const
+{
+	return m_velocity_x.data();
+}
+
+const float* World::getVelocitiesY() const
+{
+	return m_velocity_y.data();
+}
+
+const float* World::getVelocitiesZ() const
+{
+	return m_velocity_z.data();
+}
+
+const float* World::getInverseMasses() const
+{
+	return m_inverse_mass.data();
+}
+
+const float* World::getRadii() const
+{
+	return m_radius.data();
+}
+
+bool World::isSimdPathSupported(SimdPath path)
+{
+	switch (path) {
+	case SimdPath::SCALAR:
+		return true;
+#ifdef SIMULATOR_SIMD_X86
+	case SimdPath::SSE:
+		return true;
+	case SimdPath::AVX2: {
+		static const bool avx2_supported = isAvx2Supported();
+		return avx2_supported;
+	}
+#endif
+#ifdef SIMULATOR_SIMD_NEON
+	case SimdPath::NEON:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+SimdPath World::getBestSimdPath()
+{
+	for (SimdPath path : { SimdPath::AVX2, SimdPath::NEON, SimdPath::SSE }) {
+		if (isSimdPathSupported(path)) {
+			return path;
+		}
+	}
+
+	return SimdPath::SCALAR;
+}
+
+const char* World::getSimdPathName(SimdPath path)
+{
+	switch (path) {
+	case SimdPath::SCALAR:
+		return "scalar";
+	case SimdPath::SSE:
+		return "sse";
+	case SimdPath::AVX2:
+		return "avx2";
+	case SimdPath::NEON:
+		return "neon";
+	default:
+		return "unknown";
+	}
+}
+
+IntegrationKernel World::getIntegrationKernel(SimdPath path, IntegrationMethod method)
+{
+	bool verlet = (method == IntegrationMethod::VERLET);
+
+	switch (isSimdPathSupported(path) ? path : SimdPath::SCALAR) {
+#ifdef SIMULATOR_SIMD_X86
+	case SimdPath::SSE:
+		return verlet ? integrateVerletSse : integrateEulerSse;
+	case SimdPath::AVX2:
+		return verlet ? integrateVerletAvx2 : integrateEulerAvx2;
+#endif
+#ifdef SIMULATOR_SIMD_NEON
+	case SimdPath::NEON:
+		return verlet ? integrateVerletNeon : integrateEulerNeon;
+#endif
+	default:
+		return verlet ? integrateVerletScalar : integrateEulerScalar;
+	}
+}
+
+IntegrationParams World::getIntegrationParams(float dt) const
+{
+	IntegrationParams params;
+	params.dt = dt;
+	params.gravity_x = m_gravity[0];
+	params.gravity_y = m_gravity[1];
+	params.gravity_z = m_gravity[2];
+	params.velocity_scale = std::max(1.0f - m_damping * dt, 0.0f);
+	return params;
+}
+
+std::array<World::Stream*, World::STREAMS_COUNT> World::getAllStreams()
+{
+	return { &m_position_x, &m_position_y, &m_position_z, &m_previous_position_x, &m_previous_position_y, &m_previous_position_z,
+		&m_velocity_x, &m_velocity_y, &m_velocity_z, &m_force_x, &m_force_y, &m_force_z, &m_inverse_mass, &m_radius };
+}
+
+BodyStreams World::getStreams()
+{
+	BodyStreams streams;
+	streams.position_x = m_position_x.data();
+	streams.position_y = m_position_y.data();
+	streams.position_z = m_position_z.data();
+	streams.previous_position_x = m_previous_position_x.data();
+	streams.previous_position_y = m_previous_position_y.data();
+	streams.previous_position_z = m_previous_position_z.data();
+	streams.velocity_x = m_velocity_x.data();
+	streams.velocity_y = m_velocity_y.data();
+	streams.velocity_z = m_velocity_z.data();
+	streams.force_x = m_force_x.data();
+	streams.force_y = m_force_y.data();
+	streams.force_z = m_force_z.data();
+	streams.inverse_mass = m_inverse_mass.data();
+	return streams;
+}
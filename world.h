@@ -0,0 +1,112 @@
+#pragma once
+
+#include "aligned_allocator.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Simulator {
+	class JobSystem;
+
+	enum class IntegrationMethod {
+		SEMI_IMPLICIT_EULER,
+		VERLET
+	};
+
+	enum class SimdPath {
+		SCALAR,
+		SSE,
+		AVX2,
+		NEON
+	};
+
+	struct BodyStreams {
+		float* position_x;
+		float* position_y;
+		float* position_z;
+		float* previous_position_x;
+		float* previous_position_y;
+		float* previous_position_z;
+		float* velocity_x;
+		float* velocity_y;
+		float* velocity_z;
+		float* force_x;
+		float* force_y;
+		float* force_z;
+		const float* inverse_mass;
+	};
+
+	struct IntegrationParams {
+		float dt = 0.0f;
+		float gravity_x = 0.0f;
+		float gravity_y = 0.0f;
+		float gravity_z = 0.0f;
+		float velocity_scale = 1.0f;
+	};
+
+	using IntegrationKernel = void (*)(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params);
+
+	class World {
+	public:
+		World();
+		void reserve(size_t bodies_count);
+		void clear();
+		uint32_t addBody(float x, float y, float z, float velocity_x, float velocity_y, float velocity_z, float mass, float radius);
+		size_t getBodiesCount() const;
+		void setGravity(float x, float y, float z);
+		void setDamping(float damping);
+		void applyForce(uint32_t body_idx, float x, float y, float z);
+		void step(float dt, IntegrationMethod method);
+		void step(float dt, IntegrationMethod method, JobSystem& job_system);
+		void prepareStep(float dt, IntegrationMethod method);
+		void integrate(size_t begin, size_t end, float dt, IntegrationMethod method);
+		bool setSimdPath(SimdPath path);
+		SimdPath getSimdPath() const;
+		IntegrationParams getIntegrationParams(float dt) const;
+		const float* getPositionsX() const;
+		const float* getPositionsY() const;
+		const float* getPositionsZ() const;
+		const float* getVelocitiesX() const;
+		const float* getVelocitiesY() const;
+		const float* getVelocitiesZ() const;
+		const float* getInverseMasses() const;
+		const float* getRadii() const;
+
+		static bool isSimdPathSupported(SimdPath path);
+		static SimdPath getBestSimdPath();
+		static const char* getSimdPathName(SimdPath path);
+		static IntegrationKernel getIntegrationKernel(SimdPath path, IntegrationMethod method);
+
+		static constexpr size_t STREAM_ALIGNMENT = 64;
+		static constexpr size_t STREAM_PADDING = 8;
+		static constexpr size_t PARALLEL_CHUNK_SIZE = 4096;
+
+	private:
+		using Stream = AlignedVector<float, STREAM_ALIGNMENT>;
+
+		static constexpr size_t STREAMS_COUNT = 14;
+
+		std::array<Stream*, STREAMS_COUNT> getAllStreams();
+		BodyStreams getStreams();
+
+		size_t m_bodies_count = 0;
+		Stream m_position_x;
+		Stream m_position_y;
+		Stream m_position_z;
+		Stream m_previous_position_x;
+		Stream m_previous_position_y;
+		Stream m_previous_position_z;
+		Stream m_velocity_x;
+		Stream m_velocity_y;
+		Stream m_velocity_z;
+		Stream m_force_x;
+		Stream m_force_y;
+		Stream m_force_z;
+		Stream m_inverse_mass;
+		Stream m_radius;
+		float m_gravity[3]{ 0.0f, -9.81f, 0.0f };
+		float m_damping = 0.0f;
+		float m_history_dt = 0.0f;
+		SimdPath m_simd_path = SimdPath::SCALAR;
+	};
+}
@@ -0,0 +1,305 @@
+#include "world_kernels.h"
+
+#ifdef SIMULATOR_SIMD_X86
+#include <immintrin.h>
+#endif
+#ifdef SIMULATOR_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMULATOR_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define SIMULATOR_TARGET_AVX2
+#endif
+
+using namespace Simulator;
+
+static inline void integrateEulerAxis(float& position, float& velocity, float& force, float inverse_mass, float gravity, const IntegrationParams& params)
+{
+	float acceleration = force * inverse_mass + gravity;
+	velocity = (velocity + acceleration * params.dt) * params.velocity_scale;
+	position += velocity * params.dt;
+	force = 0.0f;
+}
+
+static inline void integrateVerletAxis(float& position, float& previous_position, float& velocity, float& force, float inverse_mass, float gravity,
+	const IntegrationParams& params)
+{
+	float acceleration = force * inverse_mass + gravity;
+	float next_position = position + (position - previous_position) * params.velocity_scale + acceleration * (params.dt * params.dt);
+	velocity = (next_position - position) * (1.0f / params.dt);
+	previous_position = position;
+	position = next_position;
+	force = 0.0f;
+}
+
+void Simulator::integrateEulerScalar(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params)
+{
+	for (size_t i = begin; i < end; i++) {
+		float inverse_mass = streams.inverse_mass[i];
+		float gravity_mask = (inverse_mass > 0.0f) ? 1.0f : 0.0f;
+
+		integrateEulerAxis(streams.position_x[i], streams.velocity_x[i], streams.force_x[i], inverse_mass, params.gravity_x * gravity_mask, params);
+		integrateEulerAxis(streams.position_y[i], streams.velocity_y[i], streams.force_y[i], inverse_mass, params.gravity_y * gravity_mask, params);
+		integrateEulerAxis(streams.position_z[i], streams.velocity_z[i], streams.force_z[i], inverse_mass, params.gravity_z * gravity_mask, params);
+	}
+}
+
+void Simulator::integrateVerletScalar(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params)
+{
+	for (size_t i = begin; i < end; i++) {
+		float inverse_mass = streams.inverse_mass[i];
+		float gravity_mask = (inverse_mass > 0.0f) ? 1.0f : 0.0f;
+
+		integrateVerletAxis(streams.position_x[i], streams.previous_position_x[i], streams.velocity_x[i], streams.force_x[i], inverse_mass,
+			params.gravity_x * gravity_mask, params);
+		integrateVerletAxis(streams.position_y[i], streams.previous_position_y[i], streams.velocity_y[i], streams.force_y[i], inverse_mass,
+			params.gravity_y * gravity_mask, params);
+		integrateVerletAxis(streams.position_z[i], streams.previous_position_z[i], streams.velocity_z[i], streams.force_z[i], inverse_mass,
+			params.gravity_z * gravity_mask, params);
+	}
+}
+
+/**************************************************************************************/
+
+#ifdef SIMULATOR_SIMD_X86
+static inline void integrateEulerAxisSse(float* position, float* velocity, float* force, __m128 inverse_mass, __m128 gravity, __m128 dt,
+	__m128 velocity_scale)
+{
+	__m128 acceleration = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(force), inverse_mass), gravity);
+	__m128 next_velocity = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(velocity), _mm_mul_ps(acceleration, dt)), velocity_scale);
+
+	_mm_storeu_ps(velocity, next_velocity);
+	_mm_storeu_ps(position, _mm_add_ps(_mm_loadu_ps(position), _mm_mul_ps(next_velocity, dt)));
+	_mm_storeu_ps(force, _mm_setzero_ps());
+}
+
+static inline void integrateVerletAxisSse(float* position, float* previous_position, float* velocity, float* force, __m128 inverse_mass,
+	__m128 gravity, __m128 dt_squared, __m128 inverse_dt, __m128 velocity_scale)
+{
+	__m128 current_position = _mm_loadu_ps(position);
+	__m128 acceleration = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(force), inverse_mass), gravity);
+	__m128 next_position = _mm_add_ps(_mm_add_ps(current_position,
+		_mm_mul_ps(_mm_sub_ps(current_position, _mm_loadu_ps(previous_position)), velocity_scale)), _mm_mul_ps(acceleration, dt_squared));
+
+	_mm_storeu_ps(velocity, _mm_mul_ps(_mm_sub_ps(next_position, current_position), inverse_dt));
+	_mm_storeu_ps(previous_position, current_position);
+	_mm_storeu_ps(position, next_position);
+	_mm_storeu_ps(force, _mm_setzero_ps());
+}
+
+void Simulator::integrateEulerSse(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 gravity_x = _mm_set1_ps(params.gravity_x);
+	const __m128 gravity_y = _mm_set1_ps(params.gravity_y);
+	const __m128 gravity_z = _mm_set1_ps(params.gravity_z);
+	const __m128 dt = _mm_set1_ps(params.dt);
+	const __m128 velocity_scale = _mm_set1_ps(params.velocity_scale);
+
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		__m128 inverse_mass = _mm_loadu_ps(streams.inverse_mass + i);
+		__m128 gravity_mask = _mm_cmpgt_ps(inverse_mass, zero);
+
+		integrateEulerAxisSse(streams.position_x + i, streams.velocity_x + i, streams.force_x + i, inverse_mass, _mm_and_ps(gravity_x, gravity_mask),
+			dt, velocity_scale);
+		integrateEulerAxisSse(streams.position_y + i, streams.velocity_y + i, streams.force_y + i, inverse_mass, _mm_and_ps(gravity_y, gravity_mask),
+			dt, velocity_scale);
+		integrateEulerAxisSse(streams.position_z + i, streams.velocity_z + i, streams.force_z + i, inverse_mass, _mm_and_ps(gravity_z, gravity_mask),
+			dt, velocity_scale);
+	}
+
+	integrateEulerScalar(streams, i, end, params);
+}
+
+void Simulator::integrateVerletSse(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 gravity_x = _mm_set1_ps(params.gravity_x);
+	const __m128 gravity_y = _mm_set1_ps(params.gravity_y);
+	const __m128 gravity_z = _mm_set1_ps(params.gravity_z);
+	const __m128 dt_squared = _mm_set1_ps(params.dt * params.dt);
+	const __m128 inverse_dt = _mm_set1_ps(1.0f / params.dt);
+	const __m128 velocity_scale = _mm_set1_ps(params.velocity_scale);
+
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		__m128 inverse_mass = _mm_loadu_ps(streams.inverse_mass + i);
+		__m128 gravity_mask = _mm_cmpgt_ps(inverse_mass, zero);
+
+		integrateVerletAxisSse(streams.position_x + i, streams.previous_position_x + i, streams.velocity_x + i, streams.force_x + i, inverse_mass,
+			_mm_and_ps(gravity_x, gravity_mask), dt_squared, inverse_dt, velocity_scale);
+		integrateVerletAxisSse(streams.position_y + i, streams.previous_position_y + i, streams.velocity_y + i, streams.force_y + i, inverse_mass,
+			_mm_and_ps(gravity_y, gravity_mask), dt_squared, inverse_dt, velocity_scale);
+		integrateVerletAxisSse(streams.position_z + i, streams.previous_position_z + i, streams.velocity_z + i, streams.force_z + i, inverse_mass,
+			_mm_and_ps(gravity_z, gravity_mask), dt_squared, inverse_dt, velocity_scale);
+	}
+
+	integrateVerletScalar(streams, i, end, params);
+}
+
+/**************************************************************************************/
+
+SIMULATOR_TARGET_AVX2 static inline void integrateEulerAxisAvx2(float* position, float* velocity, float* force, __m256 inverse_mass, __m256 gravity,
+	__m256 dt, __m256 velocity_scale)
+{
+	__m256 acceleration = _mm256_fmadd_ps(_mm256_loadu_ps(force), inverse_mass, gravity);
+	__m256 next_velocity = _mm256_mul_ps(_mm256_fmadd_ps(acceleration, dt, _mm256_loadu_ps(velocity)), velocity_scale);
+
+	_mm256_storeu_ps(velocity, next_velocity);
+	_mm256_storeu_ps(position, _mm256_fmadd_ps(next_velocity, dt, _mm256_loadu_ps(position)));
+	_mm256_storeu_ps(force, _mm256_setzero_ps());
+}
+
+SIMULATOR_TARGET_AVX2 static inline void integrateVerletAxisAvx2(float* position, float* previous_position, float* velocity, float* force,
+	__m256 inverse_mass, __m256 gravity, __m256 dt_squared, __m256 inverse_dt, __m256 velocity_scale)
+{
+	__m256 current_position = _mm256_loadu_ps(position);
+	__m256 acceleration = _mm256_fmadd_ps(_mm256_loadu_ps(force), inverse_mass, gravity);
+	__m256 next_position = _mm256_fmadd_ps(acceleration, dt_squared,
+		_mm256_fmadd_ps(_mm256_sub_ps(current_position, _mm256_loadu_ps(previous_position)), velocity_scale, current_position));
+
+	_mm256_storeu_ps(velocity, _mm256_mul_ps(_mm256_sub_ps(next_position, current_position), inverse_dt));
+	_mm256_storeu_ps(previous_position, current_position);
+	_mm256_storeu_ps(position, next_position);
+	_mm256_storeu_ps(force, _mm256_setzero_ps());
+}
+
+SIMULATOR_TARGET_AVX2 void Simulator::integrateEulerAvx2(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 gravity_x = _mm256_set1_ps(params.gravity_x);
+	const __m256 gravity_y = _mm256_set1_ps(params.gravity_y);
+	const __m256 gravity_z = _mm256_set1_ps(params.gravity_z);
+	const __m256 dt = _mm256_set1_ps(params.dt);
+	const __m256 velocity_scale = _mm256_set1_ps(params.velocity_scale);
+
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8) {
+		__m256 inverse_mass = _mm256_loadu_ps(streams.inverse_mass + i);
+		__m256 gravity_mask = _mm256_cmp_ps(inverse_mass, zero, _CMP_GT_OQ);
+
+		integrateEulerAxisAvx2(streams.position_x + i, streams.velocity_x + i, streams.force_x + i, inverse_mass,
+			_mm256_and_ps(gravity_x, gravity_mask), dt, velocity_scale);
+		integrateEulerAxisAvx2(streams.position_y + i, streams.velocity_y + i, streams.force_y + i, inverse_mass,
+			_mm256_and_ps(gravity_y, gravity_mask), dt, velocity_scale);
+		integrateEulerAxisAvx2(streams.position_z + i, streams.velocity_z + i, streams.force_z + i, inverse_mass,
+			_mm256_and_ps(gravity_z, gravity_mask), dt, velocity_scale);
+	}
+
+	integrateEulerScalar(streams, i, end, params);
+}
+
+SIMULATOR_TARGET_AVX2 void Simulator::integrateVerletAvx2(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 gravity_x = _mm256_set1_ps(params.gravity_x);
+	const __m256 gravity_y = _mm256_set1_ps(params.gravity_y);
+	const __m256 gravity_z = _mm256_set1_ps(params.gravity_z);
+	const __m256 dt_squared = _mm256_set1_ps(params.dt * params.dt);
+	const __m256 inverse_dt = _mm256_set1_ps(1.0f / params.dt);
+	const __m256 velocity_scale = _mm256_set1_ps(params.velocity_scale);
+
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8) {
+		__m256 inverse_mass = _mm256_loadu_ps(streams.inverse_mass + i);
+		__m256 gravity_mask = _mm256_cmp_ps(inverse_mass, zero, _CMP_GT_OQ);
+
+		integrateVerletAxisAvx2(streams.position_x + i, streams.previous_position_x + i, streams.velocity_x + i, streams.force_x + i, inverse_mass,
+			_mm256_and_ps(gravity_x, gravity_mask), dt_squared, inverse_dt, velocity_scale);
+		integrateVerletAxisAvx2(streams.position_y + i, streams.previous_position_y + i, streams.velocity_y + i, streams.force_y + i, inverse_mass,
+			_mm256_and_ps(gravity_y, gravity_mask), dt_squared, inverse_dt, velocity_scale);
+		integrateVerletAxisAvx2(streams.position_z + i, streams.previous_position_z + i, streams.velocity_z + i, streams.force_z + i, inverse_mass,
+			_mm256_and_ps(gravity_z, gravity_mask), dt_squared, inverse_dt, velocity_scale);
+	}
+
+	integrateVerletScalar(streams, i, end, params);
+}
+#endif
+
+/**************************************************************************************/
+
+#ifdef SIMULATOR_SIMD_NEON
+static inline void integrateEulerAxisNeon(float* position, float* velocity, float* force, float32x4_t inverse_mass, float32x4_t gravity,
+	float32x4_t dt, float32x4_t velocity_scale)
+{
+	float32x4_t acceleration = vfmaq_f32(gravity, vld1q_f32(force), inverse_mass);
+	float32x4_t next_velocity = vmulq_f32(vfmaq_f32(vld1q_f32(velocity), acceleration, dt), velocity_scale);
+
+	vst1q_f32(velocity, next_velocity);
+	vst1q_f32(position, vfmaq_f32(vld1q_f32(position), next_velocity, dt));
+	vst1q_f32(force, vdupq_n_f32(0.0f));
+}
+
+static inline void integrateVerletAxisNeon(float* position, float* previous_position, float* velocity, float* force, float32x4_t inverse_mass,
+	float32x4_t gravity, float32x4_t dt_squared, float32x4_t inverse_dt, float32x4_t velocity_scale)
+{
+	float32x4_t current_position = vld1q_f32(position);
+	float32x4_t acceleration = vfmaq_f32(gravity, vld1q_f32(force), inverse_mass);
+	float32x4_t next_position = vfmaq_f32(vfmaq_f32(current_position, vsubq_f32(current_position, vld1q_f32(previous_position)), velocity_scale),
+		acceleration, dt_squared);
+
+	vst1q_f32(velocity, vmulq_f32(vsubq_f32(next_position, current_position), inverse_dt));
+	vst1q_f32(previous_position, current_position);
+	vst1q_f32(position, next_position);
+	vst1q_f32(force, vdupq_n_f32(0.0f));
+}
+
+static inline float32x4_t maskGravityNeon(float32x4_t gravity, uint32x4_t gravity_mask)
+{
+	return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(gravity), gravity_mask));
+}
+
+void Simulator::integrateEulerNeon(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params)
+{
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t gravity_x = vdupq_n_f32(params.gravity_x);
+	const float32x4_t gravity_y = vdupq_n_f32(params.gravity_y);
+	const float32x4_t gravity_z = vdupq_n_f32(params.gravity_z);
+	const float32x4_t dt = vdupq_n_f32(params.dt);
+	const float32x4_t velocity_scale = vdupq_n_f32(params.velocity_scale);
+
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		float32x4_t inverse_mass = vld1q_f32(streams.inverse_mass + i);
+		uint32x4_t gravity_mask = vcgtq_f32(inverse_mass, zero);
+
+		integrateEulerAxisNeon(streams.position_x + i, streams.velocity_x + i, streams.force_x + i, inverse_mass,
+			maskGravityNeon(gravity_x, gravity_mask), dt, velocity_scale);
+		integrateEulerAxisNeon(streams.position_y + i, streams.velocity_y + i, streams.force_y + i, inverse_mass,
+			maskGravityNeon(gravity_y, gravity_mask), dt, velocity_scale);
+		integrateEulerAxisNeon(streams.position_z + i, streams.velocity_z + i, streams.force_z + i, inverse_mass,
+			maskGravityNeon(gravity_z, gravity_mask), dt, velocity_scale);
+	}
+
+	integrateEulerScalar(streams, i, end, params);
+}
+
+void Simulator::integrateVerletNeon(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params)
+{
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+	const float32x4_t gravity_x = vdupq_n_f32(params.gravity_x);
+	const float32x4_t gravity_y = vdupq_n_f32(params.gravity_y);
+	const float32x4_t gravity_z = vdupq_n_f32(params.gravity_z);
+	const float32x4_t dt_squared = vdupq_n_f32(params.dt * params.dt);
+	const float32x4_t inverse_dt = vdupq_n_f32(1.0f / params.dt);
+	const float32x4_t velocity_scale = vdupq_n_f32(params.velocity_scale);
+
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		float32x4_t inverse_mass = vld1q_f32(streams.inverse_mass + i);
+		uint32x4_t gravity_mask = vcgtq_f32(inverse_mass, zero);
+
+		integrateVerletAxisNeon(streams.position_x + i, streams.previous_position_x + i, streams.velocity_x + i, streams.force_x + i, inverse_mass,
+			maskGravityNeon(gravity_x, gravity_mask), dt_squared, inverse_dt, velocity_scale);
+		integrateVerletAxisNeon(streams.position_y + i, streams.previous_position_y + i, streams.velocity_y + i, streams.force_y + i, inverse_mass,
+			maskGravityNeon(gravity_y, gravity_mask), dt_squared, inverse_dt, velocity_scale);
+		integrateVerletAxisNeon(streams.position_z + i, streams.previous_position_z + i, streams.velocity_z + i, streams.force_z + i, inverse_mass,
+			maskGravityNeon(gravity_z, gravity_mask), dt_squared, inverse_dt, velocity_scale);
+	}
+
+	integrateVerletScalar(streams, i, end, params);
+}
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "world.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMULATOR_SIMD_X86 1
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define SIMULATOR_SIMD_NEON 1
+#endif
+
+namespace Simulator {
+	void integrateEulerScalar(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params);
+	void integrateVerletScalar(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params);
+#ifdef SIMULATOR_SIMD_X86
+	void integrateEulerSse(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params);
+	void integrateVerletSse(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params);
+	void integrateEulerAvx2(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params);
+	void integrateVerletAvx2(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params);
+#endif
+#ifdef SIMULATOR_SIMD_NEON
+	void integrateEulerNeon(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params);
+	void integrateVerletNeon(const BodyStreams& streams, size_t begin, size_t end, const IntegrationParams& params);
+#endif
+}